@@ -0,0 +1,12 @@
+; MiniCC - Generated LLVM IR
+
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+
+define i32 @main() nounwind readnone {
+  %t3 = mul nsw i32 20, 2
+  %t4 = add nsw i32 10, %t3
+  ret i32 %t4
+}
+
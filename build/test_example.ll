@@ -0,0 +1,87 @@
+; MiniCC - Generated LLVM IR
+
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+
+define i32 @gcd(i32 %a, i32 %b) nounwind readnone {
+entry:
+  br label %while_cond1
+while_cond1:
+  %t10 = phi i32 [ %b, %entry ], [ %t6, %while_body2 ]
+  %t9 = phi i32 [ %a, %entry ], [ %t10, %while_body2 ]
+  %t2 = icmp ne i32 %t10, 0
+  br i1 %t2, label %while_body2, label %while_end3
+while_body2:
+  %t6 = srem i32 %t9, %t10
+  br label %while_cond1
+while_end3:
+  ret i32 %t9
+}
+
+define i32 @power(i32 %base, i32 %exp) nounwind readnone {
+entry:
+  br label %while_cond1
+while_cond1:
+  %t11 = phi i32 [ 0, %entry ], [ %t8, %while_body2 ]
+  %t10 = phi i32 [ 1, %entry ], [ %t6, %while_body2 ]
+  %t3 = icmp slt i32 %t11, %exp
+  br i1 %t3, label %while_body2, label %while_end3
+while_body2:
+  %t6 = mul nsw i32 %t10, %base
+  %t8 = add nsw i32 %t11, 1
+  br label %while_cond1
+while_end3:
+  ret i32 %t10
+}
+
+define i32 @main() nounwind readnone {
+  %t3 = add nsw i32 12, 18
+  %t6 = sub nsw i32 12, 18
+  %t9 = mul nsw i32 12, 18
+  %t11 = sdiv i32 12, 3
+  %t14 = icmp sgt i32 12, 18
+  br i1 %t14, label %if_then1, label %if_else2
+if_then1:
+  br label %if_end3
+if_else2:
+  br label %if_end3
+if_end3:
+  br label %entry.inl1
+entry.inl1:
+  br label %while_cond1.inl1
+while_cond1.inl1:
+  %t35 = phi i32 [ 0, %entry.inl1 ], [ %t32, %while_body2.inl1 ]
+  %t34 = phi i32 [ 1, %entry.inl1 ], [ %t30, %while_body2.inl1 ]
+  %t27 = icmp slt i32 %t35, 4
+  br i1 %t27, label %while_body2.inl1, label %while_end3.inl1
+while_body2.inl1:
+  %t30 = mul nsw i32 %t34, 2
+  %t32 = add nsw i32 %t35, 1
+  br label %while_cond1.inl1
+while_end3.inl1:
+  br label %while_cond4
+while_cond4:
+  %t50 = phi i32 [ 5, %while_end3.inl1 ], [ %t23, %while_end3.inl2 ]
+  %t19 = icmp sgt i32 %t50, 0
+  br i1 %t19, label %while_body5, label %while_end6
+while_body5:
+  br label %entry.inl2
+entry.inl2:
+  br label %while_cond1.inl2
+while_cond1.inl2:
+  %t46 = phi i32 [ 0, %entry.inl2 ], [ %t43, %while_body2.inl2 ]
+  %t45 = phi i32 [ 1, %entry.inl2 ], [ %t41, %while_body2.inl2 ]
+  %t38 = icmp slt i32 %t46, 2
+  br i1 %t38, label %while_body2.inl2, label %while_end3.inl2
+while_body2.inl2:
+  %t41 = mul nsw i32 %t45, %t50
+  %t43 = add nsw i32 %t46, 1
+  br label %while_cond1.inl2
+while_end3.inl2:
+  %t23 = sub nsw i32 %t50, 1
+  br label %while_cond4
+while_end6:
+  ret i32 %t34
+}
+
@@ -0,0 +1,35 @@
+; MiniCC - Generated LLVM IR
+
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+
+define i32 @fibonacci(i32 %n) nounwind {
+  %t2 = icmp sle i32 %n, 1
+  br i1 %t2, label %if_then1, label %if_end3
+if_then1:
+  ret i32 %n
+if_end3:
+  %t5 = sub nsw i32 %n, 1
+  %t6 = call i32 @fibonacci(i32 %t5)
+  %t8 = sub nsw i32 %n, 2
+  %t9 = call i32 @fibonacci(i32 %t8)
+  %t10 = add nsw i32 %t6, %t9
+  ret i32 %t10
+}
+
+define i32 @main() nounwind {
+entry:
+  br label %while_cond1
+while_cond1:
+  %t7 = phi i32 [ 0, %entry ], [ %t6, %while_body2 ]
+  %t2 = icmp slt i32 %t7, 10
+  br i1 %t2, label %while_body2, label %while_end3
+while_body2:
+  %t4 = call i32 @fibonacci(i32 %t7)
+  %t6 = add nsw i32 %t7, 1
+  br label %while_cond1
+while_end3:
+  ret i32 0
+}
+
@@ -0,0 +1,289 @@
+; MiniCC - Generated LLVM IR
+
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+
+define i32 @test_basic_pointers() nounwind readnone {
+  %test_basic_pointers.x.2.1 = alloca i32
+  store i32 42, i32* %test_basic_pointers.x.2.1
+  %t1 = getelementptr inbounds i32, i32* %test_basic_pointers.x.2.1, i64 0
+  %t3 = load i32, i32* %t1
+  %t5 = icmp eq i32 %t3, 42
+  br i1 %t5, label %if_then1, label %if_end3
+if_then1:
+  ret i32 1
+if_end3:
+  ret i32 0
+}
+
+define i32 @test_pointer_arithmetic() nounwind readnone {
+  %test_pointer_arithmetic.arr.2.1 = alloca [5 x i32]
+  %t1 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1, i64 0, i64 0
+  store i32 10, i32* %t1
+  %t2 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1, i64 0, i64 1
+  store i32 20, i32* %t2
+  %t3 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1, i64 0, i64 2
+  store i32 30, i32* %t3
+  %t4 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1, i64 0, i64 3
+  store i32 40, i32* %t4
+  %t5 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1, i64 0, i64 4
+  store i32 50, i32* %t5
+  %t6 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1, i64 0, i64 0
+  %t8 = load i32, i32* %t6
+  %t9 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1, i64 0, i64 2
+  %t11 = load i32, i32* %t9
+  %t14 = icmp eq i32 %t8, 10
+  br i1 %t14, label %logical_right5, label %logical_left4
+logical_left4:
+  br label %logical_end6
+logical_right5:
+  %t16 = icmp eq i32 %t11, 30
+  br label %logical_end6
+logical_end6:
+  %t20 = phi i1 [ false, %logical_left4 ], [ %t16, %logical_right5 ]
+  %t18 = zext i1 %t20 to i32
+  %t19 = icmp ne i32 %t18, 0
+  br i1 %t19, label %if_then1, label %if_end3
+if_then1:
+  ret i32 1
+if_end3:
+  ret i32 0
+}
+
+define i32 @test_array_access() nounwind readnone {
+entry:
+  %test_array_access.numbers.2.1 = alloca [4 x i32]
+  %t1 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1, i64 0, i64 0
+  store i32 100, i32* %t1
+  %t2 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1, i64 0, i64 1
+  store i32 200, i32* %t2
+  %t3 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1, i64 0, i64 2
+  store i32 300, i32* %t3
+  %t4 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1, i64 0, i64 3
+  store i32 400, i32* %t4
+  br label %while_cond1
+while_cond1:
+  %t17 = phi i32 [ 0, %entry ], [ %t14, %while_body2 ]
+  %t16 = phi i32 [ 0, %entry ], [ %t12, %while_body2 ]
+  %t6 = icmp slt i32 %t17, 4
+  br i1 %t6, label %while_body2, label %while_end3
+while_body2:
+  %t11 = sext i32 %t17 to i64
+  %t9 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1, i64 0, i64 %t11
+  %t10 = load i32, i32* %t9
+  %t12 = add nsw i32 %t16, %t10
+  %t14 = add nsw i32 %t17, 1
+  br label %while_cond1
+while_end3:
+  ret i32 %t16
+}
+
+define i32 @test_vla(i32 %size) nounwind readnone {
+entry:
+  %t2 = alloca i32, i32 %size
+  br label %while_cond1
+while_cond1:
+  %t20 = phi i32 [ 0, %entry ], [ %t13, %while_body2 ]
+  %t5 = icmp slt i32 %t20, %size
+  br i1 %t5, label %while_body2, label %while_end3
+while_body2:
+  %t7 = mul nsw i32 %t20, 10
+  %t10 = sext i32 %t20 to i64
+  %t9 = getelementptr inbounds i32, i32* %t2, i64 %t10
+  store i32 %t7, i32* %t9
+  %t13 = add nsw i32 %t20, 1
+  br label %while_cond1
+while_end3:
+  %t15 = sub nsw i32 %size, 1
+  %t18 = sext i32 %t15 to i64
+  %t16 = getelementptr inbounds i32, i32* %t2, i64 %t18
+  %t17 = load i32, i32* %t16
+  ret i32 %t17
+}
+
+define i32 @test_multi_level_pointers() nounwind readonly {
+  %test_multi_level_pointers.value.2.1 = alloca i32
+  store i32 123, i32* %test_multi_level_pointers.value.2.1
+  %test_multi_level_pointers.ptr1.2.2 = alloca i32*
+  %t1 = getelementptr inbounds i32, i32* %test_multi_level_pointers.value.2.1, i64 0
+  store i32* %t1, i32** %test_multi_level_pointers.ptr1.2.2
+  %t2 = getelementptr inbounds i32*, i32** %test_multi_level_pointers.ptr1.2.2, i64 0
+  %t4 = load i32*, i32** %t2
+  %t5 = load i32, i32* %t4
+  %t7 = icmp eq i32 %t5, 123
+  br i1 %t7, label %if_then1, label %if_end3
+if_then1:
+  ret i32 1
+if_end3:
+  ret i32 0
+}
+
+define i32 @modify_through_pointer(i32* %p) nounwind {
+  store i32 999, i32* %p
+  %t3 = load i32, i32* %p
+  ret i32 %t3
+}
+
+define i32 @test_function_params() nounwind readnone {
+  %test_function_params.x.2.1 = alloca i32
+  store i32 100, i32* %test_function_params.x.2.1
+  %t1 = getelementptr inbounds i32, i32* %test_function_params.x.2.1, i64 0
+  store i32 999, i32* %t1
+  %t7 = load i32, i32* %t1
+  %t3 = load i32, i32* %test_function_params.x.2.1
+  %t4 = icmp eq i32 %t3, 999
+  br i1 %t4, label %if_then1, label %if_end3
+if_then1:
+  ret i32 1
+if_end3:
+  ret i32 0
+}
+
+define i32 @main() nounwind {
+  %test_basic_pointers.x.2.1.inl1 = alloca i32
+  %test_pointer_arithmetic.arr.2.1.inl2 = alloca [5 x i32]
+  %test_array_access.numbers.2.1.inl3 = alloca [4 x i32]
+  %test_multi_level_pointers.value.2.1.inl4 = alloca i32
+  %test_multi_level_pointers.ptr1.2.2.inl4 = alloca i32*
+  store i32 42, i32* %test_basic_pointers.x.2.1.inl1
+  %t39 = getelementptr inbounds i32, i32* %test_basic_pointers.x.2.1.inl1, i64 0
+  %t41 = load i32, i32* %t39
+  %t43 = icmp eq i32 %t41, 42
+  br i1 %t43, label %if_then1.inl1, label %if_end3.inl1
+if_then1.inl1:
+  br label %inline_end1
+if_end3.inl1:
+  br label %inline_end1
+inline_end1:
+  %t88 = phi i32 [ 1, %if_then1.inl1 ], [ 0, %if_end3.inl1 ]
+  %t44 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1.inl2, i64 0, i64 0
+  store i32 10, i32* %t44
+  %t45 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1.inl2, i64 0, i64 1
+  store i32 20, i32* %t45
+  %t46 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1.inl2, i64 0, i64 2
+  store i32 30, i32* %t46
+  %t47 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1.inl2, i64 0, i64 3
+  store i32 40, i32* %t47
+  %t48 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1.inl2, i64 0, i64 4
+  store i32 50, i32* %t48
+  %t49 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1.inl2, i64 0, i64 0
+  %t51 = load i32, i32* %t49
+  %t52 = getelementptr inbounds [5 x i32], [5 x i32]* %test_pointer_arithmetic.arr.2.1.inl2, i64 0, i64 2
+  %t54 = load i32, i32* %t52
+  %t57 = icmp eq i32 %t51, 10
+  br i1 %t57, label %logical_right5.inl2, label %logical_left4.inl2
+logical_left4.inl2:
+  br label %logical_end6.inl2
+logical_right5.inl2:
+  %t59 = icmp eq i32 %t54, 30
+  br label %logical_end6.inl2
+logical_end6.inl2:
+  %t63 = phi i1 [ false, %logical_left4.inl2 ], [ %t59, %logical_right5.inl2 ]
+  %t61 = zext i1 %t63 to i32
+  %t62 = icmp ne i32 %t61, 0
+  br i1 %t62, label %if_then1.inl2, label %if_end3.inl2
+if_then1.inl2:
+  br label %inline_end2
+if_end3.inl2:
+  br label %inline_end2
+inline_end2:
+  %t89 = phi i32 [ 1, %if_then1.inl2 ], [ 0, %if_end3.inl2 ]
+  br label %entry.inl3
+entry.inl3:
+  %t64 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1.inl3, i64 0, i64 0
+  store i32 100, i32* %t64
+  %t65 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1.inl3, i64 0, i64 1
+  store i32 200, i32* %t65
+  %t66 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1.inl3, i64 0, i64 2
+  store i32 300, i32* %t66
+  %t67 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1.inl3, i64 0, i64 3
+  store i32 400, i32* %t67
+  br label %while_cond1.inl3
+while_cond1.inl3:
+  %t80 = phi i32 [ 0, %entry.inl3 ], [ %t77, %while_body2.inl3 ]
+  %t79 = phi i32 [ 0, %entry.inl3 ], [ %t75, %while_body2.inl3 ]
+  %t69 = icmp slt i32 %t80, 4
+  br i1 %t69, label %while_body2.inl3, label %while_end3.inl3
+while_body2.inl3:
+  %t74 = sext i32 %t80 to i64
+  %t72 = getelementptr inbounds [4 x i32], [4 x i32]* %test_array_access.numbers.2.1.inl3, i64 0, i64 %t74
+  %t73 = load i32, i32* %t72
+  %t75 = add nsw i32 %t79, %t73
+  %t77 = add nsw i32 %t80, 1
+  br label %while_cond1.inl3
+while_end3.inl3:
+  %t4 = call i32 @test_vla(i32 5)
+  store i32 123, i32* %test_multi_level_pointers.value.2.1.inl4
+  %t81 = getelementptr inbounds i32, i32* %test_multi_level_pointers.value.2.1.inl4, i64 0
+  store i32* %t81, i32** %test_multi_level_pointers.ptr1.2.2.inl4
+  %t82 = getelementptr inbounds i32*, i32** %test_multi_level_pointers.ptr1.2.2.inl4, i64 0
+  %t84 = load i32*, i32** %t82
+  %t85 = load i32, i32* %t84
+  %t87 = icmp eq i32 %t85, 123
+  br i1 %t87, label %if_then1.inl4, label %if_end3.inl4
+if_then1.inl4:
+  br label %inline_end4
+if_end3.inl4:
+  br label %inline_end4
+inline_end4:
+  %t90 = phi i32 [ 1, %if_then1.inl4 ], [ 0, %if_end3.inl4 ]
+  %t6 = call i32 @test_function_params()
+  %t13 = icmp eq i32 %t88, 1
+  br i1 %t13, label %logical_right17, label %logical_left16
+logical_left16:
+  br label %logical_end18
+logical_right17:
+  %t15 = icmp eq i32 %t89, 1
+  br label %logical_end18
+logical_end18:
+  %t95 = phi i1 [ false, %logical_left16 ], [ %t15, %logical_right17 ]
+  %t17 = zext i1 %t95 to i32
+  %t18 = icmp ne i32 %t17, 0
+  br i1 %t18, label %logical_right14, label %logical_left13
+logical_left13:
+  br label %logical_end15
+logical_right14:
+  %t20 = icmp eq i32 %t79, 1000
+  br label %logical_end15
+logical_end15:
+  %t94 = phi i1 [ false, %logical_left13 ], [ %t20, %logical_right14 ]
+  %t22 = zext i1 %t94 to i32
+  %t23 = icmp ne i32 %t22, 0
+  br i1 %t23, label %logical_right11, label %logical_left10
+logical_left10:
+  br label %logical_end12
+logical_right11:
+  %t25 = icmp eq i32 %t4, 40
+  br label %logical_end12
+logical_end12:
+  %t93 = phi i1 [ false, %logical_left10 ], [ %t25, %logical_right11 ]
+  %t27 = zext i1 %t93 to i32
+  %t28 = icmp ne i32 %t27, 0
+  br i1 %t28, label %logical_right8, label %logical_left7
+logical_left7:
+  br label %logical_end9
+logical_right8:
+  %t30 = icmp eq i32 %t90, 1
+  br label %logical_end9
+logical_end9:
+  %t92 = phi i1 [ false, %logical_left7 ], [ %t30, %logical_right8 ]
+  %t32 = zext i1 %t92 to i32
+  %t33 = icmp ne i32 %t32, 0
+  br i1 %t33, label %logical_right5, label %logical_left4
+logical_left4:
+  br label %logical_end6
+logical_right5:
+  %t35 = icmp eq i32 %t6, 1
+  br label %logical_end6
+logical_end6:
+  %t91 = phi i1 [ false, %logical_left4 ], [ %t35, %logical_right5 ]
+  %t37 = zext i1 %t91 to i32
+  %t38 = icmp ne i32 %t37, 0
+  br i1 %t38, label %if_then1, label %if_end3
+if_then1:
+  ret i32 0
+if_end3:
+  ret i32 1
+}
+
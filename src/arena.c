@@ -0,0 +1,144 @@
+#define _POSIX_C_SOURCE 200809L
+#include "arena.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 8
+#define ARENA_MIN_CHUNK_SIZE (64 * 1024)
+#define ARENA_MAX_CHUNK_SIZE (4 * 1024 * 1024)
+#define ARENA_MIN_BLOCK_SIZE 32
+
+static arena_chunk_t *new_chunk(arena_t *arena, size_t size)
+{
+	arena_chunk_t *chunk = malloc(sizeof(arena_chunk_t) + size);
+	if (!chunk) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	arena->bytes_reserved += size;
+	arena->chunk_count++;
+	return chunk;
+}
+
+// Offset into chunk at which an allocation with the given alignment may start
+static size_t aligned_offset(arena_chunk_t *chunk, size_t align)
+{
+	uintptr_t addr = (uintptr_t)(chunk->data + chunk->used);
+	uintptr_t aligned = (addr + align - 1) & ~(uintptr_t)(align - 1);
+	return chunk->used + (size_t)(aligned - addr);
+}
+
+static void *arena_alloc_aligned(arena_t *arena, size_t size, size_t align)
+{
+	arena_chunk_t *chunk = arena->head;
+	if (chunk) {
+		size_t offset = aligned_offset(chunk, align);
+		if (offset + size <= chunk->size) {
+			arena->bytes_used += offset + size - chunk->used;
+			chunk->used = offset + size;
+			return chunk->data + offset;
+		}
+	}
+
+	if (arena->next_chunk_size == 0)
+		arena->next_chunk_size = ARENA_MIN_CHUNK_SIZE;
+
+	// Large requests get a dedicated chunk behind the current one so the
+	// space left in the head chunk is not wasted
+	if (chunk && size + align > arena->next_chunk_size / 4) {
+		arena_chunk_t *big = new_chunk(arena, size + align);
+		big->next = chunk->next;
+		chunk->next = big;
+		size_t offset = aligned_offset(big, align);
+		big->used = offset + size;
+		arena->bytes_used += big->used;
+		return big->data + offset;
+	}
+
+	size_t chunk_size = arena->next_chunk_size;
+	while (chunk_size < size + align)
+		chunk_size *= 2;
+	if (arena->next_chunk_size < ARENA_MAX_CHUNK_SIZE)
+		arena->next_chunk_size *= 2;
+
+	chunk = new_chunk(arena, chunk_size);
+	chunk->next = arena->head;
+	arena->head = chunk;
+
+	size_t offset = aligned_offset(chunk, align);
+	chunk->used = offset + size;
+	arena->bytes_used += chunk->used;
+	return chunk->data + offset;
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+	return arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+void *arena_calloc(arena_t *arena, size_t count, size_t size)
+{
+	void *ptr = arena_alloc(arena, count * size);
+	memset(ptr, 0, count * size);
+	return ptr;
+}
+
+char *arena_strndup(arena_t *arena, const char *str, size_t len)
+{
+	if (!str)
+		return NULL;
+	// Strings need no alignment, so they pack tightly between nodes
+	char *copy = arena_alloc_aligned(arena, len + 1, 1);
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+char *arena_strdup(arena_t *arena, const char *str)
+{
+	if (!str)
+		return NULL;
+	return arena_strndup(arena, str, strlen(str));
+}
+
+void *arena_realloc(arena_t *arena, void *ptr, size_t size)
+{
+	// The block capacity is stored just before the returned pointer
+	size_t *header = ptr ? (size_t *)ptr - 1 : NULL;
+	if (header && *header >= size)
+		return ptr;
+
+	size_t capacity = header ? *header * 2 : ARENA_MIN_BLOCK_SIZE;
+	while (capacity < size)
+		capacity *= 2;
+
+	size_t *block = arena_alloc(arena, sizeof(size_t) + capacity);
+	*block = capacity;
+	if (header)
+		memcpy(block + 1, ptr, *header);
+	return block + 1;
+}
+
+void *arena_append(arena_t *arena, void *array, size_t length, const void *items, size_t count, size_t size)
+{
+	char *block = arena_realloc(arena, array, (length + count) * size);
+	if (count)
+		memcpy(block + length * size, items, count * size);
+	return block;
+}
+
+void arena_release(arena_t *arena)
+{
+	arena_chunk_t *chunk = arena->head;
+	while (chunk) {
+		arena_chunk_t *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	memset(arena, 0, sizeof(*arena));
+}
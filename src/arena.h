@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator with chunked growth. Individual allocations are never
+// freed; everything is released at once with arena_release().
+typedef struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size; // Usable bytes in data
+	size_t used;
+	char data[];
+} arena_chunk_t;
+
+typedef struct {
+	arena_chunk_t *head;
+	size_t next_chunk_size;
+	size_t bytes_used;     // Bytes handed out, including alignment padding
+	size_t bytes_reserved; // Bytes obtained from malloc for chunks
+	size_t chunk_count;
+} arena_t;
+
+// A zero-initialized arena_t is a valid empty arena
+void *arena_alloc(arena_t *arena, size_t size);
+void *arena_calloc(arena_t *arena, size_t count, size_t size);
+char *arena_strdup(arena_t *arena, const char *str);
+char *arena_strndup(arena_t *arena, const char *str, size_t len);
+
+// Growable block for arrays built one element at a time. ptr must be NULL or
+// a block returned by arena_realloc; capacity doubles, so appends stay O(1).
+void *arena_realloc(arena_t *arena, void *ptr, size_t size);
+// Appends count elements of size bytes to such a block holding length of
+// them (array may be NULL when length is 0); returns the block, which may
+// have moved
+void *arena_append(arena_t *arena, void *array, size_t length, const void *items, size_t count, size_t size);
+
+void arena_release(arena_t *arena);
+
+#endif
@@ -1,24 +1,36 @@
 #define _POSIX_C_SOURCE 200809L
 #include "ast.h"
 #include "symbol_table.h"
+#include "fold.h"
 #include "common.h"
+#include <stdint.h>
+
+// Owns all AST nodes, identifier strings and parser-built arrays
+THREAD_LOCAL arena_t ast_arena;
+THREAD_LOCAL size_t ast_offset;
+THREAD_LOCAL source_t *ast_source;
+THREAD_LOCAL int error_count;
+
+int node_line(const ast_node_t *node)
+{
+	int line = 0;
+	if (ast_source)
+		source_position(ast_source, node->offset, &line, NULL);
+	return line;
+}
 
 // Helper function to create a new AST node
 static ast_node_t *create_node(ast_node_type_t type)
 {
-	ast_node_t *node = malloc(sizeof(ast_node_t));
-	if (!node) {
-		fprintf(stderr, "Memory allocation failed\n");
-		exit(1);
-	}
+	ast_node_t *node = arena_alloc(&ast_arena, sizeof(ast_node_t));
 	node->type = type;
-	node->line_number = line_number;
-	node->column = 0;
+	node->offset = (unsigned int)ast_offset;
+	node->expr_type = NULL;
 	return node;
 }
 
 // Type info creation and management
-type_info_t create_type_info(char *base_type, int pointer_level, int is_array, ast_node_t *array_size)
+type_info_t create_type_info(const char *base_type, int pointer_level, int is_array, ast_node_t *array_size)
 {
 	type_info_t type_info;
 	type_info.base_type = base_type;
@@ -32,10 +44,12 @@ type_info_t create_type_info(char *base_type, int pointer_level, int is_array, a
 	type_info.is_incomplete = 0;
 	type_info.storage_class = STORAGE_NONE;
 	type_info.qualifiers = QUAL_NONE;
+	type_info.pointer_qualifiers = QUAL_NONE;
 	type_info.array_size = array_size;
 	type_info.param_types = NULL;
 	type_info.param_count = 0;
 	type_info.is_variadic = 0;
+	type_info.is_inline = 0;
 	return type_info;
 }
 
@@ -44,6 +58,7 @@ declarator_t make_declarator(char *name, int pointer_level, int is_array, ast_no
 	declarator_t decl;
 	decl.name = name;
 	decl.pointer_level = pointer_level;
+	decl.pointer_qualifiers = QUAL_NONE;
 	decl.is_array = is_array;
 	decl.is_function = 0;
 	decl.array_size = array_size;
@@ -73,6 +88,7 @@ ast_node_t *create_function(char *name, type_info_t return_type, ast_node_t **pa
 	node->data.function.storage_class = return_type.storage_class;
 	node->data.function.is_variadic = return_type.is_variadic;
 	node->data.function.is_defined = (body != NULL);
+	node->data.function.is_inline = return_type.is_inline;
 	return node;
 }
 
@@ -202,6 +218,8 @@ ast_node_t *create_declaration(type_info_t type_info, char *name, ast_node_t *in
 		node->data.array_decl.size = type_info.array_size;
 		node->data.array_decl.is_vla = type_info.is_vla ||
 					       (type_info.array_size && type_info.array_size->type != AST_NUMBER);
+		node->data.array_decl.has_init = init != NULL;
+		node->data.array_decl.symbol = NULL;
 		return node;
 	}
 
@@ -210,6 +228,7 @@ ast_node_t *create_declaration(type_info_t type_info, char *name, ast_node_t *in
 	node->data.declaration.name = name;
 	node->data.declaration.init = init;
 	node->data.declaration.is_parameter = 0;
+	node->data.declaration.symbol = NULL;
 	return node;
 }
 
@@ -220,6 +239,7 @@ ast_node_t *create_array_declaration(type_info_t type_info, char *name, ast_node
 	node->data.array_decl.name = name;
 	node->data.array_decl.size = size;
 	node->data.array_decl.is_vla = (size && size->type != AST_NUMBER);
+	node->data.array_decl.symbol = NULL;
 	return node;
 }
 
@@ -298,6 +318,7 @@ ast_node_t *create_assignment(char *name, ast_node_t *value)
 	node->data.assignment.lvalue = NULL;
 	node->data.assignment.value = value;
 	node->data.assignment.op = OP_ASSIGN;
+	node->data.assignment.symbol = NULL;
 	return node;
 }
 
@@ -308,6 +329,7 @@ ast_node_t *create_assignment_to_lvalue(ast_node_t *lvalue, ast_node_t *value)
 	node->data.assignment.lvalue = lvalue;
 	node->data.assignment.value = value;
 	node->data.assignment.op = OP_ASSIGN;
+	node->data.assignment.symbol = NULL;
 	return node;
 }
 
@@ -318,6 +340,7 @@ ast_node_t *create_compound_assignment(ast_node_t *lvalue, binary_op_t op, ast_n
 	node->data.assignment.lvalue = lvalue;
 	node->data.assignment.value = value;
 	node->data.assignment.op = op;
+	node->data.assignment.symbol = NULL;
 	return node;
 }
 
@@ -328,7 +351,8 @@ ast_node_t *create_call(char *name, ast_node_t **args, int arg_count)
 	node->data.call.args = args;
 	node->data.call.arg_count = arg_count;
 	// Return type will be filled in during type checking
-	node->data.call.return_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.call.return_type = create_type_info("int", 0, 0, NULL);
+	node->data.call.symbol = NULL;
 	return node;
 }
 
@@ -339,7 +363,7 @@ ast_node_t *create_binary_op(binary_op_t op, ast_node_t *left, ast_node_t *right
 	node->data.binary_op.left = left;
 	node->data.binary_op.right = right;
 	// Result type will be filled in during type checking
-	node->data.binary_op.result_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.binary_op.result_type = create_type_info("int", 0, 0, NULL);
 	return node;
 }
 
@@ -349,7 +373,7 @@ ast_node_t *create_unary_op(unary_op_t op, ast_node_t *operand)
 	node->data.unary_op.op = op;
 	node->data.unary_op.operand = operand;
 	// Result type will be filled in during type checking
-	node->data.unary_op.result_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.unary_op.result_type = create_type_info("int", 0, 0, NULL);
 	return node;
 }
 
@@ -360,7 +384,7 @@ ast_node_t *create_conditional(ast_node_t *condition, ast_node_t *true_expr, ast
 	node->data.conditional.true_expr = true_expr;
 	node->data.conditional.false_expr = false_expr;
 	// Result type will be filled in during type checking
-	node->data.conditional.result_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.conditional.result_type = create_type_info("int", 0, 0, NULL);
 	return node;
 }
 
@@ -396,7 +420,8 @@ ast_node_t *create_identifier(char *name)
 	ast_node_t *node = create_node(AST_IDENTIFIER);
 	node->data.identifier.name = name;
 	// Type will be filled in during symbol resolution
-	node->data.identifier.type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.identifier.type = create_type_info("int", 0, 0, NULL);
+	node->data.identifier.symbol = NULL;
 	return node;
 }
 
@@ -407,11 +432,11 @@ ast_node_t *create_number(int value)
 	return node;
 }
 
-ast_node_t *create_string_literal(char *value)
+ast_node_t *create_string_literal(char *value, int length)
 {
 	ast_node_t *node = create_node(AST_STRING_LITERAL);
 	node->data.string_literal.value = value;
-	node->data.string_literal.length = value ? strlen(value) : 0;
+	node->data.string_literal.length = length; // May contain NULs, so not strlen(value)
 	return node;
 }
 
@@ -427,6 +452,7 @@ ast_node_t *create_parameter(type_info_t type_info, char *name)
 	ast_node_t *node = create_node(AST_PARAMETER);
 	node->data.parameter.type_info = type_info;
 	node->data.parameter.name = name;
+	node->data.parameter.symbol = NULL;
 	return node;
 }
 
@@ -436,7 +462,7 @@ ast_node_t *create_address_of(ast_node_t *operand)
 	ast_node_t *node = create_node(AST_ADDRESS_OF);
 	node->data.address_of.operand = operand;
 	// Result type will be filled in during type checking
-	node->data.address_of.result_type = create_type_info(string_duplicate("int"), 1, 0, NULL);
+	node->data.address_of.result_type = create_type_info("int", 1, 0, NULL);
 	return node;
 }
 
@@ -445,7 +471,7 @@ ast_node_t *create_dereference(ast_node_t *operand)
 	ast_node_t *node = create_node(AST_DEREFERENCE);
 	node->data.dereference.operand = operand;
 	// Result type will be filled in during type checking
-	node->data.dereference.result_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.dereference.result_type = create_type_info("int", 0, 0, NULL);
 	return node;
 }
 
@@ -455,7 +481,7 @@ ast_node_t *create_array_access(ast_node_t *array, ast_node_t *index)
 	node->data.array_access.array = array;
 	node->data.array_access.index = index;
 	// Element type will be filled in during type checking
-	node->data.array_access.element_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.array_access.element_type = create_type_info("int", 0, 0, NULL);
 	return node;
 }
 
@@ -465,7 +491,7 @@ ast_node_t *create_member_access(ast_node_t *object, char *member)
 	node->data.member_access.object = object;
 	node->data.member_access.member = member;
 	// Member type and offset will be filled in during type checking
-	node->data.member_access.member_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.member_access.member_type = create_type_info("int", 0, 0, NULL);
 	node->data.member_access.member_offset = 0;
 	return node;
 }
@@ -476,7 +502,7 @@ ast_node_t *create_ptr_member_access(ast_node_t *object, char *member)
 	node->data.ptr_member_access.object = object;
 	node->data.ptr_member_access.member = member;
 	// Member type and offset will be filled in during type checking
-	node->data.ptr_member_access.member_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.ptr_member_access.member_type = create_type_info("int", 0, 0, NULL);
 	node->data.ptr_member_access.member_offset = 0;
 	return node;
 }
@@ -488,18 +514,14 @@ ast_node_t *create_initializer_list(ast_node_t **values, int count)
 	node->data.initializer_list.values = values;
 	node->data.initializer_list.count = count;
 	// Element type will be determined during type checking
-	node->data.initializer_list.element_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	node->data.initializer_list.element_type = create_type_info("int", 0, 0, NULL);
 	return node;
 }
 
 // Helper functions for struct/union/enum
 member_info_t *create_member_info(char *name, type_info_t type, int bit_field_size)
 {
-	member_info_t *member = malloc(sizeof(member_info_t));
-	if (!member) {
-		fprintf(stderr, "Memory allocation failed\n");
-		exit(1);
-	}
+	member_info_t *member = arena_alloc(&ast_arena, sizeof(member_info_t));
 	member->name = name;
 	member->type = type;
 	member->bit_field_size = bit_field_size;
@@ -510,11 +532,7 @@ member_info_t *create_member_info(char *name, type_info_t type, int bit_field_si
 
 enum_value_t *create_enum_value(char *name, int value)
 {
-	enum_value_t *enum_val = malloc(sizeof(enum_value_t));
-	if (!enum_val) {
-		fprintf(stderr, "Memory allocation failed\n");
-		exit(1);
-	}
+	enum_value_t *enum_val = arena_alloc(&ast_arena, sizeof(enum_value_t));
 	enum_val->name = name;
 	enum_val->value = value;
 	enum_val->value_expr = NULL;
@@ -524,11 +542,7 @@ enum_value_t *create_enum_value(char *name, int value)
 
 case_label_t *create_case_label(ast_node_t *value, char *label_name)
 {
-	case_label_t *label = malloc(sizeof(case_label_t));
-	if (!label) {
-		fprintf(stderr, "Memory allocation failed\n");
-		exit(1);
-	}
+	case_label_t *label = arena_alloc(&ast_arena, sizeof(case_label_t));
 	label->value = value;
 	label->label_name = label_name;
 	label->next = NULL;
@@ -540,6 +554,8 @@ type_info_t merge_declaration_specifiers(type_info_t base, declarator_t declarat
 {
 	type_info_t result = base;
 	result.pointer_level += declarator.pointer_level;
+	if (declarator.pointer_level > 0)
+		result.pointer_qualifiers = declarator.pointer_qualifiers;
 	result.is_array = declarator.is_array;
 	result.is_function = declarator.is_function;
 	result.array_size = declarator.array_size;
@@ -621,21 +637,21 @@ type_info_t perform_usual_arithmetic_conversions(type_info_t *type1, type_info_t
 	// Simplified version - promote to larger type
 	if (is_floating_type(type1) || is_floating_type(type2)) {
 		if (strcmp(type1->base_type, "double") == 0 || strcmp(type2->base_type, "double") == 0) {
-			return create_type_info(string_duplicate("double"), 0, 0, NULL);
+			return create_type_info("double", 0, 0, NULL);
 		}
-		return create_type_info(string_duplicate("float"), 0, 0, NULL);
+		return create_type_info("float", 0, 0, NULL);
 	}
 
 	if (is_integer_type(type1) && is_integer_type(type2)) {
 		// Promote to int or larger
 		if (strcmp(type1->base_type, "long") == 0 || strcmp(type2->base_type, "long") == 0) {
-			return create_type_info(string_duplicate("long"), 0, 0, NULL);
+			return create_type_info("long", 0, 0, NULL);
 		}
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 
 	// Default to int
-	return create_type_info(string_duplicate("int"), 0, 0, NULL);
+	return create_type_info("int", 0, 0, NULL);
 }
 
 type_info_t perform_integer_promotions(type_info_t *type)
@@ -646,7 +662,7 @@ type_info_t perform_integer_promotions(type_info_t *type)
 
 	// Promote char and short to int
 	if (strcmp(type->base_type, "char") == 0 || strcmp(type->base_type, "short") == 0) {
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 
 	return deep_copy_type_info(type);
@@ -688,288 +704,134 @@ int can_convert_to(type_info_t *from, type_info_t *to)
 }
 
 // Memory management functions
+// Type names and parameter lists are literals or arena memory, so this only
+// resets the fields
 void free_type_info(type_info_t *type_info)
 {
 	if (!type_info)
 		return;
 
-	if (type_info->base_type) {
-		free(type_info->base_type);
-		type_info->base_type = NULL;
-	}
-	if (type_info->param_types) {
-		for (int i = 0; i < type_info->param_count; i++) {
-			free_ast(type_info->param_types[i]);
-		}
-		free(type_info->param_types);
-		type_info->param_types = NULL;
-	}
+	type_info->base_type = NULL;
+	type_info->param_types = NULL;
 	type_info->param_count = 0;
-	// Don't free array_size - it's managed by AST
 	type_info->array_size = NULL;
 }
 
-void free_member_info(member_info_t *member)
-{
-	while (member) {
-		member_info_t *next = member->next;
-		free(member->name);
-		free_type_info(&member->type);
-		free_ast(member->bit_field_expr);
-		free(member);
-		member = next;
-	}
-}
+// Distinct expression types, shared by the nodes that have them. Entries
+// live in the AST arena.
+typedef struct expr_type_entry {
+	struct expr_type_entry *next;
+	size_t hash;
+	type_info_t type;
+} expr_type_entry_t;
 
-void free_enum_value(enum_value_t *value)
-{
-	while (value) {
-		enum_value_t *next = value->next;
-		free(value->name);
-		free_ast(value->value_expr);
-		free(value);
-		value = next;
-	}
-}
+static THREAD_LOCAL struct {
+	expr_type_entry_t **buckets;
+	size_t bucket_count;
+	size_t count;
+} expr_types;
 
-void free_case_label(case_label_t *label)
+static size_t type_info_hash(const type_info_t *type)
 {
-	while (label) {
-		case_label_t *next = label->next;
-		free_ast(label->value);
-		free(label->label_name);
-		free(label);
-		label = next;
-	}
+	size_t h = 14695981039346656037ULL;
+	for (const char *p = type->base_type ? type->base_type : ""; *p; p++)
+		h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+	h ^= (size_t)type->pointer_level * 31 + (size_t)type->is_array * 7 + (size_t)type->is_struct * 3 +
+	     (size_t)type->is_union * 5 + (size_t)type->is_enum * 11;
+	h ^= (size_t)(uintptr_t)type->array_size >> 4;
+	return h;
 }
 
-void free_ast(ast_node_t *node)
+static int type_info_equal(const type_info_t *a, const type_info_t *b)
 {
-	if (!node)
-		return;
-
-	switch (node->type) {
-	case AST_PROGRAM:
-		for (int i = 0; i < node->data.program.decl_count; i++) {
-			free_ast(node->data.program.declarations[i]);
+	if ((a->base_type == NULL) != (b->base_type == NULL))
+		return 0;
+	if (a->base_type != b->base_type && strcmp(a->base_type, b->base_type) != 0)
+		return 0;
+	return a->pointer_level == b->pointer_level && a->is_array == b->is_array && a->is_vla == b->is_vla &&
+	       a->is_function == b->is_function && a->is_struct == b->is_struct && a->is_union == b->is_union &&
+	       a->is_enum == b->is_enum && a->is_incomplete == b->is_incomplete &&
+	       a->storage_class == b->storage_class && a->qualifiers == b->qualifiers &&
+	       a->array_size == b->array_size && a->param_types == b->param_types &&
+	       a->param_count == b->param_count && a->is_variadic == b->is_variadic &&
+	       a->is_inline == b->is_inline;
+}
+
+// The shared, immutable copy of type
+static const type_info_t *intern_type_info(const type_info_t *type)
+{
+	size_t hash = type_info_hash(type);
+	if (expr_types.bucket_count > 0) {
+		for (expr_type_entry_t *e = expr_types.buckets[hash % expr_types.bucket_count]; e; e = e->next) {
+			if (e->hash == hash && type_info_equal(&e->type, type))
+				return &e->type;
 		}
-		free(node->data.program.declarations);
-		break;
+	}
 
-	case AST_FUNCTION:
-		free(node->data.function.name);
-		free_type_info(&node->data.function.return_type);
-		for (int i = 0; i < node->data.function.param_count; i++) {
-			free_ast(node->data.function.params[i]);
+	if (expr_types.count >= expr_types.bucket_count) {
+		size_t bucket_count = expr_types.bucket_count ? expr_types.bucket_count * 2 : 64;
+		expr_type_entry_t **buckets = calloc(bucket_count, sizeof(expr_type_entry_t *));
+		if (!buckets) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
 		}
-		free(node->data.function.params);
-		free_ast(node->data.function.body);
-		break;
-
-	case AST_COMPOUND_STMT:
-		for (int i = 0; i < node->data.compound.stmt_count; i++) {
-			free_ast(node->data.compound.statements[i]);
+		for (size_t i = 0; i < expr_types.bucket_count; i++) {
+			expr_type_entry_t *e = expr_types.buckets[i];
+			while (e) {
+				expr_type_entry_t *next = e->next;
+				e->next = buckets[e->hash % bucket_count];
+				buckets[e->hash % bucket_count] = e;
+				e = next;
+			}
 		}
-		free(node->data.compound.statements);
-		break;
+		free(expr_types.buckets);
+		expr_types.buckets = buckets;
+		expr_types.bucket_count = bucket_count;
+	}
 
-	case AST_DECLARATION:
-		free_type_info(&node->data.declaration.type_info);
-		free(node->data.declaration.name);
-		free_ast(node->data.declaration.init);
-		break;
+	expr_type_entry_t *entry = arena_alloc(&ast_arena, sizeof(expr_type_entry_t));
+	entry->hash = hash;
+	entry->type = *type;
+	entry->next = expr_types.buckets[hash % expr_types.bucket_count];
+	expr_types.buckets[hash % expr_types.bucket_count] = entry;
+	expr_types.count++;
+	return &entry->type;
+}
 
+static int is_expression(const ast_node_t *node)
+{
+	switch (node->type) {
 	case AST_ASSIGNMENT:
-		free(node->data.assignment.name);
-		free_ast(node->data.assignment.lvalue);
-		free_ast(node->data.assignment.value);
-		break;
-
-	case AST_IF_STMT:
-		free_ast(node->data.if_stmt.condition);
-		free_ast(node->data.if_stmt.then_stmt);
-		free_ast(node->data.if_stmt.else_stmt);
-		break;
-
-	case AST_WHILE_STMT:
-		free_ast(node->data.while_stmt.condition);
-		free_ast(node->data.while_stmt.body);
-		break;
-
-	case AST_FOR_STMT:
-		free_ast(node->data.for_stmt.init);
-		free_ast(node->data.for_stmt.condition);
-		free_ast(node->data.for_stmt.update);
-		free_ast(node->data.for_stmt.body);
-		break;
-
-	case AST_DO_WHILE_STMT:
-		free_ast(node->data.do_while_stmt.body);
-		free_ast(node->data.do_while_stmt.condition);
-		break;
-
-	case AST_SWITCH_STMT:
-		free_ast(node->data.switch_stmt.expression);
-		free_ast(node->data.switch_stmt.body);
-		free_case_label(node->data.switch_stmt.cases);
-		free(node->data.switch_stmt.default_label);
-		free(node->data.switch_stmt.break_label);
-		break;
-
-	case AST_CASE_STMT:
-		free_ast(node->data.case_stmt.value);
-		free_ast(node->data.case_stmt.statement);
-		free(node->data.case_stmt.label_name);
-		break;
-
-	case AST_DEFAULT_STMT:
-		free_ast(node->data.default_stmt.statement);
-		free(node->data.default_stmt.label_name);
-		break;
-
-	case AST_GOTO_STMT:
-		free(node->data.goto_stmt.label);
-		break;
-
-	case AST_LABEL_STMT:
-		free(node->data.label_stmt.label);
-		free_ast(node->data.label_stmt.statement);
-		break;
-
-	case AST_RETURN_STMT:
-		free_ast(node->data.return_stmt.value);
-		break;
-
 	case AST_CALL:
-		free(node->data.call.name);
-		for (int i = 0; i < node->data.call.arg_count; i++) {
-			free_ast(node->data.call.args[i]);
-		}
-		free(node->data.call.args);
-		free_type_info(&node->data.call.return_type);
-		break;
-
 	case AST_BINARY_OP:
-		free_ast(node->data.binary_op.left);
-		free_ast(node->data.binary_op.right);
-		free_type_info(&node->data.binary_op.result_type);
-		break;
-
 	case AST_UNARY_OP:
-		free_ast(node->data.unary_op.operand);
-		free_type_info(&node->data.unary_op.result_type);
-		break;
-
-	case AST_CONDITIONAL:
-		free_ast(node->data.conditional.condition);
-		free_ast(node->data.conditional.true_expr);
-		free_ast(node->data.conditional.false_expr);
-		free_type_info(&node->data.conditional.result_type);
-		break;
-
-	case AST_CAST:
-		free_type_info(&node->data.cast.target_type);
-		free_ast(node->data.cast.expression);
-		break;
-
-	case AST_SIZEOF:
-		if (!node->data.sizeof_op.is_type) {
-			free_ast(node->data.sizeof_op.operand);
-		}
-		break;
-
 	case AST_IDENTIFIER:
-		free(node->data.identifier.name);
-		free_type_info(&node->data.identifier.type);
-		break;
-
+	case AST_NUMBER:
 	case AST_STRING_LITERAL:
-		free(node->data.string_literal.value);
-		break;
-
-	case AST_PARAMETER:
-		free_type_info(&node->data.parameter.type_info);
-		free(node->data.parameter.name);
-		break;
-
-	case AST_EXPR_STMT:
-		free_ast(node->data.expr_stmt.expr);
-		break;
-
+	case AST_CHARACTER:
 	case AST_ADDRESS_OF:
-		free_ast(node->data.address_of.operand);
-		free_type_info(&node->data.address_of.result_type);
-		break;
-
 	case AST_DEREFERENCE:
-		free_ast(node->data.dereference.operand);
-		free_type_info(&node->data.dereference.result_type);
-		break;
-
 	case AST_ARRAY_ACCESS:
-		free_ast(node->data.array_access.array);
-		free_ast(node->data.array_access.index);
-		free_type_info(&node->data.array_access.element_type);
-		break;
-
-	case AST_ARRAY_DECL:
-		free_type_info(&node->data.array_decl.type_info);
-		free(node->data.array_decl.name);
-		free_ast(node->data.array_decl.size);
-		break;
-
-	case AST_STRUCT_DECL:
-		free(node->data.struct_decl.name);
-		free_member_info(node->data.struct_decl.members);
-		break;
-
-	case AST_UNION_DECL:
-		free(node->data.union_decl.name);
-		free_member_info(node->data.union_decl.members);
-		break;
-
-	case AST_ENUM_DECL:
-		free(node->data.enum_decl.name);
-		free_enum_value(node->data.enum_decl.values);
-		break;
-
 	case AST_MEMBER_ACCESS:
-		free_ast(node->data.member_access.object);
-		free(node->data.member_access.member);
-		free_type_info(&node->data.member_access.member_type);
-		break;
-
 	case AST_PTR_MEMBER_ACCESS:
-		free_ast(node->data.ptr_member_access.object);
-		free(node->data.ptr_member_access.member);
-		free_type_info(&node->data.ptr_member_access.member_type);
-		break;
-
-	case AST_INITIALIZER_LIST:
-		for (int i = 0; i < node->data.initializer_list.count; i++) {
-			free_ast(node->data.initializer_list.values[i]);
-		}
-		free(node->data.initializer_list.values);
-		free_type_info(&node->data.initializer_list.element_type);
-		break;
-
-	case AST_TYPEDEF:
-		free_type_info(&node->data.typedef_decl.type);
-		free(node->data.typedef_decl.name);
-		break;
-
-	case AST_NUMBER:
-	case AST_CHARACTER:
-	case AST_BREAK_STMT:
-	case AST_CONTINUE_STMT:
-	case AST_EMPTY_STMT:
+	case AST_CAST:
+	case AST_SIZEOF:
 	case AST_INCREMENT:
 	case AST_DECREMENT:
-		// No dynamic memory to free
-		break;
+	case AST_CONDITIONAL:
+	case AST_INITIALIZER_LIST:
+		return 1;
+	default:
+		return 0;
 	}
+}
 
-	free(node);
+// Releases every node, string and array built for the current translation unit
+void free_ast_arena(void)
+{
+	arena_release(&ast_arena);
+	free(expr_types.buckets);
+	memset(&expr_types, 0, sizeof(expr_types));
 }
 
 static void traverse_node(ast_node_t *node, symbol_table_t *table);
@@ -993,8 +855,29 @@ static void traverse_function(ast_node_t *node, symbol_table_t *table)
 		func_sym->is_function_defined = (node->data.function.body != NULL);
 		func_sym->param_count = node->data.function.param_count;
 		func_sym->is_variadic = node->data.function.is_variadic;
+	} else {
+		// Declared before; a prototype may still bring the parameter types
+		func_sym = find_symbol_in_scope(table->global_scope, node->data.function.name);
+		if (func_sym && func_sym->sym_type != SYM_FUNCTION)
+			func_sym = NULL;
+	}
+
+	// Calls convert their arguments to the types the first prototype or
+	// definition gives
+	if (func_sym && !func_sym->param_symbols &&
+	    node->data.function.param_count > 0) {
+		func_sym->param_symbols = malloc(sizeof(ast_node_t *) * node->data.function.param_count);
+		if (!func_sym->param_symbols) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		memcpy(func_sym->param_symbols, node->data.function.params,
+		       sizeof(ast_node_t *) * node->data.function.param_count);
 	}
 
+	// Local names are numbered per function, as code generation expects
+	int saved_counter = table->temp_counter;
+	table->temp_counter = 0;
 	enter_scope(table);
 	set_current_function(table, node->data.function.name);
 
@@ -1020,18 +903,34 @@ static void traverse_function(ast_node_t *node, symbol_table_t *table)
 			continue;
 		}
 
-		if (add_symbol(table, name, SYM_VARIABLE, param_type) == NULL) {
+		symbol_t *param_sym = add_symbol(table, name, SYM_VARIABLE, param_type);
+		if (param_sym == NULL) {
 			fprintf(stderr, "Semantic Error: Redeclaration of parameter '%s' in function '%s' at line %d\n",
 				name, node->data.function.name ? node->data.function.name : "(anon)",
-				param->line_number);
+				node_line(param));
 			error_count++;
+			continue;
 		}
+		param_sym->is_parameter = 1;
+		if (param->type == AST_PARAMETER)
+			param->data.parameter.symbol = param_sym;
+		else
+			param->data.declaration.symbol = param_sym;
 	}
 
 	traverse_node(node->data.function.body, table);
 
 	set_current_function(table, NULL);
 	exit_scope(table);
+	table->temp_counter = saved_counter;
+}
+
+// Selection and iteration bodies are blocks of their own (C99 6.8.4, 6.8.5)
+static void traverse_scoped(ast_node_t *node, symbol_table_t *table)
+{
+	enter_scope(table);
+	traverse_node(node, table);
+	exit_scope(table);
 }
 
 static void traverse_compound_statement(ast_node_t *node, symbol_table_t *table)
@@ -1055,7 +954,9 @@ static void traverse_declaration(ast_node_t *node, symbol_table_t *table)
 		traverse_node(node->data.declaration.init, table);
 	}
 
-	if (add_symbol(table, node->data.declaration.name, SYM_VARIABLE, node->data.declaration.type_info) == NULL) {
+	node->data.declaration.symbol =
+		add_symbol(table, node->data.declaration.name, SYM_VARIABLE, node->data.declaration.type_info);
+	if (node->data.declaration.symbol == NULL) {
 		error_count++;
 	}
 }
@@ -1067,9 +968,20 @@ static void traverse_array_declaration(ast_node_t *node, symbol_table_t *table)
 
 	if (node->data.array_decl.size && node->data.array_decl.is_vla) {
 		traverse_node(node->data.array_decl.size, table);
+
+		// int a[N * 2] with N an enum constant has a fixed size after all
+		long long size;
+		if (evaluate_constant(node->data.array_decl.size, table, &size) && size > 0) {
+			node->data.array_decl.size = create_number((int)size);
+			node->data.array_decl.type_info.array_size = node->data.array_decl.size;
+			node->data.array_decl.type_info.is_vla = 0;
+			node->data.array_decl.is_vla = 0;
+		}
 	}
 
-	if (add_symbol(table, node->data.array_decl.name, SYM_VARIABLE, node->data.array_decl.type_info) == NULL) {
+	node->data.array_decl.symbol =
+		add_symbol(table, node->data.array_decl.name, SYM_VARIABLE, node->data.array_decl.type_info);
+	if (node->data.array_decl.symbol == NULL) {
 		error_count++;
 	}
 }
@@ -1080,7 +992,7 @@ static void traverse_struct_decl(ast_node_t *node, symbol_table_t *table)
 		return;
 
 	if (node->data.struct_decl.is_definition) {
-		type_info_t struct_type = create_type_info(string_duplicate(node->data.struct_decl.name), 0, 0, NULL);
+		type_info_t struct_type = create_type_info(node->data.struct_decl.name, 0, 0, NULL);
 		struct_type.is_struct = 1;
 
 		symbol_t *struct_sym = add_symbol(table, node->data.struct_decl.name, SYM_STRUCT, struct_type);
@@ -1109,7 +1021,7 @@ static void traverse_union_decl(ast_node_t *node, symbol_table_t *table)
 		return;
 
 	if (node->data.union_decl.is_definition) {
-		type_info_t union_type = create_type_info(string_duplicate(node->data.union_decl.name), 0, 0, NULL);
+		type_info_t union_type = create_type_info(node->data.union_decl.name, 0, 0, NULL);
 		union_type.is_union = 1;
 
 		symbol_t *union_sym = add_symbol(table, node->data.union_decl.name, SYM_UNION, union_type);
@@ -1138,7 +1050,7 @@ static void traverse_enum_decl(ast_node_t *node, symbol_table_t *table)
 		return;
 
 	if (node->data.enum_decl.is_definition) {
-		type_info_t enum_type = create_type_info(string_duplicate(node->data.enum_decl.name), 0, 0, NULL);
+		type_info_t enum_type = create_type_info(node->data.enum_decl.name, 0, 0, NULL);
 		enum_type.is_enum = 1;
 
 		add_symbol(table, node->data.enum_decl.name, SYM_ENUM, enum_type);
@@ -1149,7 +1061,9 @@ static void traverse_enum_decl(ast_node_t *node, symbol_table_t *table)
 		while (value) {
 			if (value->value_expr) {
 				traverse_node(value->value_expr, table);
-				// TODO: evaluate constant expression
+				long long folded;
+				if (evaluate_constant(value->value_expr, table, &folded))
+					value->value = (int)folded;
 				current_value = value->value;
 			} else {
 				value->value = current_value;
@@ -1179,10 +1093,11 @@ static void traverse_identifier(ast_node_t *node, symbol_table_t *table)
 	if (!node)
 		return;
 
-	symbol_t *symbol = find_symbol(table, node->data.identifier.name);
+	symbol_t *symbol = find_symbol_interned(table, node->data.identifier.name);
+	node->data.identifier.symbol = symbol;
 	if (symbol == NULL) {
 		fprintf(stderr, "Semantic Error: Use of undeclared identifier '%s' at line %d\n",
-			node->data.identifier.name, node->line_number);
+			node->data.identifier.name, node_line(node));
 		error_count++;
 	} else {
 		free_type_info(&node->data.identifier.type);
@@ -1196,10 +1111,11 @@ static void traverse_assignment(ast_node_t *node, symbol_table_t *table)
 		return;
 
 	if (node->data.assignment.name) {
-		symbol_t *sym = find_symbol(table, node->data.assignment.name);
+		symbol_t *sym = find_symbol_interned(table, node->data.assignment.name);
+		node->data.assignment.symbol = sym;
 		if (!sym) {
 			fprintf(stderr, "Semantic Error: Assignment to undeclared variable '%s' at line %d\n",
-				node->data.assignment.name, node->line_number);
+				node->data.assignment.name, node_line(node));
 			error_count++;
 		}
 	} else if (node->data.assignment.lvalue) {
@@ -1213,7 +1129,7 @@ static void traverse_assignment(ast_node_t *node, symbol_table_t *table)
 		type_info_t rvalue_type = get_expression_type(node->data.assignment.value, table);
 
 		if (is_integer_type(&lvalue_type) && rvalue_type.pointer_level > 0) {
-			fprintf(stderr, "Semantic Error: Assigning pointer to integer at line %d\n", node->line_number);
+			fprintf(stderr, "Semantic Error: Assigning pointer to integer at line %d\n", node_line(node));
 			error_count++;
 		}
 
@@ -1227,14 +1143,15 @@ static void traverse_call(ast_node_t *node, symbol_table_t *table)
 	if (!node)
 		return;
 
-	symbol_t *func_sym = find_symbol(table, node->data.call.name);
+	symbol_t *func_sym = find_symbol_interned(table, node->data.call.name);
+	node->data.call.symbol = func_sym;
 	if (!func_sym) {
 		fprintf(stderr, "Semantic Error: Call to undeclared function '%s' at line %d\n", node->data.call.name,
-			node->line_number);
+			node_line(node));
 		error_count++;
 	} else if (func_sym->sym_type != SYM_FUNCTION) {
 		fprintf(stderr, "Semantic Error: '%s' is not a function at line %d\n", node->data.call.name,
-			node->line_number);
+			node_line(node));
 		error_count++;
 	} else {
 		// Check argument count for non-variadic functions
@@ -1243,7 +1160,7 @@ static void traverse_call(ast_node_t *node, symbol_table_t *table)
 				fprintf(stderr,
 					"Semantic Error: Function '%s' expects %d arguments, got %d at line %d\n",
 					node->data.call.name, func_sym->param_count, node->data.call.arg_count,
-					node->line_number);
+					node_line(node));
 				error_count++;
 			}
 		} else {
@@ -1252,7 +1169,7 @@ static void traverse_call(ast_node_t *node, symbol_table_t *table)
 				fprintf(stderr,
 					"Semantic Error: Variadic function '%s' expects at least %d arguments, got %d at line %d\n",
 					node->data.call.name, func_sym->param_count, node->data.call.arg_count,
-					node->line_number);
+					node_line(node));
 				error_count++;
 			}
 		}
@@ -1280,9 +1197,9 @@ static void traverse_binary_op(ast_node_t *node, symbol_table_t *table)
 	free_type_info(&node->data.binary_op.result_type);
 
 	if (node->data.binary_op.op >= OP_EQ && node->data.binary_op.op <= OP_GE) {
-		node->data.binary_op.result_type = create_type_info(string_duplicate("_Bool"), 0, 0, NULL);
+		node->data.binary_op.result_type = create_type_info("_Bool", 0, 0, NULL);
 	} else if (node->data.binary_op.op == OP_LAND || node->data.binary_op.op == OP_LOR) {
-		node->data.binary_op.result_type = create_type_info(string_duplicate("_Bool"), 0, 0, NULL);
+		node->data.binary_op.result_type = create_type_info("_Bool", 0, 0, NULL);
 	} else {
 		node->data.binary_op.result_type = perform_usual_arithmetic_conversions(&left_type, &right_type);
 	}
@@ -1303,7 +1220,7 @@ static void traverse_unary_op(ast_node_t *node, symbol_table_t *table)
 	free_type_info(&node->data.unary_op.result_type);
 
 	if (node->data.unary_op.op == OP_NOT) {
-		node->data.unary_op.result_type = create_type_info(string_duplicate("_Bool"), 0, 0, NULL);
+		node->data.unary_op.result_type = create_type_info("_Bool", 0, 0, NULL);
 	} else {
 		node->data.unary_op.result_type = perform_integer_promotions(&operand_type);
 	}
@@ -1359,7 +1276,7 @@ static void traverse_dereference(ast_node_t *node, symbol_table_t *table)
 	if (node->data.dereference.result_type.pointer_level > 0) {
 		node->data.dereference.result_type.pointer_level--;
 	} else {
-		fprintf(stderr, "Semantic Error: Dereferencing non-pointer type at line %d\n", node->line_number);
+		fprintf(stderr, "Semantic Error: Dereferencing non-pointer type at line %d\n", node_line(node));
 		error_count++;
 	}
 }
@@ -1382,7 +1299,7 @@ static void traverse_array_access(ast_node_t *node, symbol_table_t *table)
 	} else if (node->data.array_access.element_type.pointer_level > 0) {
 		node->data.array_access.element_type.pointer_level--;
 	} else {
-		fprintf(stderr, "Semantic Error: Array subscript on non-array/pointer at line %d\n", node->line_number);
+		fprintf(stderr, "Semantic Error: Array subscript on non-array/pointer at line %d\n", node_line(node));
 		error_count++;
 	}
 }
@@ -1397,7 +1314,7 @@ static void traverse_member_access(ast_node_t *node, symbol_table_t *table)
 	type_info_t object_type = get_expression_type(node->data.member_access.object, table);
 
 	if (!object_type.is_struct && !object_type.is_union) {
-		fprintf(stderr, "Semantic Error: Member access on non-struct/union at line %d\n", node->line_number);
+		fprintf(stderr, "Semantic Error: Member access on non-struct/union at line %d\n", node_line(node));
 		error_count++;
 		free_type_info(&object_type);
 		return;
@@ -1406,7 +1323,7 @@ static void traverse_member_access(ast_node_t *node, symbol_table_t *table)
 	symbol_t *struct_sym = find_symbol(table, object_type.base_type);
 	if (!struct_sym) {
 		fprintf(stderr, "Semantic Error: Unknown struct/union type '%s' at line %d\n", object_type.base_type,
-			node->line_number);
+			node_line(node));
 		error_count++;
 		free_type_info(&object_type);
 		return;
@@ -1415,7 +1332,7 @@ static void traverse_member_access(ast_node_t *node, symbol_table_t *table)
 	symbol_t *member = find_struct_member(struct_sym, node->data.member_access.member);
 	if (!member) {
 		fprintf(stderr, "Semantic Error: No member '%s' in struct/union '%s' at line %d\n",
-			node->data.member_access.member, object_type.base_type, node->line_number);
+			node->data.member_access.member, object_type.base_type, node_line(node));
 		error_count++;
 		free_type_info(&object_type);
 		return;
@@ -1438,7 +1355,7 @@ static void traverse_ptr_member_access(ast_node_t *node, symbol_table_t *table)
 	type_info_t object_type = get_expression_type(node->data.ptr_member_access.object, table);
 
 	if (object_type.pointer_level == 0) {
-		fprintf(stderr, "Semantic Error: Pointer member access on non-pointer at line %d\n", node->line_number);
+		fprintf(stderr, "Semantic Error: Pointer member access on non-pointer at line %d\n", node_line(node));
 		error_count++;
 		free_type_info(&object_type);
 		return;
@@ -1446,7 +1363,7 @@ static void traverse_ptr_member_access(ast_node_t *node, symbol_table_t *table)
 
 	if (!object_type.is_struct && !object_type.is_union) {
 		fprintf(stderr, "Semantic Error: Pointer member access on pointer to non-struct/union at line %d\n",
-			node->line_number);
+			node_line(node));
 		error_count++;
 		free_type_info(&object_type);
 		return;
@@ -1455,7 +1372,7 @@ static void traverse_ptr_member_access(ast_node_t *node, symbol_table_t *table)
 	symbol_t *struct_sym = find_symbol(table, object_type.base_type);
 	if (!struct_sym) {
 		fprintf(stderr, "Semantic Error: Unknown struct/union type '%s' at line %d\n", object_type.base_type,
-			node->line_number);
+			node_line(node));
 		error_count++;
 		free_type_info(&object_type);
 		return;
@@ -1464,7 +1381,7 @@ static void traverse_ptr_member_access(ast_node_t *node, symbol_table_t *table)
 	symbol_t *member = find_struct_member(struct_sym, node->data.ptr_member_access.member);
 	if (!member) {
 		fprintf(stderr, "Semantic Error: No member '%s' in struct/union '%s' at line %d\n",
-			node->data.ptr_member_access.member, object_type.base_type, node->line_number);
+			node->data.ptr_member_access.member, object_type.base_type, node_line(node));
 		error_count++;
 		free_type_info(&object_type);
 		return;
@@ -1491,7 +1408,7 @@ static void traverse_return_stmt(ast_node_t *node, symbol_table_t *table)
 
 			if (!can_convert_to(&return_type, &func->type_info)) {
 				fprintf(stderr, "Semantic Warning: Return type mismatch at line %d\n",
-					node->line_number);
+					node_line(node));
 			}
 
 			free_type_info(&return_type);
@@ -1507,7 +1424,7 @@ static void traverse_label_stmt(ast_node_t *node, symbol_table_t *table)
 	symbol_t *label = add_label(table, node->data.label_stmt.label);
 	if (!label) {
 		fprintf(stderr, "Semantic Error: Label '%s' already defined at line %d\n", node->data.label_stmt.label,
-			node->line_number);
+			node_line(node));
 		error_count++;
 	}
 
@@ -1528,6 +1445,61 @@ static void traverse_goto_stmt(ast_node_t *node, symbol_table_t *table)
 	}
 }
 
+// Case values seen so far in the innermost switch being checked
+typedef struct case_values {
+	long long *values;
+	size_t count;
+	size_t capacity;
+} case_values_t;
+
+static THREAD_LOCAL case_values_t *current_cases;
+
+static void traverse_switch_stmt(ast_node_t *node, symbol_table_t *table)
+{
+	case_values_t cases = {0};
+	case_values_t *outer = current_cases;
+
+	traverse_node(node->data.switch_stmt.expression, table);
+	current_cases = &cases;
+	traverse_node(node->data.switch_stmt.body, table);
+	current_cases = outer;
+	free(cases.values);
+}
+
+static void traverse_case_stmt(ast_node_t *node, symbol_table_t *table)
+{
+	traverse_node(node->data.case_stmt.value, table);
+
+	long long value;
+	if (!evaluate_constant(node->data.case_stmt.value, table, &value)) {
+		fprintf(stderr, "Semantic Error: Case label does not reduce to an integer constant at line %d\n",
+			node_line(node));
+		error_count++;
+	} else if (current_cases) {
+		size_t i;
+		for (i = 0; i < current_cases->count && current_cases->values[i] != value; i++)
+			;
+		if (i < current_cases->count) {
+			fprintf(stderr, "Semantic Error: Duplicate case value %lld at line %d\n", value, node_line(node));
+			error_count++;
+		} else {
+			if (current_cases->count == current_cases->capacity) {
+				size_t capacity = current_cases->capacity ? current_cases->capacity * 2 : 16;
+				long long *values = realloc(current_cases->values, capacity * sizeof(*values));
+				if (!values) {
+					fprintf(stderr, "Memory allocation failed\n");
+					exit(1);
+				}
+				current_cases->values = values;
+				current_cases->capacity = capacity;
+			}
+			current_cases->values[current_cases->count++] = value;
+		}
+	}
+
+	traverse_node(node->data.case_stmt.statement, table);
+}
+
 static void traverse_node(ast_node_t *node, symbol_table_t *table)
 {
 	if (!node)
@@ -1568,12 +1540,13 @@ static void traverse_node(ast_node_t *node, symbol_table_t *table)
 	// --- Statements (Control Flow) ---
 	case AST_IF_STMT:
 		traverse_node(node->data.if_stmt.condition, table);
-		traverse_node(node->data.if_stmt.then_stmt, table);
-		traverse_node(node->data.if_stmt.else_stmt, table);
+		traverse_scoped(node->data.if_stmt.then_stmt, table);
+		if (node->data.if_stmt.else_stmt)
+			traverse_scoped(node->data.if_stmt.else_stmt, table);
 		break;
 	case AST_WHILE_STMT:
 		traverse_node(node->data.while_stmt.condition, table);
-		traverse_node(node->data.while_stmt.body, table);
+		traverse_scoped(node->data.while_stmt.body, table);
 		break;
 	case AST_FOR_STMT:
 		enter_scope(table); // for-loops have their own scope for init
@@ -1584,16 +1557,14 @@ static void traverse_node(ast_node_t *node, symbol_table_t *table)
 		exit_scope(table);
 		break;
 	case AST_DO_WHILE_STMT:
-		traverse_node(node->data.do_while_stmt.body, table);
+		traverse_scoped(node->data.do_while_stmt.body, table);
 		traverse_node(node->data.do_while_stmt.condition, table);
 		break;
 	case AST_SWITCH_STMT:
-		traverse_node(node->data.switch_stmt.expression, table);
-		traverse_node(node->data.switch_stmt.body, table);
+		traverse_switch_stmt(node, table);
 		break;
 	case AST_CASE_STMT:
-		traverse_node(node->data.case_stmt.value, table);
-		traverse_node(node->data.case_stmt.statement, table);
+		traverse_case_stmt(node, table);
 		break;
 	case AST_DEFAULT_STMT:
 		traverse_node(node->data.default_stmt.statement, table);
@@ -1639,11 +1610,8 @@ static void traverse_node(ast_node_t *node, symbol_table_t *table)
 		if (!node->data.sizeof_op.is_type) {
 			traverse_node(node->data.sizeof_op.operand, table);
 		}
-		// Calculate size
-		if (node->data.sizeof_op.is_type) {
-			// Size is based on type - would need type info
-			node->data.sizeof_op.size_value = 4; // placeholder
-		} else {
+		// sizeof(type) was sized by the parser, which still had the type
+		if (!node->data.sizeof_op.is_type) {
 			type_info_t expr_type = get_expression_type(node->data.sizeof_op.operand, table);
 			node->data.sizeof_op.size_value = calculate_type_size(&expr_type, table);
 			free_type_info(&expr_type);
@@ -1685,6 +1653,13 @@ static void traverse_node(ast_node_t *node, symbol_table_t *table)
 		fprintf(stderr, "Warning: Unhandled AST node type in traversal: %d\n", node->type);
 		break;
 	}
+
+	// Children are typed first, so each node's type is computed once, from
+	// its operands' memoized ones
+	if (is_expression(node) && !node->expr_type) {
+		type_info_t type = get_expression_type(node, table);
+		node->expr_type = intern_type_info(&type);
+	}
 }
 
 int check_types(ast_node_t *ast, symbol_table_t *table)
@@ -1692,6 +1667,9 @@ int check_types(ast_node_t *ast, symbol_table_t *table)
 	if (!ast || !table)
 		return 0;
 
+	// Nodes keep pointers to the symbols they resolve to, so symbols outlive
+	// their scopes until the table is destroyed
+	table->retain_symbols = 1;
 	traverse_node(ast, table);
 
 	return error_count == 0;
@@ -4,9 +4,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "arena.h"
+#include "common.h"
+#include "source.h"
 
-// Forward declaration to avoid circular dependency
+// Forward declarations to avoid circular dependency
 struct symbol_table;
+struct symbol;
 
 // AST Node Types - Complete implementation
 typedef enum {
@@ -122,7 +126,7 @@ struct ast_node;
 
 // Enhanced type information structure
 typedef struct {
-	char *base_type;   // int, char, void, struct_name, etc.
+	const char *base_type; // int, char, void, struct_name, etc. (literal or arena-owned)
 	int pointer_level; // number of * in declaration
 	int is_array;
 	int is_vla;      // variable length array
@@ -132,17 +136,20 @@ typedef struct {
 	int is_enum;
 	int is_incomplete; // for forward declarations
 	storage_class_t storage_class;
-	type_qualifier_t qualifiers;
+	type_qualifier_t qualifiers;         // Of the base type: what the pointers finally point to
+	type_qualifier_t pointer_qualifiers; // Of the declared pointer itself, as in int *restrict p
 	struct ast_node *array_size;
 	struct ast_node **param_types; // for function types
 	int param_count;
 	int is_variadic; // for variadic functions
+	int is_inline;   // declared with the inline function specifier
 } type_info_t;
 
 // Declarator information (used in parser)
 typedef struct {
 	char *name;
 	int pointer_level;
+	type_qualifier_t pointer_qualifiers; // Of the last *, the one nearest the name
 	int is_array;
 	int is_function;
 	struct ast_node *array_size;
@@ -178,8 +185,8 @@ typedef struct case_label {
 // AST Node structure - Complete implementation
 typedef struct ast_node {
 	ast_node_type_t type;
-	int line_number;
-	int column;
+	unsigned int offset; // Where the parser stood in the source, see node_line()
+	const type_info_t *expr_type; // Set by check_types(), shared and immutable
 
 	union {
 		struct {
@@ -196,6 +203,7 @@ typedef struct ast_node {
 			storage_class_t storage_class;
 			int is_variadic;
 			int is_defined; // vs just declared
+			int is_inline;
 		} function;
 
 		struct {
@@ -208,6 +216,7 @@ typedef struct ast_node {
 			char *name;
 			struct ast_node *init;
 			int is_parameter;
+			struct symbol *symbol; // Bound by check_types()
 		} declaration;
 
 		struct {
@@ -215,6 +224,7 @@ typedef struct ast_node {
 			struct ast_node *lvalue;
 			struct ast_node *value;
 			binary_op_t op; // for compound assignments like +=
+			struct symbol *symbol; // Target of a plain name assignment
 		} assignment;
 
 		struct {
@@ -277,6 +287,7 @@ typedef struct ast_node {
 			struct ast_node **args;
 			int arg_count;
 			type_info_t return_type; // for type checking
+			struct symbol *symbol; // Callee, bound by check_types()
 		} call;
 
 		struct {
@@ -295,6 +306,7 @@ typedef struct ast_node {
 		struct {
 			char *name;
 			type_info_t type; // resolved type information
+			struct symbol *symbol; // Declaration in scope, bound by check_types()
 		} identifier;
 
 		struct {
@@ -313,6 +325,7 @@ typedef struct ast_node {
 		struct {
 			type_info_t type_info;
 			char *name;
+			struct symbol *symbol;
 		} parameter;
 
 		struct {
@@ -340,6 +353,8 @@ typedef struct ast_node {
 			char *name;
 			struct ast_node *size;
 			int is_vla;
+			int has_init; // Had an initializer, which is not kept: the array starts zeroed
+			struct symbol *symbol;
 		} array_decl;
 
 		struct {
@@ -414,7 +429,7 @@ typedef struct ast_node {
 } ast_node_t;
 
 // Function prototypes for AST creation
-type_info_t create_type_info(char *base_type, int pointer_level, int is_array, ast_node_t *array_size);
+type_info_t create_type_info(const char *base_type, int pointer_level, int is_array, ast_node_t *array_size);
 declarator_t make_declarator(char *name, int pointer_level, int is_array, ast_node_t *array_size);
 
 void print_ast(struct ast_node *node, int indent);
@@ -464,7 +479,7 @@ ast_node_t *create_sizeof_type(type_info_t type);
 // Primary expressions
 ast_node_t *create_identifier(char *name);
 ast_node_t *create_number(int value);
-ast_node_t *create_string_literal(char *value);
+ast_node_t *create_string_literal(char *value, int length);
 ast_node_t *create_character(char value);
 ast_node_t *create_parameter(type_info_t type_info, char *name);
 
@@ -501,11 +516,9 @@ type_info_t perform_integer_promotions(type_info_t *type);
 int can_convert_to(type_info_t *from, type_info_t *to);
 
 // Memory management
-void free_ast(ast_node_t *node);
+// All AST memory lives in ast_arena and is released in one call
+void free_ast_arena(void);
 void free_type_info(type_info_t *type_info);
-void free_member_info(member_info_t *member);
-void free_enum_value(enum_value_t *value);
-void free_case_label(case_label_t *label);
 
 #define CLEANUP_TYPE_INFO(var) \
     do { free_type_info(&(var)); } while(0)
@@ -518,19 +531,63 @@ static inline void cleanup_type_wrapper(type_info_t *t)
 }
 
 // Code generation
+typedef enum {
+	SWITCH_LOWER_AUTO,  // Jump table when the cases are dense, LLVM switch otherwise
+	SWITCH_LOWER_TABLE, // Jump table whenever the case range allows it
+	SWITCH_LOWER_TREE,  // Binary search over the sorted case values
+	SWITCH_LOWER_LLVM   // Plain LLVM switch, lowered by the backend
+} switch_lowering_t;
+
+typedef struct {
+	int unbuffered_ir; // Write IR through stdio call by call instead of the IR buffer
+	switch_lowering_t switch_lowering;
+	int no_mem2reg; // Keep locals in allocas instead of promoting them to registers
+	int threads;    // Threads generating function bodies, 0 for one per CPU
+	int inline_threshold; // Largest body, in instructions, inlined at a call site; 0 disables inlining
+	int verbose;          // Report on stdout which functions were inlined
+	int no_dce;           // Keep static functions and globals that nothing refers to
+} codegen_options_t;
+
+extern codegen_options_t codegen_options;
+
+// Expects an AST that went through check_types(), whose symbol bindings
+// (and symbol table) must stay alive until this returns
 void generate_llvm_ir(ast_node_t *ast, FILE *output);
 
+// Static functions and globals left out of the IR because nothing live
+// refers to them
+size_t dropped_definition_count(void);
+
 // Type checking and semantic analysis
 int check_types(ast_node_t *ast, struct symbol_table *table);
 int check_expression_types(ast_node_t *expr, struct symbol_table *table);
 int check_statement_types(ast_node_t *stmt, struct symbol_table *table);
 
-// External references
-extern FILE *yyin;
-extern int yyparse();
-extern ast_node_t *ast_root;
-extern int error_count;
-extern int line_number;
-extern int column;
+// State of one parse of one source file. The scanner and the parser are
+// reentrant and keep everything they track here, so separate threads can
+// parse separate files.
+typedef struct {
+	ast_node_t *root;
+	struct symbol_table *symbols; // Receives struct, union and enum declarations
+	int error_count;              // Syntax errors
+	int lex_error_count;
+	source_t *source; // Scanned in place; string literals may point into it
+	size_t offset;    // End of the last token scanned
+} parse_context_t;
+
+// Parses source into context->root; returns the yyparse() result. The AST
+// may point into source->text, so the source must outlive it.
+int parse_source(source_t *source, parse_context_t *context);
+
+// Nodes are allocated by the thread that builds them and are stamped with
+// the offset its scanner has reached in ast_source
+extern THREAD_LOCAL arena_t ast_arena;
+extern THREAD_LOCAL size_t ast_offset;
+extern THREAD_LOCAL source_t *ast_source;
+
+// Source line of a node, for diagnostics
+int node_line(const ast_node_t *node);
+// Semantic errors found by the checks above on this thread
+extern THREAD_LOCAL int error_count;
 
 #endif
@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+#include "attrs.h"
+#include "ir_text.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Where a pointer value may come from, as a bit set: memory local to the
+// call (allocas), anything else the caller could see (globals, loaded or
+// returned pointers), or one of the first PARAM_LIMIT parameters
+#define FROM_LOCAL 1ull
+#define FROM_OTHER 2ull
+#define FROM_PARAM(i) (4ull << (i))
+#define PARAM_LIMIT 62
+#define PARAM_BITS (~(FROM_LOCAL | FROM_OTHER))
+
+// Open-addressing map from value names to their origins
+typedef struct {
+	slice_t *keys;
+	unsigned long long *origins;
+	size_t cap;
+	size_t count;
+} origin_map_t;
+
+static void *xcalloc(size_t count, size_t size)
+{
+	void *p = calloc(count, size);
+	if (!p) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	return p;
+}
+
+static unsigned long long *map_slot(origin_map_t *map, slice_t key, int add);
+
+static void map_grow(origin_map_t *map)
+{
+	origin_map_t old = *map;
+	map->cap = old.cap ? old.cap * 2 : 64;
+	map->keys = xcalloc(map->cap, sizeof(slice_t));
+	map->origins = xcalloc(map->cap, sizeof(unsigned long long));
+	map->count = 0;
+	for (size_t i = 0; i < old.cap; i++) {
+		if (old.keys[i].ptr)
+			*map_slot(map, old.keys[i], 1) = old.origins[i];
+	}
+	free(old.keys);
+	free(old.origins);
+}
+
+// Origins of a name; NULL when it is not mapped and add is not set
+static unsigned long long *map_slot(origin_map_t *map, slice_t key, int add)
+{
+	if (add && (map->count + 1) * 2 > map->cap)
+		map_grow(map);
+	if (!map->cap)
+		return NULL;
+	size_t i = hash_slice(key) & (map->cap - 1);
+	for (; map->keys[i].ptr; i = (i + 1) & (map->cap - 1)) {
+		if (slice_eq(map->keys[i], key))
+			return &map->origins[i];
+	}
+	if (!add)
+		return NULL;
+	map->keys[i] = key;
+	map->count++;
+	return &map->origins[i];
+}
+
+// Origins of every %name and @name operand in [p, end). Names that are not
+// values (types, labels) contribute nothing.
+static unsigned long long operand_origins(origin_map_t *map, const char *p, const char *end)
+{
+	unsigned long long origins = 0;
+	while (p < end) {
+		char sigil = *p++;
+		if ((sigil != '%' && sigil != '@') || p >= end || !is_name_char(*p))
+			continue;
+		slice_t name = {p, 0};
+		while (p < end && is_name_char(*p))
+			p++;
+		name.len = (size_t)(p - name.ptr);
+		if (sigil == '@') {
+			origins |= FROM_OTHER;
+			continue;
+		}
+		unsigned long long *slot = map_slot(map, name, 0);
+		if (slot)
+			origins |= *slot;
+	}
+	return origins;
+}
+
+// Start of the last operand of the line: the address of a load or store
+static const char *last_operand(slice_t line)
+{
+	const char *p = line.ptr + line.len;
+	while (p > line.ptr && p[-1] != ' ')
+		p--;
+	return p;
+}
+
+// Instructions whose result is never a pointer
+static const char *const scalar_ops[] = {
+	"add ",    "sub ",   "mul ",    "sdiv ",   "udiv ",   "srem ",   "urem ",   "shl ",   "lshr ",
+	"ashr ",   "and ",   "or ",     "xor ",    "icmp ",   "fcmp ",   "fadd ",   "fsub ",  "fmul ",
+	"fdiv ",   "frem ",  "fneg ",   "sext ",   "zext ",   "trunc ",  "fptosi ", "fptoui ", "sitofp ",
+	"uitofp ", "fpext ", "fptrunc ", "ptrtoint ",
+};
+
+static int is_scalar_op(slice_t op)
+{
+	for (size_t i = 0; i < sizeof(scalar_ops) / sizeof(scalar_ops[0]); i++) {
+		if (starts_with(op, scalar_ops[i]))
+			return 1;
+	}
+	return 0;
+}
+
+// Instructions that only compute an address from their operands
+static int is_address_op(slice_t op)
+{
+	return starts_with(op, "getelementptr ") || starts_with(op, "bitcast ") || starts_with(op, "phi ") ||
+	       starts_with(op, "select ");
+}
+
+// Origins of the value an instruction defines
+static unsigned long long result_origins(origin_map_t *map, slice_t op)
+{
+	if (starts_with(op, "alloca "))
+		return FROM_LOCAL;
+	if (is_address_op(op))
+		return operand_origins(map, op.ptr, op.ptr + op.len);
+	if (starts_with(op, "load ")) {
+		// Only a loaded pointer has an origin, and it is unknown
+		const char *comma = memchr(op.ptr, ',', op.len);
+		return comma && comma[-1] == '*' ? FROM_OTHER : 0;
+	}
+	if (is_scalar_op(op))
+		return 0;
+	return FROM_OTHER;
+}
+
+// One line of the body: "%name = <op>" or "<op>", with its leading spaces
+static int split_line(slice_t line, slice_t *result, slice_t *op)
+{
+	while (line.len > 0 && line.ptr[0] == ' ') {
+		line.ptr++;
+		line.len--;
+	}
+	if (line.len == 0 || line.ptr[line.len - 1] == ':')
+		return 0;
+	result->ptr = NULL;
+	result->len = 0;
+	*op = line;
+	if (line.ptr[0] == '%') {
+		const char *eq = slice_find(line, " = ");
+		if (!eq)
+			return 0;
+		*result = (slice_t){line.ptr + 1, (size_t)(eq - line.ptr - 1)};
+		*op = (slice_t){eq + 3, (size_t)(line.ptr + line.len - eq - 3)};
+	}
+	return 1;
+}
+
+// What a store, load, call or other instruction does to memory
+static void add_effects(origin_map_t *map, slice_t op, body_effects_t *effects)
+{
+	const char *end = op.ptr + op.len;
+	if (starts_with(op, "load ")) {
+		unsigned long long address = operand_origins(map, last_operand(op), end);
+		if (address != FROM_LOCAL)
+			effects->reads_memory = 1;
+		if (starts_with(op, "load volatile "))
+			effects->writes_memory = 1;
+	} else if (starts_with(op, "store ")) {
+		const char *address_start = last_operand(op);
+		unsigned long long address = operand_origins(map, address_start, end);
+		unsigned long long value = operand_origins(map, op.ptr + 6, address_start);
+		if (address != FROM_LOCAL || starts_with(op, "store volatile "))
+			effects->writes_memory = 1;
+		effects->written_params |= (address | value) & PARAM_BITS;
+	} else if (starts_with(op, "call ")) {
+		effects->reads_memory = 1;
+		effects->writes_memory = 1;
+		effects->written_params |= operand_origins(map, op.ptr, end) & PARAM_BITS;
+	} else if (starts_with(op, "ptrtoint ")) {
+		effects->written_params |= operand_origins(map, op.ptr, end) & PARAM_BITS;
+	} else if (starts_with(op, "ret ") || starts_with(op, "br ") || starts_with(op, "switch ") ||
+		   starts_with(op, "unreachable") || starts_with(op, "]") || slice_find(op, "label %")) {
+		// Control flow, including the case lines of a switch
+	} else if (!starts_with(op, "alloca ") && !is_address_op(op) && !is_scalar_op(op) &&
+		   !starts_with(op, "inttoptr ")) {
+		// Anything not understood may read, write and keep its operands
+		effects->reads_memory = 1;
+		effects->writes_memory = 1;
+		effects->written_params |= operand_origins(map, op.ptr, end) & PARAM_BITS;
+	}
+}
+
+void infer_body_effects(const char *body, size_t len, const char *const *params, int param_count,
+			body_effects_t *effects)
+{
+	memset(effects, 0, sizeof(*effects));
+	origin_map_t map = {0};
+	for (int i = 0; i < param_count; i++) {
+		slice_t name = {params[i], strlen(params[i])};
+		*map_slot(&map, name, 1) = i < PARAM_LIMIT ? FROM_PARAM(i) : FROM_OTHER;
+	}
+
+	// Phis can name values defined further down, so origins are propagated
+	// until they stop growing
+	const char *end = body + len;
+	int changed = 1;
+	while (changed) {
+		changed = 0;
+		const char *p = body;
+		slice_t line, result, op;
+		while (next_line(&p, end, &line)) {
+			if (!split_line(line, &result, &op) || !result.ptr)
+				continue;
+			unsigned long long origins = result_origins(&map, op);
+			unsigned long long *slot = map_slot(&map, result, 1);
+			if ((*slot | origins) != *slot) {
+				*slot |= origins;
+				changed = 1;
+			}
+		}
+	}
+
+	const char *p = body;
+	slice_t line, result, op;
+	while (next_line(&p, end, &line)) {
+		if (split_line(line, &result, &op))
+			add_effects(&map, op, effects);
+	}
+
+	free(map.keys);
+	free(map.origins);
+}
+
+int param_is_read_only(const body_effects_t *effects, int i)
+{
+	return i < PARAM_LIMIT && !(effects->written_params & FROM_PARAM(i));
+}
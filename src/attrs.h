@@ -0,0 +1,24 @@
+#ifndef ATTRS_H
+#define ATTRS_H
+
+#include <stddef.h>
+
+// What a function body does with memory, read off its IR. Run after
+// mem2reg, when the parameters are used directly instead of through the
+// stack slots they start in; before it, every pointer parameter escapes
+// to its slot and only the function-wide answers are useful.
+typedef struct {
+	int reads_memory;  // Loads memory the caller can see
+	int writes_memory; // Stores to memory the caller can see, calls, or volatile accesses
+	unsigned long long written_params; // Bit i: parameter i may be written through or escape
+} body_effects_t;
+
+// body holds the text between the "define" line and the closing brace;
+// params the parameter names, without the %
+void infer_body_effects(const char *body, size_t len, const char *const *params, int param_count,
+			body_effects_t *effects);
+
+// Nothing is written through parameter i, nor does it escape
+int param_is_read_only(const body_effects_t *effects, int i);
+
+#endif
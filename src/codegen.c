@@ -1,20 +1,49 @@
 #define _POSIX_C_SOURCE 200809L
-#include <ctype.h>
 #include "ast.h"
 #include "symbol_table.h"
+#include "intern.h"
 #include "common.h"
+#include "ir_writer.h"
+#include "type_table.h"
+#include "ssa.h"
+#include "fold.h"
+#include "inline.h"
+#include "attrs.h"
+#include <ctype.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-// Code generation context
+#include <unistd.h>
+
+// Data layout and triple of the host. Without them clang and opt assume a
+// generic target, which weakens alias analysis and vectorization. Other
+// hosts leave both to the tool that compiles the IR.
+#if defined(__x86_64__) && defined(__linux__)
+#define TARGET_DATALAYOUT "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+#define TARGET_TRIPLE "x86_64-pc-linux-gnu"
+#elif defined(__aarch64__) && defined(__linux__)
+#define TARGET_DATALAYOUT "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128"
+#define TARGET_TRIPLE "aarch64-unknown-linux-gnu"
+#elif defined(__x86_64__) && defined(__APPLE__)
+#define TARGET_DATALAYOUT "e-m:o-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+#define TARGET_TRIPLE "x86_64-apple-macosx"
+#elif defined(__aarch64__) && defined(__APPLE__)
+#define TARGET_DATALAYOUT "e-m:o-i64:64-i128:128-n32:64-S128"
+#define TARGET_TRIPLE "arm64-apple-macosx"
+#endif
+
+// Code generation context of the function being generated. Every codegen
+// thread has its own, so function bodies can be generated in parallel.
 typedef struct {
-	FILE *output;
+	ir_writer_t out;
+	ir_writer_t globals; // Module-level definitions produced while inside a function
 	symbol_table_t *symbol_table;
+	arena_t arena; // Switch case labels, kept until code generation ends
 	int label_counter;
 	int temp_counter;
-	int string_counter;
 	int in_return_block;
+	ir_writer_t entry_allocas; // Slots of declarations skipped as unreachable
 
 	// Control flow management
 	char *current_break_label;
@@ -24,17 +53,46 @@ typedef struct {
 	// Function context
 	char *current_function_name;
 	type_info_t current_function_return_type;
+} codegen_context_t;
+
+// Module-wide state shared by all codegen threads. Function bodies only
+// read it: global symbols and string literals are registered up front.
+typedef struct {
+	symbol_table_t *symbol_table; // Owns the global scope
+	int string_counter;
 
-	// String literals storage
-	struct {
-		char *content;
+	// String literal pool, hashed by content and length
+	struct string_literal {
+		const char *content; // Owned by the AST; may contain NULs
+		size_t length;       // Excluding the terminator
+		size_t hash;
 		int id;
+		int next; // Hash chain, -1 terminates
+		int host; // Literal whose tail holds this one, or its own index
 	} *string_literals;
 	int string_literal_count;
+	int string_literal_capacity;
+	int *string_buckets;
+	size_t string_bucket_count;
+	inline_table_t *inlines; // Bodies copied into their callers, NULL without inlining
+} module_context_t;
 
-} codegen_context_t;
+// Output of one top-level declaration; units are written in source order
+typedef struct {
+	ast_node_t *decl;
+	ir_writer_t out;
+	ir_writer_t globals;
+	int inline_candidate; // Small enough, or declared inline, to offer to the inliner
+	int leaf;             // Calls nothing, so the inliner leaves its body as it is
+	int generated;        // out already holds the body, from collect_inline_candidates()
+	int internal;         // Declared static: dropped unless something live refers to it
+	int live;
+} codegen_unit_t;
 
-static codegen_context_t ctx;
+static THREAD_LOCAL codegen_context_t ctx;
+static module_context_t module;
+
+codegen_options_t codegen_options = {.inline_threshold = INLINE_DEFAULT_THRESHOLD};
 
 // Memory management helpers
 #define CLEANUP_AND_RETURN(type_var, ret_val) \
@@ -130,112 +188,154 @@ static char *generate_label(const char *prefix)
 	return label;
 }
 
+// Terminators emitted on every branch; kept off the printf path
+static void emit_br(const char *label)
+{
+	ir_puts(&ctx.out, "  br label ");
+	ir_local(&ctx.out, label);
+	ir_putc(&ctx.out, '\n');
+}
+
+static void emit_cond_br(int cond_temp, const char *true_label, const char *false_label)
+{
+	ir_puts(&ctx.out, "  br i1 ");
+	ir_temp(&ctx.out, cond_temp);
+	ir_puts(&ctx.out, ", label ");
+	ir_local(&ctx.out, true_label);
+	ir_puts(&ctx.out, ", label ");
+	ir_local(&ctx.out, false_label);
+	ir_putc(&ctx.out, '\n');
+}
+
+// Address operand of a named variable: %name.addr for parameters, @name or %name otherwise
+static void emit_symbol_addr(const symbol_t *sym)
+{
+	ir_putc(&ctx.out, sym->is_global && !sym->is_parameter ? '@' : '%');
+	ir_puts(&ctx.out, sym->llvm_name);
+	if (sym->is_parameter)
+		ir_puts(&ctx.out, ".addr");
+}
+
+// "volatile " for the loads and stores of a variable declared volatile. A
+// pointer variable is volatile itself only as int *volatile p; arrays are
+// never loaded as a whole.
+static const char *symbol_volatile(const symbol_t *sym)
+{
+	const type_info_t *type = &sym->type_info;
+	if (type->is_array)
+		return "";
+	type_qualifier_t qualifiers = type->pointer_level > 0 ? type->pointer_qualifiers : type->qualifiers;
+	return qualifiers & QUAL_VOLATILE ? "volatile " : "";
+}
+
+// "volatile " for the access to an object of the given type through a
+// pointer or an array element, as with volatile int *p
+static const char *access_volatile(const type_info_t *type)
+{
+	return type->pointer_level == 0 && (type->qualifiers & QUAL_VOLATILE) ? "volatile " : "";
+}
+
+// "%tN = load T, T* <sym>", the most frequent line in the output
+static void emit_load_symbol(int temp, const char *type, const symbol_t *sym)
+{
+	ir_puts(&ctx.out, "  ");
+	ir_temp(&ctx.out, temp);
+	ir_puts(&ctx.out, " = load ");
+	ir_puts(&ctx.out, symbol_volatile(sym));
+	ir_type(&ctx.out, type);
+	ir_puts(&ctx.out, ", ");
+	ir_type(&ctx.out, type);
+	ir_puts(&ctx.out, "* ");
+	emit_symbol_addr(sym);
+	ir_putc(&ctx.out, '\n');
+}
+
+static void emit_store_symbol(const char *type, int value_temp, const symbol_t *sym)
+{
+	ir_puts(&ctx.out, "  store ");
+	ir_puts(&ctx.out, symbol_volatile(sym));
+	ir_type(&ctx.out, type);
+	ir_putc(&ctx.out, ' ');
+	ir_temp(&ctx.out, value_temp);
+	ir_puts(&ctx.out, ", ");
+	ir_type(&ctx.out, type);
+	ir_puts(&ctx.out, "* ");
+	emit_symbol_addr(sym);
+	ir_putc(&ctx.out, '\n');
+}
+
 static int is_comparison_op(binary_op_t op)
 {
 	return (op >= OP_EQ && op <= OP_GE);
 }
 
-// Convert C type to LLVM type string
-static char *get_llvm_type_string(type_info_t *type_info)
+// Signed overflow of int arithmetic is undefined in C, so add, sub and mul
+// on it carry nsw. Unsigned values wrap, and long values are computed in
+// i32 here, so both keep plain wrapping arithmetic.
+static int has_signed_overflow(const type_info_t *type)
 {
-	char *result = malloc(256);
-	if (!result) {
-		fprintf(stderr, "Memory allocation failed\n");
-		exit(1);
-	}
-
-	// Handle pointers first
-	if (type_info->pointer_level > 0) {
-		if (strcmp(type_info->base_type, "void") == 0) {
-			strcpy(result, "i8");
-		} else if (strcmp(type_info->base_type, "char") == 0) {
-			strcpy(result, "i8");
-		} else if (strcmp(type_info->base_type, "short") == 0) {
-			strcpy(result, "i16");
-		} else if (strcmp(type_info->base_type, "int") == 0) {
-			strcpy(result, "i32");
-		} else if (strstr(type_info->base_type, "long")) {
-			strcpy(result, "i64");
-		} else if (strcmp(type_info->base_type, "float") == 0) {
-			strcpy(result, "float");
-		} else if (strcmp(type_info->base_type, "double") == 0) {
-			strcpy(result, "double");
-		} else if (type_info->is_struct) {
-			snprintf(result, 256, "%%struct.%s", type_info->base_type);
-		} else if (type_info->is_union) {
-			snprintf(result, 256, "%%union.%s", type_info->base_type);
-		} else {
-			strcpy(result, "i32"); // default
-		}
-
-		// Add pointer levels
-		for (int i = 0; i < type_info->pointer_level; i++) {
-			strcat(result, "*");
-		}
-		return result;
-	}
-
-	// Handle non-pointer types
-	if (strcmp(type_info->base_type, "void") == 0) {
-		strcpy(result, "void");
-	} else if (strcmp(type_info->base_type, "char") == 0) {
-		strcpy(result, "i8");
-	} else if (strcmp(type_info->base_type, "short") == 0) {
-		strcpy(result, "i16");
-	} else if (strcmp(type_info->base_type, "int") == 0) {
-		strcpy(result, "i32");
-	} else if (strstr(type_info->base_type, "long")) {
-		strcpy(result, "i64");
-	} else if (strcmp(type_info->base_type, "float") == 0) {
-		strcpy(result, "float");
-	} else if (strcmp(type_info->base_type, "double") == 0) {
-		strcpy(result, "double");
-	} else if (strcmp(type_info->base_type, "_Bool") == 0) {
-		strcpy(result, "i1");
-	} else if (type_info->is_struct) {
-		snprintf(result, 256, "%%struct.%s", type_info->base_type);
-	} else if (type_info->is_union) {
-		snprintf(result, 256, "%%union.%s", type_info->base_type);
-	} else if (type_info->is_enum) {
-		strcpy(result, "i32");
-	} else {
-		strcpy(result, "i32"); // default
-	}
+	return type->pointer_level == 0 && !type->is_array && type->base_type &&
+	       !strstr(type->base_type, "unsigned") && !strstr(type->base_type, "long") &&
+	       strcmp(type->base_type, "float") != 0 && strcmp(type->base_type, "double") != 0;
+}
 
+// Whether expr is int arithmetic all the way down. Sums of long operands
+// are typed int since they are computed in i32, so operations are looked
+// through rather than trusted.
+static int is_signed_int_expression(ast_node_t *expr)
+{
+	if (expr->type == AST_BINARY_OP) {
+		binary_op_t op = expr->data.binary_op.op;
+		if (is_comparison_op(op) || op == OP_LAND || op == OP_LOR)
+			return 1;
+		if (op == OP_LSHIFT || op == OP_RSHIFT)
+			return is_signed_int_expression(expr->data.binary_op.left);
+		return is_signed_int_expression(expr->data.binary_op.left) &&
+		       is_signed_int_expression(expr->data.binary_op.right);
+	}
+	if (expr->type == AST_UNARY_OP && (expr->data.unary_op.op == OP_NEG || expr->data.unary_op.op == OP_BNOT))
+		return is_signed_int_expression(expr->data.unary_op.operand);
+	type_info_t type = get_expression_type(expr, ctx.symbol_table);
+	int result = has_signed_overflow(&type);
+	free_type_info(&type);
 	return result;
 }
 
+// Convert C type to LLVM type string. The string belongs to the type table.
+static const char *get_llvm_type_string(type_info_t *type_info)
+{
+	return llvm_type_of(type_info)->name;
+}
+
 // Generate struct type definition
 static void generate_struct_type(symbol_t *struct_sym)
 {
 	if (!struct_sym || struct_sym->sym_type != SYM_STRUCT)
 		return;
 
-	fprintf(ctx.output, "%%struct.%s = type { ", struct_sym->name);
+	ir_printf(&ctx.out, "%%struct.%s = type { ", struct_sym->name);
 
 	for (int i = 0; i < struct_sym->member_count; i++) {
 		if (i > 0)
-			fprintf(ctx.output, ", ");
+			ir_puts(&ctx.out, ", ");
 
 		symbol_t *member = struct_sym->members[i];
-		char *member_type = get_llvm_type_string(&member->type_info);
+		const char *member_type = get_llvm_type_string(&member->type_info);
 
 		if (member->type_info.is_array && !member->type_info.is_vla) {
 			// Fixed-size array member
 			if (member->type_info.array_size && member->type_info.array_size->type == AST_NUMBER) {
 				int array_size = member->type_info.array_size->data.number.value;
-				fprintf(ctx.output, "[%d x %s]", array_size, member_type);
+				ir_printf(&ctx.out, "[%d x %s]", array_size, member_type);
 			} else {
-				fprintf(ctx.output, "%s*", member_type); // Pointer for incomplete arrays
+				ir_printf(&ctx.out, "%s*", member_type); // Pointer for incomplete arrays
 			}
 		} else {
-			fprintf(ctx.output, "%s", member_type);
+			ir_printf(&ctx.out, "%s", member_type);
 		}
-
-		free(member_type);
 	}
 
-	fprintf(ctx.output, " }\n");
+	ir_printf(&ctx.out, " }\n");
 }
 
 // Generate union type definition
@@ -257,76 +357,197 @@ static void generate_union_type(symbol_t *union_sym)
 	}
 
 	if (largest_member) {
-		char *member_type = get_llvm_type_string(&largest_member->type_info);
-		fprintf(ctx.output, "%%union.%s = type { %s }\n", union_sym->name, member_type);
-		free(member_type);
+		const char *member_type = get_llvm_type_string(&largest_member->type_info);
+		ir_printf(&ctx.out, "%%union.%s = type { %s }\n", union_sym->name, member_type);
 	} else {
-		fprintf(ctx.output, "%%union.%s = type { i8 }\n", union_sym->name);
+		ir_printf(&ctx.out, "%%union.%s = type { i8 }\n", union_sym->name);
 	}
 }
 
-// Store string literal and return its ID
-static int store_string_literal(const char *content)
+static void grow_string_buckets(void)
 {
-	// Check if string already exists
-	for (int i = 0; i < ctx.string_literal_count; i++) {
-		if (strcmp(ctx.string_literals[i].content, content) == 0) {
-			return ctx.string_literals[i].id;
-		}
+	size_t count = module.string_bucket_count ? module.string_bucket_count * 2 : 256;
+	int *buckets = malloc(count * sizeof(int));
+	if (!buckets) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
 	}
+	for (size_t i = 0; i < count; i++)
+		buckets[i] = -1;
+	for (int i = 0; i < module.string_literal_count; i++) {
+		size_t idx = module.string_literals[i].hash & (count - 1);
+		module.string_literals[i].next = buckets[idx];
+		buckets[idx] = i;
+	}
+	free(module.string_buckets);
+	module.string_buckets = buckets;
+	module.string_bucket_count = count;
+}
 
-	// Add new string literal
-	ctx.string_literal_count++;
-	ctx.string_literals = realloc(ctx.string_literals, ctx.string_literal_count * sizeof(*ctx.string_literals));
+// Store string literal and return its ID. Equal literals share one ID.
+static int store_string_literal(const char *content, size_t length)
+{
+	// Algorithm: FNV-1a hash function
+	size_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char)content[i]) * 16777619u;
+
+	if (module.string_buckets) {
+		int i = module.string_buckets[hash & (module.string_bucket_count - 1)];
+		for (; i >= 0; i = module.string_literals[i].next) {
+			struct string_literal *lit = &module.string_literals[i];
+			if (lit->hash == hash && lit->length == length && memcmp(lit->content, content, length) == 0)
+				return lit->id;
+		}
+	}
+
+	if (module.string_literal_count == module.string_literal_capacity) {
+		int capacity = module.string_literal_capacity ? module.string_literal_capacity * 2 : 64;
+		struct string_literal *literals = realloc(module.string_literals, capacity * sizeof(*literals));
+		if (!literals) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		module.string_literals = literals;
+		module.string_literal_capacity = capacity;
+	}
+	if ((size_t)module.string_literal_count >= module.string_bucket_count)
+		grow_string_buckets();
+
+	int index = module.string_literal_count++;
+	struct string_literal *lit = &module.string_literals[index];
+	lit->content = content;
+	lit->length = length;
+	lit->hash = hash;
+	lit->id = ++module.string_counter;
+	lit->host = index;
+
+	size_t idx = hash & (module.string_bucket_count - 1);
+	lit->next = module.string_buckets[idx];
+	module.string_buckets[idx] = index;
+	return lit->id;
+}
 
-	int id = ++ctx.string_counter;
-	ctx.string_literals[ctx.string_literal_count - 1].content = string_duplicate(content);
-	ctx.string_literals[ctx.string_literal_count - 1].id = id;
+// Orders literals by their reversed bytes, so a literal sorts directly
+// before the literals it is a suffix of
+static int compare_reversed(const void *a, const void *b)
+{
+	const struct string_literal *x = &module.string_literals[*(const int *)a];
+	const struct string_literal *y = &module.string_literals[*(const int *)b];
+	size_t n = x->length < y->length ? x->length : y->length;
 
-	return id;
+	for (size_t i = 1; i <= n; i++) {
+		unsigned char cx = (unsigned char)x->content[x->length - i];
+		unsigned char cy = (unsigned char)y->content[y->length - i];
+		if (cx != cy)
+			return cx < cy ? -1 : 1;
+	}
+	return (x->length > y->length) - (x->length < y->length);
 }
 
-// Generate global string constants
-static void generate_string_constants(void)
+static int is_suffix_of(const struct string_literal *tail, const struct string_literal *lit)
 {
-	for (int i = 0; i < ctx.string_literal_count; i++) {
-		const char *content = ctx.string_literals[i].content;
-		int id = ctx.string_literals[i].id;
-		size_t len = strlen(content) + 1; // Include null terminator
-
-		fprintf(ctx.output, "@.str%d = private unnamed_addr constant [%zu x i8] c\"", id, len);
-
-		// Emit string with escape sequences
-		for (const char *p = content; *p; p++) {
-			switch (*p) {
-			case '\n':
-				fprintf(ctx.output, "\\0A");
-				break;
-			case '\t':
-				fprintf(ctx.output, "\\09");
-				break;
-			case '\r':
-				fprintf(ctx.output, "\\0D");
-				break;
-			case '\\':
-				fprintf(ctx.output, "\\\\");
-				break;
-			case '"':
-				fprintf(ctx.output, "\\22");
-				break;
-			case '\0':
-				fprintf(ctx.output, "\\00");
-				break;
-			default:
-				if (*p >= 32 && *p <= 126) {
-					fprintf(ctx.output, "%c", *p);
-				} else {
-					fprintf(ctx.output, "\\%02X", (unsigned char)*p);
-				}
-				break;
+	return tail->length <= lit->length &&
+	       memcmp(lit->content + lit->length - tail->length, tail->content, tail->length) == 0;
+}
+
+// Tail sharing: a literal that ends another one ("bar" in "foobar") is
+// emitted as an alias into the longer literal instead of its own array
+static void merge_string_suffixes(void)
+{
+	int count = module.string_literal_count;
+	if (count < 2)
+		return;
+
+	int *order = malloc(count * sizeof(int));
+	if (!order) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (int i = 0; i < count; i++)
+		order[i] = i;
+	qsort(order, count, sizeof(int), compare_reversed);
+
+	for (int k = count - 2; k >= 0; k--) {
+		struct string_literal *lit = &module.string_literals[order[k]];
+		const struct string_literal *next = &module.string_literals[order[k + 1]];
+		if (is_suffix_of(lit, next))
+			lit->host = next->host;
+	}
+	free(order);
+}
+
+static void emit_string_bytes(const char *content, size_t length)
+{
+	for (const char *p = content; p < content + length; p++) {
+		switch (*p) {
+		case '\n':
+			ir_puts(&ctx.out, "\\0A");
+			break;
+		case '\t':
+			ir_puts(&ctx.out, "\\09");
+			break;
+		case '\r':
+			ir_puts(&ctx.out, "\\0D");
+			break;
+		case '\\':
+			ir_puts(&ctx.out, "\\\\");
+			break;
+		case '"':
+			ir_puts(&ctx.out, "\\22");
+			break;
+		case '\0':
+			ir_puts(&ctx.out, "\\00");
+			break;
+		default:
+			if (*p >= 32 && *p <= 126) {
+				ir_putc(&ctx.out, *p);
+			} else {
+				ir_hex_escape(&ctx.out, (unsigned char)*p);
 			}
+			break;
+		}
+	}
+}
+
+// Generate global string constants
+static void generate_string_constants(unsigned char *used)
+{
+	merge_string_suffixes();
+
+	// With used given, only the literals it flags (by ID) are emitted, and
+	// the hosts their aliases point into
+	if (used) {
+		for (int i = 0; i < module.string_literal_count; i++) {
+			const struct string_literal *lit = &module.string_literals[i];
+			if (lit->host != i && used[lit->id])
+				used[module.string_literals[lit->host].id] = 1;
 		}
-		fprintf(ctx.output, "\\00\"\n");
+	}
+
+	for (int i = 0; i < module.string_literal_count; i++) {
+		const struct string_literal *lit = &module.string_literals[i];
+		if (lit->host != i || (used && !used[lit->id]))
+			continue;
+		size_t len = lit->length + 1; // Include null terminator
+
+		ir_printf(&ctx.out, "@.str%d = private unnamed_addr constant [%zu x i8] c\"", lit->id, len);
+		emit_string_bytes(lit->content, lit->length);
+		ir_puts(&ctx.out, "\\00\"\n");
+	}
+
+	for (int i = 0; i < module.string_literal_count; i++) {
+		const struct string_literal *lit = &module.string_literals[i];
+		if (lit->host == i || (used && !used[lit->id]))
+			continue;
+		const struct string_literal *host = &module.string_literals[lit->host];
+		size_t len = lit->length + 1;
+		size_t host_len = host->length + 1;
+
+		ir_printf(&ctx.out,
+			"@.str%d = private unnamed_addr alias [%zu x i8], [%zu x i8]* bitcast (i8* "
+			"getelementptr inbounds ([%zu x i8], [%zu x i8]* @.str%d, i64 0, i64 %zu) to [%zu x i8]*)\n",
+			lit->id, len, len, host_len, host_len, host->id, host_len - len, len);
 	}
 }
 
@@ -340,7 +561,8 @@ static int convert_to_boolean(ast_node_t *expr, int expr_temp)
 	int bool_temp = get_next_temp();
 	char expr_str[32];
 
-	if (expr->type == AST_NUMBER) {
+	int is_constant = expr->type == AST_NUMBER || expr->type == AST_CHARACTER;
+	if (is_constant) {
 		snprintf(expr_str, sizeof(expr_str), "%d", expr_temp);
 	} else {
 		snprintf(expr_str, sizeof(expr_str), "%%t%d", expr_temp);
@@ -352,66 +574,74 @@ static int convert_to_boolean(ast_node_t *expr, int expr_temp)
 	// Generate appropriate comparison based on type
 	if (expr_type.pointer_level > 0) {
 		// Pointer comparison with null
-		char *type_str = get_llvm_type_string(&expr_type);
-		fprintf(ctx.output, "  %%t%d = icmp ne %s %s, null\n", bool_temp, type_str, expr_str);
-		free(type_str);
+		const char *type_str = get_llvm_type_string(&expr_type);
+		ir_printf(&ctx.out, "  %%t%d = icmp ne %s %s, null\n", bool_temp, type_str, expr_str);
 	} else {
-		// Integer comparison with zero
-		fprintf(ctx.output, "  %%t%d = icmp ne i32 %s, 0\n", bool_temp, expr_str);
+		// Integer comparison with zero, at the expression's own width
+		const llvm_type_t *type = llvm_type_of(&expr_type);
+		ir_printf(&ctx.out, "  %%t%d = icmp ne %s %s, 0\n", bool_temp,
+			llvm_type_is_integer(type) && !is_constant ? type->name : "i32", expr_str);
 	}
 
 	free_type_info(&expr_type);
 	return bool_temp;
 }
 
-static int cast_value(int val_temp, type_info_t *src_type, type_info_t *dest_type)
+// The conversion instruction from a value of src_type, whose LLVM type is
+// src, to dest. Integers are extended by the source's signedness.
+static const char *cast_opcode(const type_info_t *src_type, const llvm_type_t *src, const llvm_type_t *dest)
 {
-	char *src_str = get_llvm_type_string(src_type);
-
-	if (src_type->is_array) {
-		char *decayed_ptr = malloc(strlen(src_str) + 2);
-		if (decayed_ptr) {
-			sprintf(decayed_ptr, "%s*", src_str);
-			free(src_str);
-			src_str = decayed_ptr;
-		}
-	}
+	int is_unsigned = src_type->base_type &&
+			  (strstr(src_type->base_type, "unsigned") || strcmp(src_type->base_type, "_Bool") == 0);
+	int src_float = src->kind == LLVM_TYPE_FLOAT || src->kind == LLVM_TYPE_DOUBLE;
+	int dest_float = dest->kind == LLVM_TYPE_FLOAT || dest->kind == LLVM_TYPE_DOUBLE;
+
+	if (llvm_type_is_integer(src) && llvm_type_is_integer(dest))
+		return src->bits > dest->bits ? "trunc" : is_unsigned ? "zext" : "sext";
+	if (llvm_type_is_pointer(src) && llvm_type_is_integer(dest))
+		return "ptrtoint";
+	if (llvm_type_is_integer(src) && llvm_type_is_pointer(dest))
+		return "inttoptr";
+	if (llvm_type_is_integer(src) && dest_float)
+		return is_unsigned ? "uitofp" : "sitofp";
+	if (src_float && llvm_type_is_integer(dest))
+		return "fptosi";
+	if (src_float && dest_float)
+		return src->kind == LLVM_TYPE_FLOAT ? "fpext" : "fptrunc";
+	return "bitcast";
+}
 
-	char *dest_str = get_llvm_type_string(dest_type);
+static int cast_value(int val_temp, type_info_t *src_type, type_info_t *dest_type)
+{
+	const llvm_type_t *src = llvm_type_of(src_type);
+	if (src_type->is_array)
+		src = llvm_pointer_to(src);
+	const llvm_type_t *dest = llvm_type_of(dest_type);
 
-	if (strcmp(src_str, dest_str) == 0) {
-		free(src_str);
-		free(dest_str);
+	if (src == dest)
 		return val_temp;
-	}
 
 	int new_temp = get_next_temp();
+	ir_printf(&ctx.out, "  %%t%d = %s %s %%t%d to %s\n", new_temp, cast_opcode(src_type, src, dest), src->name,
+		val_temp, dest->name);
 
-	if (src_str[0] == 'i' && dest_str[0] == 'i' && isdigit(src_str[1]) && isdigit(dest_str[1]) &&
-	    strchr(src_str, '*') == NULL && strchr(dest_str, '*') == NULL) {
-
-		int src_bits = atoi(src_str + 1);
-		int dest_bits = atoi(dest_str + 1);
+	return new_temp;
+}
 
-		if (src_bits > dest_bits) {
-			// Truncate (e.g., long to int)
-			fprintf(ctx.output, "  %%t%d = trunc %s %%t%d to %s\n", new_temp, src_str, val_temp, dest_str);
-		} else {
-			// Sign extend (e.g., int to long)
-			fprintf(ctx.output, "  %%t%d = sext %s %%t%d to %s\n", new_temp, src_str, val_temp, dest_str);
-		}
-	} else if ((src_type->pointer_level > 0 || src_type->is_array) && dest_str[0] == 'i' &&
-		   strchr(dest_str, '*') == NULL) {
-		fprintf(ctx.output, "  %%t%d = ptrtoint %s %%t%d to %s\n", new_temp, src_str, val_temp, dest_str);
-	} else if (src_str[0] == 'i' && strchr(src_str, '*') == NULL && dest_type->pointer_level > 0) {
-		fprintf(ctx.output, "  %%t%d = inttoptr %s %%t%d to %s\n", new_temp, src_str, val_temp, dest_str);
-	} else {
-		fprintf(ctx.output, "  %%t%d = bitcast %s %%t%d to %s\n", new_temp, src_str, val_temp, dest_str);
+// Writes the i64 operand of a getelementptr for an index expression whose
+// value was generated into value. Constants are used as they are; anything
+// else is sign extended once here, so the GEP needs no implicit extension.
+static void format_gep_index(char *buf, size_t size, ast_node_t *index, int value)
+{
+	if (index->type == AST_NUMBER || index->type == AST_CHARACTER) {
+		snprintf(buf, size, "%d", value);
+		return;
 	}
-
-	free(src_str);
-	free(dest_str);
-	return new_temp;
+	type_info_t index_type = get_expression_type(index, ctx.symbol_table);
+	type_info_t long_type = {0};
+	long_type.base_type = "long";
+	snprintf(buf, size, "%%t%d", cast_value(value, &index_type, &long_type));
+	free_type_info(&index_type);
 }
 
 // Forward declarations
@@ -435,68 +665,59 @@ static int generate_expression(ast_node_t *node)
 	}
 
 	case AST_STRING_LITERAL: {
-		int string_id = store_string_literal(node->data.string_literal.value);
+		int string_id =
+			store_string_literal(node->data.string_literal.value, node->data.string_literal.length);
 		int temp = get_next_temp();
-		size_t len = strlen(node->data.string_literal.value) + 1;
+		size_t len = node->data.string_literal.length + 1;
 
-		fprintf(ctx.output, "  %%t%d = getelementptr [%zu x i8], [%zu x i8]* @.str%d, i32 0, i32 0\n", temp,
+		ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds [%zu x i8], [%zu x i8]* @.str%d, i64 0, i64 0\n", temp,
 			len, len, string_id);
 
 		return temp;
 	}
 
 	case AST_IDENTIFIER: {
-		symbol_t *sym = find_symbol(ctx.symbol_table, node->data.identifier.name);
+		symbol_t *sym = node->data.identifier.symbol;
 		if (!sym) {
 			fprintf(stderr, "Undefined variable: %s\n", node->data.identifier.name);
 			return -1;
 		}
 
 		int temp = get_next_temp();
-		char *type_str = get_llvm_type_string(&sym->type_info);
+		const char *type_str = get_llvm_type_string(&sym->type_info);
 
 		// Handle different symbol types
 		if (sym->sym_type == SYM_ENUM_CONSTANT) {
-			// Enum constants are compile-time constants
-			free(type_str);
-			return sym->enum_value;
+			// Folding turns enum constants into numbers; without it, callers expect a temp
+			ir_printf(&ctx.out, "  %%t%d = add i32 0, %d\n", temp, sym->enum_value);
+			return temp;
 		}
 
 		if (sym->type_info.is_array) {
 			if (sym->is_parameter) {
-				fprintf(ctx.output, "  %%t%d = load %s, %s* %%%s.addr\n", temp, type_str, type_str,
-					sym->llvm_name);
+				ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %%%s.addr\n", temp, symbol_volatile(sym),
+					type_str, type_str, sym->llvm_name);
 			} else if (sym->type_info.is_vla) {
-				fprintf(ctx.output, "  %%t%d = load %s*, %s** %%%s\n", temp, type_str, type_str,
+				ir_printf(&ctx.out, "  %%t%d = load %s*, %s** %%%s\n", temp, type_str, type_str,
 					sym->llvm_name);
 			} else {
 				// Fixed array - get pointer to first element
-				char *element_type = get_llvm_type_string(&sym->type_info);
-				if (sym->type_info.pointer_level > 0) {
-					element_type[strlen(element_type) - 1] = '\0'; // Remove one *
-				}
+				const llvm_type_t *array_type = llvm_type_of(&sym->type_info);
+				if (sym->type_info.pointer_level > 0)
+					array_type = array_type->pointee; // Remove one *
+				const char *element_type = array_type->name;
 				size_t array_length = get_array_length(sym, ctx.symbol_table);
 				const char *prefix = sym->is_global ? "@" : "%";
 
-				fprintf(ctx.output,
-					"  %%t%d = getelementptr [%zu x %s], [%zu x %s]* %s%s, i32 0, i32 0\n", temp,
+				ir_printf(&ctx.out,
+					"  %%t%d = getelementptr inbounds [%zu x %s], [%zu x %s]* %s%s, i64 0, i64 0\n", temp,
 					array_length, element_type, array_length, element_type, prefix, sym->llvm_name);
-
-				free(element_type);
 			}
 		} else {
 			// Regular variables
-			if (sym->is_parameter) {
-				fprintf(ctx.output, "  %%t%d = load %s, %s* %%%s.addr\n", temp, type_str, type_str,
-					sym->llvm_name);
-			} else {
-				const char *prefix = sym->is_global ? "@" : "%";
-				fprintf(ctx.output, "  %%t%d = load %s, %s* %s%s\n", temp, type_str, type_str, prefix,
-					sym->llvm_name);
-			}
+			emit_load_symbol(temp, type_str, sym);
 		}
 
-		free(type_str);
 		return temp;
 	}
 
@@ -508,73 +729,41 @@ static int generate_expression(ast_node_t *node)
 			char *end_label = generate_label("logical_end");
 			int result_temp = get_next_temp();
 
-			fprintf(ctx.output, "  %%t%d.addr = alloca i1\n", result_temp);
+			ir_printf(&ctx.out, "  %%t%d.addr = alloca i1\n", result_temp);
 
 			int left = generate_expression(node->data.binary_op.left);
-			int left_bool;
-
-			if (node->data.binary_op.left->type == AST_BINARY_OP &&
-			    is_comparison_op(node->data.binary_op.left->data.binary_op.op)) {
-				left_bool = left;
-			} else {
-				left_bool = get_next_temp();
-				char left_str[32];
-				if (node->data.binary_op.left->type == AST_NUMBER ||
-				    node->data.binary_op.left->type == AST_CHARACTER) {
-					snprintf(left_str, sizeof(left_str), "%d", left);
-				} else {
-					snprintf(left_str, sizeof(left_str), "%%t%d", left);
-				}
-				fprintf(ctx.output, "  %%t%d = icmp ne i32 %s, 0\n", left_bool, left_str);
-			}
+			int left_bool = convert_to_boolean(node->data.binary_op.left, left);
 
 			if (node->data.binary_op.op == OP_LAND) {
 				// AND: if left is false, result is false; otherwise evaluate right
-				fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", left_bool, right_label,
-					left_label);
+				emit_cond_br(left_bool, right_label, left_label);
 
-				fprintf(ctx.output, "%s:\n", left_label);
-				fprintf(ctx.output, "  store i1 false, i1* %%t%d.addr\n", result_temp);
-				fprintf(ctx.output, "  br label %%%s\n", end_label);
+				ir_label_def(&ctx.out, left_label);
+				ir_printf(&ctx.out, "  store i1 false, i1* %%t%d.addr\n", result_temp);
+				emit_br(end_label);
 			} else {
 				// OR: if left is true, result is true; otherwise evaluate right
-				fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", left_bool, left_label,
-					right_label);
+				emit_cond_br(left_bool, left_label, right_label);
 
-				fprintf(ctx.output, "%s:\n", left_label);
-				fprintf(ctx.output, "  store i1 true, i1* %%t%d.addr\n", result_temp);
-				fprintf(ctx.output, "  br label %%%s\n", end_label);
+				ir_label_def(&ctx.out, left_label);
+				ir_printf(&ctx.out, "  store i1 true, i1* %%t%d.addr\n", result_temp);
+				emit_br(end_label);
 			}
 
-			fprintf(ctx.output, "%s:\n", right_label);
+			ir_label_def(&ctx.out, right_label);
 			int right = generate_expression(node->data.binary_op.right);
-			int right_bool;
+			int right_bool = convert_to_boolean(node->data.binary_op.right, right);
 
-			if (node->data.binary_op.right->type == AST_BINARY_OP &&
-			    is_comparison_op(node->data.binary_op.right->data.binary_op.op)) {
-				right_bool = right;
-			} else {
-				right_bool = get_next_temp();
-				char right_str[32];
-				if (node->data.binary_op.right->type == AST_NUMBER ||
-				    node->data.binary_op.right->type == AST_CHARACTER) {
-					snprintf(right_str, sizeof(right_str), "%d", right);
-				} else {
-					snprintf(right_str, sizeof(right_str), "%%t%d", right);
-				}
-				fprintf(ctx.output, "  %%t%d = icmp ne i32 %s, 0\n", right_bool, right_str);
-			}
-
-			fprintf(ctx.output, "  store i1 %%t%d, i1* %%t%d.addr\n", right_bool, result_temp);
-			fprintf(ctx.output, "  br label %%%s\n", end_label);
+			ir_printf(&ctx.out, "  store i1 %%t%d, i1* %%t%d.addr\n", right_bool, result_temp);
+			emit_br(end_label);
 
-			fprintf(ctx.output, "%s:\n", end_label);
+			ir_label_def(&ctx.out, end_label);
 			int final_temp = get_next_temp();
-			fprintf(ctx.output, "  %%t%d = load i1, i1* %%t%d.addr\n", final_temp, result_temp);
+			ir_printf(&ctx.out, "  %%t%d = load i1, i1* %%t%d.addr\n", final_temp, result_temp);
 
 			// Convert to i32 for compatibility
 			int result = get_next_temp();
-			fprintf(ctx.output, "  %%t%d = zext i1 %%t%d to i32\n", result, final_temp);
+			ir_printf(&ctx.out, "  %%t%d = zext i1 %%t%d to i32\n", result, final_temp);
 
 			free(left_label);
 			free(right_label);
@@ -636,19 +825,9 @@ static int generate_expression(ast_node_t *node)
 			}
 
 			if (left_type.pointer_level > 0 || left_type.is_array) {
-				if (node->data.binary_op.right->type == AST_NUMBER ||
-				    node->data.binary_op.right->type == AST_CHARACTER) {
-					snprintf(idx_str, sizeof(idx_str), "%d", idx_val);
-				} else {
-					snprintf(idx_str, sizeof(idx_str), "%%t%d", idx_val);
-				}
+				format_gep_index(idx_str, sizeof(idx_str), node->data.binary_op.right, idx_val);
 			} else {
-				if (node->data.binary_op.left->type == AST_NUMBER ||
-				    node->data.binary_op.left->type == AST_CHARACTER) {
-					snprintf(idx_str, sizeof(idx_str), "%d", idx_val);
-				} else {
-					snprintf(idx_str, sizeof(idx_str), "%%t%d", idx_val);
-				}
+				format_gep_index(idx_str, sizeof(idx_str), node->data.binary_op.left, idx_val);
 			}
 
 			// Determine element type (type pointed to)
@@ -661,12 +840,11 @@ static int generate_expression(ast_node_t *node)
 				// Pointer: strip one level
 				elem_info.pointer_level--;
 			}
-			char *elem_type_str = get_llvm_type_string(&elem_info);
+			const char *elem_type_str = get_llvm_type_string(&elem_info);
 
-			fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %s, i32 %s\n", temp, elem_type_str,
+			ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %s, i64 %s\n", temp, elem_type_str,
 				elem_type_str, ptr_str, idx_str);
 
-			free(elem_type_str);
 			free_type_info(&elem_info);
 			free_type_info(&left_type);
 			free_type_info(&right_type);
@@ -686,16 +864,11 @@ static int generate_expression(ast_node_t *node)
 				snprintf(ptr_str, sizeof(ptr_str), "%%t%d", left);
 			}
 
-			if (node->data.binary_op.right->type == AST_NUMBER ||
-			    node->data.binary_op.right->type == AST_CHARACTER) {
-				snprintf(idx_str, sizeof(idx_str), "%d", right);
-			} else {
-				snprintf(idx_str, sizeof(idx_str), "%%t%d", right);
-			}
+			format_gep_index(idx_str, sizeof(idx_str), node->data.binary_op.right, right);
 
 			// Negate index
 			int neg_idx = get_next_temp();
-			fprintf(ctx.output, "  %%t%d = sub i32 0, %s\n", neg_idx, idx_str);
+			ir_printf(&ctx.out, "  %%t%d = sub i64 0, %s\n", neg_idx, idx_str);
 
 			type_info_t elem_info = deep_copy_type_info(&left_type);
 			if (elem_info.is_array) {
@@ -703,12 +876,11 @@ static int generate_expression(ast_node_t *node)
 			} else {
 				elem_info.pointer_level--;
 			}
-			char *elem_type_str = get_llvm_type_string(&elem_info);
+			const char *elem_type_str = get_llvm_type_string(&elem_info);
 
-			fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %s, i32 %%t%d\n", temp, elem_type_str,
+			ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %s, i64 %%t%d\n", temp, elem_type_str,
 				elem_type_str, ptr_str, neg_idx);
 
-			free(elem_type_str);
 			free_type_info(&elem_info);
 			free_type_info(&left_type);
 			free_type_info(&right_type);
@@ -736,7 +908,7 @@ static int generate_expression(ast_node_t *node)
 			}
 
 			// Construct pointer type string for ptrtoint
-			char *ptr_type;
+			const char *ptr_type;
 			if (left_type.is_array) {
 				type_info_t decayed = deep_copy_type_info(&left_type);
 				decayed.is_array = 0;
@@ -753,18 +925,24 @@ static int generate_expression(ast_node_t *node)
 			int final_res = temp;
 
 			// Ptr to int (use i64 for address diff)
-			fprintf(ctx.output, "  %%t%d = ptrtoint %s %s to i64\n", l_int, ptr_type, ptr_l_str);
-			fprintf(ctx.output, "  %%t%d = ptrtoint %s %s to i64\n", r_int, ptr_type, ptr_r_str);
-			fprintf(ctx.output, "  %%t%d = sub i64 %%t%d, %%t%d\n", diff, l_int, r_int);
+			ir_printf(&ctx.out, "  %%t%d = ptrtoint %s %s to i64\n", l_int, ptr_type, ptr_l_str);
+			ir_printf(&ctx.out, "  %%t%d = ptrtoint %s %s to i64\n", r_int, ptr_type, ptr_r_str);
+			ir_printf(&ctx.out, "  %%t%d = sub i64 %%t%d, %%t%d\n", diff, l_int, r_int);
 
-			size_t elem_size = get_basic_type_size(left_type.base_type);
+			// The difference is a ptrdiff_t (long), an exact multiple of the element size
+			type_info_t elem_info = deep_copy_type_info(&left_type);
+			if (elem_info.is_array)
+				elem_info.is_array = 0;
+			else
+				elem_info.pointer_level--;
+			size_t elem_size = elem_info.pointer_level > 0		     ? 8
+					   : elem_info.is_struct || elem_info.is_union ? calculate_type_size(&elem_info, ctx.symbol_table)
+											: get_basic_type_size(elem_info.base_type);
+			free_type_info(&elem_info);
 
-			int res_i64 = get_next_temp();
-			fprintf(ctx.output, "  %%t%d = sdiv i64 %%t%d, %zu\n", res_i64, diff,
+			ir_printf(&ctx.out, "  %%t%d = sdiv exact i64 %%t%d, %zu\n", final_res, diff,
 				(elem_size > 0 ? elem_size : 1));
-			fprintf(ctx.output, "  %%t%d = trunc i64 %%t%d to i32\n", final_res, res_i64);
 
-			free(ptr_type);
 			free_type_info(&left_type);
 			free_type_info(&right_type);
 			return final_res;
@@ -784,7 +962,7 @@ static int generate_expression(ast_node_t *node)
 		    is_comparison_op(node->data.binary_op.left->data.binary_op.op)) {
 			// Convert boolean i1 -> i32
 			int z = get_next_temp();
-			fprintf(ctx.output, "  %%t%d = zext i1 %%t%d to i32\n", z, left);
+			ir_printf(&ctx.out, "  %%t%d = zext i1 %%t%d to i32\n", z, left);
 			left_i32 = z;
 		} else if (node->data.binary_op.left->type != AST_NUMBER &&
 			   node->data.binary_op.left->type != AST_CHARACTER) {
@@ -796,13 +974,18 @@ static int generate_expression(ast_node_t *node)
 		if (node->data.binary_op.right->type == AST_BINARY_OP &&
 		    is_comparison_op(node->data.binary_op.right->data.binary_op.op)) {
 			int z = get_next_temp();
-			fprintf(ctx.output, "  %%t%d = zext i1 %%t%d to i32\n", z, right);
+			ir_printf(&ctx.out, "  %%t%d = zext i1 %%t%d to i32\n", z, right);
 			right_i32 = z;
 		} else if (node->data.binary_op.right->type != AST_NUMBER &&
 			   node->data.binary_op.right->type != AST_CHARACTER) {
 			right_i32 = cast_value(right, &right_type, &int_type);
 		}
 
+		int no_signed_wrap = is_signed_int_expression(node->data.binary_op.left) &&
+				     is_signed_int_expression(node->data.binary_op.right);
+		int is_unsigned = node->data.binary_op.op == OP_LSHIFT || node->data.binary_op.op == OP_RSHIFT
+					  ? is_unsigned_arithmetic(&left_type, &left_type)
+					  : is_unsigned_arithmetic(&left_type, &right_type);
 		free_type_info(&left_type);
 		free_type_info(&right_type);
 
@@ -810,10 +993,10 @@ static int generate_expression(ast_node_t *node)
 		if (is_comparison_op(node->data.binary_op.op)) {
 			const char *pred = node->data.binary_op.op == OP_EQ   ? "eq"
 					   : node->data.binary_op.op == OP_NE ? "ne"
-					   : node->data.binary_op.op == OP_LT ? "slt"
-					   : node->data.binary_op.op == OP_LE ? "sle"
-					   : node->data.binary_op.op == OP_GT ? "sgt"
-									      : "sge";
+					   : node->data.binary_op.op == OP_LT ? (is_unsigned ? "ult" : "slt")
+					   : node->data.binary_op.op == OP_LE ? (is_unsigned ? "ule" : "sle")
+					   : node->data.binary_op.op == OP_GT ? (is_unsigned ? "ugt" : "sgt")
+									      : (is_unsigned ? "uge" : "sge");
 
 			char L[32];
 			char R[32];
@@ -831,7 +1014,7 @@ static int generate_expression(ast_node_t *node)
 			}
 
 			// icmp: operands i32, result i1
-			fprintf(ctx.output, "  %%t%d = icmp %s i32 %s, %s\n", temp, pred, L, R);
+			ir_printf(&ctx.out, "  %%t%d = icmp %s i32 %s, %s\n", temp, pred, L, R);
 			return temp;
 		}
 
@@ -839,19 +1022,19 @@ static int generate_expression(ast_node_t *node)
 		const char *op_str = NULL;
 		switch (node->data.binary_op.op) {
 		case OP_ADD:
-			op_str = "add";
+			op_str = no_signed_wrap ? "add nsw" : "add";
 			break;
 		case OP_SUB:
-			op_str = "sub";
+			op_str = no_signed_wrap ? "sub nsw" : "sub";
 			break;
 		case OP_MUL:
-			op_str = "mul";
+			op_str = no_signed_wrap ? "mul nsw" : "mul";
 			break;
 		case OP_DIV:
-			op_str = "sdiv";
+			op_str = is_unsigned ? "udiv" : "sdiv";
 			break;
 		case OP_MOD:
-			op_str = "srem";
+			op_str = is_unsigned ? "urem" : "srem";
 			break;
 		case OP_BAND:
 			op_str = "and";
@@ -866,7 +1049,7 @@ static int generate_expression(ast_node_t *node)
 			op_str = "shl";
 			break;
 		case OP_RSHIFT:
-			op_str = "ashr";
+			op_str = is_unsigned ? "lshr" : "ashr";
 			break;
 		default:
 			fprintf(stderr, "Unknown binary operator: %d\n", node->data.binary_op.op);
@@ -888,7 +1071,7 @@ static int generate_expression(ast_node_t *node)
 		}
 
 		// Opcode uses i32 operands
-		fprintf(ctx.output, "  %%t%d = %s i32 %s, %s\n", temp, op_str, L, R);
+		ir_printf(&ctx.out, "  %%t%d = %s i32 %s, %s\n", temp, op_str, L, R);
 		return temp;
 	}
 
@@ -898,13 +1081,13 @@ static int generate_expression(ast_node_t *node)
 
 		if (node->data.assignment.name) {
 			// Simple identifier assignment
-			symbol_t *sym = find_symbol(ctx.symbol_table, node->data.assignment.name);
+			symbol_t *sym = node->data.assignment.symbol;
 			if (!sym) {
 				fprintf(stderr, "Undefined variable in assignment: %s\n", node->data.assignment.name);
 				return -1;
 			}
 
-			char *type_str = get_llvm_type_string(&sym->type_info);
+			const char *type_str = get_llvm_type_string(&sym->type_info);
 			int final_value = value;
 
 			if (node->data.assignment.value->type != AST_NUMBER &&
@@ -920,34 +1103,33 @@ static int generate_expression(ast_node_t *node)
 				if (node->data.assignment.value->type == AST_NUMBER ||
 				    node->data.assignment.value->type == AST_CHARACTER) {
 					if (sym->type_info.pointer_level > 0 && value == 0) {
-						fprintf(ctx.output, "  store %s null, %s* %%%s.addr\n", type_str,
-							type_str, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s null, %s* %%%s.addr\n",
+							symbol_volatile(sym), type_str, type_str, sym->llvm_name);
 					} else {
-						fprintf(ctx.output, "  store %s %d, %s* %%%s.addr\n", type_str, value,
-							type_str, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s %d, %s* %%%s.addr\n",
+							symbol_volatile(sym), type_str, value, type_str,
+							sym->llvm_name);
 					}
 				} else {
-					fprintf(ctx.output, "  store %s %%t%d, %s* %%%s.addr\n", type_str, final_value,
-						type_str, sym->llvm_name);
+					emit_store_symbol(type_str, final_value, sym);
 				}
 			} else {
 				const char *prefix = sym->is_global ? "@" : "%";
 				if (node->data.assignment.value->type == AST_NUMBER ||
 				    node->data.assignment.value->type == AST_CHARACTER) {
 					if (sym->type_info.pointer_level > 0 && value == 0) {
-						fprintf(ctx.output, "  store %s null, %s* %s%s\n", type_str, type_str,
-							prefix, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s null, %s* %s%s\n",
+							symbol_volatile(sym), type_str, type_str, prefix,
+							sym->llvm_name);
 					} else {
-						fprintf(ctx.output, "  store %s %d, %s* %s%s\n", type_str, value,
-							type_str, prefix, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s %d, %s* %s%s\n", symbol_volatile(sym),
+							type_str, value, type_str, prefix, sym->llvm_name);
 					}
 				} else {
-					fprintf(ctx.output, "  store %s %%t%d, %s* %s%s\n", type_str, final_value,
-						type_str, prefix, sym->llvm_name);
+					emit_store_symbol(type_str, final_value, sym);
 				}
 			}
 
-			free(type_str);
 			return final_value;
 		}
 
@@ -959,7 +1141,7 @@ static int generate_expression(ast_node_t *node)
 				ast_node_t *index = node->data.assignment.lvalue->data.array_access.index;
 
 				if (array->type == AST_IDENTIFIER) {
-					symbol_t *sym = find_symbol(ctx.symbol_table, array->data.identifier.name);
+					symbol_t *sym = array->data.identifier.symbol;
 					if (!sym) {
 						fprintf(stderr, "Undefined array in assignment: %s\n",
 							array->data.identifier.name);
@@ -970,13 +1152,11 @@ static int generate_expression(ast_node_t *node)
 					int addr_temp = get_next_temp();
 
 					char index_str[32];
-					if (index->type == AST_NUMBER || index->type == AST_CHARACTER) {
-						snprintf(index_str, sizeof(index_str), "%d", index_val);
-					} else {
-						snprintf(index_str, sizeof(index_str), "%%t%d", index_val);
-					}
+					format_gep_index(index_str, sizeof(index_str), index, index_val);
 
-					char *element_type = get_llvm_type_string(
+					const char *element_type = get_llvm_type_string(
+						&node->data.assignment.lvalue->data.array_access.element_type);
+					const char *access = access_volatile(
 						&node->data.assignment.lvalue->data.array_access.element_type);
 
 					const char *prefix = sym->is_global ? "@" : "%";
@@ -984,38 +1164,38 @@ static int generate_expression(ast_node_t *node)
 					if (sym->type_info.is_array) {
 						if (sym->is_parameter) {
 							int ptr_temp = get_next_temp();
-							char *param_type = get_llvm_type_string(&sym->type_info);
-							fprintf(ctx.output, "  %%t%d = load %s, %s* %%%s.addr\n",
-								ptr_temp, param_type, param_type, sym->llvm_name);
-							fprintf(ctx.output,
-								"  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+							const char *param_type = get_llvm_type_string(&sym->type_info);
+							ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %%%s.addr\n",
+								ptr_temp, symbol_volatile(sym), param_type, param_type,
+								sym->llvm_name);
+							ir_printf(&ctx.out,
+								"  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 								addr_temp, element_type, element_type, ptr_temp,
 								index_str);
-							free(param_type);
 						} else if (sym->type_info.is_vla) {
 							int ptr_temp = get_next_temp();
-							fprintf(ctx.output, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp,
+							ir_printf(&ctx.out, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp,
 								element_type, element_type, sym->llvm_name);
-							fprintf(ctx.output,
-								"  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+							ir_printf(&ctx.out,
+								"  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 								addr_temp, element_type, element_type, ptr_temp,
 								index_str);
 						} else {
 							size_t array_length = get_array_length(sym, ctx.symbol_table);
-							fprintf(ctx.output,
-								"  %%t%d = getelementptr [%zu x %s], [%zu x %s]* "
-								"%s%s, i32 0, i32 %s\n",
+							ir_printf(&ctx.out,
+								"  %%t%d = getelementptr inbounds [%zu x %s], [%zu x %s]* "
+								"%s%s, i64 0, i64 %s\n",
 								addr_temp, array_length, element_type, array_length,
 								element_type, prefix, sym->llvm_name, index_str);
 						}
 					} else if (sym->type_info.pointer_level > 0) {
 						int ptr_temp = get_next_temp();
-						char *ptr_type = get_llvm_type_string(&sym->type_info);
-						fprintf(ctx.output, "  %%t%d = load %s, %s* %s%s\n", ptr_temp, ptr_type,
-							ptr_type, prefix, sym->llvm_name);
-						fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+						const char *ptr_type = get_llvm_type_string(&sym->type_info);
+						ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %s%s%s\n", ptr_temp,
+							symbol_volatile(sym), ptr_type, ptr_type, prefix,
+							sym->llvm_name, sym->is_parameter ? ".addr" : "");
+						ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 							addr_temp, element_type, element_type, ptr_temp, index_str);
-						free(ptr_type);
 					}
 
 					int final_value = value;
@@ -1032,21 +1212,22 @@ static int generate_expression(ast_node_t *node)
 					// Store value
 					if (node->data.assignment.value->type == AST_NUMBER ||
 					    node->data.assignment.value->type == AST_CHARACTER) {
-						fprintf(ctx.output, "  store %s %d, %s* %%t%d\n", element_type, value,
-							element_type, addr_temp);
+						ir_printf(&ctx.out, "  store %s%s %d, %s* %%t%d\n", access,
+							element_type, value, element_type, addr_temp);
 					} else {
-						fprintf(ctx.output, "  store %s %%t%d, %s* %%t%d\n", element_type,
-							final_value, element_type, addr_temp);
+						ir_printf(&ctx.out, "  store %s%s %%t%d, %s* %%t%d\n", access,
+							element_type, final_value, element_type, addr_temp);
 					}
 
-					free(element_type);
 					return final_value;
 				}
 			} else if (node->data.assignment.lvalue->type == AST_DEREFERENCE) {
 				// Handle *pointer = value
 				int ptr = generate_expression(node->data.assignment.lvalue->data.dereference.operand);
-				char *result_type = get_llvm_type_string(
+				const char *result_type = get_llvm_type_string(
 					&node->data.assignment.lvalue->data.dereference.result_type);
+				const char *access =
+					access_volatile(&node->data.assignment.lvalue->data.dereference.result_type);
 
 				char ptr_str[32];
 				if (node->data.assignment.lvalue->data.dereference.operand->type == AST_NUMBER ||
@@ -1069,14 +1250,13 @@ static int generate_expression(ast_node_t *node)
 
 				if (node->data.assignment.value->type == AST_NUMBER ||
 				    node->data.assignment.value->type == AST_CHARACTER) {
-					fprintf(ctx.output, "  store %s %d, %s* %s\n", result_type, value, result_type,
-						ptr_str);
-				} else {
-					fprintf(ctx.output, "  store %s %%t%d, %s* %s\n", result_type, final_value,
+					ir_printf(&ctx.out, "  store %s%s %d, %s* %s\n", access, result_type, value,
 						result_type, ptr_str);
+				} else {
+					ir_printf(&ctx.out, "  store %s%s %%t%d, %s* %s\n", access, result_type,
+						final_value, result_type, ptr_str);
 				}
 
-				free(result_type);
 				return final_value;
 			}
 		}
@@ -1093,14 +1273,14 @@ static int generate_expression(ast_node_t *node)
 				return -1;
 			}
 
-			symbol_t *sym = find_symbol(ctx.symbol_table, operand->data.identifier.name);
+			symbol_t *sym = operand->data.identifier.symbol;
 			if (!sym) {
 				fprintf(stderr, "Undefined variable in increment/decrement: %s\n",
 					operand->data.identifier.name);
 				return -1;
 			}
 
-			char *type_str = get_llvm_type_string(&sym->type_info);
+			const char *type_str = get_llvm_type_string(&sym->type_info);
 			int old_val_temp = get_next_temp();
 			int new_val_temp = get_next_temp();
 
@@ -1108,11 +1288,11 @@ static int generate_expression(ast_node_t *node)
 
 			// Load current value
 			if (sym->is_parameter) {
-				fprintf(ctx.output, "  %%t%d = load %s, %s* %%%s.addr\n", old_val_temp, type_str,
-					type_str, sym->llvm_name);
+				ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %%%s.addr\n", old_val_temp,
+					symbol_volatile(sym), type_str, type_str, sym->llvm_name);
 			} else {
-				fprintf(ctx.output, "  %%t%d = load %s, %s* %s%s\n", old_val_temp, type_str, type_str,
-					prefix, sym->llvm_name);
+				ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %s%s\n", old_val_temp,
+					symbol_volatile(sym), type_str, type_str, prefix, sym->llvm_name);
 			}
 
 			// Calculate new value
@@ -1126,12 +1306,11 @@ static int generate_expression(ast_node_t *node)
 				type_info_t elem_info = deep_copy_type_info(&sym->type_info);
 				elem_info.pointer_level--; // Dereference to get base type
 
-				char *elem_type_str = get_llvm_type_string(&elem_info);
+				const char *elem_type_str = get_llvm_type_string(&elem_info);
 
-				fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %d\n", new_val_temp,
+				ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %d\n", new_val_temp,
 					elem_type_str, elem_type_str, old_val_temp, offset);
 
-				free(elem_type_str);
 				free_type_info(&elem_info);
 			} else {
 				// Integer arithmetic using add/sub
@@ -1139,21 +1318,19 @@ static int generate_expression(ast_node_t *node)
 					(node->data.unary_op.op == OP_PREINC || node->data.unary_op.op == OP_POSTINC)
 						? "add"
 						: "sub";
-				fprintf(ctx.output, "  %%t%d = %s %s %%t%d, 1\n", new_val_temp, op_str, type_str,
-					old_val_temp);
+				ir_printf(&ctx.out, "  %%t%d = %s%s %s %%t%d, 1\n", new_val_temp, op_str,
+					has_signed_overflow(&sym->type_info) ? " nsw" : "", type_str, old_val_temp);
 			}
 
 			// Store new value
 			if (sym->is_parameter) {
-				fprintf(ctx.output, "  store %s %%t%d, %s* %%%s.addr\n", type_str, new_val_temp,
-					type_str, sym->llvm_name);
+				ir_printf(&ctx.out, "  store %s%s %%t%d, %s* %%%s.addr\n", symbol_volatile(sym),
+					type_str, new_val_temp, type_str, sym->llvm_name);
 			} else {
-				fprintf(ctx.output, "  store %s %%t%d, %s* %s%s\n", type_str, new_val_temp, type_str,
-					prefix, sym->llvm_name);
+				ir_printf(&ctx.out, "  store %s%s %%t%d, %s* %s%s\n", symbol_volatile(sym), type_str,
+					new_val_temp, type_str, prefix, sym->llvm_name);
 			}
 
-			free(type_str);
-
 			// Return appropriate value
 			if (node->data.unary_op.op == OP_PREINC || node->data.unary_op.op == OP_PREDEC) {
 				return new_val_temp;
@@ -1174,13 +1351,28 @@ static int generate_expression(ast_node_t *node)
 
 		switch (node->data.unary_op.op) {
 		case OP_NEG:
-			fprintf(ctx.output, "  %%t%d = sub i32 0, %s\n", temp, operand_str);
+			ir_printf(&ctx.out, "  %%t%d = sub i32 0, %s\n", temp, operand_str);
 			break;
-		case OP_NOT:
-			fprintf(ctx.output, "  %%t%d = icmp eq i32 %s, 0\n", temp, operand_str);
+		case OP_NOT: {
+			// Compared with zero at the operand's own width: i1 for a
+			// comparison, i64 for a long, null for a pointer
+			type_info_t operand_type = get_expression_type(node->data.unary_op.operand, ctx.symbol_table);
+			const llvm_type_t *type = llvm_type_of(&operand_type);
+			if (operand_type.is_array)
+				type = llvm_pointer_to(type);
+			if (llvm_type_is_pointer(type))
+				ir_printf(&ctx.out, "  %%t%d = icmp eq %s %s, null\n", temp, type->name, operand_str);
+			else
+				ir_printf(&ctx.out, "  %%t%d = icmp eq %s %s, 0\n", temp,
+					llvm_type_is_integer(type) && node->data.unary_op.operand->type != AST_NUMBER
+						? type->name
+						: "i32",
+					operand_str);
+			free_type_info(&operand_type);
 			break;
+		}
 		case OP_BNOT:
-			fprintf(ctx.output, "  %%t%d = xor i32 %s, -1\n", temp, operand_str);
+			ir_printf(&ctx.out, "  %%t%d = xor i32 %s, -1\n", temp, operand_str);
 			break;
 		default:
 			fprintf(stderr, "Unknown unary operator: %d\n", node->data.unary_op.op);
@@ -1204,10 +1396,6 @@ static int generate_expression(ast_node_t *node)
 		    ((true_type.pointer_level > 0 || true_type.is_array) &&
 		     (false_type.pointer_level > 0 || false_type.is_array))) {
 
-			if (node->data.conditional.result_type.base_type) {
-				free(node->data.conditional.result_type.base_type);
-			}
-
 			node->data.conditional.result_type = deep_copy_type_info(&true_type);
 
 			if (node->data.conditional.result_type.is_array) {
@@ -1216,67 +1404,66 @@ static int generate_expression(ast_node_t *node)
 			}
 		}
 
-		char *result_type_str = get_llvm_type_string(&node->data.conditional.result_type);
-		fprintf(ctx.output, "  %%t%d.addr = alloca %s\n", result_temp, result_type_str);
+		const char *result_type_str = get_llvm_type_string(&node->data.conditional.result_type);
+		ir_printf(&ctx.out, "  %%t%d.addr = alloca %s\n", result_temp, result_type_str);
 
 		// Evaluate condition
 		int cond = generate_expression(node->data.conditional.condition);
 
 		int bool_temp = convert_to_boolean(node->data.conditional.condition, cond);
 
-		fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", bool_temp, true_label, false_label);
+		emit_cond_br(bool_temp, true_label, false_label);
 
 		// True branch
-		fprintf(ctx.output, "%s:\n", true_label);
+		ir_label_def(&ctx.out, true_label);
 		int true_val = generate_expression(node->data.conditional.true_expr);
 
 		// Handle constants or cast expression to match result type
 		if (node->data.conditional.true_expr->type == AST_NUMBER ||
 		    node->data.conditional.true_expr->type == AST_CHARACTER) {
 			if (node->data.conditional.result_type.pointer_level > 0 && true_val == 0) {
-				fprintf(ctx.output, "  store %s null, %s* %%t%d.addr\n", result_type_str,
+				ir_printf(&ctx.out, "  store %s null, %s* %%t%d.addr\n", result_type_str,
 					result_type_str, result_temp);
 			} else {
-				fprintf(ctx.output, "  store %s %d, %s* %%t%d.addr\n", result_type_str, true_val,
+				ir_printf(&ctx.out, "  store %s %d, %s* %%t%d.addr\n", result_type_str, true_val,
 					result_type_str, result_temp);
 			}
 		} else {
 			int casted_val = cast_value(true_val, &true_type, &node->data.conditional.result_type);
-			fprintf(ctx.output, "  store %s %%t%d, %s* %%t%d.addr\n", result_type_str, casted_val,
+			ir_printf(&ctx.out, "  store %s %%t%d, %s* %%t%d.addr\n", result_type_str, casted_val,
 				result_type_str, result_temp);
 		}
-		fprintf(ctx.output, "  br label %%%s\n", end_label);
+		emit_br(end_label);
 
 		// False branch
-		fprintf(ctx.output, "%s:\n", false_label);
+		ir_label_def(&ctx.out, false_label);
 		int false_val = generate_expression(node->data.conditional.false_expr);
 
 		// Handle constants or cast expression to match result type
 		if (node->data.conditional.false_expr->type == AST_NUMBER ||
 		    node->data.conditional.false_expr->type == AST_CHARACTER) {
 			if (node->data.conditional.result_type.pointer_level > 0 && false_val == 0) {
-				fprintf(ctx.output, "  store %s null, %s* %%t%d.addr\n", result_type_str,
+				ir_printf(&ctx.out, "  store %s null, %s* %%t%d.addr\n", result_type_str,
 					result_type_str, result_temp);
 			} else {
-				fprintf(ctx.output, "  store %s %d, %s* %%t%d.addr\n", result_type_str, false_val,
+				ir_printf(&ctx.out, "  store %s %d, %s* %%t%d.addr\n", result_type_str, false_val,
 					result_type_str, result_temp);
 			}
 		} else {
 			int casted_val = cast_value(false_val, &false_type, &node->data.conditional.result_type);
-			fprintf(ctx.output, "  store %s %%t%d, %s* %%t%d.addr\n", result_type_str, casted_val,
+			ir_printf(&ctx.out, "  store %s %%t%d, %s* %%t%d.addr\n", result_type_str, casted_val,
 				result_type_str, result_temp);
 		}
-		fprintf(ctx.output, "  br label %%%s\n", end_label);
+		emit_br(end_label);
 
 		// End - load result
-		fprintf(ctx.output, "%s:\n", end_label);
+		ir_label_def(&ctx.out, end_label);
 		int final_temp = get_next_temp();
-		fprintf(ctx.output, "  %%t%d = load %s, %s* %%t%d.addr\n", final_temp, result_type_str, result_type_str,
+		ir_printf(&ctx.out, "  %%t%d = load %s, %s* %%t%d.addr\n", final_temp, result_type_str, result_type_str,
 			result_temp);
 
 		free_type_info(&true_type);
 		free_type_info(&false_type);
-		free(result_type_str);
 		free(true_label);
 		free(false_label);
 		free(end_label);
@@ -1284,8 +1471,10 @@ static int generate_expression(ast_node_t *node)
 	}
 
 	case AST_SIZEOF: {
-		// Return the computed size as a constant
-		return (int)node->data.sizeof_op.size_value;
+		// Folding turns sizeof into a number; without it, callers expect a temp as well
+		int temp = get_next_temp();
+		ir_printf(&ctx.out, "  %%t%d = add i32 0, %zu\n", temp, node->data.sizeof_op.size_value);
+		return temp;
 	}
 
 	case AST_CAST: {
@@ -1293,39 +1482,34 @@ static int generate_expression(ast_node_t *node)
 		int temp = get_next_temp();
 
 		type_info_t source_type = get_expression_type(node->data.cast.expression, ctx.symbol_table);
-		char *source_type_str = get_llvm_type_string(&source_type);
-		char *target_type_str = get_llvm_type_string(&node->data.cast.target_type);
+		const llvm_type_t *source = llvm_type_of(&source_type);
+		if (source_type.is_array)
+			source = llvm_pointer_to(source);
+		const llvm_type_t *target = llvm_type_of(&node->data.cast.target_type);
 
 		// Handle different cast types
-		if (strcmp(source_type_str, target_type_str) == 0) {
-			// No cast needed
-			free(source_type_str);
-			free(target_type_str);
-			free_type_info(&source_type);
-			return operand;
-		}
-
-		// Implement various cast operations
 		char operand_str[32];
-		if (node->data.cast.expression->type == AST_NUMBER) {
+		int constant = node->data.cast.expression->type == AST_NUMBER ||
+			       node->data.cast.expression->type == AST_CHARACTER;
+		if (constant) {
 			snprintf(operand_str, sizeof(operand_str), "%d", operand);
 		} else {
 			snprintf(operand_str, sizeof(operand_str), "%%t%d", operand);
 		}
 
-		// Simple casting - extend for more complex cases
-		if (strcmp(target_type_str, "i32") == 0 && strcmp(source_type_str, "i8") == 0) {
-			fprintf(ctx.output, "  %%t%d = sext i8 %s to i32\n", temp, operand_str);
-		} else if (strcmp(target_type_str, "i8") == 0 && strcmp(source_type_str, "i32") == 0) {
-			fprintf(ctx.output, "  %%t%d = trunc i32 %s to i8\n", temp, operand_str);
-		} else {
-			// Default bitcast
-			fprintf(ctx.output, "  %%t%d = bitcast %s %s to %s\n", temp, source_type_str, operand_str,
-				target_type_str);
+		// Handle different cast types
+		if (source == target) {
+			free_type_info(&source_type);
+			if (!constant)
+				return operand; // No cast needed
+			// A retyped literal, as (unsigned)-1, still has to be a temp
+			ir_printf(&ctx.out, "  %%t%d = add %s 0, %s\n", temp, target->name, operand_str);
+			return temp;
 		}
 
-		free(source_type_str);
-		free(target_type_str);
+		ir_printf(&ctx.out, "  %%t%d = %s %s %s to %s\n", temp, cast_opcode(&source_type, source, target),
+			source->name, operand_str, target->name);
+
 		free_type_info(&source_type);
 		return temp;
 	}
@@ -1334,7 +1518,7 @@ static int generate_expression(ast_node_t *node)
 		ast_node_t *operand = node->data.address_of.operand;
 
 		if (operand->type == AST_IDENTIFIER) {
-			symbol_t *sym = find_symbol(ctx.symbol_table, operand->data.identifier.name);
+			symbol_t *sym = operand->data.identifier.symbol;
 			if (!sym) {
 				fprintf(stderr, "Undefined variable in address-of: %s\n",
 					operand->data.identifier.name);
@@ -1342,20 +1526,19 @@ static int generate_expression(ast_node_t *node)
 			}
 
 			int temp = get_next_temp();
-			char *var_type_str = get_llvm_type_string(&sym->type_info);
+			const char *var_type_str = get_llvm_type_string(&sym->type_info);
 
 			if (sym->is_parameter) {
 				// For parameters, return address of .addr
-				fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%%s.addr, i32 0\n", temp,
+				ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%%s.addr, i64 0\n", temp,
 					var_type_str, var_type_str, sym->llvm_name);
 			} else {
 				const char *prefix = sym->is_global ? "@" : "%";
 				// For local variables, return their address
-				fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %s%s, i32 0\n", temp, var_type_str,
+				ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %s%s, i64 0\n", temp, var_type_str,
 					var_type_str, prefix, sym->llvm_name);
 			}
 
-			free(var_type_str);
 			return temp;
 		}
 		if (operand->type == AST_ARRAY_ACCESS) {
@@ -1364,7 +1547,7 @@ static int generate_expression(ast_node_t *node)
 			ast_node_t *index_node = operand->data.array_access.index;
 
 			if (array_node->type == AST_IDENTIFIER) {
-				symbol_t *sym = find_symbol(ctx.symbol_table, array_node->data.identifier.name);
+				symbol_t *sym = array_node->data.identifier.symbol;
 				if (!sym) {
 					fprintf(stderr, "Undefined array in address-of: %s\n",
 						array_node->data.identifier.name);
@@ -1375,45 +1558,41 @@ static int generate_expression(ast_node_t *node)
 				int addr_temp = get_next_temp();
 
 				char index_str[32];
-				if (index_node->type == AST_NUMBER) {
-					snprintf(index_str, sizeof(index_str), "%d", index);
-				} else {
-					snprintf(index_str, sizeof(index_str), "%%t%d", index);
-				}
+				format_gep_index(index_str, sizeof(index_str), index_node, index);
 
-				char *element_type = get_llvm_type_string(&operand->data.array_access.element_type);
+				const char *element_type = get_llvm_type_string(&operand->data.array_access.element_type);
 
 				if (sym->type_info.is_array) {
 					if (sym->is_parameter) {
 						int ptr_temp = get_next_temp();
-						fprintf(ctx.output, "  %%t%d = load %s*, %s** %%%s.addr\n", ptr_temp,
-							element_type, element_type, sym->llvm_name);
-						fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+						ir_printf(&ctx.out, "  %%t%d = load %s%s*, %s** %%%s.addr\n", ptr_temp,
+							symbol_volatile(sym), element_type, element_type,
+							sym->llvm_name);
+						ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 							addr_temp, element_type, element_type, ptr_temp, index_str);
 					} else if (sym->type_info.is_vla) {
 						int ptr_temp = get_next_temp();
-						fprintf(ctx.output, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp,
+						ir_printf(&ctx.out, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp,
 							element_type, element_type, sym->llvm_name);
-						fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+						ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 							addr_temp, element_type, element_type, ptr_temp, index_str);
 					} else {
 						size_t array_length = get_array_length(sym, ctx.symbol_table);
-						fprintf(ctx.output,
-							"  %%t%d = getelementptr [%zu x %s], [%zu x %s]* %%%s, i32 0, i32 %s\n",
+						ir_printf(&ctx.out,
+							"  %%t%d = getelementptr inbounds [%zu x %s], [%zu x %s]* %s%s, i64 0, i64 %s\n",
 							addr_temp, array_length, element_type, array_length,
-							element_type, sym->llvm_name, index_str);
+							element_type, sym->is_global ? "@" : "%", sym->llvm_name, index_str);
 					}
 				} else if (sym->type_info.pointer_level > 0) {
 					int ptr_temp = get_next_temp();
-					char *ptr_type = get_llvm_type_string(&sym->type_info);
-					fprintf(ctx.output, "  %%t%d = load %s, %s* %%%s\n", ptr_temp, ptr_type,
-						ptr_type, sym->llvm_name);
-					fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+					const char *ptr_type = get_llvm_type_string(&sym->type_info);
+					ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %s%s%s\n", ptr_temp,
+						symbol_volatile(sym), ptr_type, ptr_type, sym->is_global ? "@" : "%",
+						sym->llvm_name, sym->is_parameter ? ".addr" : "");
+					ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 						addr_temp, element_type, element_type, ptr_temp, index_str);
-					free(ptr_type);
 				}
 
-				free(element_type);
 				return addr_temp;
 			}
 		} else if (operand->type == AST_DEREFERENCE) {
@@ -1425,7 +1604,7 @@ static int generate_expression(ast_node_t *node)
 			const char *member_name = operand->data.member_access.member;
 
 			if (object->type == AST_IDENTIFIER) {
-				symbol_t *obj_sym = find_symbol(ctx.symbol_table, object->data.identifier.name);
+				symbol_t *obj_sym = object->data.identifier.symbol;
 				if (!obj_sym || (!obj_sym->type_info.is_struct && !obj_sym->type_info.is_union)) {
 					fprintf(stderr, "Member access on non-struct/union in address-of\n");
 					return -1;
@@ -1445,13 +1624,12 @@ static int generate_expression(ast_node_t *node)
 				}
 
 				int addr_temp = get_next_temp();
-				char *struct_type = get_llvm_type_string(&obj_sym->type_info);
+				const char *struct_type = get_llvm_type_string(&obj_sym->type_info);
 
 				// Get address of member
-				fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%%s, i32 0, i32 %zu\n", addr_temp,
+				ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%%s, i32 0, i32 %zu\n", addr_temp,
 					struct_type, struct_type, obj_sym->llvm_name, member->offset);
 
-				free(struct_type);
 				return addr_temp;
 			}
 		}
@@ -1464,7 +1642,8 @@ static int generate_expression(ast_node_t *node)
 		int ptr = generate_expression(node->data.dereference.operand);
 		int temp = get_next_temp();
 
-		char *result_type = get_llvm_type_string(&node->data.dereference.result_type);
+		const char *result_type = get_llvm_type_string(&node->data.dereference.result_type);
+		const char *access = access_volatile(&node->data.dereference.result_type);
 
 		char ptr_str[32];
 		if (node->data.dereference.operand->type == AST_NUMBER) {
@@ -1473,9 +1652,8 @@ static int generate_expression(ast_node_t *node)
 			snprintf(ptr_str, sizeof(ptr_str), "%%t%d", ptr);
 		}
 
-		fprintf(ctx.output, "  %%t%d = load %s, %s* %s\n", temp, result_type, result_type, ptr_str);
+		ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %s\n", temp, access, result_type, result_type, ptr_str);
 
-		free(result_type);
 		return temp;
 	}
 
@@ -1485,7 +1663,7 @@ static int generate_expression(ast_node_t *node)
 		ast_node_t *index_node = node->data.array_access.index;
 
 		if (array_node->type == AST_IDENTIFIER) {
-			symbol_t *sym = find_symbol(ctx.symbol_table, array_node->data.identifier.name);
+			symbol_t *sym = array_node->data.identifier.symbol;
 			if (!sym) {
 				fprintf(stderr, "Undefined array: %s\n", array_node->data.identifier.name);
 				return -1;
@@ -1496,13 +1674,10 @@ static int generate_expression(ast_node_t *node)
 			int result_temp = get_next_temp();
 
 			char index_str[32];
-			if (index_node->type == AST_NUMBER) {
-				snprintf(index_str, sizeof(index_str), "%d", index);
-			} else {
-				snprintf(index_str, sizeof(index_str), "%%t%d", index);
-			}
+			format_gep_index(index_str, sizeof(index_str), index_node, index);
 
-			char *element_type = get_llvm_type_string(&node->data.array_access.element_type);
+			const char *element_type = get_llvm_type_string(&node->data.array_access.element_type);
+			const char *access = access_volatile(&node->data.array_access.element_type);
 
 			const char *prefix = sym->is_global ? "@" : "%";
 
@@ -1511,60 +1686,56 @@ static int generate_expression(ast_node_t *node)
 				if (sym->is_parameter) {
 					// Parameter array: load pointer first
 					int ptr_temp = get_next_temp();
-					char *param_type = get_llvm_type_string(&sym->type_info);
-					fprintf(ctx.output, "  %%t%d = load %s, %s* %%%s.addr\n", ptr_temp, param_type,
-						param_type, sym->llvm_name);
-					fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+					const char *param_type = get_llvm_type_string(&sym->type_info);
+					ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %%%s.addr\n", ptr_temp,
+						symbol_volatile(sym), param_type, param_type, sym->llvm_name);
+					ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 						addr_temp, element_type, element_type, ptr_temp, index_str);
-					free(param_type);
 				} else if (sym->type_info.is_vla) {
 					// VLA: load pointer first
 					int ptr_temp = get_next_temp();
-					fprintf(ctx.output, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp, element_type,
+					ir_printf(&ctx.out, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp, element_type,
 						element_type, sym->llvm_name);
-					fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+					ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 						addr_temp, element_type, element_type, ptr_temp, index_str);
 				} else if (sym->type_info.is_array) {
 					// Fixed array
 					if (sym->type_info.array_size &&
 					    sym->type_info.array_size->type == AST_NUMBER) {
 						size_t array_length = sym->type_info.array_size->data.number.value;
-						fprintf(ctx.output,
-							"  %%t%d = getelementptr [%zu x %s], [%zu x %s]* %s%s, i32 0, i32 %s\n",
+						ir_printf(&ctx.out,
+							"  %%t%d = getelementptr inbounds [%zu x %s], [%zu x %s]* %s%s, i64 0, i64 %s\n",
 							addr_temp, array_length, element_type, array_length,
 							element_type, prefix, sym->llvm_name, index_str);
 					} else {
 						// Incomplete array - treat as pointer
 						int ptr_temp = get_next_temp();
-						char *ptr_type = get_llvm_type_string(&sym->type_info);
-						fprintf(ctx.output, "  %%t%d = load %s, %s* %s%s\n", ptr_temp, ptr_type,
-							ptr_type, prefix, sym->llvm_name);
-						fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+						const char *ptr_type = get_llvm_type_string(&sym->type_info);
+						ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %s%s\n", ptr_temp,
+							symbol_volatile(sym), ptr_type, ptr_type, prefix,
+							sym->llvm_name);
+						ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 							addr_temp, element_type, element_type, ptr_temp, index_str);
-						free(ptr_type);
 					}
 				} else if (sym->type_info.pointer_level > 0) {
 					// Pointer access
 					int ptr_temp = get_next_temp();
-					char *ptr_type = get_llvm_type_string(&sym->type_info);
-					fprintf(ctx.output, "  %%t%d = load %s, %s* %s%s\n", ptr_temp, ptr_type,
-						ptr_type, prefix, sym->llvm_name);
-					fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%t%d, i32 %s\n",
+					const char *ptr_type = get_llvm_type_string(&sym->type_info);
+					ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %s%s\n", ptr_temp,
+						symbol_volatile(sym), ptr_type, ptr_type, prefix, sym->llvm_name);
+					ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%t%d, i64 %s\n",
 						addr_temp, element_type, element_type, ptr_temp, index_str);
-					free(ptr_type);
 				}
 			} else {
 				fprintf(stderr, "Array access on non-array/pointer variable: %s\n",
 					array_node->data.identifier.name);
-				free(element_type);
 				return -1;
 			}
 
 			// Load the value
-			fprintf(ctx.output, "  %%t%d = load %s, %s* %%t%d\n", result_temp, element_type, element_type,
-				addr_temp);
+			ir_printf(&ctx.out, "  %%t%d = load %s%s, %s* %%t%d\n", result_temp, access, element_type,
+				element_type, addr_temp);
 
-			free(element_type);
 			return result_temp;
 		}
 
@@ -1578,7 +1749,7 @@ static int generate_expression(ast_node_t *node)
 		const char *member_name = node->data.member_access.member;
 
 		if (object->type == AST_IDENTIFIER) {
-			symbol_t *obj_sym = find_symbol(ctx.symbol_table, object->data.identifier.name);
+			symbol_t *obj_sym = object->data.identifier.symbol;
 			if (!obj_sym || (!obj_sym->type_info.is_struct && !obj_sym->type_info.is_union)) {
 				fprintf(stderr, "Member access on non-struct/union\n");
 				return -1;
@@ -1599,19 +1770,17 @@ static int generate_expression(ast_node_t *node)
 			int addr_temp = get_next_temp();
 			int result_temp = get_next_temp();
 
-			char *struct_type = get_llvm_type_string(&obj_sym->type_info);
-			char *member_type = get_llvm_type_string(&member->type_info);
+			const char *struct_type = get_llvm_type_string(&obj_sym->type_info);
+			const char *member_type = get_llvm_type_string(&member->type_info);
 
 			// Get address of member
-			fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %%%s, i32 0, i32 %zu\n", addr_temp,
+			ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %%%s, i32 0, i32 %zu\n", addr_temp,
 				struct_type, struct_type, obj_sym->llvm_name, member->offset);
 
 			// Load member value
-			fprintf(ctx.output, "  %%t%d = load %s, %s* %%t%d\n", result_temp, member_type, member_type,
+			ir_printf(&ctx.out, "  %%t%d = load %s, %s* %%t%d\n", result_temp, member_type, member_type,
 				addr_temp);
 
-			free(struct_type);
-			free(member_type);
 			return result_temp;
 		}
 
@@ -1651,10 +1820,10 @@ static int generate_expression(ast_node_t *node)
 		int addr_temp = get_next_temp();
 		int result_temp = get_next_temp();
 
-		char *struct_type = get_llvm_type_string(&ptr_type);
 		// Remove one level of pointer for the struct type
-		struct_type[strlen(struct_type) - 1] = '\0';
-		char *member_type = get_llvm_type_string(&member->type_info);
+		const llvm_type_t *object_type = llvm_type_of(&ptr_type);
+		const char *struct_type = object_type->pointee ? object_type->pointee->name : object_type->name;
+		const char *member_type = get_llvm_type_string(&member->type_info);
 
 		char ptr_str[32];
 		if (object->type == AST_NUMBER) {
@@ -1664,28 +1833,26 @@ static int generate_expression(ast_node_t *node)
 		}
 
 		// Get address of member
-		fprintf(ctx.output, "  %%t%d = getelementptr %s, %s* %s, i32 0, i32 %zu\n", addr_temp, struct_type,
+		ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds %s, %s* %s, i32 0, i32 %zu\n", addr_temp, struct_type,
 			struct_type, ptr_str, member->offset);
 
 		// Load member value
-		fprintf(ctx.output, "  %%t%d = load %s, %s* %%t%d\n", result_temp, member_type, member_type, addr_temp);
+		ir_printf(&ctx.out, "  %%t%d = load %s, %s* %%t%d\n", result_temp, member_type, member_type, addr_temp);
 
-		free(struct_type);
-		free(member_type);
 		free_type_info(&ptr_type);
 		return result_temp;
 	}
 
 	case AST_CALL: {
-		symbol_t *func_sym = find_symbol(ctx.symbol_table, node->data.call.name);
+		symbol_t *func_sym = node->data.call.symbol;
 
 		int *arg_values = NULL;      // Holds temp IDs or constant values
-		char **arg_type_strs = NULL; // Holds type strings (e.g., "i32", "i64")
-		int *is_constant = NULL;     // Flags for constants
+		const llvm_type_t **arg_types = NULL; // Argument types (e.g., i32, i64)
+		int *is_constant = NULL;     // 1 for constants, 2 for null pointers
 
 		if (node->data.call.arg_count > 0) {
 			arg_values = malloc(sizeof(int) * node->data.call.arg_count);
-			arg_type_strs = malloc(sizeof(char *) * node->data.call.arg_count);
+			arg_types = malloc(sizeof(llvm_type_t *) * node->data.call.arg_count);
 			is_constant = malloc(sizeof(int) * node->data.call.arg_count);
 
 			for (int i = 0; i < node->data.call.arg_count; i++) {
@@ -1698,7 +1865,7 @@ static int generate_expression(ast_node_t *node)
 					arg_type.is_array = 0;
 					arg_type.pointer_level++;
 				}
-				arg_type_strs[i] = get_llvm_type_string(&arg_type);
+				arg_types[i] = llvm_type_of(&arg_type);
 				free_type_info(&arg_type);
 
 				// Determine if constant
@@ -1707,68 +1874,76 @@ static int generate_expression(ast_node_t *node)
 			}
 		}
 
-		// 2. Perform Type Checking and emit ZEXT if needed (BEFORE printing call)
+		// 2. Convert arguments to the parameter types (BEFORE printing call)
 		if (func_sym && func_sym->param_symbols) {
 			for (int i = 0; i < node->data.call.arg_count && i < func_sym->param_count; i++) {
 				type_info_t *expected = &func_sym->param_symbols[i]->data.parameter.type_info;
-				char *expected_str = get_llvm_type_string(expected);
-
-				// Check for i32 -> i64 mismatch
-				if (strcmp(arg_type_strs[i], "i32") == 0 && strcmp(expected_str, "i64") == 0) {
-					if (is_constant[i]) {
-						// For constants, just change the type label (e.g. "i32 12" -> "i64 12")
-						free(arg_type_strs[i]);
-						arg_type_strs[i] = strdup("i64");
-					} else {
-						// For variables, emit ZEXT instruction
-						int zext_temp = get_next_temp();
-						fprintf(ctx.output, "  %%t%d = zext i32 %%t%d to i64\n", zext_temp,
-							arg_values[i]);
-
-						// Update to use the new temporary
-						arg_values[i] = zext_temp;
-						free(arg_type_strs[i]);
-						arg_type_strs[i] = strdup("i64");
-						is_constant[i] = 0; // It's now a temp register
-					}
+				const llvm_type_t *expected_type = llvm_type_of(expected);
+				if (expected->is_array)
+					expected_type = llvm_pointer_to(expected_type);
+				if (arg_types[i] == expected_type)
+					continue;
+
+				if (is_constant[i] && llvm_type_is_pointer(expected_type) && arg_values[i] == 0) {
+					// A null pointer constant
+					arg_types[i] = expected_type;
+					is_constant[i] = 2;
+				} else if (!(llvm_type_is_integer(arg_types[i]) && llvm_type_is_integer(expected_type)) &&
+					   !(llvm_type_is_pointer(arg_types[i]) && llvm_type_is_pointer(expected_type))) {
+					continue;
+				} else if (is_constant[i]) {
+					// For constants, just change the type label (e.g. "i32 12" -> "i64 12")
+					arg_types[i] = expected_type;
+				} else if (llvm_type_is_pointer(arg_types[i])) {
+					// Such as int * to the void * of realloc()
+					int cast_temp = get_next_temp();
+					ir_printf(&ctx.out, "  %%t%d = bitcast %s %%t%d to %s\n", cast_temp,
+						arg_types[i]->name, arg_values[i], expected_type->name);
+					arg_values[i] = cast_temp;
+					arg_types[i] = expected_type;
+				} else {
+					// Widened by the argument's signedness, narrowed by truncation
+					type_info_t arg_type =
+						get_expression_type(node->data.call.args[i], ctx.symbol_table);
+					arg_values[i] = cast_value(arg_values[i], &arg_type, expected);
+					arg_types[i] = expected_type;
+					free_type_info(&arg_type);
 				}
-				free(expected_str);
 			}
 		}
 
 		// 3. Generate the CALL instruction
-		char *return_type = get_llvm_type_string(&node->data.call.return_type);
+		const char *return_type = get_llvm_type_string(&node->data.call.return_type);
 		int returns_void = (strcmp(return_type, "void") == 0);
 		int temp = -1;
 
 		if (returns_void) {
-			fprintf(ctx.output, "  call %s @%s(", return_type, node->data.call.name);
+			ir_printf(&ctx.out, "  call %s @%s(", return_type, node->data.call.name);
 		} else {
 			temp = get_next_temp();
-			fprintf(ctx.output, "  %%t%d = call %s @%s(", temp, return_type, node->data.call.name);
+			ir_printf(&ctx.out, "  %%t%d = call %s @%s(", temp, return_type, node->data.call.name);
 		}
 
 		for (int i = 0; i < node->data.call.arg_count; i++) {
 			if (i > 0)
-				fprintf(ctx.output, ", ");
+				ir_puts(&ctx.out, ", ");
 
-			if (is_constant[i]) {
-				fprintf(ctx.output, "%s %d", arg_type_strs[i], arg_values[i]);
+			if (is_constant[i] == 2) {
+				ir_printf(&ctx.out, "%s null", arg_types[i]->name);
+			} else if (is_constant[i]) {
+				ir_printf(&ctx.out, "%s %d", arg_types[i]->name, arg_values[i]);
 			} else {
-				fprintf(ctx.output, "%s %%t%d", arg_type_strs[i], arg_values[i]);
+				ir_printf(&ctx.out, "%s %%t%d", arg_types[i]->name, arg_values[i]);
 			}
 		}
-		fprintf(ctx.output, ")\n");
+		ir_printf(&ctx.out, ")\n");
 
 		// Cleanup
 		if (node->data.call.arg_count > 0) {
-			for (int i = 0; i < node->data.call.arg_count; i++)
-				free(arg_type_strs[i]);
-			free(arg_type_strs);
+			free(arg_types);
 			free(arg_values);
 			free(is_constant);
 		}
-		free(return_type);
 
 		// Return temp for non-void, -1 for void
 		return temp;
@@ -1780,11 +1955,248 @@ static int generate_expression(ast_node_t *node)
 	}
 }
 
+// Statements that start a basic block and so stay reachable after a terminator
+static int starts_basic_block(ast_node_t *node)
+{
+	return node->type == AST_LABEL_STMT || node->type == AST_CASE_STMT || node->type == AST_DEFAULT_STMT ||
+	       node->type == AST_COMPOUND_STMT;
+}
+
+// Give every case/default of a switch a block label and record it in the
+// switch node. Nested switches own their labels and are skipped.
+static void collect_switch_cases(ast_node_t *switch_node, ast_node_t *stmt, case_label_t **tail)
+{
+	if (!stmt)
+		return;
+
+	switch (stmt->type) {
+	case AST_CASE_STMT: {
+		char *label = generate_label("switch_case");
+		stmt->data.case_stmt.label_name = arena_strdup(&ctx.arena, label);
+		free(label);
+		case_label_t *case_label = arena_alloc(&ctx.arena, sizeof(case_label_t));
+		case_label->value = stmt->data.case_stmt.value;
+		case_label->label_name = stmt->data.case_stmt.label_name;
+		case_label->next = NULL;
+		*tail = case_label;
+		tail = &(*tail)->next;
+		collect_switch_cases(switch_node, stmt->data.case_stmt.statement, tail);
+		break;
+	}
+	case AST_DEFAULT_STMT: {
+		char *label = generate_label("switch_default");
+		stmt->data.default_stmt.label_name = arena_strdup(&ctx.arena, label);
+		free(label);
+		switch_node->data.switch_stmt.default_label = stmt->data.default_stmt.label_name;
+		collect_switch_cases(switch_node, stmt->data.default_stmt.statement, tail);
+		break;
+	}
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < stmt->data.compound.stmt_count; i++) {
+			collect_switch_cases(switch_node, stmt->data.compound.statements[i], tail);
+			while (*tail)
+				tail = &(*tail)->next;
+		}
+		break;
+	case AST_IF_STMT:
+		collect_switch_cases(switch_node, stmt->data.if_stmt.then_stmt, tail);
+		while (*tail)
+			tail = &(*tail)->next;
+		collect_switch_cases(switch_node, stmt->data.if_stmt.else_stmt, tail);
+		break;
+	case AST_WHILE_STMT:
+		collect_switch_cases(switch_node, stmt->data.while_stmt.body, tail);
+		break;
+	case AST_DO_WHILE_STMT:
+		collect_switch_cases(switch_node, stmt->data.do_while_stmt.body, tail);
+		break;
+	case AST_FOR_STMT:
+		collect_switch_cases(switch_node, stmt->data.for_stmt.body, tail);
+		break;
+	case AST_LABEL_STMT:
+		collect_switch_cases(switch_node, stmt->data.label_stmt.statement, tail);
+		break;
+	default:
+		break;
+	}
+}
+
+typedef struct {
+	long long value;
+	const char *label;
+} switch_case_t;
+
+static int compare_switch_cases(const void *a, const void *b)
+{
+	long long x = ((const switch_case_t *)a)->value;
+	long long y = ((const switch_case_t *)b)->value;
+	return (x > y) - (x < y);
+}
+
+// Jump tables are used for at least this many cases covering at least
+// this percentage of their value range
+#define SWITCH_TABLE_MIN_CASES 4
+#define SWITCH_TABLE_MIN_DENSITY 40
+#define SWITCH_TABLE_MAX_ENTRIES 4096
+
+// O(1) dispatch: index a table of block addresses and jump indirectly
+static void emit_switch_table(const char *value, const char *type, const switch_case_t *cases, int count,
+			      const char *default_label)
+{
+	long long min = cases[0].value;
+	long long range = cases[count - 1].value - min + 1;
+	int table_id = ++ctx.label_counter;
+	char *table_label = generate_label("switch_table");
+
+	int index = get_next_temp();
+	ir_printf(&ctx.out, "  %%t%d = sub %s %s, %lld\n", index, type, value, min);
+	int in_range = get_next_temp();
+	ir_printf(&ctx.out, "  %%t%d = icmp ult %s %%t%d, %lld\n", in_range, type, index, range);
+	emit_cond_br(in_range, table_label, default_label);
+
+	ir_label_def(&ctx.out, table_label);
+	if (strcmp(type, "i64") != 0) {
+		int wide = get_next_temp();
+		ir_printf(&ctx.out, "  %%t%d = zext %s %%t%d to i64\n", wide, type, index);
+		index = wide;
+	}
+	int slot = get_next_temp();
+	ir_printf(&ctx.out, "  %%t%d = getelementptr inbounds [%lld x i8*], [%lld x i8*]* @%s.switch_table%d, i64 0, i64 %%t%d\n",
+		slot, range, range, ctx.current_function_name, table_id, index);
+	int target = get_next_temp();
+	ir_printf(&ctx.out, "  %%t%d = load i8*, i8** %%t%d\n", target, slot);
+	ir_printf(&ctx.out, "  indirectbr i8* %%t%d, [label %%%s", target, default_label);
+	for (int i = 0; i < count; i++) {
+		if (i > 0 && cases[i].label == cases[i - 1].label)
+			continue;
+		ir_printf(&ctx.out, ", label %%%s", cases[i].label);
+	}
+	ir_puts(&ctx.out, "]\n");
+
+	// The table itself is a module-level constant
+	ir_printf(&ctx.globals, "@%s.switch_table%d = private unnamed_addr constant [%lld x i8*] [",
+		ctx.current_function_name, table_id, range);
+	int next = 0;
+	for (long long v = min; v < min + range; v++) {
+		const char *label = default_label;
+		if (next < count && cases[next].value == v)
+			label = cases[next++].label;
+		ir_printf(&ctx.globals, "%si8* blockaddress(@%s, %%%s)", v > min ? ", " : "",
+			ctx.current_function_name, label);
+	}
+	ir_puts(&ctx.globals, "]\n");
+
+	free(table_label);
+}
+
+// O(log n) dispatch over cases[lo, hi), sorted by value
+static void emit_switch_tree(const char *value, const char *type, const switch_case_t *cases, int lo, int hi,
+			     const char *default_label)
+{
+	if (hi - lo <= 3) {
+		for (int i = lo; i < hi; i++) {
+			char *next_label = generate_label("switch_test");
+			int cond = get_next_temp();
+			ir_printf(&ctx.out, "  %%t%d = icmp eq %s %s, %lld\n", cond, type, value, cases[i].value);
+			emit_cond_br(cond, cases[i].label, next_label);
+			ir_label_def(&ctx.out, next_label);
+			free(next_label);
+		}
+		emit_br(default_label);
+		return;
+	}
+
+	int mid = lo + (hi - lo) / 2;
+	char *low_label = generate_label("switch_low");
+	char *high_label = generate_label("switch_high");
+	int cond = get_next_temp();
+	ir_printf(&ctx.out, "  %%t%d = icmp slt %s %s, %lld\n", cond, type, value, cases[mid].value);
+	emit_cond_br(cond, low_label, high_label);
+
+	ir_label_def(&ctx.out, low_label);
+	emit_switch_tree(value, type, cases, lo, mid, default_label);
+	ir_label_def(&ctx.out, high_label);
+	emit_switch_tree(value, type, cases, mid, hi, default_label);
+
+	free(low_label);
+	free(high_label);
+}
+
+static void emit_switch_dispatch(const char *value, const char *type, switch_case_t *cases, int count,
+				 const char *default_label)
+{
+	qsort(cases, count, sizeof(switch_case_t), compare_switch_cases);
+
+	switch_lowering_t mode = codegen_options.switch_lowering;
+	if (count > 0 && (mode == SWITCH_LOWER_AUTO || mode == SWITCH_LOWER_TABLE)) {
+		unsigned long long range = (unsigned long long)cases[count - 1].value - cases[0].value + 1;
+		int dense = count >= SWITCH_TABLE_MIN_CASES &&
+			    (unsigned long long)count * 100 >= range * SWITCH_TABLE_MIN_DENSITY;
+		if (range <= SWITCH_TABLE_MAX_ENTRIES && (dense || mode == SWITCH_LOWER_TABLE)) {
+			emit_switch_table(value, type, cases, count, default_label);
+			return;
+		}
+	}
+
+	if (mode == SWITCH_LOWER_TREE) {
+		emit_switch_tree(value, type, cases, 0, count, default_label);
+		return;
+	}
+
+	ir_printf(&ctx.out, "  switch %s %s, label %%%s [\n", type, value, default_label);
+	for (int i = 0; i < count; i++)
+		ir_printf(&ctx.out, "    %s %lld, label %%%s\n", type, cases[i].value, cases[i].label);
+	ir_puts(&ctx.out, "  ]\n");
+}
+
+// Linkage and kind of a global variable: static ones are internal, and
+// const objects (not pointers to const data) are constants, as long as
+// exact_init says the emitted initializer is the declared one. A constant
+// with a stand-in zero would let LLVM fold its reads to that zero.
+static const char *global_definition_kind(const type_info_t *type, int exact_init)
+{
+	int constant = (type->qualifiers & QUAL_CONST) && type->pointer_level == 0 && exact_init;
+	if (type->storage_class == STORAGE_STATIC)
+		return constant ? "internal constant" : "internal global";
+	return constant ? "constant" : "global";
+}
+
 // Generate statement
+// A declaration jumped over, as one before the first case of a switch, is
+// not generated, but a label after it may still use the variable, so its
+// slot goes in the entry block. C does not allow jumping past a VLA.
+static void emit_skipped_declaration(ast_node_t *node)
+{
+	if (node->type == AST_DECLARATION && node->data.declaration.symbol &&
+	    !node->data.declaration.symbol->is_global) {
+		symbol_t *sym = node->data.declaration.symbol;
+		ir_printf(&ctx.entry_allocas, "  %%%s = alloca %s\n", sym->llvm_name,
+			get_llvm_type_string(&sym->type_info));
+	} else if (node->type == AST_ARRAY_DECL && node->data.array_decl.symbol &&
+		   !node->data.array_decl.symbol->is_global && !node->data.array_decl.is_vla &&
+		   node->data.array_decl.size && node->data.array_decl.size->type == AST_NUMBER) {
+		ir_printf(&ctx.entry_allocas, "  %%%s = alloca [%d x %s]\n", node->data.array_decl.symbol->llvm_name,
+			node->data.array_decl.size->data.number.value,
+			get_llvm_type_string(&node->data.array_decl.type_info));
+	}
+}
+
 static void generate_statement(ast_node_t *node)
 {
-	if (!node || ctx.in_return_block)
+	if (!node)
 		return;
+	if (ctx.in_return_block && !starts_basic_block(node)) {
+		if (!contains_label(node)) {
+			emit_skipped_declaration(node);
+			return;
+		}
+		// A case or label inside still gets jumped to, so the statement is
+		// generated whole in a block nothing branches to
+		char *dead_label = generate_label("unreachable");
+		ir_label_def(&ctx.out, dead_label);
+		free(dead_label);
+		ctx.in_return_block = 0;
+	}
 
 	switch (node->type) {
 	case AST_COMPOUND_STMT: {
@@ -1793,47 +2205,51 @@ static void generate_statement(ast_node_t *node)
 	}
 
 	case AST_DECLARATION: {
-		symbol_t *sym = add_symbol(ctx.symbol_table, node->data.declaration.name, SYM_VARIABLE,
-					   node->data.declaration.type_info);
+		symbol_t *sym = node->data.declaration.symbol;
 		if (!sym) {
 			fprintf(stderr, "Failed to add symbol: %s\n", node->data.declaration.name);
 			return;
 		}
 
-		char *type_str = get_llvm_type_string(&sym->type_info);
+		const char *type_str = get_llvm_type_string(&sym->type_info);
 
 		if (sym->is_global) {
-			fprintf(ctx.output, "@%s = global %s ", sym->llvm_name, type_str);
+			ast_node_t *init = node->data.declaration.init;
+			int exact_init = !init || init->type == AST_NUMBER || init->type == AST_CHARACTER ||
+					 init->type == AST_STRING_LITERAL;
+			ir_printf(&ctx.out, "@%s = %s %s ", sym->llvm_name,
+				global_definition_kind(&sym->type_info, exact_init), type_str);
 
 			if (node->data.declaration.init) {
 				if (node->data.declaration.init->type == AST_NUMBER) {
-					fprintf(ctx.output, "%d", node->data.declaration.init->data.number.value);
+					ir_printf(&ctx.out, "%d", node->data.declaration.init->data.number.value);
 				} else if (node->data.declaration.init->type == AST_CHARACTER) {
-					fprintf(ctx.output, "%d",
+					ir_printf(&ctx.out, "%d",
 						(int)node->data.declaration.init->data.character.value);
 				} else if (node->data.declaration.init->type == AST_STRING_LITERAL) {
 					int str_id = store_string_literal(
-						node->data.declaration.init->data.string_literal.value);
+						node->data.declaration.init->data.string_literal.value,
+						node->data.declaration.init->data.string_literal.length);
 					size_t len = node->data.declaration.init->data.string_literal.length + 1;
-					fprintf(ctx.output,
+					ir_printf(&ctx.out,
 						"getelementptr inbounds ([%zu x i8], [%zu x i8]* @.str%d, "
 						"i32 0, i32 0)",
 						len, len, str_id);
 				} else {
-					fprintf(ctx.output, "0");
+					ir_puts(&ctx.out, "0");
 				}
 			} else {
 				if (sym->type_info.is_array || sym->type_info.is_struct || sym->type_info.is_union) {
-					fprintf(ctx.output, "zeroinitializer");
+					ir_puts(&ctx.out, "zeroinitializer");
 				} else if (sym->type_info.pointer_level > 0) {
-					fprintf(ctx.output, "null");
+					ir_puts(&ctx.out, "null");
 				} else {
-					fprintf(ctx.output, "0");
+					ir_puts(&ctx.out, "0");
 				}
 			}
-			fprintf(ctx.output, "\n");
+			ir_printf(&ctx.out, "\n");
 		} else {
-			fprintf(ctx.output, "  %%%s = alloca %s\n", sym->llvm_name, type_str);
+			ir_printf(&ctx.out, "  %%%s = alloca %s\n", sym->llvm_name, type_str);
 
 			if (node->data.declaration.init) {
 				int init_value = generate_expression(node->data.declaration.init);
@@ -1842,11 +2258,11 @@ static void generate_statement(ast_node_t *node)
 				if (node->data.declaration.init->type == AST_NUMBER ||
 				    node->data.declaration.init->type == AST_CHARACTER) {
 					if (sym->type_info.pointer_level > 0 && init_value == 0) {
-						fprintf(ctx.output, "  store %s null, %s* %%%s\n", type_str, type_str,
-							sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s null, %s* %%%s\n",
+							symbol_volatile(sym), type_str, type_str, sym->llvm_name);
 					} else {
-						fprintf(ctx.output, "  store %s %d, %s* %%%s\n", type_str, init_value,
-							type_str, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s %d, %s* %%%s\n", symbol_volatile(sym),
+							type_str, init_value, type_str, sym->llvm_name);
 					}
 				} else {
 					type_info_t init_type =
@@ -1854,13 +2270,12 @@ static void generate_statement(ast_node_t *node)
 					final_value = cast_value(init_value, &init_type, &sym->type_info);
 					free_type_info(&init_type);
 
-					fprintf(ctx.output, "  store %s %%t%d, %s* %%%s\n", type_str, final_value,
-						type_str, sym->llvm_name);
+					ir_printf(&ctx.out, "  store %s%s %%t%d, %s* %%%s\n", symbol_volatile(sym),
+						type_str, final_value, type_str, sym->llvm_name);
 				}
 			}
 		}
 
-		free(type_str);
 		break;
 	}
 
@@ -1868,13 +2283,13 @@ static void generate_statement(ast_node_t *node)
 		if (node->data.assignment.name) {
 			int value = generate_expression(node->data.assignment.value);
 
-			symbol_t *sym = find_symbol(ctx.symbol_table, node->data.assignment.name);
+			symbol_t *sym = node->data.assignment.symbol;
 			if (!sym) {
 				fprintf(stderr, "Undefined variable in assignment: %s\n", node->data.assignment.name);
 				return;
 			}
 
-			char *type_str = get_llvm_type_string(&sym->type_info);
+			const char *type_str = get_llvm_type_string(&sym->type_info);
 			int final_value = value;
 
 			if (node->data.assignment.value->type != AST_NUMBER) {
@@ -1887,34 +2302,32 @@ static void generate_statement(ast_node_t *node)
 			if (sym->is_parameter) {
 				if (node->data.assignment.value->type == AST_NUMBER) {
 					if (sym->type_info.pointer_level > 0 && value == 0) {
-						fprintf(ctx.output, "  store %s null, %s* %%%s.addr\n", type_str,
-							type_str, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s null, %s* %%%s.addr\n",
+							symbol_volatile(sym), type_str, type_str, sym->llvm_name);
 					} else {
-						fprintf(ctx.output, "  store %s %d, %s* %%%s.addr\n", type_str, value,
-							type_str, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s %d, %s* %%%s.addr\n",
+							symbol_volatile(sym), type_str, value, type_str,
+							sym->llvm_name);
 					}
 				} else {
-					fprintf(ctx.output, "  store %s %%t%d, %s* %%%s.addr\n", type_str, final_value,
-						type_str, sym->llvm_name);
+					emit_store_symbol(type_str, final_value, sym);
 				}
 			} else {
 				const char *prefix = sym->is_global ? "@" : "%";
 
 				if (node->data.assignment.value->type == AST_NUMBER) {
 					if (sym->type_info.pointer_level > 0 && value == 0) {
-						fprintf(ctx.output, "  store %s null, %s* %s%s\n", type_str, type_str,
-							prefix, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s null, %s* %s%s\n",
+							symbol_volatile(sym), type_str, type_str, prefix,
+							sym->llvm_name);
 					} else {
-						fprintf(ctx.output, "  store %s %d, %s* %s%s\n", type_str, value,
-							type_str, prefix, sym->llvm_name);
+						ir_printf(&ctx.out, "  store %s%s %d, %s* %s%s\n", symbol_volatile(sym),
+							type_str, value, type_str, prefix, sym->llvm_name);
 					}
 				} else {
-					fprintf(ctx.output, "  store %s %%t%d, %s* %s%s\n", type_str, final_value,
-						type_str, prefix, sym->llvm_name);
+					emit_store_symbol(type_str, final_value, sym);
 				}
 			}
-
-			free(type_str);
 		} else if (node->data.assignment.lvalue) {
 			int value = generate_expression(node->data.assignment.value);
 
@@ -1923,7 +2336,7 @@ static void generate_statement(ast_node_t *node)
 				ast_node_t *index = node->data.assignment.lvalue->data.array_access.index;
 
 				if (array->type == AST_IDENTIFIER) {
-					symbol_t *sym = find_symbol(ctx.symbol_table, array->data.identifier.name);
+					symbol_t *sym = array->data.identifier.symbol;
 					if (!sym) {
 						fprintf(stderr, "Undefined array in assignment: %s\n",
 							array->data.identifier.name);
@@ -1934,39 +2347,38 @@ static void generate_statement(ast_node_t *node)
 					int addr_temp = get_next_temp();
 
 					char index_str[32];
-					if (index->type == AST_NUMBER) {
-						snprintf(index_str, sizeof(index_str), "%d", index_val);
-					} else {
-						snprintf(index_str, sizeof(index_str), "%%t%d", index_val);
-					}
+					format_gep_index(index_str, sizeof(index_str), index, index_val);
 
-					char *element_type = get_llvm_type_string(
+					const char *element_type = get_llvm_type_string(
+						&node->data.assignment.lvalue->data.array_access.element_type);
+					const char *access = access_volatile(
 						&node->data.assignment.lvalue->data.array_access.element_type);
 
 					if (sym->type_info.is_array) {
 						if (sym->is_parameter) {
 							int ptr_temp = get_next_temp();
-							fprintf(ctx.output, "  %%t%d = load %s*, %s** %%%s.addr\n",
-								ptr_temp, element_type, element_type, sym->llvm_name);
-							fprintf(ctx.output,
-								"  %%t%d = getelementptr %s, %s* %%t%d, "
-								"i32 %s\n",
+							ir_printf(&ctx.out, "  %%t%d = load %s%s*, %s** %%%s.addr\n",
+								ptr_temp, symbol_volatile(sym), element_type,
+								element_type, sym->llvm_name);
+							ir_printf(&ctx.out,
+								"  %%t%d = getelementptr inbounds %s, %s* %%t%d, "
+								"i64 %s\n",
 								addr_temp, element_type, element_type, ptr_temp,
 								index_str);
 						} else if (sym->type_info.is_vla) {
 							int ptr_temp = get_next_temp();
-							fprintf(ctx.output, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp,
+							ir_printf(&ctx.out, "  %%t%d = load %s*, %s** %%%s\n", ptr_temp,
 								element_type, element_type, sym->llvm_name);
-							fprintf(ctx.output,
-								"  %%t%d = getelementptr %s, %s* %%t%d, "
-								"i32 %s\n",
+							ir_printf(&ctx.out,
+								"  %%t%d = getelementptr inbounds %s, %s* %%t%d, "
+								"i64 %s\n",
 								addr_temp, element_type, element_type, ptr_temp,
 								index_str);
 						} else {
 							size_t array_length = get_array_length(sym, ctx.symbol_table);
-							fprintf(ctx.output,
-								"  %%t%d = getelementptr [%zu x %s], [%zu "
-								"x %s]* %%%s, i32 0, i32 %s\n",
+							ir_printf(&ctx.out,
+								"  %%t%d = getelementptr inbounds [%zu x %s], [%zu "
+								"x %s]* %%%s, i64 0, i64 %s\n",
 								addr_temp, array_length, element_type, array_length,
 								element_type, sym->llvm_name, index_str);
 						}
@@ -1986,23 +2398,23 @@ static void generate_statement(ast_node_t *node)
 						if (node->data.assignment.lvalue->data.array_access.element_type
 								    .pointer_level > 0 &&
 						    value == 0) {
-							fprintf(ctx.output, "  store %s null, %s* %%t%d\n",
-								element_type, element_type, addr_temp);
+							ir_printf(&ctx.out, "  store %s%s null, %s* %%t%d\n",
+								access, element_type, element_type, addr_temp);
 						} else {
-							fprintf(ctx.output, "  store %s %d, %s* %%t%d\n", element_type,
-								value, element_type, addr_temp);
+							ir_printf(&ctx.out, "  store %s%s %d, %s* %%t%d\n", access,
+								element_type, value, element_type, addr_temp);
 						}
 					} else {
-						fprintf(ctx.output, "  store %s %%t%d, %s* %%t%d\n", element_type,
-							final_value, element_type, addr_temp);
+						ir_printf(&ctx.out, "  store %s%s %%t%d, %s* %%t%d\n", access,
+							element_type, final_value, element_type, addr_temp);
 					}
-
-					free(element_type);
 				}
 			} else if (node->data.assignment.lvalue->type == AST_DEREFERENCE) {
 				int ptr = generate_expression(node->data.assignment.lvalue->data.dereference.operand);
-				char *result_type = get_llvm_type_string(
+				const char *result_type = get_llvm_type_string(
 					&node->data.assignment.lvalue->data.dereference.result_type);
+				const char *access =
+					access_volatile(&node->data.assignment.lvalue->data.dereference.result_type);
 
 				char ptr_str[32];
 				if (node->data.assignment.lvalue->data.dereference.operand->type == AST_NUMBER) {
@@ -2025,26 +2437,23 @@ static void generate_statement(ast_node_t *node)
 					if (node->data.assignment.lvalue->data.dereference.result_type.pointer_level >
 						    0 &&
 					    value == 0) {
-						fprintf(ctx.output, "  store %s null, %s* %s\n", result_type,
+						ir_printf(&ctx.out, "  store %s%s null, %s* %s\n", access, result_type,
 							result_type, ptr_str);
 					} else {
-						fprintf(ctx.output, "  store %s %d, %s* %s\n", result_type, value,
-							result_type, ptr_str);
+						ir_printf(&ctx.out, "  store %s%s %d, %s* %s\n", access, result_type,
+							value, result_type, ptr_str);
 					}
 				} else {
-					fprintf(ctx.output, "  store %s %%t%d, %s* %s\n", result_type, final_value,
-						result_type, ptr_str);
+					ir_printf(&ctx.out, "  store %s%s %%t%d, %s* %s\n", access, result_type,
+						final_value, result_type, ptr_str);
 				}
-
-				free(result_type);
 			}
 		}
 		break;
 	}
 
 	case AST_ARRAY_DECL: {
-		symbol_t *sym = add_symbol(ctx.symbol_table, node->data.array_decl.name, SYM_VARIABLE,
-					   node->data.array_decl.type_info);
+		symbol_t *sym = node->data.array_decl.symbol;
 		if (!sym) {
 			return;
 		}
@@ -2061,27 +2470,25 @@ static void generate_statement(ast_node_t *node)
 				snprintf(size_str, sizeof(size_str), "%%t%d", size);
 			}
 
-			char *element_type = get_llvm_type_string(&node->data.array_decl.type_info);
-			fprintf(ctx.output, "  %%t%d = alloca %s, i32 %s\n", temp, element_type, size_str);
-			fprintf(ctx.output, "  %%%s = alloca %s*\n", sym->llvm_name, element_type);
-			fprintf(ctx.output, "  store %s* %%t%d, %s** %%%s\n", element_type, temp, element_type,
+			const char *element_type = get_llvm_type_string(&node->data.array_decl.type_info);
+			ir_printf(&ctx.out, "  %%t%d = alloca %s, i32 %s\n", temp, element_type, size_str);
+			ir_printf(&ctx.out, "  %%%s = alloca %s*\n", sym->llvm_name, element_type);
+			ir_printf(&ctx.out, "  store %s* %%t%d, %s** %%%s\n", element_type, temp, element_type,
 				sym->llvm_name);
-			free(element_type);
 		} else {
 			// Fixed size array
 			if (node->data.array_decl.size && node->data.array_decl.size->type == AST_NUMBER) {
 				int array_size = node->data.array_decl.size->data.number.value;
-				char *element_type = get_llvm_type_string(&node->data.array_decl.type_info);
+				const char *element_type = get_llvm_type_string(&node->data.array_decl.type_info);
 
 				if (sym->is_global) {
-					fprintf(ctx.output, "@%s = global [%d x %s] zeroinitializer\n", sym->llvm_name,
+					ir_printf(&ctx.out, "@%s = %s [%d x %s] zeroinitializer\n", sym->llvm_name,
+						global_definition_kind(&sym->type_info, !node->data.array_decl.has_init),
 						array_size, element_type);
 				} else {
-					fprintf(ctx.output, "  %%%s = alloca [%d x %s]\n", sym->llvm_name, array_size,
+					ir_printf(&ctx.out, "  %%%s = alloca [%d x %s]\n", sym->llvm_name, array_size,
 						element_type);
 				}
-
-				free(element_type);
 			}
 		}
 		break;
@@ -2096,39 +2503,33 @@ static void generate_statement(ast_node_t *node)
 		int bool_temp = convert_to_boolean(node->data.if_stmt.condition, cond);
 
 		if (node->data.if_stmt.else_stmt) {
-			fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", bool_temp, then_label,
-				else_label);
+			emit_cond_br(bool_temp, then_label, else_label);
 		} else {
-			fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", bool_temp, then_label,
-				end_label);
+			emit_cond_br(bool_temp, then_label, end_label);
 		}
 
-		fprintf(ctx.output, "%s:\n", then_label);
-		enter_scope(ctx.symbol_table);
+		ir_label_def(&ctx.out, then_label);
 		int prev_return_state = ctx.in_return_block;
 		ctx.in_return_block = 0;
 		generate_statement(node->data.if_stmt.then_stmt);
 		if (!ctx.in_return_block) {
-			fprintf(ctx.output, "  br label %%%s\n", end_label);
+			emit_br(end_label);
 		}
 		int then_terminates = ctx.in_return_block;
 		ctx.in_return_block = prev_return_state;
-		exit_scope(ctx.symbol_table);
 
 		int else_terminates = 0;
 
 		if (node->data.if_stmt.else_stmt) {
-			fprintf(ctx.output, "%s:\n", else_label);
-			enter_scope(ctx.symbol_table);
+			ir_label_def(&ctx.out, else_label);
 			prev_return_state = ctx.in_return_block;
 			ctx.in_return_block = 0;
 			generate_statement(node->data.if_stmt.else_stmt);
 			if (!ctx.in_return_block) {
-				fprintf(ctx.output, "  br label %%%s\n", end_label);
+				emit_br(end_label);
 			}
 			else_terminates = ctx.in_return_block;
 			ctx.in_return_block = prev_return_state || (then_terminates && else_terminates);
-			exit_scope(ctx.symbol_table);
 		} else {
 			// No else block, so the 'else' path is not terminated
 			else_terminates = 0;
@@ -2138,7 +2539,7 @@ static void generate_statement(ast_node_t *node)
 
 		// Only print end_label if it's reachable from at least one branch
 		if (!then_terminates || !else_terminates) {
-			fprintf(ctx.output, "%s:\n", end_label);
+			ir_label_def(&ctx.out, end_label);
 		}
 
 		free(then_label);
@@ -2158,26 +2559,24 @@ static void generate_statement(ast_node_t *node)
 		ctx.current_break_label = string_duplicate(end_label);
 		ctx.current_continue_label = string_duplicate(cond_label);
 
-		fprintf(ctx.output, "  br label %%%s\n", cond_label);
-		fprintf(ctx.output, "%s:\n", cond_label);
+		emit_br(cond_label);
+		ir_label_def(&ctx.out, cond_label);
 
 		int cond = generate_expression(node->data.while_stmt.condition);
 		int bool_temp = convert_to_boolean(node->data.while_stmt.condition, cond);
 
-		fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", bool_temp, body_label, end_label);
+		emit_cond_br(bool_temp, body_label, end_label);
 
-		fprintf(ctx.output, "%s:\n", body_label);
-		enter_scope(ctx.symbol_table);
+		ir_label_def(&ctx.out, body_label);
 		int prev_return_state = ctx.in_return_block;
 		ctx.in_return_block = 0;
 		generate_statement(node->data.while_stmt.body);
 		if (!ctx.in_return_block) {
-			fprintf(ctx.output, "  br label %%%s\n", cond_label);
+			emit_br(cond_label);
 		}
 		ctx.in_return_block = prev_return_state;
-		exit_scope(ctx.symbol_table);
 
-		fprintf(ctx.output, "%s:\n", end_label);
+		ir_label_def(&ctx.out, end_label);
 
 		// Restore previous break/continue labels
 		free(ctx.current_break_label);
@@ -2203,8 +2602,6 @@ static void generate_statement(ast_node_t *node)
 		ctx.current_break_label = string_duplicate(end_label);
 		ctx.current_continue_label = string_duplicate(update_label);
 
-		enter_scope(ctx.symbol_table);
-
 		// Generate initialization
 		if (node->data.for_stmt.init) {
 			if (node->data.for_stmt.init->type == AST_DECLARATION ||
@@ -2215,41 +2612,38 @@ static void generate_statement(ast_node_t *node)
 			}
 		}
 
-		fprintf(ctx.output, "  br label %%%s\n", cond_label);
-		fprintf(ctx.output, "%s:\n", cond_label);
+		emit_br(cond_label);
+		ir_label_def(&ctx.out, cond_label);
 
 		// Generate condition
 		if (node->data.for_stmt.condition) {
 			int cond = generate_expression(node->data.for_stmt.condition);
 			int bool_temp = convert_to_boolean(node->data.for_stmt.condition, cond);
 
-			fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", bool_temp, body_label,
-				end_label);
+			emit_cond_br(bool_temp, body_label, end_label);
 		} else {
 			// No condition means infinite loop
-			fprintf(ctx.output, "  br label %%%s\n", body_label);
+			emit_br(body_label);
 		}
 
 		// Generate body
-		fprintf(ctx.output, "%s:\n", body_label);
+		ir_label_def(&ctx.out, body_label);
 		int prev_return_state = ctx.in_return_block;
 		ctx.in_return_block = 0;
 		generate_statement(node->data.for_stmt.body);
 		if (!ctx.in_return_block) {
-			fprintf(ctx.output, "  br label %%%s\n", update_label);
+			emit_br(update_label);
 		}
 		ctx.in_return_block = prev_return_state;
 
 		// Generate update
-		fprintf(ctx.output, "%s:\n", update_label);
+		ir_label_def(&ctx.out, update_label);
 		if (node->data.for_stmt.update) {
 			generate_expression(node->data.for_stmt.update);
 		}
-		fprintf(ctx.output, "  br label %%%s\n", cond_label);
-
-		fprintf(ctx.output, "%s:\n", end_label);
+		emit_br(cond_label);
 
-		exit_scope(ctx.symbol_table);
+		ir_label_def(&ctx.out, end_label);
 
 		// Restore previous break/continue labels
 		free(ctx.current_break_label);
@@ -2275,26 +2669,24 @@ static void generate_statement(ast_node_t *node)
 		ctx.current_break_label = string_duplicate(end_label);
 		ctx.current_continue_label = string_duplicate(cond_label);
 
-		fprintf(ctx.output, "  br label %%%s\n", body_label);
-		fprintf(ctx.output, "%s:\n", body_label);
+		emit_br(body_label);
+		ir_label_def(&ctx.out, body_label);
 
-		enter_scope(ctx.symbol_table);
 		int prev_return_state = ctx.in_return_block;
 		ctx.in_return_block = 0;
 		generate_statement(node->data.do_while_stmt.body);
 		if (!ctx.in_return_block) {
-			fprintf(ctx.output, "  br label %%%s\n", cond_label);
+			emit_br(cond_label);
 		}
 		ctx.in_return_block = prev_return_state;
-		exit_scope(ctx.symbol_table);
 
-		fprintf(ctx.output, "%s:\n", cond_label);
+		ir_label_def(&ctx.out, cond_label);
 		int cond = generate_expression(node->data.do_while_stmt.condition);
 		int bool_temp = convert_to_boolean(node->data.do_while_stmt.condition, cond);
 
-		fprintf(ctx.output, "  br i1 %%t%d, label %%%s, label %%%s\n", bool_temp, body_label, end_label);
+		emit_cond_br(bool_temp, body_label, end_label);
 
-		fprintf(ctx.output, "%s:\n", end_label);
+		ir_label_def(&ctx.out, end_label);
 
 		// Restore previous break/continue labels
 		free(ctx.current_break_label);
@@ -2310,7 +2702,6 @@ static void generate_statement(ast_node_t *node)
 
 	case AST_SWITCH_STMT: {
 		char *end_label = generate_label("switch_end");
-		char *default_label = generate_label("switch_default");
 
 		// Save previous break label
 		char *prev_break = ctx.current_break_label;
@@ -2318,22 +2709,71 @@ static void generate_statement(ast_node_t *node)
 		ctx.current_break_label = string_duplicate(end_label);
 		ctx.current_switch_end_label = string_duplicate(end_label);
 
-		int switch_val = generate_expression(node->data.switch_stmt.expression);
-		(void)switch_val;
-		// For now, implement switch as a series of if-else statements
-		// A more sophisticated implementation would use LLVM's switch instruction
-
-		fprintf(ctx.output, "  br label %%%s\n", default_label);
-		fprintf(ctx.output, "%s:\n", default_label);
-
-		enter_scope(ctx.symbol_table);
+		// Evaluate the scrutinee, promoting narrow integers to int
+		ast_node_t *expr = node->data.switch_stmt.expression;
+		int switch_val = generate_expression(expr);
+		type_info_t expr_type = get_expression_type(expr, ctx.symbol_table);
+		const llvm_type_t *value_type = llvm_type_of(&expr_type);
+		char value_str[32];
+		if (expr->type == AST_NUMBER || expr->type == AST_CHARACTER) {
+			value_type = NULL;
+			snprintf(value_str, sizeof(value_str), "%d", switch_val);
+		} else {
+			if (llvm_type_is_integer(value_type) && value_type->bits < 32) {
+				type_info_t int_type = create_type_info("int", 0, 0, NULL);
+				switch_val = cast_value(switch_val, &expr_type, &int_type);
+				free_type_info(&int_type);
+				value_type = NULL;
+			}
+			snprintf(value_str, sizeof(value_str), "%%t%d", switch_val);
+		}
+		const char *type_str = value_type ? value_type->name : "i32";
+		free_type_info(&expr_type);
+
+		// Collect the case labels of this switch
+		node->data.switch_stmt.cases = NULL;
+		node->data.switch_stmt.default_label = NULL;
+		node->data.switch_stmt.break_label = NULL;
+		collect_switch_cases(node, node->data.switch_stmt.body, &node->data.switch_stmt.cases);
+
+		int case_count = 0;
+		for (case_label_t *c = node->data.switch_stmt.cases; c; c = c->next)
+			case_count++;
+		switch_case_t *cases = malloc((case_count ? case_count : 1) * sizeof(switch_case_t));
+		if (!cases) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		int n = 0;
+		for (case_label_t *c = node->data.switch_stmt.cases; c; c = c->next) {
+			// Semantic analysis already rejected non-constant and duplicate labels
+			long long value;
+			if (!evaluate_constant(c->value, NULL, &value))
+				continue;
+			int duplicate = 0;
+			for (int i = 0; i < n && !duplicate; i++)
+				duplicate = cases[i].value == value;
+			if (duplicate)
+				continue;
+			cases[n].value = value;
+			cases[n].label = c->label_name;
+			n++;
+		}
+
+		const char *default_target =
+			node->data.switch_stmt.default_label ? node->data.switch_stmt.default_label : end_label;
+		emit_switch_dispatch(value_str, type_str, cases, n, default_target);
+		free(cases);
+
+		// The body is only entered through its case labels
+		ctx.in_return_block = 1;
 		generate_statement(node->data.switch_stmt.body);
 		if (!ctx.in_return_block) {
-			fprintf(ctx.output, "  br label %%%s\n", end_label);
+			emit_br(end_label);
 		}
-		exit_scope(ctx.symbol_table);
 
-		fprintf(ctx.output, "%s:\n", end_label);
+		ir_label_def(&ctx.out, end_label);
+		ctx.in_return_block = 0;
 
 		// Restore previous break label
 		free(ctx.current_break_label);
@@ -2342,27 +2782,34 @@ static void generate_statement(ast_node_t *node)
 		ctx.current_switch_end_label = prev_switch_end;
 
 		free(end_label);
-		free(default_label);
 		break;
 	}
 
 	case AST_CASE_STMT:
-	case AST_DEFAULT_STMT:
-		// Case and default statements are handled within switch implementation
-		// For now, just generate the statement part
+	case AST_DEFAULT_STMT: {
+		const char *label = node->type == AST_CASE_STMT ? node->data.case_stmt.label_name
+								: node->data.default_stmt.label_name;
+		if (label) {
+			// Fall through from the previous case
+			if (!ctx.in_return_block)
+				emit_br(label);
+			ir_label_def(&ctx.out, label);
+			ctx.in_return_block = 0;
+		}
 		if (node->type == AST_CASE_STMT) {
 			generate_statement(node->data.case_stmt.statement);
 		} else {
 			generate_statement(node->data.default_stmt.statement);
 		}
 		break;
+	}
 
 	case AST_BREAK_STMT: {
 		if (!ctx.current_break_label) {
 			fprintf(stderr, "Break statement outside of loop or switch\n");
 			return;
 		}
-		fprintf(ctx.output, "  br label %%%s\n", ctx.current_break_label);
+		emit_br(ctx.current_break_label);
 		ctx.in_return_block = 1;
 		break;
 	}
@@ -2372,38 +2819,24 @@ static void generate_statement(ast_node_t *node)
 			fprintf(stderr, "Continue statement outside of loop\n");
 			return;
 		}
-		fprintf(ctx.output, "  br label %%%s\n", ctx.current_continue_label);
+		emit_br(ctx.current_continue_label);
 		ctx.in_return_block = 1;
 		break;
 	}
 
 	case AST_GOTO_STMT: {
-		symbol_t *label_sym = find_label(ctx.symbol_table, node->data.goto_stmt.label);
-		if (!label_sym) {
-			// Forward declaration of label
-			label_sym = add_label(ctx.symbol_table, node->data.goto_stmt.label);
-			if (label_sym) {
-				label_sym->label_defined = 0;
-			}
-		}
-		fprintf(ctx.output, "  br label %%%s\n", node->data.goto_stmt.label);
+		// Labels were checked by semantic analysis; IR labels need no declaration
+		emit_br(node->data.goto_stmt.label);
 		ctx.in_return_block = 1;
 		break;
 	}
 
 	case AST_LABEL_STMT: {
-		symbol_t *label_sym = find_label(ctx.symbol_table, node->data.label_stmt.label);
-		if (!label_sym) {
-			label_sym = add_label(ctx.symbol_table, node->data.label_stmt.label);
-		}
-		if (label_sym) {
-			label_sym->label_defined = 1;
-		}
-
-		if (ctx.in_return_block) {
-			ctx.in_return_block = 0; // Label makes code reachable again
-		}
-		fprintf(ctx.output, "%s:\n", node->data.label_stmt.label);
+		// Fall into the labeled block; a label also makes code reachable again
+		if (!ctx.in_return_block)
+			emit_br(node->data.label_stmt.label);
+		ctx.in_return_block = 0;
+		ir_label_def(&ctx.out, node->data.label_stmt.label);
 		generate_statement(node->data.label_stmt.statement);
 		break;
 	}
@@ -2422,18 +2855,16 @@ static void generate_statement(ast_node_t *node)
 				free_type_info(&expr_type);
 			}
 
-			char *return_type = get_llvm_type_string(&ctx.current_function_return_type);
+			const char *return_type = get_llvm_type_string(&ctx.current_function_return_type);
 
 			if (node->data.return_stmt.value->type == AST_NUMBER ||
 			    node->data.return_stmt.value->type == AST_CHARACTER) {
-				fprintf(ctx.output, "  ret %s %d\n", return_type, value);
+				ir_printf(&ctx.out, "  ret %s %d\n", return_type, value);
 			} else {
-				fprintf(ctx.output, "  ret %s %%t%d\n", return_type, value);
+				ir_printf(&ctx.out, "  ret %s %%t%d\n", return_type, value);
 			}
-
-			free(return_type);
 		} else {
-			fprintf(ctx.output, "  ret void\n");
+			ir_printf(&ctx.out, "  ret void\n");
 		}
 		ctx.in_return_block = 1;
 		break;
@@ -2455,7 +2886,7 @@ static void generate_statement(ast_node_t *node)
 		// Add struct to symbol table
 		symbol_t *struct_sym =
 			add_symbol(ctx.symbol_table, node->data.struct_decl.name, SYM_STRUCT,
-				   create_type_info(string_duplicate(node->data.struct_decl.name), 0, 0, NULL));
+				   create_type_info(node->data.struct_decl.name, 0, 0, NULL));
 		if (struct_sym && node->data.struct_decl.is_definition) {
 			struct_sym->total_size = node->data.struct_decl.size;
 			struct_sym->max_alignment = node->data.struct_decl.alignment;
@@ -2470,7 +2901,7 @@ static void generate_statement(ast_node_t *node)
 		// Add union to symbol table
 		symbol_t *union_sym =
 			add_symbol(ctx.symbol_table, node->data.union_decl.name, SYM_UNION,
-				   create_type_info(string_duplicate(node->data.union_decl.name), 0, 0, NULL));
+				   create_type_info(node->data.union_decl.name, 0, 0, NULL));
 		if (union_sym && node->data.union_decl.is_definition) {
 			union_sym->total_size = node->data.union_decl.size;
 			union_sym->max_alignment = node->data.union_decl.alignment;
@@ -2482,19 +2913,7 @@ static void generate_statement(ast_node_t *node)
 	}
 
 	case AST_ENUM_DECL: {
-		if (node->data.enum_decl.is_definition) {
-			// Add enum constants to symbol table
-			enum_value_t *value = node->data.enum_decl.values;
-			int current_value = 0;
-
-			while (value) {
-				int enum_val = value->value_expr ? generate_expression(value->value_expr)
-								 : current_value;
-				add_enum_constant(ctx.symbol_table, value->name, enum_val);
-				current_value = enum_val + 1;
-				value = value->next;
-			}
-		}
+		// Identifiers naming the constants are bound to them already
 		break;
 	}
 
@@ -2504,18 +2923,54 @@ static void generate_statement(ast_node_t *node)
 	}
 }
 
-// Generate compound statement with proper scoping
+// Generate compound statement. Names were scoped by semantic analysis,
+// which bound each use to its declaration.
 static void generate_compound_statement(ast_node_t *node)
 {
-	enter_scope(ctx.symbol_table);
-	for (int i = 0; i < node->data.compound.stmt_count && !ctx.in_return_block; i++) {
+	// Unreachable statements are skipped, but a later label can resume code
+	for (int i = 0; i < node->data.compound.stmt_count; i++) {
 		generate_statement(node->data.compound.statements[i]);
 	}
-	exit_scope(ctx.symbol_table);
+}
+
+// " noalias" for a restrict-qualified pointer parameter: nothing else
+// reaches its object while the call runs
+static const char *param_noalias(const type_info_t *type)
+{
+	return type->pointer_level > 0 && (type->pointer_qualifiers & QUAL_RESTRICT) ? " noalias" : "";
+}
+
+// "define ... @name(<params>) <attributes> {". C lets a callee cast const
+// away, so a pointer to const is only marked readonly once the body shows
+// nothing is written through it; effects is NULL when not known.
+static void emit_function_header(ir_writer_t *out, ast_node_t *node, int internal, const body_effects_t *effects)
+{
+	const char *return_type_str = get_llvm_type_string(&node->data.function.return_type);
+	ir_printf(out, "define %s%s @%s(", internal ? "internal " : "", return_type_str, node->data.function.name);
+
+	for (int i = 0; i < node->data.function.param_count; i++) {
+		if (i > 0)
+			ir_puts(out, ", ");
+		type_info_t *type = &node->data.function.params[i]->data.parameter.type_info;
+		int points_to_const = type->pointer_level + type->is_array == 1 && (type->qualifiers & QUAL_CONST);
+		ir_printf(out, "%s%s%s %%%s", get_llvm_type_string(type), param_noalias(type),
+			  points_to_const && effects && param_is_read_only(effects, i) ? " readonly" : "",
+			  node->data.function.params[i]->data.parameter.name);
+	}
+
+	if (node->data.function.is_variadic && node->data.function.param_count > 0) {
+		ir_puts(out, ", ...");
+	}
+
+	// C has no exceptions, so nothing unwinds out of a function
+	ir_puts(out, ") nounwind");
+	if (effects && !effects->writes_memory)
+		ir_puts(out, effects->reads_memory ? " readonly" : " readnone");
+	ir_puts(out, " {\n");
 }
 
 // Generate function
-static void generate_function(ast_node_t *node)
+static void generate_function(ast_node_t *node, int internal, int leaf)
 {
 	// Make deep copies for context to avoid double-free
 	free(ctx.current_function_name); // Free previous if any
@@ -2526,54 +2981,29 @@ static void generate_function(ast_node_t *node)
 
 	ctx.in_return_block = 0;
 
-	// Add function to symbol table
-	symbol_t *func_sym =
-		add_symbol(ctx.symbol_table, node->data.function.name, SYM_FUNCTION, node->data.function.return_type);
-	if (func_sym) {
-		func_sym->is_function_defined = node->data.function.is_defined;
-		func_sym->param_count = node->data.function.param_count;
-		func_sym->is_variadic = node->data.function.is_variadic;
-	}
-
-	set_current_function(ctx.symbol_table, node->data.function.name);
+	const char *return_type_str = get_llvm_type_string(&node->data.function.return_type);
 
-	// Function declaration
-	char *return_type_str = get_llvm_type_string(&node->data.function.return_type);
-	fprintf(ctx.output, "define %s @%s(", return_type_str, node->data.function.name);
+	// The body is collected in memory so calls can be inlined, it can be
+	// promoted to SSA form and the header can carry what it does to memory
+	ir_writer_t function_out = ctx.out;
+	int first_temp = ctx.temp_counter;
+	ir_writer_init(&ctx.out, NULL);
+	ir_writer_init(&ctx.entry_allocas, NULL);
 
-	// Parameters
-	for (int i = 0; i < node->data.function.param_count; i++) {
-		if (i > 0)
-			fprintf(ctx.output, ", ");
-		ast_node_t *param = node->data.function.params[i];
-		char *param_type_str = get_llvm_type_string(&param->data.parameter.type_info);
-		fprintf(ctx.output, "%s %%%s", param_type_str, param->data.parameter.name);
-		free(param_type_str);
-	}
-
-	if (node->data.function.is_variadic && node->data.function.param_count > 0) {
-		fprintf(ctx.output, ", ...");
-	}
-
-	fprintf(ctx.output, ") {\n");
-
-	// Enter function scope
+	// Local struct and union tags go in a function scope, away from the
+	// global scope the other threads share
 	enter_scope(ctx.symbol_table);
 
-	// Add parameters to symbol table and allocate space
+	// Allocate space for the parameters
 	for (int i = 0; i < node->data.function.param_count; i++) {
 		ast_node_t *param = node->data.function.params[i];
 
-		symbol_t *param_sym = add_symbol(ctx.symbol_table, param->data.parameter.name, SYM_VARIABLE,
-						 param->data.parameter.type_info);
+		symbol_t *param_sym = param->data.parameter.symbol;
 		if (param_sym) {
-			param_sym->is_parameter = 1;
-
-			char *param_type_str = get_llvm_type_string(&param->data.parameter.type_info);
-			fprintf(ctx.output, "  %%%s.addr = alloca %s\n", param_sym->llvm_name, param_type_str);
-			fprintf(ctx.output, "  store %s %%%s, %s* %%%s.addr\n", param_type_str,
-				param->data.parameter.name, param_type_str, param_sym->llvm_name);
-			free(param_type_str);
+			const char *param_type_str = get_llvm_type_string(&param->data.parameter.type_info);
+			ir_printf(&ctx.out, "  %%%s.addr = alloca %s\n", param_sym->llvm_name, param_type_str);
+			ir_printf(&ctx.out, "  store %s%s %%%s, %s* %%%s.addr\n", symbol_volatile(param_sym),
+				param_type_str, param->data.parameter.name, param_type_str, param_sym->llvm_name);
 		}
 	}
 
@@ -2583,40 +3013,509 @@ static void generate_function(ast_node_t *node)
 	// Add default return if needed
 	if (!ctx.in_return_block) {
 		if (strcmp(node->data.function.return_type.base_type, "void") == 0) {
-			fprintf(ctx.output, "  ret void\n");
+			ir_printf(&ctx.out, "  ret void\n");
 		} else {
-			fprintf(ctx.output, "  ret %s 0\n", return_type_str);
+			ir_printf(&ctx.out, "  ret %s 0\n", return_type_str);
 		}
 	}
 
-	fprintf(ctx.output, "}\n\n");
+	ir_writer_t body = ctx.out;
+	if (ctx.entry_allocas.len > 0) {
+		ir_writer_t entry = ctx.entry_allocas;
+		ir_putn(&entry, body.buf, body.len);
+		ir_writer_finish(&body);
+		body = entry;
+	} else {
+		ir_writer_finish(&ctx.entry_allocas);
+	}
+	if (module.inlines && !leaf) {
+		ir_writer_t inlined;
+		ir_writer_init(&inlined, NULL);
+		inline_calls(module.inlines, body.buf, body.len, &inlined, &ctx.temp_counter);
+		ir_writer_finish(&body);
+		body = inlined;
+	}
+	if (!codegen_options.no_mem2reg) {
+		ir_writer_t promoted;
+		ir_writer_init(&promoted, NULL);
+		ssa_promote_function(body.buf, body.len, &promoted, first_temp, &ctx.temp_counter);
+		ir_writer_finish(&body);
+		body = promoted;
+	}
+
+	// Parameter attributes are inferred from the final body, where promoted
+	// parameters are used directly rather than through their stack slots
+	const char **param_names = malloc((size_t)node->data.function.param_count * sizeof(char *) + 1);
+	if (!param_names) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (int i = 0; i < node->data.function.param_count; i++)
+		param_names[i] = node->data.function.params[i]->data.parameter.name;
+	body_effects_t effects;
+	infer_body_effects(body.buf, body.len, param_names, node->data.function.param_count, &effects);
+	free(param_names);
+
+	ctx.out = function_out;
+	emit_function_header(&ctx.out, node, internal, &effects);
+	ir_putn(&ctx.out, body.buf, body.len);
+	ir_writer_finish(&body);
+	ir_printf(&ctx.out, "}\n\n");
 
 	// Exit function scope
 	exit_scope(ctx.symbol_table);
 
-	free(return_type_str);
+}
+
+// Definitions of the module by symbol name: their linkage, and the unit
+// that holds them once the third pass has reached them
+typedef struct {
+	const char *name;
+	size_t length;
+	int unit;     // -1 for a function that is only declared, or not reached yet
+	int defined;  // A function with a body in this module
+	int declared; // Already has its declare line
+	int internal; // Declared static somewhere in the module
+	int called;   // Named by a call somewhere in the module
+} definition_t;
+
+typedef struct {
+	definition_t *slots;
+	size_t mask;
+} definition_table_t;
+
+static size_t dropped_definitions;
+
+size_t dropped_definition_count(void)
+{
+	return dropped_definitions;
+}
+
+// Sized for count names, each top-level declaration adding at most one
+static void definition_table_init(definition_table_t *table, int count)
+{
+	size_t capacity = 16;
+	while (capacity < (size_t)count * 2)
+		capacity *= 2;
+	table->slots = calloc(capacity, sizeof(definition_t));
+	if (!table->slots) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	table->mask = capacity - 1;
+}
+
+// Entry for the name, added when add is set; NULL if it is missing
+static definition_t *find_definition(definition_table_t *table, const char *name, size_t length, int add)
+{
+	// Algorithm: FNV-1a hash function
+	size_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+
+	size_t i = hash & table->mask;
+	for (; table->slots[i].name; i = (i + 1) & table->mask) {
+		definition_t *def = &table->slots[i];
+		if (def->length == length && memcmp(def->name, name, length) == 0)
+			return def;
+	}
+	if (!add)
+		return NULL;
+	table->slots[i].name = name;
+	table->slots[i].length = length;
+	table->slots[i].unit = -1;
+	return &table->slots[i];
+}
+
+// What scan_declaration() saw of a function body, for the inliner
+typedef struct {
+	int nodes;
+	int calls;
+	definition_table_t *definitions; // Callees defined here are marked called
+} body_scan_t;
+
+// Register every string literal in source order before any function body
+// is generated, so literal IDs do not depend on thread scheduling, and
+// measure the body for the inliner
+static void scan_declaration(ast_node_t *node, body_scan_t *scan)
+{
+	if (!node)
+		return;
+
+	scan->nodes++;
+	switch (node->type) {
+	case AST_STRING_LITERAL:
+		store_string_literal(node->data.string_literal.value, node->data.string_literal.length);
+		break;
+	case AST_FUNCTION:
+		scan_declaration(node->data.function.body, scan);
+		break;
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < node->data.compound.stmt_count; i++)
+			scan_declaration(node->data.compound.statements[i], scan);
+		break;
+	case AST_DECLARATION:
+		scan_declaration(node->data.declaration.type_info.array_size, scan);
+		scan_declaration(node->data.declaration.init, scan);
+		break;
+	case AST_ARRAY_DECL:
+		scan_declaration(node->data.array_decl.size, scan);
+		break;
+	case AST_ASSIGNMENT:
+		scan_declaration(node->data.assignment.lvalue, scan);
+		scan_declaration(node->data.assignment.value, scan);
+		break;
+	case AST_IF_STMT:
+		scan_declaration(node->data.if_stmt.condition, scan);
+		scan_declaration(node->data.if_stmt.then_stmt, scan);
+		scan_declaration(node->data.if_stmt.else_stmt, scan);
+		break;
+	case AST_WHILE_STMT:
+		scan_declaration(node->data.while_stmt.condition, scan);
+		scan_declaration(node->data.while_stmt.body, scan);
+		break;
+	case AST_FOR_STMT:
+		scan_declaration(node->data.for_stmt.init, scan);
+		scan_declaration(node->data.for_stmt.condition, scan);
+		scan_declaration(node->data.for_stmt.update, scan);
+		scan_declaration(node->data.for_stmt.body, scan);
+		break;
+	case AST_DO_WHILE_STMT:
+		scan_declaration(node->data.do_while_stmt.body, scan);
+		scan_declaration(node->data.do_while_stmt.condition, scan);
+		break;
+	case AST_SWITCH_STMT:
+		scan_declaration(node->data.switch_stmt.expression, scan);
+		scan_declaration(node->data.switch_stmt.body, scan);
+		break;
+	case AST_CASE_STMT:
+		scan_declaration(node->data.case_stmt.value, scan);
+		scan_declaration(node->data.case_stmt.statement, scan);
+		break;
+	case AST_DEFAULT_STMT:
+		scan_declaration(node->data.default_stmt.statement, scan);
+		break;
+	case AST_LABEL_STMT:
+		scan_declaration(node->data.label_stmt.statement, scan);
+		break;
+	case AST_RETURN_STMT:
+		scan_declaration(node->data.return_stmt.value, scan);
+		break;
+	case AST_EXPR_STMT:
+		scan_declaration(node->data.expr_stmt.expr, scan);
+		break;
+	case AST_CALL: {
+		scan->calls++;
+		const char *name = node->data.call.name;
+		definition_t *def = name ? find_definition(scan->definitions, name, strlen(name), 0) : NULL;
+		if (def)
+			def->called = 1;
+		for (int i = 0; i < node->data.call.arg_count; i++)
+			scan_declaration(node->data.call.args[i], scan);
+		break;
+	}
+	case AST_BINARY_OP:
+		scan_declaration(node->data.binary_op.left, scan);
+		scan_declaration(node->data.binary_op.right, scan);
+		break;
+	case AST_UNARY_OP:
+		scan_declaration(node->data.unary_op.operand, scan);
+		break;
+	case AST_ADDRESS_OF:
+		scan_declaration(node->data.address_of.operand, scan);
+		break;
+	case AST_DEREFERENCE:
+		scan_declaration(node->data.dereference.operand, scan);
+		break;
+	case AST_ARRAY_ACCESS:
+		scan_declaration(node->data.array_access.array, scan);
+		scan_declaration(node->data.array_access.index, scan);
+		break;
+	case AST_MEMBER_ACCESS:
+		scan_declaration(node->data.member_access.object, scan);
+		break;
+	case AST_PTR_MEMBER_ACCESS:
+		scan_declaration(node->data.ptr_member_access.object, scan);
+		break;
+	case AST_CAST:
+		scan_declaration(node->data.cast.expression, scan);
+		break;
+	case AST_SIZEOF:
+		if (!node->data.sizeof_op.is_type)
+			scan_declaration(node->data.sizeof_op.operand, scan);
+		break;
+	case AST_CONDITIONAL:
+		scan_declaration(node->data.conditional.condition, scan);
+		scan_declaration(node->data.conditional.true_expr, scan);
+		scan_declaration(node->data.conditional.false_expr, scan);
+		break;
+	case AST_INITIALIZER_LIST:
+		for (int i = 0; i < node->data.initializer_list.count; i++)
+			scan_declaration(node->data.initializer_list.values[i], scan);
+		break;
+	default:
+		break;
+	}
+}
+
+static void begin_thread_context(void)
+{
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.current_function_return_type = create_type_info("void", 0, 0, NULL);
+}
+
+static void end_thread_context(void)
+{
+	free(ctx.current_break_label);
+	free(ctx.current_continue_label);
+	free(ctx.current_switch_end_label);
+	free(ctx.current_function_name);
+	free_type_info(&ctx.current_function_return_type);
+}
+
+// Generate one function body, appending to unit->out (a fresh memory writer
+// unless the caller points it somewhere else) and to private globals
+static void generate_unit(codegen_unit_t *unit)
+{
+	ctx.out = unit->out;
+	ir_writer_init(&ctx.globals, NULL);
+	ctx.symbol_table = create_function_symbol_table(module.symbol_table);
+	ctx.label_counter = 0;
+	ctx.temp_counter = 0;
+
+	generate_function(unit->decl, unit->internal, unit->leaf);
+
+	destroy_function_symbol_table(ctx.symbol_table);
+	unit->out = ctx.out;
+	unit->globals = ctx.globals;
+}
+
+// Work queue shared by the codegen threads
+typedef struct {
+	codegen_unit_t **units;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+	arena_t *arenas; // One per thread, released once every body is done
+} codegen_queue_t;
+
+static void run_codegen_queue(codegen_queue_t *queue, int thread_index)
+{
+	begin_thread_context();
+	for (;;) {
+		pthread_mutex_lock(&queue->lock);
+		int i = queue->next++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->count)
+			break;
+		if (!queue->units[i]->generated)
+			generate_unit(queue->units[i]);
+	}
+	queue->arenas[thread_index] = ctx.arena;
+	end_thread_context();
+}
+
+typedef struct {
+	codegen_queue_t *queue;
+	int thread_index;
+} codegen_worker_t;
+
+static void *codegen_worker_main(void *arg)
+{
+	codegen_worker_t *worker = arg;
+	run_codegen_queue(worker->queue, worker->thread_index);
+	return NULL;
+}
+
+static int codegen_thread_count(int function_count)
+{
+	long threads = codegen_options.threads;
+	if (threads <= 0)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads > function_count)
+		threads = function_count;
+	return threads > 1 ? (int)threads : 1;
+}
+
+// Generate the function bodies on the given number of threads
+static void generate_function_units(codegen_unit_t **units, int count, int threads)
+{
+	codegen_queue_t queue = {units, count, 0, PTHREAD_MUTEX_INITIALIZER, NULL};
+	queue.arenas = calloc((size_t)threads, sizeof(arena_t));
+	codegen_worker_t *workers = malloc((size_t)threads * sizeof(codegen_worker_t));
+	pthread_t *tids = malloc((size_t)threads * sizeof(pthread_t));
+	if (!queue.arenas || !workers || !tids) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	intern_set_shared(1);
+	type_table_set_shared(1);
+
+	// Thread 0 is this one; its own context is set aside meanwhile
+	int started = 1;
+	for (int i = 1; i < threads; i++) {
+		workers[i].queue = &queue;
+		workers[i].thread_index = i;
+		if (pthread_create(&tids[i], NULL, codegen_worker_main, &workers[i]) != 0)
+			break;
+		started++;
+	}
+	codegen_context_t saved = ctx;
+	run_codegen_queue(&queue, 0);
+	ctx = saved;
+	for (int i = 1; i < started; i++)
+		pthread_join(tids[i], NULL);
+
+	intern_set_shared(0);
+	type_table_set_shared(0);
+
+	for (int i = 0; i < threads; i++)
+		arena_release(&queue.arenas[i]);
+	pthread_mutex_destroy(&queue.lock);
+	free(queue.arenas);
+	free(workers);
+	free(tids);
+}
+
+// Append the units to the module output in source order. Without worker
+// threads the bodies are generated here and written straight to the module
+// output, so no function's IR is held back.
+static void write_units(codegen_unit_t *units, int count, int generate)
+{
+	codegen_context_t module_ctx = ctx;
+	if (generate)
+		begin_thread_context();
+	for (int i = 0; i < count; i++) {
+		if (generate && units[i].decl && !units[i].generated) {
+			units[i].out = module_ctx.out;
+			generate_unit(&units[i]);
+			module_ctx.out = units[i].out;
+			continue;
+		}
+		if (units[i].live && units[i].out.len > 0)
+			ir_putn(&module_ctx.out, units[i].out.buf, units[i].out.len);
+		ir_writer_finish(&units[i].out);
+	}
+	if (generate) {
+		arena_release(&ctx.arena);
+		end_thread_context();
+	}
+	ctx = module_ctx;
+}
+
+// AST nodes per instruction of the inline threshold beyond which a body is
+// not worth generating for the inliner
+#define INLINE_NODES_PER_INSTRUCTION 3
+
+// Generate the called inlining candidates up front, as they will be
+// emitted, so every function body can take copies of them at its call
+// sites. Nothing is inlined into a leaf, so its body is kept as its own
+// definition; a candidate that calls others is generated again once the
+// table is complete. Bodies that add module-level definitions (switch
+// tables, ...) are left out.
+static inline_table_t *collect_inline_candidates(codegen_unit_t **units, int count,
+						 definition_table_t *definitions)
+{
+	inline_table_t *table = inline_table_create(codegen_options.inline_threshold);
+	codegen_context_t module_ctx = ctx;
+	begin_thread_context();
+	for (int i = 0; i < count; i++) {
+		if (!units[i]->inline_candidate)
+			continue;
+		const char *name = units[i]->decl->data.function.name;
+		if (!find_definition(definitions, name, strlen(name), 0)->called)
+			continue;
+		codegen_unit_t scratch = *units[i];
+		codegen_unit_t *unit = units[i]->leaf ? units[i] : &scratch;
+		ir_writer_init(&unit->out, NULL);
+		generate_unit(unit);
+		if (unit->globals.len == 0)
+			inline_table_add(table, unit->out.buf, unit->out.len, unit->decl->data.function.is_inline);
+		if (unit == units[i]) {
+			unit->generated = 1;
+		} else {
+			ir_writer_finish(&unit->out);
+			ir_writer_finish(&unit->globals);
+		}
+	}
+	arena_release(&ctx.arena);
+	end_thread_context();
+	ctx = module_ctx;
+	return table;
+}
+
+static int is_name_char(char c)
+{
+	return isalnum((unsigned char)c) || c == '_' || c == '.' || c == '$';
+}
+
+// Keep what the module exports and, transitively, whatever the kept IR
+// refers to by name; static definitions nothing reaches are dropped. The
+// string literals the kept IR uses are flagged in used_strings, by ID.
+static void mark_live_units(codegen_unit_t *units, int count, definition_table_t *definitions,
+			    unsigned char *used_strings)
+{
+	int *pending = malloc(((size_t)count + 1) * sizeof(int));
+	if (!pending) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	int top = 0;
+	for (int i = 0; i < count; i++) {
+		units[i].live = !units[i].internal;
+		if (units[i].live)
+			pending[top++] = i;
+	}
+
+	while (top > 0) {
+		codegen_unit_t *unit = &units[pending[--top]];
+		const ir_writer_t *texts[2] = {&unit->out, &unit->globals};
+		for (int t = 0; t < 2; t++) {
+			const char *p = texts[t]->buf;
+			const char *end = p + texts[t]->len;
+			while (p < end && (p = memchr(p, '@', (size_t)(end - p)))) {
+				const char *name = ++p;
+				while (p < end && is_name_char(*p))
+					p++;
+				size_t length = (size_t)(p - name);
+				if (length > 4 && memcmp(name, ".str", 4) == 0) {
+					int id = atoi(name + 4);
+					if (id > 0 && id <= module.string_counter)
+						used_strings[id] = 1;
+					continue;
+				}
+				definition_t *def = find_definition(definitions, name, length, 0);
+				if (def && def->unit >= 0 && !units[def->unit].live) {
+					units[def->unit].live = 1;
+					pending[top++] = def->unit;
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+		dropped_definitions += !units[i].live;
+	free(pending);
 }
 
 // Main code generation function
 void generate_llvm_ir(ast_node_t *ast, FILE *output)
 {
 	// Initialize context
-	ctx.output = output;
-	ctx.symbol_table = create_symbol_table();
-	ctx.label_counter = 0;
-	ctx.temp_counter = 0;
-	ctx.string_counter = 0;
-	ctx.in_return_block = 0;
-	ctx.current_break_label = NULL;
-	ctx.current_continue_label = NULL;
-	ctx.current_switch_end_label = NULL;
-	ctx.current_function_name = NULL;
-	ctx.current_function_return_type = create_type_info(string_duplicate("void"), 0, 0, NULL);
-	ctx.string_literals = NULL;
-	ctx.string_literal_count = 0;
+	begin_thread_context();
+	ir_writer_init(&ctx.out, output);
+	ctx.out.unbuffered = codegen_options.unbuffered_ir;
+	memset(&module, 0, sizeof(module));
+	module.symbol_table = create_symbol_table();
+	ctx.symbol_table = module.symbol_table;
 
 	// Generate LLVM IR header
-	fprintf(output, "; MiniCC - Generated LLVM IR\n\n");
+	ir_printf(&ctx.out, "; MiniCC - Generated LLVM IR\n\n");
+#ifdef TARGET_TRIPLE
+	ir_puts(&ctx.out, "target datalayout = \"" TARGET_DATALAYOUT "\"\n");
+	ir_puts(&ctx.out, "target triple = \"" TARGET_TRIPLE "\"\n\n");
+#endif
 
 	// First pass: collect all type definitions
 	for (int i = 0; i < ast->data.program.decl_count; i++) {
@@ -2633,89 +3532,156 @@ void generate_llvm_ir(ast_node_t *ast, FILE *output)
 		}
 	}
 
+	// Every function name up front: a prototype of a function defined here
+	// needs no declare line, and static on any declaration makes it internal
+	int decl_count = ast->data.program.decl_count;
+	definition_table_t definitions;
+	definition_table_init(&definitions, decl_count);
+	for (int i = 0; i < decl_count; i++) {
+		ast_node_t *decl = ast->data.program.declarations[i];
+		if (decl->type != AST_FUNCTION)
+			continue;
+		const char *name = decl->data.function.name;
+		definition_t *def = find_definition(&definitions, name, strlen(name), 1);
+		def->defined |= decl->data.function.is_defined;
+		def->internal |= decl->data.function.storage_class == STORAGE_STATIC;
+	}
+
 	// Second pass: generate function declarations (prototypes/extern)
 	for (int i = 0; i < ast->data.program.decl_count; i++) {
 		ast_node_t *decl = ast->data.program.declarations[i];
 
 		if (decl->type == AST_FUNCTION && !decl->data.function.is_defined) {
+			const char *name = decl->data.function.name;
+			definition_t *def = find_definition(&definitions, name, strlen(name), 0);
+			if (def->defined || def->declared)
+				continue;
+			def->declared = 1;
+
 			// This is a function declaration without body (prototype)
-			char *return_type_str = get_llvm_type_string(&decl->data.function.return_type);
-			fprintf(output, "declare %s @%s(", return_type_str, decl->data.function.name);
+			const char *return_type_str = get_llvm_type_string(&decl->data.function.return_type);
+			ir_printf(&ctx.out, "declare %s @%s(", return_type_str, decl->data.function.name);
 
 			// Parameters
 			for (int j = 0; j < decl->data.function.param_count; j++) {
 				if (j > 0) {
-					fprintf(output, ", ");
+					ir_puts(&ctx.out, ", ");
 				}
 				ast_node_t *param = decl->data.function.params[j];
-				char *param_type_str = get_llvm_type_string(&param->data.parameter.type_info);
-				fprintf(output, "%s", param_type_str);
-				free(param_type_str);
+				type_info_t *param_type = &param->data.parameter.type_info;
+				ir_printf(&ctx.out, "%s%s", get_llvm_type_string(param_type), param_noalias(param_type));
 			}
 
 			if (decl->data.function.is_variadic) {
 				if (decl->data.function.param_count > 0) {
-					fprintf(output, ", ...");
+					ir_puts(&ctx.out, ", ...");
 				} else {
-					fprintf(output, "...");
+					ir_puts(&ctx.out, "...");
 				}
 			}
 
-			fprintf(output, ")\n");
-			free(return_type_str);
+			ir_printf(&ctx.out, ")\n");
 
-			// Add to symbol table as extern function
-			symbol_t *func_sym = add_symbol(ctx.symbol_table, decl->data.function.name, SYM_FUNCTION,
-							decl->data.function.return_type);
-			if (func_sym) {
-				func_sym->is_extern = 1;
-				func_sym->is_function_defined = 0;
-				func_sym->param_count = decl->data.function.param_count;
-				func_sym->is_variadic = decl->data.function.is_variadic;
-
-				if (decl->data.function.param_count > 0) {
-					func_sym->param_symbols =
-						malloc(sizeof(ast_node_t *) * decl->data.function.param_count);
-					for (int k = 0; k < decl->data.function.param_count; k++) {
-						func_sym->param_symbols[k] = decl->data.function.params[k];
-					}
-				} else {
-					func_sym->param_symbols = NULL;
-				}
-			}
 		}
 	}
 
-	fprintf(output, "\n");
+	ir_printf(&ctx.out, "\n");
 
-	// Third pass: generate function definitions and other declarations
-	for (int i = 0; i < ast->data.program.decl_count; i++) {
+	// Third pass: global declarations and function symbols, in source order
+	codegen_unit_t *units = calloc((size_t)decl_count + 1, sizeof(codegen_unit_t));
+	codegen_unit_t **function_units = malloc(((size_t)decl_count + 1) * sizeof(codegen_unit_t *));
+	if (!units || !function_units) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	int unit_count = 0;
+	int function_count = 0;
+	for (int i = 0; i < decl_count; i++) {
 		ast_node_t *decl = ast->data.program.declarations[i];
+		body_scan_t scan = {0, 0, &definitions};
+		scan_declaration(decl, &scan);
 
 		if (decl->type == AST_FUNCTION && decl->data.function.is_defined) {
 			// Only generate definitions for functions with bodies
-			generate_function(decl);
+			units[unit_count].decl = decl;
+			int hint = decl->data.function.is_inline;
+			int limit = codegen_options.inline_threshold * (hint ? 2 : 1);
+			units[unit_count].inline_candidate = (hint || scan.calls == 0) && !decl->data.function.is_variadic &&
+							     scan.nodes <= INLINE_NODES_PER_INSTRUCTION * limit;
+			units[unit_count].leaf = scan.calls == 0;
+			const char *name = decl->data.function.name;
+			definition_t *def = find_definition(&definitions, name, strlen(name), 1);
+			def->unit = unit_count;
+			units[unit_count].internal = def->internal;
+			units[unit_count].live = 1;
+			function_units[function_count++] = &units[unit_count++];
 		} else if (decl->type != AST_FUNCTION && decl->type != AST_STRUCT_DECL &&
 			   decl->type != AST_UNION_DECL && decl->type != AST_ENUM_DECL) {
 			// Handle other global declarations
+			ir_writer_t module_out = ctx.out;
+			ir_writer_init(&ctx.out, NULL);
 			generate_statement(decl);
+			units[unit_count].out = ctx.out;
+			ir_writer_init(&units[unit_count].globals, NULL);
+			symbol_t *sym = decl->type == AST_DECLARATION ? decl->data.declaration.symbol :
+					decl->type == AST_ARRAY_DECL ? decl->data.array_decl.symbol : NULL;
+			if (sym && sym->is_global && sym->type_info.storage_class == STORAGE_STATIC) {
+				definition_t *def = find_definition(&definitions, sym->llvm_name, strlen(sym->llvm_name), 1);
+				def->unit = unit_count;
+				units[unit_count].internal = 1;
+			}
+			units[unit_count].live = 1;
+			unit_count++;
+			ctx.out = module_out;
 		}
 	}
 
+	if (codegen_options.inline_threshold > 0)
+		module.inlines = collect_inline_candidates(function_units, function_count, &definitions);
+
+	// Function bodies only read the global scope from here on. Dropping
+	// unreferenced static definitions takes every body generated first.
+	int prune = 0;
+	for (int i = 0; i < unit_count && !codegen_options.no_dce; i++)
+		prune |= units[i].internal;
+	int threads = codegen_thread_count(function_count);
+	if (threads > 1 || prune)
+		generate_function_units(function_units, function_count, threads);
+	unsigned char *used_strings = NULL;
+	if (prune) {
+		used_strings = calloc((size_t)module.string_counter + 1, 1);
+		if (!used_strings) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		mark_live_units(units, unit_count, &definitions, used_strings);
+	}
+	write_units(units, unit_count, threads <= 1 && !prune);
+
 	// Generate string constants at the end
-	generate_string_constants();
+	generate_string_constants(used_strings);
+	for (int i = 0; i < unit_count; i++) {
+		if (units[i].live && units[i].globals.len > 0)
+			ir_putn(&ctx.out, units[i].globals.buf, units[i].globals.len);
+		ir_writer_finish(&units[i].globals);
+	}
+	free(used_strings);
+	free(units);
+	free(function_units);
+	free(definitions.slots);
 
 	// Cleanup
-	for (int i = 0; i < ctx.string_literal_count; i++) {
-		free(ctx.string_literals[i].content);
-	}
-	free(ctx.string_literals);
+	free(module.string_literals);
+	free(module.string_buckets);
+	end_thread_context();
+	arena_release(&ctx.arena);
 
-	free(ctx.current_break_label);
-	free(ctx.current_continue_label);
-	free(ctx.current_switch_end_label);
-	free(ctx.current_function_name);
-	free_type_info(&ctx.current_function_return_type);
+	destroy_symbol_table(module.symbol_table);
+	ir_writer_finish(&ctx.out);
 
-	destroy_symbol_table(ctx.symbol_table);
+	if (module.inlines) {
+		if (codegen_options.verbose)
+			inline_report(module.inlines, stdout);
+		inline_table_destroy(module.inlines);
+	}
 }
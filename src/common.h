@@ -9,6 +9,9 @@
 #define MAX_IDENTIFIER_LENGTH 256
 #define MAX_STRING_LENGTH 1024
 
+// Storage that each code generation thread keeps to itself
+#define THREAD_LOCAL __thread
+
 // Error codes
 #define ERROR_SUCCESS 0
 #define ERROR_SYNTAX 1
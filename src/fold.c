@@ -0,0 +1,506 @@
+#define _POSIX_C_SOURCE 200809L
+#include "fold.h"
+#include "common.h"
+#include "type_table.h"
+#include <limits.h>
+#include <string.h>
+
+static THREAD_LOCAL size_t folded_total;
+
+// Results wrap around like the i32 arithmetic codegen would emit
+static long long wrap_int(long long value)
+{
+	return (int)(unsigned int)value;
+}
+
+static int apply_unary(unary_op_t op, long long operand, long long *value)
+{
+	switch (op) {
+	case OP_NEG:
+		*value = wrap_int(-operand);
+		return 1;
+	case OP_NOT:
+		*value = !operand;
+		return 1;
+	case OP_BNOT:
+		*value = wrap_int(~operand);
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static int apply_binary(binary_op_t op, long long left, long long right, long long *value)
+{
+	switch (op) {
+	case OP_ADD: *value = wrap_int(left + right); return 1;
+	case OP_SUB: *value = wrap_int(left - right); return 1;
+	case OP_MUL: *value = wrap_int(left * right); return 1;
+	case OP_DIV:
+	case OP_MOD:
+		// Both trap at run time; leave them to it
+		if (right == 0 || (left == INT_MIN && right == -1))
+			return 0;
+		*value = op == OP_DIV ? left / right : left % right;
+		return 1;
+	case OP_EQ: *value = left == right; return 1;
+	case OP_NE: *value = left != right; return 1;
+	case OP_LT: *value = left < right; return 1;
+	case OP_LE: *value = left <= right; return 1;
+	case OP_GT: *value = left > right; return 1;
+	case OP_GE: *value = left >= right; return 1;
+	case OP_LAND: *value = left && right; return 1;
+	case OP_LOR: *value = left || right; return 1;
+	case OP_BAND: *value = left & right; return 1;
+	case OP_BOR: *value = left | right; return 1;
+	case OP_BXOR: *value = left ^ right; return 1;
+	case OP_LSHIFT:
+	case OP_RSHIFT:
+		if (right < 0 || right >= 32)
+			return 0;
+		*value = op == OP_LSHIFT ? wrap_int((long long)((unsigned int)left << right)) : left >> right;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// Converts value to the integer type of a cast; floating and void targets
+// are not integer constants
+static int convert_to_type(const type_info_t *type, long long *value)
+{
+	if (type->pointer_level > 0 || type->is_array)
+		return 1;
+	const char *name = type->base_type;
+	int is_unsigned = strstr(name, "unsigned") != NULL;
+	if (strcmp(name, "float") == 0 || strcmp(name, "double") == 0 || strcmp(name, "void") == 0)
+		return 0;
+	if (strcmp(name, "_Bool") == 0)
+		*value = *value != 0;
+	else if (strstr(name, "char"))
+		*value = is_unsigned ? (long long)(unsigned char)*value : (long long)(signed char)*value;
+	else if (strstr(name, "short"))
+		*value = is_unsigned ? (long long)(unsigned short)*value : (long long)(short)*value;
+	else
+		*value = wrap_int(*value);
+	return 1;
+}
+
+int evaluate_constant(const ast_node_t *expr, symbol_table_t *table, long long *value)
+{
+	long long left, right;
+
+	if (!expr)
+		return 0;
+
+	switch (expr->type) {
+	case AST_NUMBER:
+		*value = expr->data.number.value;
+		return 1;
+	case AST_CHARACTER:
+		*value = expr->data.character.value;
+		return 1;
+	case AST_IDENTIFIER: {
+		symbol_t *sym = expr->data.identifier.symbol;
+		if (!sym && table)
+			sym = find_symbol(table, expr->data.identifier.name);
+		if (!sym || sym->sym_type != SYM_ENUM_CONSTANT)
+			return 0;
+		*value = sym->enum_value;
+		return 1;
+	}
+	case AST_SIZEOF:
+		*value = (long long)expr->data.sizeof_op.size_value;
+		return 1;
+	case AST_CAST:
+		return evaluate_constant(expr->data.cast.expression, table, value) &&
+		       convert_to_type(&expr->data.cast.target_type, value);
+	case AST_UNARY_OP:
+		return evaluate_constant(expr->data.unary_op.operand, table, &left) &&
+		       apply_unary(expr->data.unary_op.op, left, value);
+	case AST_BINARY_OP:
+		if (!evaluate_constant(expr->data.binary_op.left, table, &left))
+			return 0;
+		// 0 && x and 1 || x are constant whatever x is
+		if ((expr->data.binary_op.op == OP_LAND && !left) || (expr->data.binary_op.op == OP_LOR && left)) {
+			*value = expr->data.binary_op.op == OP_LOR;
+			return 1;
+		}
+		return evaluate_constant(expr->data.binary_op.right, table, &right) &&
+		       apply_binary(expr->data.binary_op.op, left, right, value);
+	case AST_CONDITIONAL:
+		if (!evaluate_constant(expr->data.conditional.condition, table, &left))
+			return 0;
+		return evaluate_constant(left ? expr->data.conditional.true_expr : expr->data.conditional.false_expr,
+					 table, value);
+	default:
+		return 0;
+	}
+}
+
+size_t folded_node_count(void)
+{
+	return folded_total;
+}
+
+// Operands are folded first, so a constant operand is always one of these
+static int constant_operand(const ast_node_t *node, long long *value)
+{
+	if (node->type == AST_NUMBER) {
+		*value = node->data.number.value;
+		return 1;
+	}
+	if (node->type == AST_CHARACTER) {
+		*value = node->data.character.value;
+		return 1;
+	}
+	return 0;
+}
+
+// Turns node into an int literal; get_expression_type() types it from scratch
+static ast_node_t *make_number(ast_node_t *node, long long value)
+{
+	node->type = AST_NUMBER;
+	node->data.number.value = (int)value;
+	node->expr_type = NULL;
+	folded_total++;
+	return node;
+}
+
+static int is_int(const type_info_t *type)
+{
+	return type && type->pointer_level == 0 && !type->is_array && !type->is_function &&
+	       strcmp(type->base_type, "int") == 0;
+}
+
+// Whether operand can stand in for node: same type, and not a float, where
+// x + 0 is not x for x == -0.0
+static int can_replace(const ast_node_t *node, const ast_node_t *operand)
+{
+	if (!node->expr_type)
+		return 0;
+	if (operand->expr_type != node->expr_type) {
+		// Literals folded here lost their memo but are still int
+		if (operand->type != AST_NUMBER || operand->expr_type || !is_int(node->expr_type))
+			return 0;
+		return 1;
+	}
+	const llvm_type_t *type = llvm_type_of(node->expr_type);
+	return llvm_type_is_integer(type) || llvm_type_is_pointer(type);
+}
+
+// Whether reading node reads a volatile object, which counts as a side effect
+static int reads_volatile(const ast_node_t *node)
+{
+	const type_info_t *type = node->expr_type;
+	if (node->type == AST_IDENTIFIER) {
+		if (!node->data.identifier.symbol)
+			return 0;
+		type = &node->data.identifier.symbol->type_info;
+	}
+	if (!type || type->is_array)
+		return 0;
+	type_qualifier_t qualifiers = type->pointer_level > 0 ? type->pointer_qualifiers : type->qualifiers;
+	return (qualifiers & QUAL_VOLATILE) != 0;
+}
+
+static int has_side_effects(const ast_node_t *node)
+{
+	if (!node)
+		return 0;
+
+	switch (node->type) {
+	case AST_NUMBER:
+	case AST_CHARACTER:
+	case AST_STRING_LITERAL:
+	case AST_SIZEOF:
+		return 0;
+	case AST_IDENTIFIER:
+		return reads_volatile(node);
+	case AST_BINARY_OP:
+		return has_side_effects(node->data.binary_op.left) || has_side_effects(node->data.binary_op.right);
+	case AST_UNARY_OP:
+		if (node->data.unary_op.op != OP_NEG && node->data.unary_op.op != OP_NOT &&
+		    node->data.unary_op.op != OP_BNOT)
+			return 1; // ++ and --
+		return has_side_effects(node->data.unary_op.operand);
+	case AST_CAST:
+		return has_side_effects(node->data.cast.expression);
+	case AST_ADDRESS_OF:
+		return has_side_effects(node->data.address_of.operand);
+	case AST_DEREFERENCE:
+		return reads_volatile(node) || has_side_effects(node->data.dereference.operand);
+	case AST_ARRAY_ACCESS:
+		return reads_volatile(node) || has_side_effects(node->data.array_access.array) ||
+		       has_side_effects(node->data.array_access.index);
+	case AST_MEMBER_ACCESS:
+		return reads_volatile(node) || has_side_effects(node->data.member_access.object);
+	case AST_PTR_MEMBER_ACCESS:
+		return reads_volatile(node) || has_side_effects(node->data.ptr_member_access.object);
+	case AST_CONDITIONAL:
+		return has_side_effects(node->data.conditional.condition) ||
+		       has_side_effects(node->data.conditional.true_expr) ||
+		       has_side_effects(node->data.conditional.false_expr);
+	default:
+		// Calls, assignments and anything not listed
+		return 1;
+	}
+}
+
+int contains_label(const ast_node_t *stmt)
+{
+	if (!stmt)
+		return 0;
+
+	switch (stmt->type) {
+	case AST_LABEL_STMT:
+	case AST_CASE_STMT:
+	case AST_DEFAULT_STMT:
+		return 1;
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < stmt->data.compound.stmt_count; i++) {
+			if (contains_label(stmt->data.compound.statements[i]))
+				return 1;
+		}
+		return 0;
+	case AST_IF_STMT:
+		return contains_label(stmt->data.if_stmt.then_stmt) || contains_label(stmt->data.if_stmt.else_stmt);
+	case AST_WHILE_STMT:
+		return contains_label(stmt->data.while_stmt.body);
+	case AST_FOR_STMT:
+		return contains_label(stmt->data.for_stmt.body);
+	case AST_DO_WHILE_STMT:
+		return contains_label(stmt->data.do_while_stmt.body);
+	case AST_SWITCH_STMT:
+		return contains_label(stmt->data.switch_stmt.body);
+	default:
+		return 0;
+	}
+}
+
+static ast_node_t *fold_node(ast_node_t *node);
+
+static ast_node_t *fold_binary(ast_node_t *node)
+{
+	binary_op_t op = node->data.binary_op.op;
+	ast_node_t *left = node->data.binary_op.left = fold_node(node->data.binary_op.left);
+	long long l, r, value;
+	int left_constant = left && constant_operand(left, &l);
+
+	// 0 && x and 1 || x never evaluate x
+	if (left_constant && ((op == OP_LAND && !l) || (op == OP_LOR && l)))
+		return make_number(node, op == OP_LOR);
+
+	ast_node_t *right = node->data.binary_op.right = fold_node(node->data.binary_op.right);
+	if (!left || !right)
+		return node;
+	int right_constant = constant_operand(right, &r);
+
+	if (left_constant && right_constant)
+		return apply_binary(op, l, r, &value) ? make_number(node, value) : node;
+
+	if (right_constant) {
+		switch (op) {
+		case OP_ADD:
+		case OP_SUB:
+		case OP_BOR:
+		case OP_BXOR:
+		case OP_LSHIFT:
+		case OP_RSHIFT:
+			if (r == 0 && can_replace(node, left))
+				return left;
+			break;
+		case OP_MUL:
+		case OP_DIV:
+			if (r == 1 && can_replace(node, left))
+				return left;
+			if (op == OP_MUL && r == 0 && is_int(node->expr_type) && !has_side_effects(left))
+				return make_number(node, 0);
+			break;
+		case OP_BAND:
+			if (r == -1 && can_replace(node, left))
+				return left;
+			if (r == 0 && is_int(node->expr_type) && !has_side_effects(left))
+				return make_number(node, 0);
+			break;
+		default:
+			break;
+		}
+	} else if (left_constant) {
+		switch (op) {
+		case OP_ADD:
+		case OP_BOR:
+		case OP_BXOR:
+			if (l == 0 && can_replace(node, right))
+				return right;
+			break;
+		case OP_MUL:
+			if (l == 1 && can_replace(node, right))
+				return right;
+			if (l == 0 && is_int(node->expr_type) && !has_side_effects(right))
+				return make_number(node, 0);
+			break;
+		case OP_BAND:
+			if (l == -1 && can_replace(node, right))
+				return right;
+			if (l == 0 && is_int(node->expr_type) && !has_side_effects(right))
+				return make_number(node, 0);
+			break;
+		default:
+			break;
+		}
+	}
+	return node;
+}
+
+static ast_node_t *fold_node(ast_node_t *node)
+{
+	long long value;
+
+	if (!node)
+		return NULL;
+
+	switch (node->type) {
+	case AST_PROGRAM:
+		for (int i = 0; i < node->data.program.decl_count; i++)
+			node->data.program.declarations[i] = fold_node(node->data.program.declarations[i]);
+		break;
+	case AST_FUNCTION:
+		node->data.function.body = fold_node(node->data.function.body);
+		break;
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < node->data.compound.stmt_count; i++)
+			node->data.compound.statements[i] = fold_node(node->data.compound.statements[i]);
+		break;
+	case AST_DECLARATION:
+		node->data.declaration.init = fold_node(node->data.declaration.init);
+		break;
+	case AST_INITIALIZER_LIST:
+		for (int i = 0; i < node->data.initializer_list.count; i++)
+			node->data.initializer_list.values[i] = fold_node(node->data.initializer_list.values[i]);
+		break;
+	case AST_EXPR_STMT:
+		node->data.expr_stmt.expr = fold_node(node->data.expr_stmt.expr);
+		break;
+	case AST_RETURN_STMT:
+		node->data.return_stmt.value = fold_node(node->data.return_stmt.value);
+		break;
+
+	case AST_IF_STMT: {
+		ast_node_t *condition = node->data.if_stmt.condition = fold_node(node->data.if_stmt.condition);
+		ast_node_t *then_stmt = node->data.if_stmt.then_stmt = fold_node(node->data.if_stmt.then_stmt);
+		ast_node_t *else_stmt = node->data.if_stmt.else_stmt = fold_node(node->data.if_stmt.else_stmt);
+		if (!condition || !constant_operand(condition, &value) || contains_label(value ? else_stmt : then_stmt))
+			break;
+		folded_total++;
+		if (value ? then_stmt : else_stmt)
+			return value ? then_stmt : else_stmt;
+		node->type = AST_EMPTY_STMT;
+		break;
+	}
+	case AST_WHILE_STMT:
+		node->data.while_stmt.condition = fold_node(node->data.while_stmt.condition);
+		node->data.while_stmt.body = fold_node(node->data.while_stmt.body);
+		if (node->data.while_stmt.condition && constant_operand(node->data.while_stmt.condition, &value) &&
+		    !value && !contains_label(node->data.while_stmt.body)) {
+			folded_total++;
+			node->type = AST_EMPTY_STMT;
+		}
+		break;
+	case AST_FOR_STMT:
+		node->data.for_stmt.init = fold_node(node->data.for_stmt.init);
+		node->data.for_stmt.condition = fold_node(node->data.for_stmt.condition);
+		node->data.for_stmt.update = fold_node(node->data.for_stmt.update);
+		node->data.for_stmt.body = fold_node(node->data.for_stmt.body);
+		break;
+	case AST_DO_WHILE_STMT:
+		node->data.do_while_stmt.body = fold_node(node->data.do_while_stmt.body);
+		node->data.do_while_stmt.condition = fold_node(node->data.do_while_stmt.condition);
+		break;
+	case AST_SWITCH_STMT:
+		node->data.switch_stmt.expression = fold_node(node->data.switch_stmt.expression);
+		node->data.switch_stmt.body = fold_node(node->data.switch_stmt.body);
+		break;
+	case AST_CASE_STMT:
+		node->data.case_stmt.value = fold_node(node->data.case_stmt.value);
+		node->data.case_stmt.statement = fold_node(node->data.case_stmt.statement);
+		break;
+	case AST_DEFAULT_STMT:
+		node->data.default_stmt.statement = fold_node(node->data.default_stmt.statement);
+		break;
+	case AST_LABEL_STMT:
+		node->data.label_stmt.statement = fold_node(node->data.label_stmt.statement);
+		break;
+
+	case AST_IDENTIFIER: {
+		symbol_t *sym = node->data.identifier.symbol;
+		if (sym && sym->sym_type == SYM_ENUM_CONSTANT)
+			return make_number(node, sym->enum_value);
+		break;
+	}
+	case AST_SIZEOF:
+		return make_number(node, (long long)node->data.sizeof_op.size_value);
+	case AST_BINARY_OP:
+		return fold_binary(node);
+	case AST_UNARY_OP:
+		node->data.unary_op.operand = fold_node(node->data.unary_op.operand);
+		if (node->data.unary_op.operand && constant_operand(node->data.unary_op.operand, &value) &&
+		    apply_unary(node->data.unary_op.op, value, &value))
+			return make_number(node, value);
+		break;
+	case AST_CAST:
+		node->data.cast.expression = fold_node(node->data.cast.expression);
+		// Narrower or wider targets would need the constant retyped
+		if (node->data.cast.expression && is_int(&node->data.cast.target_type) &&
+		    constant_operand(node->data.cast.expression, &value))
+			return make_number(node, value);
+		break;
+	case AST_CONDITIONAL: {
+		ast_node_t *condition = node->data.conditional.condition =
+			fold_node(node->data.conditional.condition);
+		ast_node_t *true_expr = node->data.conditional.true_expr = fold_node(node->data.conditional.true_expr);
+		ast_node_t *false_expr = node->data.conditional.false_expr =
+			fold_node(node->data.conditional.false_expr);
+		if (condition && true_expr && false_expr && constant_operand(condition, &value)) {
+			ast_node_t *taken = value ? true_expr : false_expr;
+			if (can_replace(node, taken) || (is_int(node->expr_type) && constant_operand(taken, &value))) {
+				folded_total++;
+				return taken;
+			}
+		}
+		break;
+	}
+	case AST_ASSIGNMENT:
+		node->data.assignment.lvalue = fold_node(node->data.assignment.lvalue);
+		node->data.assignment.value = fold_node(node->data.assignment.value);
+		break;
+	case AST_CALL:
+		for (int i = 0; i < node->data.call.arg_count; i++)
+			node->data.call.args[i] = fold_node(node->data.call.args[i]);
+		break;
+	case AST_ADDRESS_OF:
+		node->data.address_of.operand = fold_node(node->data.address_of.operand);
+		break;
+	case AST_DEREFERENCE:
+		node->data.dereference.operand = fold_node(node->data.dereference.operand);
+		break;
+	case AST_ARRAY_ACCESS:
+		node->data.array_access.array = fold_node(node->data.array_access.array);
+		node->data.array_access.index = fold_node(node->data.array_access.index);
+		break;
+	case AST_MEMBER_ACCESS:
+		node->data.member_access.object = fold_node(node->data.member_access.object);
+		break;
+	case AST_PTR_MEMBER_ACCESS:
+		node->data.ptr_member_access.object = fold_node(node->data.ptr_member_access.object);
+		break;
+	default:
+		break;
+	}
+	return node;
+}
+
+void fold_constants(ast_node_t *ast)
+{
+	fold_node(ast);
+}
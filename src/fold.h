@@ -0,0 +1,26 @@
+#ifndef FOLD_H
+#define FOLD_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Evaluates an integer constant expression with int arithmetic: literals,
+// enum constants, sizeof, casts and the unary and binary operators.
+// Identifiers not yet bound by check_types() are looked up in table when
+// it is not NULL. Returns 0 if expr is not constant, or divides by zero,
+// or shifts by more than the width of int.
+int evaluate_constant(const ast_node_t *expr, symbol_table_t *table, long long *value);
+
+// Rewrites an AST that went through check_types() before codegen:
+// constant subexpressions become AST_NUMBER, identities such as x*1, x+0
+// and x&0 drop their operator, and if, while and ?: with a constant
+// condition keep only the branch that runs. Branches holding a label or a
+// case are kept, since a jump may still reach them.
+void fold_constants(ast_node_t *ast);
+
+// Whether a goto or an enclosing switch could jump into stmt
+int contains_label(const ast_node_t *stmt);
+
+size_t folded_node_count(void);
+
+#endif
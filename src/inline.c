@@ -0,0 +1,584 @@
+#define _POSIX_C_SOURCE 200809L
+#include "inline.h"
+#include "common.h"
+#include "ir_text.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// What a call costs the caller besides the callee's body: the call and the
+// return, and passing each argument. Inlining saves all of it.
+#define CALL_COST 2
+#define ARGUMENT_COST 1
+// A constant argument usually lets the branches and arithmetic on that
+// parameter fold once the body sits at the call site
+#define CONSTANT_ARGUMENT_BONUS 2
+
+// "<type> <value>" in a parameter or argument list
+typedef struct {
+	slice_t type;
+	slice_t value; // Parameter names keep their %
+} operand_t;
+
+typedef struct {
+	char *text; // Copy of the function, which the slices point into
+	slice_t name;
+	slice_t return_type;
+	operand_t *params;
+	int param_count;
+	slice_t body;
+	int cost;       // Instructions, leaving out labels and allocas
+	int limit;      // Largest cost a call site accepts
+	int max_temp;   // Highest %tN of the body
+	int single_ret; // The only ret is the last line
+	size_t sites;
+} callee_t;
+
+struct inline_table {
+	callee_t *callees;
+	int count;
+	int *buckets; // Open addressing by name, -1 when empty
+	size_t bucket_count;
+	int threshold;
+};
+
+static size_t inlined_total;
+static pthread_mutex_t inline_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Register number of "tN" or "tN.addr", -1 for any other name; *digits
+// receives the length of "tN"
+static int temp_prefix(slice_t name, size_t *digits)
+{
+	if (name.len < 2 || name.ptr[0] != 't')
+		return -1;
+	int n = 0;
+	size_t i = 1;
+	for (; i < name.len && name.ptr[i] >= '0' && name.ptr[i] <= '9'; i++)
+		n = n * 10 + (name.ptr[i] - '0');
+	if (i == 1 || (i < name.len && (name.len - i != 5 || memcmp(name.ptr + i, ".addr", 5) != 0)))
+		return -1;
+	*digits = i;
+	return n;
+}
+
+// Splits "<type> <value>, ..." at the commas outside brackets. Returns NULL
+// with *count set to -1 when an item is not a typed value (such as "...")
+static operand_t *parse_operands(const char *p, const char *end, int *count)
+{
+	operand_t *ops = NULL;
+	int n = 0;
+	int depth = 0;
+	*count = -1;
+	while (p < end && *p == ' ')
+		p++;
+	if (p == end) {
+		*count = 0;
+		return NULL;
+	}
+	const char *start = p;
+	for (;; p++) {
+		if (p < end && *p != ',') {
+			if (*p == '(' || *p == '[' || *p == '{' || *p == '<')
+				depth++;
+			else if (*p == ')' || *p == ']' || *p == '}' || *p == '>')
+				depth--;
+			continue;
+		}
+		if (p < end && depth > 0)
+			continue;
+
+		// The value is the last word of the item
+		const char *q = p;
+		while (q > start && q[-1] == ' ')
+			q--;
+		const char *value = q;
+		while (value > start && value[-1] != ' ')
+			value--;
+		if (value == start || value == q) {
+			free(ops);
+			return NULL;
+		}
+		operand_t *grown = realloc(ops, (size_t)(n + 1) * sizeof(operand_t));
+		if (!grown) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		ops = grown;
+		ops[n].type = (slice_t){start, (size_t)(value - 1 - start)};
+		ops[n].value = (slice_t){value, (size_t)(q - value)};
+		n++;
+		if (p == end)
+			break;
+		start = p + 1;
+		while (start < end && *start == ' ')
+			start++;
+		p = start - 1;
+	}
+	*count = n;
+	return ops;
+}
+
+// Drops the parameter attributes codegen puts after a type, which call
+// sites do not repeat
+static void strip_attributes(slice_t *type)
+{
+	static const char *const attributes[] = {" noalias", " readonly"};
+	for (int changed = 1; changed;) {
+		changed = 0;
+		for (size_t i = 0; i < sizeof(attributes) / sizeof(attributes[0]); i++) {
+			size_t n = strlen(attributes[i]);
+			if (type->len > n && memcmp(type->ptr + type->len - n, attributes[i], n) == 0) {
+				type->len -= n;
+				changed = 1;
+			}
+		}
+	}
+}
+
+inline_table_t *inline_table_create(int threshold)
+{
+	inline_table_t *table = calloc(1, sizeof(inline_table_t));
+	if (!table) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	table->threshold = threshold;
+	return table;
+}
+
+void inline_table_destroy(inline_table_t *table)
+{
+	if (!table)
+		return;
+	for (int i = 0; i < table->count; i++) {
+		free(table->callees[i].text);
+		free(table->callees[i].params);
+	}
+	free(table->callees);
+	free(table->buckets);
+	free(table);
+}
+
+static callee_t *find_callee(const inline_table_t *table, slice_t name)
+{
+	if (table->bucket_count == 0)
+		return NULL;
+	size_t i = hash_slice(name) & (table->bucket_count - 1);
+	while (table->buckets[i] >= 0) {
+		callee_t *callee = &table->callees[table->buckets[i]];
+		if (slice_eq(callee->name, name))
+			return callee;
+		i = (i + 1) & (table->bucket_count - 1);
+	}
+	return NULL;
+}
+
+static void insert_bucket(inline_table_t *table, int index)
+{
+	size_t i = hash_slice(table->callees[index].name) & (table->bucket_count - 1);
+	while (table->buckets[i] >= 0)
+		i = (i + 1) & (table->bucket_count - 1);
+	table->buckets[i] = index;
+}
+
+// Fills in the body's cost and shape; returns 0 for bodies that cannot be
+// copied into another function
+static int measure_body(callee_t *callee, int *calls)
+{
+	const char *p = callee->body.ptr;
+	const char *end = p + callee->body.len;
+	slice_t line;
+	int ret_count = 0;
+	int last_is_ret = 0;
+	*calls = 0;
+
+	while (next_line(&p, end, &line)) {
+		last_is_ret = 0;
+		if (is_label_line(line))
+			continue;
+		if (contains(line, "blockaddress") || contains(line, "indirectbr") || contains(line, "@llvm.va_start") ||
+		    contains(line, "@llvm.stacksave"))
+			return 0;
+
+		const char *q = line.ptr;
+		slice_t name;
+		while (next_local(&q, line.ptr + line.len, &name)) {
+			size_t digits;
+			int n = temp_prefix(name, &digits);
+			if (n > callee->max_temp)
+				callee->max_temp = n;
+		}
+
+		if (contains(line, " = alloca ")) {
+			// Only fixed-size allocas can move to the caller's entry block
+			if (contains(line, ", "))
+				return 0;
+			continue;
+		}
+		if (starts_with(line, "  call ") || contains(line, " = call ")) {
+			const char *at = memchr(line.ptr, '@', line.len);
+			if (at) {
+				slice_t target = {at + 1, (size_t)(line.ptr + line.len - at - 1)};
+				if (starts_with(target, "llvm.")) {
+					// Intrinsics are not calls
+				} else if (target.len > callee->name.len && target.ptr[callee->name.len] == '(' &&
+					   memcmp(target.ptr, callee->name.ptr, callee->name.len) == 0) {
+					return 0;
+				} else {
+					++*calls;
+				}
+			} else {
+				++*calls;
+			}
+		}
+		if (starts_with(line, "  ret ")) {
+			ret_count++;
+			last_is_ret = 1;
+		}
+		callee->cost++;
+	}
+	callee->single_ret = ret_count == 1 && last_is_ret;
+	return 1;
+}
+
+int inline_table_add(inline_table_t *table, const char *text, size_t len, int hint)
+{
+	callee_t callee;
+	memset(&callee, 0, sizeof(callee));
+	callee.text = malloc(len + 1);
+	if (!callee.text) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	memcpy(callee.text, text, len);
+	callee.text[len] = '\0';
+
+	// "define [internal] <type> @<name>(<params>) [attributes] {", the
+	// body, then "}"
+	const char *end = callee.text + len;
+	const char *p = callee.text;
+	slice_t header;
+	if (!next_line(&p, end, &header) || !starts_with(header, "define ") || header.len < 10 ||
+	    memcmp(header.ptr + header.len - 2, " {", 2) != 0)
+		goto reject;
+	const char *type = header.ptr + 7;
+	if (starts_with((slice_t){type, header.len - 7}, "internal "))
+		type += 9;
+	const char *at = memchr(type, '@', (size_t)(header.ptr + header.len - type));
+	const char *open = at ? memchr(at, '(', (size_t)(header.ptr + header.len - at)) : NULL;
+	const char *close = header.ptr + header.len - 2;
+	while (close > header.ptr && *close != ')')
+		close--;
+	if (!at || !open || at < type + 2 || close < open)
+		goto reject;
+	callee.return_type = (slice_t){type, (size_t)(at - 1 - type)};
+	callee.name = (slice_t){at + 1, (size_t)(open - at - 1)};
+	callee.params = parse_operands(open + 1, close, &callee.param_count);
+	if (callee.param_count < 0)
+		goto reject;
+	for (int i = 0; i < callee.param_count; i++)
+		strip_attributes(&callee.params[i].type);
+
+	const char *body_end = end;
+	while (body_end > p && body_end[-1] != '}')
+		body_end--;
+	if (body_end - p < 2)
+		goto reject;
+	callee.body = (slice_t){p, (size_t)(body_end - 1 - p)};
+
+	int calls;
+	if (!measure_body(&callee, &calls) || (calls > 0 && !hint))
+		goto reject;
+
+	// Even a call site passing only constants could not afford more
+	callee.limit = hint ? table->threshold * 2 : table->threshold;
+	int best_case = callee.cost - CALL_COST - callee.param_count * (ARGUMENT_COST + CONSTANT_ARGUMENT_BONUS);
+	if (best_case > callee.limit || find_callee(table, callee.name))
+		goto reject;
+
+	callee_t *grown = realloc(table->callees, (size_t)(table->count + 1) * sizeof(callee_t));
+	if (!grown) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	table->callees = grown;
+	table->callees[table->count++] = callee;
+
+	if ((size_t)table->count * 2 > table->bucket_count) {
+		size_t count = table->bucket_count ? table->bucket_count * 2 : 16;
+		int *buckets = malloc(count * sizeof(int));
+		if (!buckets) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		free(table->buckets);
+		table->buckets = buckets;
+		table->bucket_count = count;
+		memset(buckets, -1, count * sizeof(int));
+		for (int i = 0; i < table->count; i++)
+			insert_bucket(table, i);
+	} else {
+		insert_bucket(table, table->count - 1);
+	}
+	return 1;
+
+reject:
+	free(callee.text);
+	free(callee.params);
+	return 0;
+}
+
+// A call site taking a copy of callee
+typedef struct {
+	const callee_t *callee;
+	operand_t *args;
+	int result; // %tN receiving the return value, -1 for none
+	int base;   // Added to the callee's register numbers
+	int id;     // Suffix of the callee's names in this copy
+} site_t;
+
+// "  call <type> @<name>(<args>)" or "  %tN = call <type> @<name>(<args>)"
+// to a table function whose parameter types match and which the cost
+// model lets in
+static int match_site(inline_table_t *table, slice_t line, site_t *site)
+{
+	const char *end = line.ptr + line.len;
+	const char *p = line.ptr + 2;
+	site->result = -1;
+	if (starts_with(line, "  %t")) {
+		slice_t name;
+		size_t digits;
+		if (!next_local(&p, end, &name) || temp_prefix(name, &digits) < 0 || digits != name.len)
+			return 0;
+		site->result = temp_prefix(name, &digits);
+		if (end - p < 3 || memcmp(p, " = ", 3) != 0)
+			return 0;
+		p += 3;
+	}
+	if (end - p < 5 || memcmp(p, "call ", 5) != 0 || end[-1] != ')')
+		return 0;
+	p += 5;
+	const char *at = memchr(p, '@', (size_t)(end - p));
+	const char *open = at ? memchr(at, '(', (size_t)(end - at)) : NULL;
+	if (!at || !open || at == p)
+		return 0;
+
+	slice_t name = {at + 1, (size_t)(open - at - 1)};
+	const callee_t *callee = find_callee(table, name);
+	slice_t return_type = {p, (size_t)(at - 1 - p)};
+	if (!callee || !slice_eq(return_type, callee->return_type))
+		return 0;
+
+	int arg_count;
+	operand_t *args = parse_operands(open + 1, end - 1, &arg_count);
+	if (arg_count != callee->param_count) {
+		free(args);
+		return 0;
+	}
+	int cost = callee->cost - CALL_COST - arg_count * ARGUMENT_COST;
+	for (int i = 0; i < arg_count; i++) {
+		if (!slice_eq(args[i].type, callee->params[i].type)) {
+			free(args);
+			return 0;
+		}
+		if (args[i].value.ptr[0] != '%')
+			cost -= CONSTANT_ARGUMENT_BONUS;
+	}
+	if (cost > callee->limit) {
+		free(args);
+		return 0;
+	}
+	site->callee = callee;
+	site->args = args;
+	return 1;
+}
+
+// A %name of the callee as it reads in this copy: parameters become the
+// arguments, registers are renumbered and everything else gets a suffix
+static void write_local(ir_writer_t *out, slice_t name, const site_t *site)
+{
+	for (int i = 0; i < site->callee->param_count; i++) {
+		slice_t param = site->callee->params[i].value;
+		if (param.len == name.len + 1 && memcmp(param.ptr + 1, name.ptr, name.len) == 0) {
+			ir_putn(out, site->args[i].value.ptr, site->args[i].value.len);
+			return;
+		}
+	}
+	size_t digits;
+	int n = temp_prefix(name, &digits);
+	if (n >= 0) {
+		ir_temp(out, site->base + n);
+		ir_putn(out, name.ptr + digits, name.len - digits);
+		return;
+	}
+	ir_putc(out, '%');
+	ir_putn(out, name.ptr, name.len);
+	if (!starts_with(name, "struct.") && !starts_with(name, "union.")) {
+		ir_puts(out, ".inl");
+		ir_int(out, site->id);
+	}
+}
+
+static void write_line(ir_writer_t *out, slice_t line, const site_t *site)
+{
+	const char *p = line.ptr;
+	const char *end = line.ptr + line.len;
+	const char *written = p;
+	slice_t name;
+	while (next_local(&p, end, &name)) {
+		ir_putn(out, written, (size_t)(name.ptr - 1 - written));
+		write_local(out, name, site);
+		written = p;
+	}
+	ir_putn(out, written, (size_t)(end - written));
+	ir_putc(out, '\n');
+}
+
+// "<type>* %tN.addr", the slot receiving the return value
+static void write_result_slot(ir_writer_t *out, const site_t *site)
+{
+	ir_putn(out, site->callee->return_type.ptr, site->callee->return_type.len);
+	ir_puts(out, "* ");
+	ir_temp(out, site->result);
+	ir_puts(out, ".addr");
+}
+
+static void expand_site(ir_writer_t *code, ir_writer_t *allocas, const site_t *site)
+{
+	const callee_t *callee = site->callee;
+	const char *p = callee->body.ptr;
+	const char *end = p + callee->body.len;
+	slice_t line;
+	int first = 1;
+
+	if (site->result >= 0) {
+		ir_puts(allocas, "  ");
+		ir_temp(allocas, site->result);
+		ir_puts(allocas, ".addr = alloca ");
+		ir_putn(allocas, callee->return_type.ptr, callee->return_type.len);
+		ir_putc(allocas, '\n');
+	}
+
+	while (next_line(&p, end, &line)) {
+		if (is_label_line(line)) {
+			slice_t label = {line.ptr, line.len - 1};
+			if (first) {
+				// The caller's block falls into the callee's entry block
+				ir_puts(code, "  br label ");
+				write_local(code, label, site);
+				ir_putc(code, '\n');
+			}
+			ir_putn(code, label.ptr, label.len);
+			ir_puts(code, ".inl");
+			ir_int(code, site->id);
+			ir_putn(code, ":\n", 2);
+		} else if (contains(line, " = alloca ")) {
+			write_line(allocas, line, site);
+		} else if (starts_with(line, "  ret ")) {
+			// "  ret <type> <value>" stores the value and leaves the copy
+			size_t skip = 6 + callee->return_type.len + 1;
+			if (site->result >= 0 && line.len > skip) {
+				ir_puts(code, "  store ");
+				ir_putn(code, callee->return_type.ptr, callee->return_type.len);
+				ir_putc(code, ' ');
+				slice_t value = {line.ptr + skip, line.len - skip};
+				const char *q = value.ptr;
+				slice_t name;
+				if (value.ptr[0] == '%' && next_local(&q, value.ptr + value.len, &name))
+					write_local(code, name, site);
+				else
+					ir_putn(code, value.ptr, value.len);
+				ir_puts(code, ", ");
+				write_result_slot(code, site);
+				ir_putc(code, '\n');
+			}
+			if (!callee->single_ret) {
+				ir_puts(code, "  br label %inline_end");
+				ir_int(code, site->id);
+				ir_putc(code, '\n');
+			}
+		} else {
+			write_line(code, line, site);
+		}
+		first = 0;
+	}
+
+	if (!callee->single_ret) {
+		ir_puts(code, "inline_end");
+		ir_int(code, site->id);
+		ir_putn(code, ":\n", 2);
+	}
+	if (site->result >= 0) {
+		ir_puts(code, "  ");
+		ir_temp(code, site->result);
+		ir_puts(code, " = load ");
+		ir_putn(code, callee->return_type.ptr, callee->return_type.len);
+		ir_puts(code, ", ");
+		write_result_slot(code, site);
+		ir_putc(code, '\n');
+	}
+}
+
+void inline_calls(inline_table_t *table, const char *body, size_t len, ir_writer_t *out, int *temp_counter)
+{
+	const char *end = body + len;
+	const char *p = body;
+	const char *copied = body;
+	ir_writer_t allocas;
+	ir_writer_t code;
+	slice_t line;
+	int sites = 0;
+
+	if (table->count == 0) {
+		ir_putn(out, body, len);
+		return;
+	}
+	ir_writer_init(&allocas, NULL);
+	ir_writer_init(&code, NULL);
+
+	while (next_line(&p, end, &line)) {
+		site_t site;
+		if (!contains(line, "call ") || !match_site(table, line, &site))
+			continue;
+
+		site.base = *temp_counter;
+		site.id = ++sites;
+		*temp_counter += site.callee->max_temp;
+		ir_putn(&code, copied, (size_t)(line.ptr - copied));
+		expand_site(&code, &allocas, &site);
+		copied = p;
+		free(site.args);
+
+		pthread_mutex_lock(&inline_lock);
+		((callee_t *)site.callee)->sites++;
+		inlined_total++;
+		pthread_mutex_unlock(&inline_lock);
+	}
+
+	if (sites == 0) {
+		ir_putn(out, body, len);
+	} else {
+		// The copies' allocas go first, in the caller's entry block
+		ir_putn(out, allocas.buf, allocas.len);
+		ir_putn(out, code.buf, code.len);
+		ir_putn(out, copied, (size_t)(end - copied));
+	}
+	ir_writer_finish(&allocas);
+	ir_writer_finish(&code);
+}
+
+void inline_report(const inline_table_t *table, FILE *out)
+{
+	for (int i = 0; i < table->count; i++) {
+		const callee_t *callee = &table->callees[i];
+		if (callee->sites > 0)
+			fprintf(out, "  Inlined %.*s at %zu call site(s)\n", (int)callee->name.len, callee->name.ptr,
+				callee->sites);
+	}
+}
+
+size_t inlined_call_count(void)
+{
+	return inlined_total;
+}
@@ -0,0 +1,38 @@
+#ifndef INLINE_H
+#define INLINE_H
+
+#include "ir_writer.h"
+
+// Largest callee body, in IR instructions, that a call site takes a copy
+// of by default (--inline-threshold)
+#define INLINE_DEFAULT_THRESHOLD 25
+
+// Functions whose bodies can be copied into their callers. Leaf functions
+// (no calls but to LLVM intrinsics) qualify up to the threshold; functions
+// declared inline get twice the threshold and may call other functions,
+// whose calls stay calls.
+typedef struct inline_table inline_table_t;
+
+inline_table_t *inline_table_create(int threshold);
+void inline_table_destroy(inline_table_t *table);
+
+// Offers a function for inlining. text is the function as the code
+// generator emits it, from the "define" line to the closing brace. Returns
+// 0 when no call site could take it: too big, not a leaf, recursive,
+// variadic, or using dynamic allocas or blockaddress.
+int inline_table_add(inline_table_t *table, const char *text, size_t len, int hint);
+
+// Copies the body (the text between the "define" line and the closing
+// brace, before mem2reg) to out, with the calls to the table's functions
+// replaced by renamed copies of their bodies wherever the cost model
+// allows it. Each return becomes a store to a result slot that mem2reg
+// promotes afterwards, and the callee's allocas move to the entry block.
+// New registers are numbered from *temp_counter.
+void inline_calls(inline_table_t *table, const char *body, size_t len, ir_writer_t *out, int *temp_counter);
+
+// One line per function that was inlined, with its number of call sites
+void inline_report(const inline_table_t *table, FILE *out);
+
+size_t inlined_call_count(void);
+
+#endif
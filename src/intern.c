@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+#include "intern.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_INITIAL_BUCKETS 1024
+
+static arena_t intern_arena;
+static interned_string_t **buckets;
+static size_t bucket_count;
+static size_t string_count;
+
+// Taken only while several threads may use the table (parallel codegen)
+static pthread_rwlock_t intern_lock = PTHREAD_RWLOCK_INITIALIZER;
+static int intern_shared;
+
+// Algorithm: djb2a hash function
+static size_t hash_bytes(const char *str, size_t len)
+{
+	size_t hash = 5381;
+	for (size_t i = 0; i < len; i++)
+		hash = ((hash << 5) + hash) ^ (unsigned char)str[i];
+	return hash;
+}
+
+static interned_string_t *find_entry(const char *str, size_t len, size_t hash)
+{
+	if (!buckets)
+		return NULL;
+	interned_string_t *entry = buckets[hash & (bucket_count - 1)];
+	while (entry) {
+		if (entry->hash == hash && entry->length == len && memcmp(entry->text, str, len) == 0)
+			return entry;
+		entry = entry->next;
+	}
+	return NULL;
+}
+
+static void grow_buckets(void)
+{
+	size_t new_count = bucket_count ? bucket_count * 2 : INTERN_INITIAL_BUCKETS;
+	interned_string_t **new_buckets = calloc(new_count, sizeof(interned_string_t *));
+	if (!new_buckets) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (size_t i = 0; i < bucket_count; i++) {
+		interned_string_t *entry = buckets[i];
+		while (entry) {
+			interned_string_t *next = entry->next;
+			size_t idx = entry->hash & (new_count - 1);
+			entry->next = new_buckets[idx];
+			new_buckets[idx] = entry;
+			entry = next;
+		}
+	}
+	free(buckets);
+	buckets = new_buckets;
+	bucket_count = new_count;
+}
+
+static interned_string_t *insert_entry(const char *str, size_t len, size_t hash)
+{
+	// Keep the load factor at or below 1
+	if (string_count >= bucket_count)
+		grow_buckets();
+
+	interned_string_t *entry = arena_alloc(&intern_arena, sizeof(interned_string_t) + len + 1);
+	entry->hash = hash;
+	entry->length = len;
+	memcpy(entry->text, str, len);
+	entry->text[len] = '\0';
+
+	size_t idx = hash & (bucket_count - 1);
+	entry->next = buckets[idx];
+	buckets[idx] = entry;
+	string_count++;
+	return entry;
+}
+
+const char *intern_string_n(const char *str, size_t len)
+{
+	size_t hash = hash_bytes(str, len);
+	if (!intern_shared) {
+		interned_string_t *entry = find_entry(str, len, hash);
+		return (entry ? entry : insert_entry(str, len, hash))->text;
+	}
+
+	pthread_rwlock_rdlock(&intern_lock);
+	interned_string_t *entry = find_entry(str, len, hash);
+	pthread_rwlock_unlock(&intern_lock);
+	if (entry)
+		return entry->text;
+
+	// Another thread may have inserted it in between
+	pthread_rwlock_wrlock(&intern_lock);
+	entry = find_entry(str, len, hash);
+	if (!entry)
+		entry = insert_entry(str, len, hash);
+	pthread_rwlock_unlock(&intern_lock);
+	return entry->text;
+}
+
+const char *intern_string(const char *str)
+{
+	if (!str)
+		return NULL;
+	return intern_string_n(str, strlen(str));
+}
+
+const char *intern_lookup(const char *str)
+{
+	if (!str)
+		return NULL;
+	size_t len = strlen(str);
+	size_t hash = hash_bytes(str, len);
+	if (intern_shared)
+		pthread_rwlock_rdlock(&intern_lock);
+	interned_string_t *entry = find_entry(str, len, hash);
+	if (intern_shared)
+		pthread_rwlock_unlock(&intern_lock);
+	return entry ? entry->text : NULL;
+}
+
+void intern_set_shared(int shared)
+{
+	intern_shared = shared;
+}
+
+size_t intern_count(void)
+{
+	return string_count;
+}
+
+size_t intern_bytes(void)
+{
+	return intern_arena.bytes_used;
+}
+
+void intern_release(void)
+{
+	arena_release(&intern_arena);
+	free(buckets);
+	buckets = NULL;
+	bucket_count = 0;
+	string_count = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+
+// Global string interner. Equal strings intern to the same pointer, so
+// interned names can be compared with == and carry a precomputed hash.
+// Identifier names produced by the lexer are always interned.
+typedef struct interned_string {
+	struct interned_string *next; // Hash chain
+	size_t hash;
+	size_t length;
+	char text[];
+} interned_string_t;
+
+const char *intern_string(const char *str);
+const char *intern_string_n(const char *str, size_t len);
+
+// Returns the interned copy of str, or NULL if it was never interned
+const char *intern_lookup(const char *str);
+
+static inline const interned_string_t *interned_header(const char *str)
+{
+	return (const interned_string_t *)(str - offsetof(interned_string_t, text));
+}
+
+// Hash and length of an interned string, without rescanning it
+static inline size_t interned_hash(const char *str)
+{
+	return interned_header(str)->hash;
+}
+
+static inline size_t interned_length(const char *str)
+{
+	return interned_header(str)->length;
+}
+
+// While shared, the table may be used from several threads at once
+void intern_set_shared(int shared);
+
+size_t intern_count(void);
+size_t intern_bytes(void);
+void intern_release(void);
+
+#endif
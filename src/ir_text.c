@@ -0,0 +1,55 @@
+#include "ir_text.h"
+
+size_t hash_slice(slice_t s)
+{
+	size_t hash = 5381;
+	for (size_t i = 0; i < s.len; i++)
+		hash = ((hash << 5) + hash) ^ (unsigned char)s.ptr[i];
+	return hash;
+}
+
+const char *slice_find(slice_t s, const char *needle)
+{
+	size_t n = strlen(needle);
+	for (size_t i = 0; i + n <= s.len; i++) {
+		if (memcmp(s.ptr + i, needle, n) == 0)
+			return s.ptr + i;
+	}
+	return NULL;
+}
+
+int next_local(const char **pos, const char *end, slice_t *name)
+{
+	const char *p = *pos;
+	while (p < end) {
+		if (*p == '%' && p + 1 < end && is_name_char(p[1])) {
+			const char *start = p + 1;
+			p = start;
+			while (p < end && is_name_char(*p))
+				p++;
+			name->ptr = start;
+			name->len = (size_t)(p - start);
+			*pos = p;
+			return 1;
+		}
+		p++;
+	}
+	*pos = p;
+	return 0;
+}
+
+int next_line(const char **pos, const char *end, slice_t *line)
+{
+	if (*pos >= end)
+		return 0;
+	const char *nl = memchr(*pos, '\n', (size_t)(end - *pos));
+	line->ptr = *pos;
+	line->len = (size_t)((nl ? nl : end) - *pos);
+	*pos = nl ? nl + 1 : end;
+	return 1;
+}
+
+int is_label_line(slice_t text)
+{
+	return text.len > 1 && text.ptr[0] != ' ' && text.ptr[0] != ';' && text.ptr[text.len - 1] == ':';
+}
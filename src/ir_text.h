@@ -0,0 +1,52 @@
+#ifndef IR_TEXT_H
+#define IR_TEXT_H
+
+#include <stddef.h>
+#include <string.h>
+
+// Reading back the LLVM IR the code generator wrote, for the passes that
+// work on function bodies as text (mem2reg, inlining, attribute inference).
+// Slices point into the text and are not NUL-terminated.
+typedef struct {
+	const char *ptr;
+	size_t len;
+} slice_t;
+
+size_t hash_slice(slice_t s);
+
+static inline int slice_eq(slice_t a, slice_t b)
+{
+	return a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+static inline int starts_with(slice_t s, const char *prefix)
+{
+	size_t n = strlen(prefix);
+	return s.len >= n && memcmp(s.ptr, prefix, n) == 0;
+}
+
+// Start of the first occurrence of needle in s, or NULL
+const char *slice_find(slice_t s, const char *needle);
+
+static inline int contains(slice_t s, const char *needle)
+{
+	return slice_find(s, needle) != NULL;
+}
+
+// Characters of a %name or @name after the sigil
+static inline int is_name_char(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '_' ||
+	       c == '$';
+}
+
+// Finds the next %name in [*pos, end); the returned slice excludes the %
+int next_local(const char **pos, const char *end, slice_t *name);
+
+// Next line of [*pos, end), without its newline; 0 once the text is used up
+int next_line(const char **pos, const char *end, slice_t *line);
+
+// "name:" line that starts a basic block
+int is_label_line(slice_t text);
+
+#endif
@@ -0,0 +1,122 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ir_writer.h"
+#include <stdarg.h>
+#include <stdlib.h>
+
+// First allocation of an in-memory writer; most hold one function body
+#define IR_INITIAL_CAPACITY (4 * 1024)
+
+// A writer with a FILE writes its pending output once it fills a chunk
+#define IR_CHUNK_SIZE (64 * 1024)
+
+void ir_writer_init(ir_writer_t *w, FILE *file)
+{
+	w->file = file;
+	w->buf = NULL;
+	w->len = 0;
+	w->cap = 0;
+	w->unbuffered = 0;
+}
+
+static void ir_flush(ir_writer_t *w)
+{
+	if (w->len == 0)
+		return;
+	fwrite(w->buf, 1, w->len, w->file);
+	w->len = 0;
+}
+
+void ir_writer_finish(ir_writer_t *w)
+{
+	if (w->file) {
+		ir_flush(w);
+		fflush(w->file);
+	}
+	free(w->buf);
+	w->buf = NULL;
+	w->len = 0;
+	w->cap = 0;
+}
+
+// Make room for n more bytes, writing out a full chunk first
+static void ir_reserve(ir_writer_t *w, size_t n)
+{
+	if (w->len + n <= w->cap)
+		return;
+	if (w->file)
+		ir_flush(w);
+	if (w->len + n <= w->cap)
+		return;
+
+	size_t cap = w->cap ? w->cap : w->file ? IR_CHUNK_SIZE : IR_INITIAL_CAPACITY;
+	while (cap < w->len + n)
+		cap *= 2;
+	char *buf = realloc(w->buf, cap);
+	if (!buf) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	w->buf = buf;
+	w->cap = cap;
+}
+
+void ir_putn(ir_writer_t *w, const char *s, size_t n)
+{
+	if (n == 0)
+		return; // An empty in-memory writer has no buffer to copy into yet
+	if (w->unbuffered) {
+		fwrite(s, 1, n, w->file);
+		return;
+	}
+	// A whole function body held in memory goes out without another copy
+	if (w->file && n >= IR_CHUNK_SIZE) {
+		ir_flush(w);
+		fwrite(s, 1, n, w->file);
+		return;
+	}
+	ir_reserve(w, n);
+	memcpy(w->buf + w->len, s, n);
+	w->len += n;
+}
+
+void ir_int(ir_writer_t *w, long long value)
+{
+	char tmp[24];
+	char *p = tmp + sizeof(tmp);
+	unsigned long long v = value < 0 ? -(unsigned long long)value : (unsigned long long)value;
+
+	do {
+		*--p = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+	if (value < 0)
+		*--p = '-';
+	ir_putn(w, p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
+void ir_printf(ir_writer_t *w, const char *fmt, ...)
+{
+	va_list args;
+
+	if (w->unbuffered) {
+		va_start(args, fmt);
+		vfprintf(w->file, fmt, args);
+		va_end(args);
+		return;
+	}
+
+	// Most lines fit in the space left; format again after growing otherwise
+	ir_reserve(w, 256);
+	va_start(args, fmt);
+	int n = vsnprintf(w->buf + w->len, w->cap - w->len, fmt, args);
+	va_end(args);
+	if (n < 0)
+		return;
+	if ((size_t)n >= w->cap - w->len) {
+		ir_reserve(w, (size_t)n + 1);
+		va_start(args, fmt);
+		vsnprintf(w->buf + w->len, w->cap - w->len, fmt, args);
+		va_end(args);
+	}
+	w->len += (size_t)n;
+}
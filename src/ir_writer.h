@@ -0,0 +1,74 @@
+#ifndef IR_WRITER_H
+#define IR_WRITER_H
+
+#include <stdio.h>
+#include <string.h>
+
+// Text sink for LLVM IR. Output accumulates in a buffer and a writer with
+// a FILE hands it to stdio one chunk at a time, instead of taking the
+// stream lock for every fragment. A writer without a FILE keeps everything
+// in a growable buffer, for text that is emitted later.
+typedef struct {
+	FILE *file;
+	char *buf;
+	size_t len;
+	size_t cap;
+	int unbuffered; // Pass every fragment straight to stdio (benchmark baseline)
+} ir_writer_t;
+
+void ir_writer_init(ir_writer_t *w, FILE *file);
+// Writes what is pending and flushes the FILE, which is left open; frees
+// the buffer
+void ir_writer_finish(ir_writer_t *w);
+
+void ir_printf(ir_writer_t *w, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void ir_putn(ir_writer_t *w, const char *s, size_t n);
+void ir_int(ir_writer_t *w, long long value);
+
+static inline void ir_puts(ir_writer_t *w, const char *s)
+{
+	ir_putn(w, s, strlen(s));
+}
+
+static inline void ir_putc(ir_writer_t *w, char c)
+{
+	ir_putn(w, &c, 1);
+}
+
+// Type strings are appended verbatim ("i32", "%struct.point*", ...)
+static inline void ir_type(ir_writer_t *w, const char *type)
+{
+	ir_puts(w, type);
+}
+
+// %tN
+static inline void ir_temp(ir_writer_t *w, int n)
+{
+	ir_putn(w, "%t", 2);
+	ir_int(w, n);
+}
+
+// %name, used for label operands and named locals
+static inline void ir_local(ir_writer_t *w, const char *name)
+{
+	ir_putc(w, '%');
+	ir_puts(w, name);
+}
+
+// \XX escape inside a c"..." constant
+static inline void ir_hex_escape(ir_writer_t *w, unsigned char c)
+{
+	static const char digits[] = "0123456789ABCDEF";
+	char esc[3] = {'\\', digits[c >> 4], digits[c & 15]};
+	ir_putn(w, esc, 3);
+}
+
+// "name:" line that starts a basic block
+static inline void ir_label_def(ir_writer_t *w, const char *label)
+{
+	ir_puts(w, label);
+	ir_putn(w, ":\n", 2);
+}
+
+#endif
@@ -0,0 +1,103 @@
+#define _POSIX_C_SOURCE 200809L
+#include "llvm_backend.h"
+#include <llvm-c/Core.h>
+#include <llvm-c/IRReader.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
+#include <stdio.h>
+
+static LLVMCodeGenOptLevel codegen_level(int optimization_level)
+{
+	switch (optimization_level) {
+	case 0:
+		return LLVMCodeGenLevelNone;
+	case 1:
+		return LLVMCodeGenLevelLess;
+	case 2:
+		return LLVMCodeGenLevelDefault;
+	default:
+		return LLVMCodeGenLevelAggressive;
+	}
+}
+
+static int report(const char *what, char *message)
+{
+	fprintf(stderr, "Error: %s: %s\n", what, message ? message : "unknown error");
+	LLVMDisposeMessage(message);
+	return -1;
+}
+
+static int optimize(LLVMModuleRef module, LLVMTargetMachineRef machine, int optimization_level)
+{
+	char pipeline[16];
+	snprintf(pipeline, sizeof(pipeline), "default<O%d>", optimization_level);
+
+	LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
+	LLVMErrorRef error = LLVMRunPasses(module, pipeline, machine, options);
+	LLVMDisposePassBuilderOptions(options);
+	if (error) {
+		char *message = LLVMGetErrorMessage(error);
+		fprintf(stderr, "Error: optimization failed: %s\n", message);
+		LLVMDisposeErrorMessage(message);
+		return -1;
+	}
+	return 0;
+}
+
+int llvm_backend_emit_object(const char *ir, size_t len, int optimization_level, const char *object_file)
+{
+	static int initialized;
+	if (!initialized) {
+		LLVMInitializeNativeTarget();
+		LLVMInitializeNativeAsmPrinter();
+		initialized = 1;
+	}
+
+	LLVMContextRef context = LLVMContextCreate();
+	LLVMModuleRef module = NULL;
+	LLVMTargetMachineRef machine = NULL;
+	char *triple = LLVMGetDefaultTargetTriple();
+	char *message = NULL;
+	int result = -1;
+
+	// The parser takes ownership of the buffer; the IR itself is not copied
+	LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRange(ir, len, "minicc", 1);
+	if (LLVMParseIRInContext(context, buffer, &module, &message)) {
+		report("invalid IR", message);
+		goto done;
+	}
+
+	LLVMTargetRef target;
+	if (LLVMGetTargetFromTriple(triple, &target, &message)) {
+		report("no target", message);
+		goto done;
+	}
+	machine = LLVMCreateTargetMachine(target, triple, "generic", "", codegen_level(optimization_level),
+					  LLVMRelocPIC, LLVMCodeModelDefault);
+
+	LLVMSetTarget(module, triple);
+	LLVMTargetDataRef data_layout = LLVMCreateTargetDataLayout(machine);
+	char *layout = LLVMCopyStringRepOfTargetData(data_layout);
+	LLVMSetDataLayout(module, layout);
+	LLVMDisposeMessage(layout);
+	LLVMDisposeTargetData(data_layout);
+
+	if (optimize(module, machine, optimization_level) != 0)
+		goto done;
+
+	if (LLVMTargetMachineEmitToFile(machine, module, (char *)object_file, LLVMObjectFile, &message)) {
+		report("object emission failed", message);
+		goto done;
+	}
+	result = 0;
+
+done:
+	if (machine)
+		LLVMDisposeTargetMachine(machine);
+	if (module)
+		LLVMDisposeModule(module);
+	LLVMDisposeMessage(triple);
+	LLVMContextDispose(context);
+	return result;
+}
@@ -0,0 +1,13 @@
+#ifndef LLVM_BACKEND_H
+#define LLVM_BACKEND_H
+
+#include <stddef.h>
+
+// In-process replacement for "clang -O<n>", built with make LLVM_BACKEND=1.
+// ir holds the module text and must be NUL terminated at ir[len], as
+// open_memstream() leaves it. The module is parsed from memory, run through
+// the default<O<n>> pass pipeline and written to object_file. Returns 0 on
+// success; errors are reported on stderr.
+int llvm_backend_emit_object(const char *ir, size_t len, int optimization_level, const char *object_file);
+
+#endif
@@ -1,19 +1,28 @@
 #define _POSIX_C_SOURCE 200809L
 #include "ast.h"
 #include "symbol_table.h"
+#include "intern.h"
+#include "type_table.h"
+#include "ssa.h"
+#include "fold.h"
+#include "inline.h"
+#include "scan.h"
+#include "x86_backend.h"
+#ifdef MINICC_LLVM_BACKEND
+#include "llvm_backend.h"
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <time.h>
 
-extern symbol_table_t *global_symbol_table;
-extern int yylex(void);
-extern int lex_error_count;
-extern char *yytext;
-extern int get_line_number(void);
-extern int get_column(void);
-extern void yylex_destroy(void);
+typedef void *yyscan_t;
+extern yyscan_t open_scanner(source_t *source, parse_context_t *context);
+extern void close_scanner(yyscan_t scanner);
+extern int scan_token(yyscan_t scanner);
+extern const char *scanned_text(yyscan_t scanner);
 
 // Program version and info
 #define VERSION "2.0.0"
@@ -23,16 +32,29 @@ void print_usage(const char *program_name)
 {
 	printf("%s v%s\n", PROGRAM_NAME, VERSION);
 	printf("A complete C subset compiler supporting structs, unions, enums, and advanced features\n\n");
-	printf("Usage: %s [options] <input_file>\n", program_name);
+	printf("Usage: %s [options] <input_file>...\n", program_name);
 	printf("\nOptions:\n");
 	printf("  -o <output_file>  Specify output file (default: stdout for IR, a.out for executable)\n");
 	printf("  -S                Generate LLVM IR only (default)\n");
 	printf("  -c                Compile to executable\n");
 	printf("  -O <level>        Optimization level (0-3, default: 0)\n");
+	printf("  -j <n>            With several input files, compile n of them at a time\n");
 	printf("  -f                Force compilation despite errors (for testing)\n");
 	printf("  -v, --verbose     Verbose output with symbol table information\n");
 	printf("  -t, --type-check  Enable enhanced type checking\n");
 	printf("  -d, --debug       Enable debug output\n");
+	printf("  --stats           Print memory usage statistics to stderr\n");
+	printf("  --no-ir-buffer    Write IR with one stdio call per fragment (benchmark baseline)\n");
+	printf("  --no-mmap         Read the input into memory instead of mapping it (benchmark baseline)\n");
+	printf("  --switch=<mode>   Switch lowering: auto (default), table, tree or llvm\n");
+	printf("  --no-mem2reg      Keep local variables in stack slots instead of SSA registers\n");
+	printf("  --no-fold         Emit constant expressions and dead branches as written\n");
+	printf("  --no-inline       Keep every call instead of inlining small leaf and inline functions\n");
+	printf("  --inline-threshold=<n> Largest callee body inlined, in IR instructions (default: %d)\n",
+	       INLINE_DEFAULT_THRESHOLD);
+	printf("  --no-dce          Keep static functions and globals that nothing refers to\n");
+	printf("  --backend=<name>  Code generator: llvm (default) or native (x86-64 assembly via cc, ~1.5x faster than llvm -O0)\n");
+	printf("  --codegen-threads=<n> Generate function bodies on n threads (default: one per CPU)\n");
 	printf("  -h, --help        Show this help message\n");
 	printf("  --version         Show version information\n");
 	printf("\nSupported Language Features:\n");
@@ -56,6 +78,7 @@ void print_usage(const char *program_name)
 	printf("  %s -S program.c -o program.ll      # Generate LLVM IR\n", program_name);
 	printf("  %s -c program.c -o program          # Compile to executable\n", program_name);
 	printf("  %s -v -t program.c                  # Verbose compilation with type checking\n", program_name);
+	printf("  %s -c -j 4 a.c b.c c.c              # Compile to a.o, b.o and c.o\n", program_name);
 	printf("  --lex-only         Run only the lexer (exit 0 if ok)\n");
 	printf("  --parse-only       Run only the parser (exit 0 if grammar accepts)\n");
 }
@@ -178,6 +201,34 @@ void print_stats(compilation_stats_t *stats, int verbose)
 	}
 }
 
+// Printed to stderr so IR written to stdout stays clean
+void print_arena_stats(void)
+{
+	fprintf(stderr, "\nInternal Statistics:\n");
+	fprintf(stderr, "  AST arena used:     %zu bytes\n", ast_arena.bytes_used);
+	fprintf(stderr, "  AST arena reserved: %zu bytes in %zu chunk(s)\n", ast_arena.bytes_reserved,
+		ast_arena.chunk_count);
+	fprintf(stderr, "  Interned names:     %zu (%zu bytes)\n", intern_count(), intern_bytes());
+	fprintf(stderr, "  LLVM types:         %zu\n", type_table_count());
+	fprintf(stderr, "  Folded nodes:       %zu\n", folded_node_count());
+	fprintf(stderr, "  Promoted allocas:   %zu\n", ssa_promoted_count());
+	fprintf(stderr, "  Inlined calls:      %zu\n", inlined_call_count());
+	fprintf(stderr, "  Dropped statics:    %zu\n", dropped_definition_count());
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+int count_ir_buffer_lines(const char *ir, size_t len)
+{
+	int lines = 0;
+	for (const char *p = ir; (p = memchr(p, '\n', len - (size_t)(p - ir))) != NULL; p++)
+		lines++;
+	return lines;
+}
+
 int count_ir_lines(const char *filename)
 {
 	FILE *file = fopen(filename, "r");
@@ -195,244 +246,189 @@ int count_ir_lines(const char *filename)
 	return lines;
 }
 
-static int run_lex_only(const char *path, int verbose)
+static int run_lex_only(const char *path, int verbose, int no_mmap)
 {
-	FILE *f = fopen(path, "r");
-	if (!f) {
+	source_t source;
+	if (source_open(&source, path, !no_mmap) != 0) {
 		perror("Error opening input file");
 		return 1;
 	}
-	yyin = f;
-
-	lex_error_count = 0;
-	while (yylex() != 0) { /* consome tokens até EOF */
+	parse_context_t context = {0};
+	struct timespec start, end;
+	size_t tokens = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	yyscan_t scanner = open_scanner(&source, &context);
+
+	while (scan_token(scanner) != 0) { /* consome tokens até EOF */
+		tokens++;
 	}
 
-	fclose(f);
+	close_scanner(scanner);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	size_t bytes = source.size;
+	free_ast_arena();
+	source_close(&source);
+	type_table_release();
+	intern_release();
 
 	if (verbose) {
-		if (lex_error_count == 0) {
+		if (context.lex_error_count == 0) {
 			printf("Lexical analysis: OK\n");
 		} else {
-			printf("Lexical analysis: %d error(s)\n", lex_error_count);
+			printf("Lexical analysis: %d error(s)\n", context.lex_error_count);
 		}
+		double ms = elapsed_ms(&start, &end);
+		printf("Scanned %zu bytes, %zu tokens in %.2f ms (%.1f MB/s, %s fast path)\n", bytes, tokens, ms,
+		       ms > 0 ? bytes / (ms * 1000.0) : 0.0, scan_kernel_name());
 	}
-	return (lex_error_count == 0) ? 0 : 1;
+	return (context.lex_error_count == 0) ? 0 : 1;
 }
 
-static int run_parse_only(const char *path, int verbose)
+static int run_parse_only(const char *path, int verbose, int show_stats, int no_mmap)
 {
-	FILE *f = fopen(path, "r");
-	if (!f) {
+	source_t source;
+	if (source_open(&source, path, !no_mmap) != 0) {
 		perror("Error opening input file");
 		return 1;
 	}
-	yyin = f;
-
-	error_count = 0;
-	ast_root = NULL;
+	parse_context_t context = {0};
 
-	int ret = yyparse();
-	fclose(f);
+	int ret = parse_source(&source, &context);
+	if (show_stats)
+		print_arena_stats();
+	free_ast_arena();
+	source_close(&source);
+	type_table_release();
+	intern_release();
 
 	if (verbose) {
-		if (error_count == 0 && ret == 0) {
+		if (context.error_count == 0 && ret == 0) {
 			printf("Syntactic analysis: OK\n");
 		} else {
-			printf("Syntactic analysis: %d error(s)\n", error_count);
+			printf("Syntactic analysis: %d error(s)\n", context.error_count);
 		}
 	}
-	return (error_count == 0 && ret == 0) ? 0 : 1;
+	return (context.error_count == 0 && ret == 0) ? 0 : 1;
 }
 
-static int run_dump_lexemes(const char *path)
+static int run_dump_lexemes(const char *path, int no_mmap)
 {
-	FILE *f = fopen(path, "r");
-	if (!f) {
+	source_t source;
+	if (source_open(&source, path, !no_mmap) != 0) {
 		perror("Error opening input file");
 		return 1;
 	}
-	yyin = f;
-	lex_error_count = 0;
+	parse_context_t context = {0};
+	yyscan_t scanner = open_scanner(&source, &context);
 
 	int tok;
-	while ((tok = yylex()) != 0) {
+	while ((tok = scan_token(scanner)) != 0) {
 		// imprime só o lexema de cada token (uma linha por token)
-		puts(yytext);
+		puts(scanned_text(scanner));
 	}
-	fclose(f);
-	return (lex_error_count == 0) ? 0 : 1;
+	close_scanner(scanner);
+	free_ast_arena();
+	source_close(&source);
+	type_table_release();
+	intern_release();
+	return (context.lex_error_count == 0) ? 0 : 1;
 }
 
-static int run_dump_tokens(const char *path, int verbose)
+static int run_dump_tokens(const char *path, int verbose, int no_mmap)
 {
-	FILE *f = fopen(path, "r");
-	if (!f) {
+	source_t source;
+	if (source_open(&source, path, !no_mmap) != 0) {
 		perror("Error opening input file");
 		return 1;
 	}
-	yyin = f;
-	lex_error_count = 0;
+	parse_context_t context = {0};
+	yyscan_t scanner = open_scanner(&source, &context);
 
 	int tok;
-	while ((tok = yylex()) != 0) {
-		printf("%d\t%s\t@%d:%d\n", tok, yytext, get_line_number(), get_column());
+	while ((tok = scan_token(scanner)) != 0) {
+		int line, column;
+		source_position(&source, context.offset, &line, &column);
+		printf("%d\t%s\t@%d:%d\n", tok, scanned_text(scanner), line, column);
 	}
-	fclose(f);
-	return (lex_error_count == 0) ? 0 : 1;
+	close_scanner(scanner);
+	free_ast_arena();
+	source_close(&source);
+	type_table_release();
+	intern_release();
+	return (context.lex_error_count == 0) ? 0 : 1;
 }
 
-int main(int argc, char *argv[])
+// Settings shared by every input file of one minicc run
+typedef struct {
+	int compile_to_executable;
+	int object_only; // With -c on several inputs: stop at one object file per input
+	int optimization_level;
+	int force_compilation;
+	int verbose;
+	int enable_type_checking;
+	int debug_mode;
+	int show_stats;
+	int no_mmap; // Read the input into memory instead of mapping it
+	int no_fold; // Hand the AST to codegen without folding constants
+	int native_backend; // Generate x86-64 assembly instead of LLVM IR where possible
+} compile_options_t;
+
+// Where the IR of a -c build goes before it is handed to clang: a buffer
+// for the in-process LLVM backend, or <input>.ll
+static FILE *open_ir_output(const char *input_file, char **ir_file, char **ir_buffer, size_t *ir_length)
 {
-	char *input_file = NULL;
-	char *output_file = NULL;
-	FILE *output = stdout;
-	int compile_to_executable = 0;
-	int optimization_level = 0;
-	int force_compilation = 0;
-	int verbose = 0;
-	int enable_type_checking = 1; // Default enabled
-	int debug_mode = 0;
-	int lex_only = 0;
-	int parse_only = 0;
-	int dump_lexemes = 0;
-	int dump_tokens = 0;
-	int dump_ast = 0;
-
-	// Parse command line arguments
-	for (int i = 1; i < argc; i++) {
-		if (strcmp(argv[i], "-o") == 0) {
-			if (i + 1 < argc) {
-				output_file = argv[++i];
-			} else {
-				fprintf(stderr, "Error: -o option requires an argument\n");
-				return 1;
-			}
-		} else if (strcmp(argv[i], "-c") == 0) {
-			compile_to_executable = 1;
-		} else if (strcmp(argv[i], "-S") == 0) {
-			compile_to_executable = 0;
-		} else if (strcmp(argv[i], "-f") == 0) {
-			force_compilation = 1;
-		} else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
-			verbose = 1;
-		} else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--type-check") == 0) {
-			enable_type_checking = 1;
-		} else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) {
-			debug_mode = 1;
-			verbose = 1; // Debug implies verbose
-		} else if (strcmp(argv[i], "--lex-only") == 0) {
-			lex_only = 1;
-		} else if (strcmp(argv[i], "--dump-lexemes") == 0) {
-			dump_lexemes = 1;
-		} else if (strcmp(argv[i], "--dump-tokens") == 0) {
-			dump_tokens = 1;
-		} else if (strcmp(argv[i], "--parse-only") == 0) {
-			parse_only = 1;
-		} else if (strcmp(argv[i], "--dump-ast") == 0) {
-			dump_ast = 1;
-		} else if (strcmp(argv[i], "-O") == 0) {
-			if (i + 1 < argc) {
-				optimization_level = atoi(argv[++i]);
-				if (optimization_level < 0 || optimization_level > 3) {
-					fprintf(stderr, "Error: Invalid optimization level. Use 0-3.\n");
-					return 1;
-				}
-			} else {
-				fprintf(stderr, "Error: -O option requires an argument\n");
-				return 1;
-			}
-		} else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
-			print_usage(argv[0]);
-			return 0;
-		} else if (strcmp(argv[i], "--version") == 0) {
-			print_version();
-			return 0;
-		} else if (argv[i][0] == '-') {
-			fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
-			print_usage(argv[0]);
-			return 1;
-		} else {
-			if (input_file == NULL) {
-				input_file = argv[i];
-			} else {
-				fprintf(stderr, "Error: Multiple input files specified\n");
-				return 1;
-			}
-			if (dump_lexemes) {
-				return run_dump_lexemes(input_file);
-			}
-			if (dump_tokens) {
-				return run_dump_tokens(input_file, verbose);
-			}
-		}
-	}
-
-	if (input_file == NULL) {
-		fprintf(stderr, "Error: No input file specified\n");
-		print_usage(argv[0]);
-		return 1;
-	}
-
-	if (dump_ast) {
-		// parse + imprime AST e sai
-		FILE *f = fopen(input_file, "r");
-		if (!f) {
-			perror("Error opening input file");
-			return 1;
-		}
-		yyin = f;
-		error_count = 0;
-		ast_root = NULL;
-
-		int ret = yyparse();
-		fclose(f);
-
-		if (error_count == 0 && ret == 0 && ast_root) {
-			print_ast(ast_root, 0);
-			free_ast(ast_root);
-			return 0;
-		} else {
-			fprintf(stderr, "Cannot dump AST: parse errors (%d)\n", error_count);
-			return 1;
-		}
+#ifdef MINICC_LLVM_BACKEND
+	(void)input_file;
+	(void)ir_file;
+	// The IR stays in memory and goes straight to the LLVM backend
+	FILE *output = open_memstream(ir_buffer, ir_length);
+	if (!output)
+		perror("Error creating IR buffer");
+	return output;
+#else
+	(void)ir_buffer;
+	(void)ir_length;
+	*ir_file = malloc(strlen(input_file) + 20);
+	sprintf(*ir_file, "%s.ll", input_file);
+
+	FILE *output = fopen(*ir_file, "w");
+	if (!output) {
+		perror("Error creating temporary IR file");
+		free(*ir_file);
+		*ir_file = NULL;
 	}
+	return output;
+#endif
+}
 
-	if (lex_only) {
-		if (verbose) {
-			printf("%s v%s\n", PROGRAM_NAME, VERSION);
-			printf("Lex-only mode. Scanning tokens from: %s\n", input_file);
-		}
-		return run_lex_only(input_file, verbose);
-	}
+// Run the whole pipeline on one input file. All lexer, parser and symbol
+// table state is set up here and torn down before returning, so the next
+// file starts clean. Returns the process exit code for this file.
+static int compile_file(const char *input_file, const char *output_file, const compile_options_t *options)
+{
+	FILE *output = stdout;
+	double semantic_ms = 0;
+	double codegen_ms = 0;
 
-	if (verbose) {
-		printf("%s v%s\n", PROGRAM_NAME, VERSION);
+	if (options->verbose) {
 		printf("Compiling: %s\n", input_file);
-		if (debug_mode) {
+		if (options->debug_mode) {
 			printf("Debug mode enabled\n");
 		}
 	}
 
-	if (parse_only) {
-		if (verbose) {
-			printf("%s v%s\n", PROGRAM_NAME, VERSION);
-			printf("Parse-only mode. Parsing: %s\n", input_file);
-		}
-		return run_parse_only(input_file, verbose);
-	}
-
 	// Generate temporary IR file name if compiling to executable
 	char *ir_file = NULL;
-	if (compile_to_executable) {
-		ir_file = malloc(strlen(input_file) + 20);
-		sprintf(ir_file, "%s.ll", input_file);
-
-		output = fopen(ir_file, "w");
-		if (!output) {
-			perror("Error creating temporary IR file");
+	char *ir_buffer = NULL;
+	size_t ir_length = 0;
+	int native_code = 0; // The native backend compiled this file
+	if (options->compile_to_executable && options->native_backend) {
+		// Opened once codegen knows whether the native backend took the file
+		output = NULL;
+	} else if (options->compile_to_executable) {
+		output = open_ir_output(input_file, &ir_file, &ir_buffer, &ir_length);
+		if (!output)
 			return 1;
-		}
 	} else if (output_file) {
 		output = fopen(output_file, "w");
 		if (!output) {
@@ -441,62 +437,70 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	// Open input file
-	yyin = fopen(input_file, "r");
-	if (!yyin) {
+	// Open input file; unless --no-mmap is given it is mapped and scanned in place
+	source_t source;
+	if (source_open(&source, input_file, !options->no_mmap) != 0) {
 		perror("Error opening input file");
-		if (output != stdout)
+		if (output && output != stdout)
 			fclose(output);
 		return 1;
 	}
 
-	// Initialize global symbol table
-	global_symbol_table = create_symbol_table();
-
-	// Reset error count for this compilation
-	error_count = 0;
+	// Everything the parse of this file produces lives in its own context
+	parse_context_t parse = {0};
+	parse.symbols = create_symbol_table();
 
-	if (verbose) {
+	if (options->verbose) {
 		printf("Phase 1: Lexical and syntactic analysis...\n");
 	}
 
-	yyparse();
+	parse_source(&source, &parse);
+	ast_node_t *ast_root = parse.root;
+	symbol_table_t *global_symbol_table = parse.symbols;
+	// Semantic analysis adds its errors to the syntax errors
+	error_count = parse.error_count;
 
 	// Report parsing results
 	if (error_count > 0) {
 		printf("Parsing completed with %d error(s)\n", error_count);
 
-		if (!force_compilation) {
+		if (!options->force_compilation) {
 			printf("Compilation stopped due to errors. Use -f to force compilation.\n");
-			fclose(yyin);
-			if (output != stdout)
+			if (output && output != stdout)
 				fclose(output);
+			free(ir_buffer);
 			if (ir_file) {
 				unlink(ir_file);
 				free(ir_file);
 			}
-			free_ast(ast_root);
-			yylex_destroy();
+			free_ast_arena();
+			source_close(&source);
 			destroy_symbol_table(global_symbol_table);
+			type_table_release();
+			intern_release();
 			return 1;
 		} else {
 			printf("Forcing compilation despite errors (-f flag used).\n");
 		}
-	} else if (verbose) {
+	} else if (options->verbose) {
 		printf("Parsing completed successfully.\n");
 	}
 
 	// Check if we have a valid AST
 	if (!ast_root) {
 		fprintf(stderr, "No AST generated - cannot continue\n");
-		fclose(yyin);
-		if (output != stdout)
+		if (output && output != stdout)
 			fclose(output);
+		free(ir_buffer);
 		if (ir_file) {
 			unlink(ir_file);
 			free(ir_file);
 		}
 		destroy_symbol_table(global_symbol_table);
+		free_ast_arena();
+		source_close(&source);
+		type_table_release();
+		intern_release();
 		return 1;
 	}
 
@@ -506,88 +510,180 @@ int main(int argc, char *argv[])
 
 	// Perform semantic analysis if enabled
 	int semantic_success = 1;
-	if (enable_type_checking && (error_count == 0 || force_compilation)) {
-		if (verbose) {
+	if (options->enable_type_checking && (error_count == 0 || options->force_compilation)) {
+		if (options->verbose) {
 			printf("Phase 2: Semantic analysis and type checking...\n");
 		}
 
-		semantic_success = perform_semantic_analysis(ast_root, global_symbol_table, debug_mode);
+		struct timespec semantic_start, semantic_end;
+		clock_gettime(CLOCK_MONOTONIC, &semantic_start);
+		semantic_success = perform_semantic_analysis(ast_root, global_symbol_table, options->debug_mode);
+		clock_gettime(CLOCK_MONOTONIC, &semantic_end);
+		semantic_ms = elapsed_ms(&semantic_start, &semantic_end);
 
-		if (!semantic_success && !force_compilation) {
+		if (!semantic_success && !options->force_compilation) {
 			printf("Compilation stopped due to semantic errors. Use -f to force compilation.\n");
-			fclose(yyin);
-			if (output != stdout)
+			if (output && output != stdout)
 				fclose(output);
+			free(ir_buffer);
 			if (ir_file) {
 				unlink(ir_file);
 				free(ir_file);
 			}
-			free_ast(ast_root);
+			free_ast_arena();
+			source_close(&source);
 			destroy_symbol_table(global_symbol_table);
-			yylex_destroy();
+			type_table_release();
+			intern_release();
 			return 1;
 		}
+
+		// Folding relies on the symbols check_types() bound
+		if (!options->no_fold)
+			fold_constants(ast_root);
 	}
 
 	// Generate code if parsing was successful or forced
-	if (error_count == 0 || force_compilation) {
-		if (verbose) {
+	if (error_count == 0 || options->force_compilation) {
+		if (options->verbose) {
 			printf("Phase 3: Code generation...\n");
 		}
 
-		// Generate LLVM IR
-		generate_llvm_ir(ast_root, output);
+		// The native backend needs the symbols semantic analysis bound; it
+		// returns NULL on anything it cannot compile, and LLVM IR is
+		// generated as usual
+		struct timespec codegen_start, codegen_end;
+		clock_gettime(CLOCK_MONOTONIC, &codegen_start);
+		char *assembly = NULL;
+		size_t assembly_length = 0;
+		if (options->native_backend && options->enable_type_checking && semantic_success && error_count == 0)
+			assembly = x86_generate_assembly(ast_root, global_symbol_table, &assembly_length);
+		native_code = assembly != NULL;
+		if (!output) {
+			if (assembly) {
+				// Assembled and linked by cc below, in place of the IR file
+				ir_file = malloc(strlen(input_file) + 20);
+				sprintf(ir_file, "%s.s", input_file);
+				output = fopen(ir_file, "w");
+				if (!output)
+					perror("Error creating temporary assembly file");
+			} else {
+				output = open_ir_output(input_file, &ir_file, &ir_buffer, &ir_length);
+			}
+			if (!output) {
+				free(assembly);
+				free(ir_file);
+				free_ast_arena();
+				source_close(&source);
+				destroy_symbol_table(global_symbol_table);
+				type_table_release();
+				intern_release();
+				return 1;
+			}
+		}
+		if (assembly) {
+			fwrite(assembly, 1, assembly_length, output);
+			stats.lines_of_ir = count_ir_buffer_lines(assembly, assembly_length);
+			free(assembly);
+		} else {
+			generate_llvm_ir(ast_root, output);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &codegen_end);
+		codegen_ms = elapsed_ms(&codegen_start, &codegen_end);
 
 		if (error_count > 0) {
 			printf("Warning: IR generated with parse errors - may not be valid\n");
-		} else if (verbose) {
+		} else if (options->verbose) {
 			printf("LLVM IR generation complete.\n");
 		}
 	}
 
 	// Count IR lines for statistics
-	if (output != stdout) {
+	if (output && output != stdout) {
 		fclose(output);
-		if (ir_file || output_file) {
+		if (ir_buffer) {
+			stats.lines_of_ir = count_ir_buffer_lines(ir_buffer, ir_length);
+		} else if (!native_code && (ir_file || output_file)) {
 			stats.lines_of_ir = count_ir_lines(ir_file ? ir_file : output_file);
 		}
 	}
 
 	// Print compilation statistics
-	print_stats(&stats, verbose);
+	print_stats(&stats, options->verbose);
+	if (options->show_stats) {
+		print_arena_stats();
+		fprintf(stderr, "  Semantic analysis:  %.2f ms\n", semantic_ms);
+		fprintf(stderr, "  Code generation:    %.2f ms\n", codegen_ms);
+	}
 
 	// Cleanup parsing resources
-	free_ast(ast_root);
-	fclose(yyin);
-	yylex_destroy();
+	free_ast_arena();
+	source_close(&source);
 	destroy_symbol_table(global_symbol_table);
+	type_table_release();
+	intern_release();
 
 	// If compiling to executable and no critical errors, use clang
-	if (compile_to_executable && (error_count == 0 || force_compilation)) {
+	if (options->compile_to_executable && (error_count == 0 || options->force_compilation)) {
 		char command[1024];
 		const char *final_output = output_file ? output_file : "a.out";
 
-		if (verbose) {
-			printf("Phase 4: Linking with LLVM/Clang...\n");
+		if (options->verbose) {
+			printf("Phase 4: %s...\n", native_code ? "Assembling and linking with cc" : "Linking with LLVM/Clang");
 		}
 
-		// Build clang command with optimization
-		snprintf(command, sizeof(command), "clang -O%d -o %s %s", optimization_level, final_output, ir_file);
-
-		if (run_command(command) != 0) {
-			fprintf(stderr, "Failed to compile IR to executable\n");
-			if (ir_file) {
+		if (native_code) {
+			// cc only assembles and links; -O does not apply to native code
+			snprintf(command, sizeof(command), "cc%s -o %s %s", options->object_only ? " -c" : "", final_output,
+				 ir_file);
+			if (run_command(command) != 0) {
+				fprintf(stderr, "Failed to assemble native code\n");
 				unlink(ir_file);
 				free(ir_file);
+				return 1;
 			}
-			return 1;
+		} else {
+#ifdef MINICC_LLVM_BACKEND
+			// Optimize and emit the object in process; only linking is left to cc
+			char *object_file = malloc(strlen(input_file) + strlen(final_output) + 20);
+			if (options->object_only)
+				strcpy(object_file, final_output);
+			else
+				sprintf(object_file, "%s.o", input_file);
+			int backend_failed = llvm_backend_emit_object(ir_buffer, ir_length, options->optimization_level, object_file) != 0;
+			free(ir_buffer);
+			if (!backend_failed && !options->object_only) {
+				snprintf(command, sizeof(command), "cc -o %s %s", final_output, object_file);
+				backend_failed = run_command(command) != 0;
+				unlink(object_file);
+			}
+			free(object_file);
+			if (backend_failed) {
+				fprintf(stderr, "Failed to compile IR to executable\n");
+				return 1;
+			}
+#else
+			// Build clang command with optimization
+			snprintf(command, sizeof(command), "clang -O%d%s -o %s %s", options->optimization_level,
+				 options->object_only ? " -c" : "", final_output, ir_file);
+
+			if (run_command(command) != 0) {
+				fprintf(stderr, "Failed to compile IR to executable\n");
+				if (ir_file) {
+					unlink(ir_file);
+					free(ir_file);
+				}
+				return 1;
+			}
+#endif
 		}
 
+		const char *kind = options->object_only ? "Object file" : "Executable";
 		if (error_count > 0) {
-			printf("Compilation completed with warnings! Executable: %s\n", final_output);
+			printf("Compilation completed with warnings! %s: %s\n", kind, final_output);
 		} else {
-			if (verbose) {
-				printf("Compilation successful! Executable: %s\n", final_output);
+			if (options->verbose) {
+				printf("Compilation successful! %s: %s\n", kind, final_output);
 			} else {
 				printf("Compilation successful: %s\n", final_output);
 			}
@@ -595,22 +691,23 @@ int main(int argc, char *argv[])
 
 		// Clean up temporary IR file
 		if (ir_file) {
-			if (!debug_mode) {
+			if (!options->debug_mode) {
 				unlink(ir_file);
 			} else {
 				printf("Debug: IR file preserved at %s\n", ir_file);
 			}
 			free(ir_file);
 		}
-	} else if (compile_to_executable) {
+	} else if (options->compile_to_executable) {
 		printf("Executable generation skipped due to errors.\n");
+		free(ir_buffer);
 		if (ir_file) {
 			unlink(ir_file);
 			free(ir_file);
 		}
 	} else {
 		if (output_file) {
-			if (verbose) {
+			if (options->verbose) {
 				printf("LLVM IR written to %s (%d lines)\n", output_file, stats.lines_of_ir);
 			} else {
 				printf("Output written to %s\n", output_file);
@@ -620,15 +717,401 @@ int main(int argc, char *argv[])
 
 	// Return appropriate exit code
 	int exit_code = 0;
-	if (error_count > 0 && !force_compilation) {
+	if (error_count > 0 && !options->force_compilation) {
 		exit_code = 1;
 	} else if (error_count > 0) {
 		exit_code = 2; // Warnings but compilation forced
 	}
 
-	if (verbose && exit_code == 0) {
+	if (options->verbose && exit_code == 0) {
 		printf("Compilation completed successfully.\n");
 	}
 
 	return exit_code;
 }
+
+// Where an input's output goes in batch mode: "dir/foo.c" becomes "foo.ll"
+// (or "foo.o") in the current directory, as cc -S/-c does
+static char *batch_output_name(const char *input_file, const char *extension)
+{
+	const char *base = strrchr(input_file, '/');
+	base = base ? base + 1 : input_file;
+	const char *dot = strrchr(base, '.');
+	size_t stem = dot && dot != base ? (size_t)(dot - base) : strlen(base);
+
+	char *name = malloc(stem + strlen(extension) + 1);
+	if (!name) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	memcpy(name, base, stem);
+	strcpy(name + stem, extension);
+	return name;
+}
+
+// A failed file outranks one compiled with forced errors, which outranks success
+static int worse_exit_code(int a, int b)
+{
+	if (a == 1 || b == 1)
+		return 1;
+	return a > b ? a : b;
+}
+
+// Copies the diagnostics a file left in log to stderr in one write, each
+// line prefixed with the input path
+static void flush_batch_diagnostics(FILE *log, const char *input_file)
+{
+	char *text = NULL;
+	size_t length = 0;
+	FILE *out = open_memstream(&text, &length);
+	if (!out) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+
+	char line[1024];
+	int at_line_start = 1;
+	rewind(log);
+	while (fgets(line, sizeof(line), log)) {
+		if (at_line_start)
+			fprintf(out, "%s: ", input_file);
+		fputs(line, out);
+		at_line_start = strchr(line, '\n') != NULL;
+	}
+	if (!at_line_start)
+		fputc('\n', out);
+	fclose(out);
+
+	fwrite(text, 1, length, stderr);
+	fflush(stderr);
+	free(text);
+}
+
+typedef struct {
+	const char *output;
+	int input;
+} batch_output_t;
+
+static int compare_batch_outputs(const void *a, const void *b)
+{
+	const batch_output_t *x = a;
+	const batch_output_t *y = b;
+	int order = strcmp(x->output, y->output);
+	return order ? order : x->input - y->input;
+}
+
+// Two inputs with the same stem, as a/x.c and b/x.c, would write the same
+// output file, the later (or, with -j, either) silently replacing the
+// other. Reports every such pair; returns the number found.
+static int check_batch_outputs(char **input_files, char **outputs, int count)
+{
+	batch_output_t *sorted = malloc((size_t)count * sizeof(batch_output_t));
+	if (!sorted) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (int i = 0; i < count; i++)
+		sorted[i] = (batch_output_t){outputs[i], i};
+	qsort(sorted, (size_t)count, sizeof(batch_output_t), compare_batch_outputs);
+
+	int clashes = 0;
+	for (int i = 1; i < count; i++) {
+		if (strcmp(sorted[i - 1].output, sorted[i].output) != 0)
+			continue;
+		fprintf(stderr, "Error: %s and %s would both be written to %s\n", input_files[sorted[i - 1].input],
+			input_files[sorted[i].input], sorted[i].output);
+		clashes++;
+	}
+	free(sorted);
+	return clashes;
+}
+
+static int compile_batch_file(const char *input_file, const char *output_file, const compile_options_t *options)
+{
+	// Diagnostics go to a temporary file first, so that those of files
+	// compiled at the same time do not interleave and each names its input
+	fflush(stderr);
+	FILE *log = tmpfile();
+	int saved_stderr = log ? dup(STDERR_FILENO) : -1;
+	if (saved_stderr >= 0)
+		dup2(fileno(log), STDERR_FILENO);
+
+	int exit_code = compile_file(input_file, output_file, options);
+
+	if (saved_stderr >= 0) {
+		fflush(stderr);
+		dup2(saved_stderr, STDERR_FILENO);
+		close(saved_stderr);
+		flush_batch_diagnostics(log, input_file);
+	}
+	if (log)
+		fclose(log);
+	return exit_code;
+}
+
+// Compile every input to its own .ll (or .o with -c). With jobs > 1 up to
+// that many files are compiled at once, each in a forked child: the lexer,
+// parser and symbol tables are process globals, so a child of the
+// already-running compiler is the cheapest isolated worker. Nothing is
+// compiled when two inputs would share an output file.
+static int compile_batch(char **input_files, int input_count, int jobs, const compile_options_t *options)
+{
+	int exit_code = 0;
+	int running = 0;
+	int next = 0;
+
+	char **outputs = malloc((size_t)input_count * sizeof(char *));
+	if (!outputs) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (int i = 0; i < input_count; i++)
+		outputs[i] = batch_output_name(input_files[i], options->compile_to_executable ? ".o" : ".ll");
+	if (check_batch_outputs(input_files, outputs, input_count) > 0) {
+		exit_code = 1;
+		next = input_count;
+	}
+
+	while (next < input_count || running > 0) {
+		if (next < input_count && (jobs <= 1 || running < jobs)) {
+			const char *input_file = input_files[next];
+			const char *output_file = outputs[next++];
+			pid_t pid = -1;
+			if (jobs > 1) {
+				// Unflushed output would otherwise be printed again by the child
+				fflush(stdout);
+				fflush(stderr);
+				pid = fork();
+				if (pid == 0)
+					exit(compile_batch_file(input_file, output_file, options));
+			}
+			if (pid > 0)
+				running++;
+			else
+				exit_code = worse_exit_code(exit_code, compile_batch_file(input_file, output_file, options));
+			continue;
+		}
+
+		int status;
+		if (wait(&status) < 0)
+			break;
+		running--;
+		exit_code = worse_exit_code(exit_code, WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+	}
+
+	for (int i = 0; i < input_count; i++)
+		free(outputs[i]);
+	free(outputs);
+	return exit_code;
+}
+
+int main(int argc, char *argv[])
+{
+	char *input_files[argc];
+	int input_count = 0;
+	char *output_file = NULL;
+	compile_options_t options = {0};
+	options.enable_type_checking = 1; // Default enabled
+	int jobs = 1;
+	int lex_only = 0;
+	int parse_only = 0;
+	int dump_lexemes = 0;
+	int dump_tokens = 0;
+	int dump_ast = 0;
+
+	// Parse command line arguments
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0) {
+			if (i + 1 < argc) {
+				output_file = argv[++i];
+			} else {
+				fprintf(stderr, "Error: -o option requires an argument\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-c") == 0) {
+			options.compile_to_executable = 1;
+		} else if (strcmp(argv[i], "-S") == 0) {
+			options.compile_to_executable = 0;
+		} else if (strcmp(argv[i], "-f") == 0) {
+			options.force_compilation = 1;
+		} else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+			options.verbose = 1;
+		} else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--type-check") == 0) {
+			options.enable_type_checking = 1;
+		} else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) {
+			options.debug_mode = 1;
+			options.verbose = 1; // Debug implies verbose
+		} else if (strcmp(argv[i], "--lex-only") == 0) {
+			lex_only = 1;
+		} else if (strcmp(argv[i], "--dump-lexemes") == 0) {
+			dump_lexemes = 1;
+		} else if (strcmp(argv[i], "--dump-tokens") == 0) {
+			dump_tokens = 1;
+		} else if (strcmp(argv[i], "--parse-only") == 0) {
+			parse_only = 1;
+		} else if (strcmp(argv[i], "--dump-ast") == 0) {
+			dump_ast = 1;
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			options.show_stats = 1;
+		} else if (strcmp(argv[i], "--no-ir-buffer") == 0) {
+			codegen_options.unbuffered_ir = 1;
+		} else if (strcmp(argv[i], "--no-mmap") == 0) {
+			options.no_mmap = 1;
+		} else if (strcmp(argv[i], "--no-fold") == 0) {
+			options.no_fold = 1;
+		} else if (strcmp(argv[i], "--no-mem2reg") == 0) {
+			codegen_options.no_mem2reg = 1;
+		} else if (strcmp(argv[i], "--no-inline") == 0) {
+			codegen_options.inline_threshold = 0;
+		} else if (strcmp(argv[i], "--no-dce") == 0) {
+			codegen_options.no_dce = 1;
+		} else if (strncmp(argv[i], "--inline-threshold=", 19) == 0) {
+			codegen_options.inline_threshold = atoi(argv[i] + 19);
+			if (codegen_options.inline_threshold < 0) {
+				fprintf(stderr, "Error: --inline-threshold needs an instruction count\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--codegen-threads=", 18) == 0) {
+			codegen_options.threads = atoi(argv[i] + 18);
+			if (codegen_options.threads < 1) {
+				fprintf(stderr, "Error: --codegen-threads needs a positive thread count\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--backend=", 10) == 0) {
+			const char *backend = argv[i] + 10;
+			if (strcmp(backend, "llvm") == 0) {
+				options.native_backend = 0;
+			} else if (strcmp(backend, "native") == 0) {
+				options.native_backend = 1;
+			} else {
+				fprintf(stderr, "Error: Unknown backend '%s'. Use llvm or native.\n", backend);
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--switch=", 9) == 0) {
+			const char *mode = argv[i] + 9;
+			if (strcmp(mode, "auto") == 0) {
+				codegen_options.switch_lowering = SWITCH_LOWER_AUTO;
+			} else if (strcmp(mode, "table") == 0) {
+				codegen_options.switch_lowering = SWITCH_LOWER_TABLE;
+			} else if (strcmp(mode, "tree") == 0) {
+				codegen_options.switch_lowering = SWITCH_LOWER_TREE;
+			} else if (strcmp(mode, "llvm") == 0) {
+				codegen_options.switch_lowering = SWITCH_LOWER_LLVM;
+			} else {
+				fprintf(stderr, "Error: Unknown switch lowering '%s'. Use auto, table, tree or llvm.\n",
+					mode);
+				return 1;
+			}
+		} else if (strncmp(argv[i], "-j", 2) == 0) {
+			const char *count = argv[i] + 2;
+			if (*count == '\0') {
+				if (i + 1 >= argc) {
+					fprintf(stderr, "Error: -j option requires an argument\n");
+					return 1;
+				}
+				count = argv[++i];
+			}
+			jobs = atoi(count);
+			if (jobs < 1) {
+				fprintf(stderr, "Error: -j needs a positive job count\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-O") == 0) {
+			if (i + 1 < argc) {
+				options.optimization_level = atoi(argv[++i]);
+				if (options.optimization_level < 0 || options.optimization_level > 3) {
+					fprintf(stderr, "Error: Invalid optimization level. Use 0-3.\n");
+					return 1;
+				}
+			} else {
+				fprintf(stderr, "Error: -O option requires an argument\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+			print_usage(argv[0]);
+			return 0;
+		} else if (strcmp(argv[i], "--version") == 0) {
+			print_version();
+			return 0;
+		} else if (argv[i][0] == '-') {
+			fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+			print_usage(argv[0]);
+			return 1;
+		} else {
+			input_files[input_count++] = argv[i];
+			if (dump_lexemes) {
+				return run_dump_lexemes(argv[i], options.no_mmap);
+			}
+			if (dump_tokens) {
+				return run_dump_tokens(argv[i], options.verbose, options.no_mmap);
+			}
+		}
+	}
+
+	if (input_count == 0) {
+		fprintf(stderr, "Error: No input file specified\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+	if (input_count > 1 && (output_file || lex_only || parse_only || dump_ast)) {
+		fprintf(stderr, "Error: Multiple input files specified (only allowed with -S or -c and no -o)\n");
+		return 1;
+	}
+	char *input_file = input_files[0];
+
+	if (dump_ast) {
+		// parse + imprime AST e sai
+		source_t source;
+		if (source_open(&source, input_file, !options.no_mmap) != 0) {
+			perror("Error opening input file");
+			return 1;
+		}
+		parse_context_t context = {0};
+
+		int ret = parse_source(&source, &context);
+
+		if (context.error_count == 0 && ret == 0 && context.root) {
+			print_ast(context.root, 0);
+			free_ast_arena();
+			source_close(&source);
+			type_table_release();
+			intern_release();
+			return 0;
+		} else {
+			fprintf(stderr, "Cannot dump AST: parse errors (%d)\n", context.error_count);
+			free_ast_arena();
+			source_close(&source);
+			type_table_release();
+			intern_release();
+			return 1;
+		}
+	}
+
+	if (lex_only) {
+		if (options.verbose) {
+			printf("%s v%s\n", PROGRAM_NAME, VERSION);
+			printf("Lex-only mode. Scanning tokens from: %s\n", input_file);
+		}
+		return run_lex_only(input_file, options.verbose, options.no_mmap);
+	}
+
+	if (parse_only) {
+		if (options.verbose) {
+			printf("%s v%s\n", PROGRAM_NAME, VERSION);
+			printf("Parse-only mode. Parsing: %s\n", input_file);
+		}
+		return run_parse_only(input_file, options.verbose, options.show_stats, options.no_mmap);
+	}
+
+	if (options.verbose) {
+		printf("%s v%s\n", PROGRAM_NAME, VERSION);
+	}
+
+	codegen_options.verbose = options.verbose;
+
+	if (input_count > 1) {
+		options.object_only = options.compile_to_executable;
+		return compile_batch(input_files, input_count, jobs, &options);
+	}
+	return compile_file(input_file, output_file, &options);
+}
@@ -2,29 +2,20 @@
 #define _POSIX_C_SOURCE 200809L
 #include "ast.h"
 #include "symbol_table.h"
+#include "fold.h"
 #include "common.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-extern int yylex();
-extern int yyparse();
-extern FILE *yyin;
-extern int line_number;
-extern int column;
-
-void yyerror(const char *s);
-
-ast_node_t *ast_root = NULL;
-symbol_table_t *global_symbol_table = NULL;
-// Error recovery globals
-int error_count = 0;
+// Error recovery limit
 int max_errors = 20;
 
 // Helper to merge declaration specifiers and declarator with proper cleanup
 static type_info_t make_complete_type(type_info_t base_type, declarator_t decl) {
     type_info_t result = deep_copy_type_info(&base_type);
     result.pointer_level = decl.pointer_level;
+    result.pointer_qualifiers = decl.pointer_qualifiers;
     result.is_array = decl.is_array;
     result.is_function = decl.is_function;
     result.array_size = decl.array_size;
@@ -51,18 +42,15 @@ static ast_node_t *create_error_expression() {
 }
 
 // Helper to calculate sizes during parsing
-static void calculate_and_store_sizes(ast_node_t *node) {
-    if (!node || !global_symbol_table) return;
+static void calculate_and_store_sizes(ast_node_t *node, symbol_table_t *symbols) {
+    if (!node || !symbols) return;
     switch (node->type) {
         case AST_SIZEOF:
-            if (node->data.sizeof_op.is_type) {
-                // Calculate size from type info stored in operand
-                node->data.sizeof_op.size_value = 4;
-                // Placeholder - will be calculated in semantic analysis
-            } else if (node->data.sizeof_op.operand) {
+            // sizeof(type) is sized where its type_name is reduced
+            if (!node->data.sizeof_op.is_type && node->data.sizeof_op.operand) {
                 // Calculate size from expression type
-                type_info_t expr_type = get_expression_type(node->data.sizeof_op.operand, global_symbol_table);
-                node->data.sizeof_op.size_value = calculate_type_size(&expr_type, global_symbol_table);
+                type_info_t expr_type = get_expression_type(node->data.sizeof_op.operand, symbols);
+                node->data.sizeof_op.size_value = calculate_type_size(&expr_type, symbols);
                 free_type_info(&expr_type);
             }
             break;
@@ -70,20 +58,60 @@ static void calculate_and_store_sizes(ast_node_t *node) {
             break;
     }
 }
+%}
+
+%code requires {
+#include "ast.h"
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
+
+%code {
+int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner);
+yyscan_t open_scanner(source_t *source, parse_context_t *context);
+void close_scanner(yyscan_t scanner);
+void yyerror(yyscan_t scanner, parse_context_t *context, const char *s);
+
+// Enumerators count up from the one before unless given a value, which
+// must be a constant expression and may name the enumerators before it
+static void define_enumerators(parse_context_t *context, enum_value_t **values, int count) {
+    if (!context->symbols) return;
+    int current_enum_val = 0;
+    for (int i = 0; i < count; i++) {
+        enum_value_t *ev = values[i];
+
+        if (ev->value_expr) {
+            long long value;
+            if (evaluate_constant(ev->value_expr, context->symbols, &value)) {
+                ev->value = (int)value;
+            } else {
+                yyerror(NULL, context, "enumerator value is not an integer constant");
+            }
+            current_enum_val = ev->value;
+        } else {
+            ev->value = current_enum_val;
+        }
 
-// Safe cleanup for type_info_t
-static void cleanup_type_info(type_info_t *type_info) {
-    if (type_info && type_info->base_type) {
-        free(type_info->base_type);
-        type_info->base_type = NULL;
+        add_enum_constant(context->symbols, ev->name, current_enum_val);
+        current_enum_val++;
     }
 }
-%}
+}
+
+%define api.pure full
+%param {yyscan_t scanner}
+%parse-param {parse_context_t *context}
 
 %union {
     int number;
     char character;
     char *string;
+    struct {
+        char *text;
+        int length;
+    } string_literal;
     ast_node_t *node;
     type_info_t type_info;
     declarator_t declarator;
@@ -117,49 +145,9 @@ static void cleanup_type_info(type_info_t *type_info) {
     } declarator_list;
 }
 
-%destructor { 
-    if ($$) free($$); 
-} <string>
-
-%destructor { 
-    cleanup_type_info(&$$); 
-} <type_info>
-
-%destructor {
-    if ($$.name) free($$.name);
-    free_ast($$.array_size);
-    if ($$.params) {
-        for (int i = 0; i < $$.param_count; i++) {
-            free_ast($$.params[i]); // free children
-        }
-        free($$.params);
-    }
-} <declarator>
-
-%destructor {
-    if ($$.declarators) {
-        for (int i = 0; i < $$.count; i++) {
-            if ($$.declarators[i].name) free($$.declarators[i].name);
-            free_ast($$.declarators[i].array_size); // free child
-            if ($$.declarators[i].params) {
-               for (int j = 0; j < $$.declarators[i].param_count; j++) {
-                   free_ast($$.declarators[i].params[j]); // free children
-               }
-               free($$.declarators[i].params);
-            }
-        }
-        free($$.declarators);
-    }
-    if ($$.initializers) {
-        for (int i = 0; i < $$.count; i++) {
-            free_ast($$.initializers[i]); 
-        }
-        free($$.initializers);
-    }
-} <declarator_list>
-
 /* Tokens */
-%token <string> IDENTIFIER TYPE_NAME STRING_LITERAL
+%token <string> IDENTIFIER TYPE_NAME
+%token <string_literal> STRING_LITERAL
 %token <number> CONSTANT
 %token <character> CHARACTER
 
@@ -248,59 +236,38 @@ translation_unit
         if ($1) {
             // Check if this is a compound statement (multiple declarations)
             if ($1->type == AST_COMPOUND_STMT) {
+                // The wrapper's statement array is an arena block and can be adopted as is
                 count = $1->data.compound.stmt_count;
-                decls = malloc(count * sizeof(ast_node_t*));
-                for (int i = 0; i < count; i++) {
-                    decls[i] = $1->data.compound.statements[i];
-                }
-                // Free the wrapper but keep the statements
-                $1->data.compound.statements = NULL;
-                $1->data.compound.stmt_count = 0;
-                free_ast($1);
+                decls = $1->data.compound.statements;
             } else {
                 count = 1;
-                decls = malloc(sizeof(ast_node_t*));
-                decls[0] = $1;
+                decls = arena_append(&ast_arena, NULL, 0, &$1, 1, sizeof(ast_node_t*));
             }
         } else {
             decls = NULL;
         }
         
         $$ = create_program(decls, count);
-        ast_root = $$;
+        context->root = $$;
     }
     | translation_unit external_declaration {
         if ($2) {
             // Check if this is a compound statement (multiple declarations)
+            $$ = $1;
+            ast_node_t **items = &$2;
+            int new_count = 1;
             if ($2->type == AST_COMPOUND_STMT) {
-                int new_count = $2->data.compound.stmt_count;
-                $$ = $1;
-                
-                int old_count = $$->data.program.decl_count;
-                $$->data.program.decl_count += new_count;
-                $$->data.program.declarations = realloc($$->data.program.declarations,
-                                                       $$->data.program.decl_count * sizeof(ast_node_t*));
-                
-                for (int i = 0; i < new_count; i++) {
-                    $$->data.program.declarations[old_count + i] = 
-                        $2->data.compound.statements[i];
-                }
-                
-                // Free the wrapper but keep the statements
-                $2->data.compound.statements = NULL;
-                $2->data.compound.stmt_count = 0;
-                free_ast($2);
-            } else {
-                $$ = $1;
-                $$->data.program.decl_count++;
-                $$->data.program.declarations = realloc($$->data.program.declarations,
-                                                       $$->data.program.decl_count * sizeof(ast_node_t*));
-                $$->data.program.declarations[$$->data.program.decl_count - 1] = $2;
+                items = $2->data.compound.statements;
+                new_count = $2->data.compound.stmt_count;
             }
+            $$->data.program.declarations = arena_append(&ast_arena, $$->data.program.declarations,
+                                                         $$->data.program.decl_count, items, new_count,
+                                                         sizeof(ast_node_t*));
+            $$->data.program.decl_count += new_count;
         } else {
             $$ = $1;
         }
-        ast_root = $$;
+        context->root = $$;
     }
     ;
 
@@ -315,11 +282,9 @@ function_definition
     : declaration_specifiers declarator declaration_list compound_statement {
         type_info_t func_type = make_complete_type($1, $2);
         func_type.is_variadic = $2.is_variadic;
-        $$ = create_function(string_duplicate($2.name), func_type, NULL, 0, $4);
+        $$ = create_function($2.name, func_type, NULL, 0, $4);
         $$->data.function.is_defined = 1;
         $$->data.function.is_variadic = $2.is_variadic;
-        free($2.name);
-        cleanup_type_info(&$1);
         // func_type is now owned by the function node
     }
     | declaration_specifiers declarator compound_statement {
@@ -333,11 +298,9 @@ function_definition
             param_count = $2.param_count;
         }
 
-        $$ = create_function(string_duplicate($2.name), func_type, params, param_count, $3);
+        $$ = create_function($2.name, func_type, params, param_count, $3);
         $$->data.function.is_defined = 1;
         $$->data.function.is_variadic = $2.is_variadic;
-        free($2.name);
-        cleanup_type_info(&$1);
         // func_type is now owned by the function node
     }
     ;
@@ -350,7 +313,7 @@ declaration_list
 /* Declarations */
 declaration_specifiers
     : storage_class_specifier {
-        $$ = create_type_info(string_duplicate("int"), 0, 0, NULL);
+        $$ = create_type_info("int", 0, 0, NULL);
         $$.storage_class = $1;
     }
     | storage_class_specifier declaration_specifiers {
@@ -365,13 +328,11 @@ declaration_specifiers
         
         // Handle "unsigned long"
         if (strcmp($1.base_type, "unsigned int") == 0 && strcmp($2.base_type, "long") == 0) {
-            free($$.base_type);
-            $$.base_type = string_duplicate("unsigned long");
+            $$.base_type = "unsigned long";
         }
         // Handle "long long"
         else if (strcmp($1.base_type, "long") == 0 && strcmp($2.base_type, "long") == 0) {
-            free($$.base_type);
-            $$.base_type = string_duplicate("long long");
+            $$.base_type = "long long";
         }
         // Handle "long int"
         else if (strcmp($1.base_type, "long") == 0 && strcmp($2.base_type, "int") == 0) {
@@ -380,10 +341,10 @@ declaration_specifiers
 
         if ($2.storage_class != STORAGE_NONE) $$.storage_class = $2.storage_class;
         $$.qualifiers |= $2.qualifiers;
-        cleanup_type_info(&$2);
+        $$.is_inline |= $2.is_inline;
     }
     | type_qualifier {
-        $$ = create_type_info(string_duplicate("int"), 0, 0, NULL);
+        $$ = create_type_info("int", 0, 0, NULL);
         $$.qualifiers = $1;
     }
     | type_qualifier declaration_specifiers {
@@ -391,27 +352,25 @@ declaration_specifiers
         $$.qualifiers |= $1;
     }
     | function_specifier {
-        $$ = create_type_info(string_duplicate("int"), 0, 0, NULL);
+        $$ = create_type_info("int", 0, 0, NULL);
+        $$.is_inline = 1;
     }
     | function_specifier declaration_specifiers {
         $$ = $2;
+        $$.is_inline = 1;
     }
     ;
 
 init_declarator_list
     : init_declarator {
-        $$.declarators = malloc(sizeof(declarator_t));
-        $$.initializers = malloc(sizeof(ast_node_t*));
-        $$.declarators[0] = $1.declarator;
-        $$.initializers[0] = $1.initializer;
+        $$.declarators = arena_append(&ast_arena, NULL, 0, &$1.declarator, 1, sizeof(declarator_t));
+        $$.initializers = arena_append(&ast_arena, NULL, 0, &$1.initializer, 1, sizeof(ast_node_t*));
         $$.count = 1;
     }
     | init_declarator_list COMMA init_declarator {
+        $$.declarators = arena_append(&ast_arena, $1.declarators, $1.count, &$3.declarator, 1, sizeof(declarator_t));
+        $$.initializers = arena_append(&ast_arena, $1.initializers, $1.count, &$3.initializer, 1, sizeof(ast_node_t*));
         $$.count = $1.count + 1;
-        $$.declarators = realloc($1.declarators, $$.count * sizeof(declarator_t));
-        $$.initializers = realloc($1.initializers, $$.count * sizeof(ast_node_t*));
-        $$.declarators[$$.count - 1] = $3.declarator;
-        $$.initializers[$$.count - 1] = $3.initializer;
     }
     ;
 
@@ -435,35 +394,34 @@ storage_class_specifier
     ;
 
 type_specifier
-    : VOID { $$ = create_type_info(string_duplicate("void"), 0, 0, NULL); }
-    | CHAR { $$ = create_type_info(string_duplicate("char"), 0, 0, NULL); }
-    | SHORT { $$ = create_type_info(string_duplicate("short"), 0, 0, NULL); }
-    | INT { $$ = create_type_info(string_duplicate("int"), 0, 0, NULL); }
-    | LONG { $$ = create_type_info(string_duplicate("long"), 0, 0, NULL); }
-    | FLOAT { $$ = create_type_info(string_duplicate("float"), 0, 0, NULL); }
-    | DOUBLE { $$ = create_type_info(string_duplicate("double"), 0, 0, NULL); }
-    | SIGNED { $$ = create_type_info(string_duplicate("signed int"), 0, 0, NULL); }
-    | UNSIGNED { $$ = create_type_info(string_duplicate("unsigned int"), 0, 0, NULL); }
-    | BOOL { $$ = create_type_info(string_duplicate("_Bool"), 0, 0, NULL); }
-    | COMPLEX { $$ = create_type_info(string_duplicate("_Complex"), 0, 0, NULL); }
-    | IMAGINARY { $$ = create_type_info(string_duplicate("_Imaginary"), 0, 0, NULL); }
+    : VOID { $$ = create_type_info("void", 0, 0, NULL); }
+    | CHAR { $$ = create_type_info("char", 0, 0, NULL); }
+    | SHORT { $$ = create_type_info("short", 0, 0, NULL); }
+    | INT { $$ = create_type_info("int", 0, 0, NULL); }
+    | LONG { $$ = create_type_info("long", 0, 0, NULL); }
+    | FLOAT { $$ = create_type_info("float", 0, 0, NULL); }
+    | DOUBLE { $$ = create_type_info("double", 0, 0, NULL); }
+    | SIGNED { $$ = create_type_info("signed int", 0, 0, NULL); }
+    | UNSIGNED { $$ = create_type_info("unsigned int", 0, 0, NULL); }
+    | BOOL { $$ = create_type_info("_Bool", 0, 0, NULL); }
+    | COMPLEX { $$ = create_type_info("_Complex", 0, 0, NULL); }
+    | IMAGINARY { $$ = create_type_info("_Imaginary", 0, 0, NULL); }
     | struct_or_union_specifier { $$ = $1; }
     | enum_specifier { $$ = $1; }
     | TYPE_NAME { 
-        $$ = create_type_info(string_duplicate($1), 0, 0, NULL); 
-        free($1);
+        $$ = create_type_info($1, 0, 0, NULL); 
     }
     ;
 
 struct_or_union_specifier
     : struct_or_union IDENTIFIER LBRACE struct_declaration_list RBRACE {
-        $$ = create_type_info(string_duplicate($2), 0, 0, NULL);
+        $$ = create_type_info($2, 0, 0, NULL);
         $$.is_struct = (strcmp($1, "struct") == 0);
         $$.is_union = (strcmp($1, "union") == 0);
 
-        if (global_symbol_table) {
+        if (context->symbols) {
             symbol_type_t sym_type = $$.is_struct ? SYM_STRUCT : SYM_UNION;
-            symbol_t *struct_sym = add_symbol(global_symbol_table, $2, sym_type, $$);
+            symbol_t *struct_sym = add_symbol(context->symbols, $2, sym_type, $$);
 
             if (struct_sym) {
                 for (int i = 0; i < $4.count; i++) {
@@ -475,64 +433,47 @@ struct_or_union_specifier
 
                         symbol_t *member = create_symbol(member_name, SYM_VARIABLE, member_type);
                         
-                        member->size = calculate_type_size(&member_type, global_symbol_table);
-                        member->alignment = calculate_type_alignment(&member_type, global_symbol_table);
+                        member->size = calculate_type_size(&member_type, context->symbols);
+                        member->alignment = calculate_type_alignment(&member_type, context->symbols);
 
                         add_struct_member(struct_sym, member);
                     }
-                    free_ast(decl_node);
                 }
                 
                 calculate_struct_offsets(struct_sym);
-            } else {
-                for (int i = 0; i < $4.count; i++) free_ast($4.nodes[i]);
             }
-            free($4.nodes);
-        } else {
-             for (int i = 0; i < $4.count; i++) free_ast($4.nodes[i]);
-             free($4.nodes);
         }
-
-        free($1);
-        free($2);
     }
     | struct_or_union LBRACE struct_declaration_list RBRACE {
-        $$ = create_type_info(string_duplicate("anonymous"), 0, 0, NULL);
+        $$ = create_type_info("anonymous", 0, 0, NULL);
         $$.is_struct = (strcmp($1, "struct") == 0);
         $$.is_union = (strcmp($1, "union") == 0);
-        free($1);
     }
     | struct_or_union IDENTIFIER {
-        $$ = create_type_info(string_duplicate($2), 0, 0, NULL);
+        $$ = create_type_info($2, 0, 0, NULL);
         $$.is_struct = (strcmp($1, "struct") == 0);
         $$.is_union = (strcmp($1, "union") == 0);
         $$.is_incomplete = 1;
-        free($1);
-        free($2);
     }
     ;
 
 struct_or_union
-    : STRUCT { $$ = string_duplicate("struct"); }
-    | UNION { $$ = string_duplicate("union"); }
+    : STRUCT { $$ = "struct"; }
+    | UNION { $$ = "union"; }
     ;
 
 struct_declaration_list
     : struct_declaration { $$ = $1; }
     | struct_declaration_list struct_declaration {
+        $$.nodes = arena_append(&ast_arena, $1.nodes, $1.count, $2.nodes, $2.count, sizeof(ast_node_t*));
         $$.count = $1.count + $2.count;
-        $$.nodes = realloc($1.nodes, $$.count * sizeof(ast_node_t*));
-        for (int i = 0; i < $2.count; i++) {
-            $$.nodes[$1.count + i] = $2.nodes[i];
-        }
-        free($2.nodes);
     }
     ;
 
 struct_declaration
     : specifier_qualifier_list struct_declarator_list SEMICOLON {
         $$.count = $2.count;
-        $$.nodes = malloc($$.count * sizeof(ast_node_t*));
+        $$.nodes = arena_realloc(&ast_arena, NULL, $$.count * sizeof(ast_node_t*));
         for (int i = 0; i < $$.count; i++) {
             member_info_t *member = &$2.members[i];
             
@@ -555,13 +496,8 @@ struct_declaration
 
             type_info_t member_type = make_complete_type($1, member_decl);
             
-            $$.nodes[i] = create_declaration(member_type, string_duplicate(member->name), NULL);
-            
-            if (member->type.base_type) free(member->type.base_type);
-            if (member->name) free(member->name);
+            $$.nodes[i] = create_declaration(member_type, member->name, NULL);
         }
-        free($2.members);
-        cleanup_type_info(&$1);
     }
     ;
 
@@ -569,7 +505,6 @@ specifier_qualifier_list
     : type_specifier specifier_qualifier_list {
         $$ = $1;
         $$.qualifiers |= $2.qualifiers;
-        cleanup_type_info(&$2);
     }
     | type_specifier { $$ = $1; }
     | type_qualifier specifier_qualifier_list {
@@ -577,7 +512,7 @@ specifier_qualifier_list
         $$.qualifiers |= $1;
     }
     | type_qualifier {
-        $$ = create_type_info(string_duplicate("int"), 0, 0, NULL);
+        $$ = create_type_info("int", 0, 0, NULL);
         $$.qualifiers = $1;
     }
     ;
@@ -585,141 +520,87 @@ specifier_qualifier_list
 struct_declarator_list
     : struct_declarator {
         $$.count = 1;
-        $$.members = malloc(sizeof(member_info_t));
-        $$.members[0] = *$1;
-        free($1);
+        $$.members = arena_append(&ast_arena, NULL, 0, $1, 1, sizeof(member_info_t));
     }
     | struct_declarator_list COMMA struct_declarator {
+        $$.members = arena_append(&ast_arena, $1.members, $1.count, $3, 1, sizeof(member_info_t));
         $$.count = $1.count + 1;
-        $$.members = realloc($1.members, $$.count * sizeof(member_info_t));
-        $$.members[$$.count - 1] = *$3;
-        free($3);
     }
     ;
 
 struct_declarator
     : declarator {
-        $$ = create_member_info(string_duplicate($1.name),
-                               create_type_info(string_duplicate("int"), $1.pointer_level, $1.is_array, $1.array_size), 0);
-        free($1.name);
+        $$ = create_member_info($1.name,
+                               create_type_info("int", $1.pointer_level, $1.is_array, $1.array_size), 0);
     }
     | COLON constant_expression {
-        $$ = create_member_info(string_duplicate(""),
-                               create_type_info(string_duplicate("int"), 0, 0, NULL),
+        $$ = create_member_info("",
+                               create_type_info("int", 0, 0, NULL),
                                $2->data.number.value);
         $$->bit_field_expr = $2;
     }
     | declarator COLON constant_expression {
-        $$ = create_member_info(string_duplicate($1.name),
-                               create_type_info(string_duplicate("int"), $1.pointer_level, $1.is_array, $1.array_size),
+        $$ = create_member_info($1.name,
+                               create_type_info("int", $1.pointer_level, $1.is_array, $1.array_size),
                                $3->data.number.value);
         $$->bit_field_expr = $3;
-        free($1.name);
     }
     ;
 
 enum_specifier
     : ENUM LBRACE enumerator_list RBRACE {
-        $$ = create_type_info(string_duplicate("enum"), 0, 0, NULL);
+        $$ = create_type_info("enum", 0, 0, NULL);
         $$.is_enum = 1;
 
-        if (global_symbol_table) {
-            int current_enum_val = 0;
-            for (int i = 0; i < $3.count; i++) {
-                enum_value_t *ev = $3.values[i];
-                
-                if (ev->value_expr) {
-                    current_enum_val = ev->value;
-                } else {
-                    ev->value = current_enum_val;
-                }
-
-                add_enum_constant(global_symbol_table, ev->name, current_enum_val);
-                
-                current_enum_val++;
-
-                if (ev->name) free(ev->name);
-                if (ev->value_expr) free_ast(ev->value_expr);
-                free(ev);
-            }
-            // Free the list array itself
-            free($3.values);
-        }
+        define_enumerators(context, $3.values, $3.count);
     }
     | ENUM IDENTIFIER LBRACE enumerator_list RBRACE {
-        $$ = create_type_info(string_duplicate($2), 0, 0, NULL);
+        $$ = create_type_info($2, 0, 0, NULL);
         $$.is_enum = 1;
 
-        if (global_symbol_table) {
-            int current_enum_val = 0;
-            for (int i = 0; i < $4.count; i++) {
-                enum_value_t *ev = $4.values[i];
-                
-                if (ev->value_expr) {
-                    current_enum_val = ev->value;
-                } else {
-                    ev->value = current_enum_val;
-                }
-
-                add_enum_constant(global_symbol_table, ev->name, current_enum_val);
-                current_enum_val++;
-
-                if (ev->name) free(ev->name);
-                if (ev->value_expr) free_ast(ev->value_expr);
-                free(ev);
-            }
-            free($4.values);
-        }
-        free($2);
+        define_enumerators(context, $4.values, $4.count);
     }
     | ENUM LBRACE enumerator_list COMMA RBRACE {
-        $$ = create_type_info(string_duplicate("enum"), 0, 0, NULL);
+        $$ = create_type_info("enum", 0, 0, NULL);
         $$.is_enum = 1;
+        define_enumerators(context, $3.values, $3.count);
     }
     | ENUM IDENTIFIER LBRACE enumerator_list COMMA RBRACE {
-        $$ = create_type_info(string_duplicate($2), 0, 0, NULL);
+        $$ = create_type_info($2, 0, 0, NULL);
         $$.is_enum = 1;
-        free($2);
+        define_enumerators(context, $4.values, $4.count);
     }
     | ENUM IDENTIFIER {
-        $$ = create_type_info(string_duplicate($2), 0, 0, NULL);
+        $$ = create_type_info($2, 0, 0, NULL);
         $$.is_enum = 1;
         $$.is_incomplete = 1;
-        free($2);
     }
     ;
 
 enumerator_list
     : enumerator { $$ = $1; }
     | enumerator_list COMMA enumerator {
+        $$.values = arena_append(&ast_arena, $1.values, $1.count, $3.values, $3.count, sizeof(enum_value_t*));
         $$.count = $1.count + $3.count;
-        $$.values = realloc($1.values, $$.count * sizeof(enum_value_t*));
-        for (int i = 0; i < $3.count; i++) {
-            $$.values[$1.count + i] = $3.values[i];
-        }
-        free($3.values);
     }
     ;
 
 enumerator
     : enumerator_item {
         $$.count = 1;
-        $$.values = malloc(sizeof(enum_value_t*));
-        $$.values[0] = $1;
+        $$.values = arena_append(&ast_arena, NULL, 0, &$1, 1, sizeof(enum_value_t*));
     }
     ;
 
 enumerator_item
     : IDENTIFIER {
-        $$ = create_enum_value(string_duplicate($1), 0);
-        free($1);
+        $$ = create_enum_value($1, 0);
     }
     | IDENTIFIER ASSIGN constant_expression {
         int value = ($3->type == AST_NUMBER) ?
         $3->data.number.value : 0;
-        $$ = create_enum_value(string_duplicate($1), value);
+        $$ = create_enum_value($1, value);
         $$->value_expr = $3;
-        free($1);
     }
     ;
 
@@ -738,14 +619,14 @@ declarator
     : pointer direct_declarator {
         $$ = $2;
         $$.pointer_level = $1.pointer_level;
+        $$.pointer_qualifiers = $1.pointer_qualifiers;
     }
     | direct_declarator { $$ = $1; }
     ;
 
 direct_declarator
     : IDENTIFIER {
-        $$ = make_declarator(string_duplicate($1), 0, 0, NULL);
-        free($1);
+        $$ = make_declarator($1, 0, 0, NULL);
     }
     | LPAREN declarator RPAREN {
         $$ = $2;
@@ -812,6 +693,7 @@ pointer
     }
     | ASTERISK type_qualifier_list {
         $$ = make_declarator(NULL, 1, 0, NULL);
+        $$.pointer_qualifiers = $2;
     }
     | ASTERISK pointer {
         $$ = $2;
@@ -841,23 +723,19 @@ parameter_type_list
 
 parameter_list
     : parameter_declaration {
-        $$.nodes = malloc(sizeof(ast_node_t*));
-        $$.nodes[0] = $1;
+        $$.nodes = arena_append(&ast_arena, NULL, 0, &$1, 1, sizeof(ast_node_t*));
         $$.count = 1;
     }
     | parameter_list COMMA parameter_declaration {
+        $$.nodes = arena_append(&ast_arena, $1.nodes, $1.count, &$3, 1, sizeof(ast_node_t*));
         $$.count = $1.count + 1;
-        $$.nodes = realloc($1.nodes, $$.count * sizeof(ast_node_t*));
-        $$.nodes[$$.count - 1] = $3;
     }
     ;
 
 parameter_declaration
     : declaration_specifiers declarator {
         type_info_t param_type = make_complete_type($1, $2);
-        $$ = create_parameter(param_type, string_duplicate($2.name));
-        free($2.name);
-        cleanup_type_info(&$1);
+        $$ = create_parameter(param_type, $2.name);
     }
 | declaration_specifiers abstract_declarator {
         type_info_t param_type = make_complete_type($1, $2);
@@ -866,13 +744,11 @@ parameter_declaration
             param_type.param_types = $2.params;
         }
 
-        $$ = create_parameter(param_type, string_duplicate(""));
-        cleanup_type_info(&$1);
+        $$ = create_parameter(param_type, "");
     }
     | declaration_specifiers {
         type_info_t param_type = deep_copy_type_info(&$1);
-        $$ = create_parameter(param_type, string_duplicate(""));
-        cleanup_type_info(&$1);
+        $$ = create_parameter(param_type, "");
     }
     ;
 
@@ -880,7 +756,6 @@ type_name
     : specifier_qualifier_list { $$ = $1; }
     | specifier_qualifier_list abstract_declarator { 
         $$ = make_complete_type($1, $2);
-        cleanup_type_info(&$1);
     }
     ;
 
@@ -892,6 +767,7 @@ abstract_declarator
     | pointer direct_abstract_declarator {
         $$ = $2;  /* $2 is the base abstract declarator */
         $$.pointer_level += $1.pointer_level;
+        $$.pointer_qualifiers = $1.pointer_qualifiers;
     }
     ;
 
@@ -908,13 +784,11 @@ direct_abstract_declarator
     | direct_abstract_declarator LBRACKET RBRACKET {
         $$ = $1;
         $$.is_array = 1;
-        free_ast($1.array_size);
         $$.array_size = NULL;
     }
     | direct_abstract_declarator LBRACKET assignment_expression RBRACKET {
         $$ = $1;
         $$.is_array = 1;
-        free_ast($1.array_size);
         $$.array_size = $3;
     }
     | LBRACKET ASTERISK RBRACKET {
@@ -924,7 +798,6 @@ direct_abstract_declarator
     | direct_abstract_declarator LBRACKET ASTERISK RBRACKET {
         $$ = $1;
         $$.is_array = 1;
-        free_ast($1.array_size);
         $$.array_size = NULL;
     }
     | LPAREN RPAREN {
@@ -967,8 +840,7 @@ statement
 
 labeled_statement
     : IDENTIFIER COLON statement {
-        $$ = create_label_stmt(string_duplicate($1), $3);
-        free($1);
+        $$ = create_label_stmt($1, $3);
     }
     | CASE constant_expression COLON statement {
         $$ = create_case_stmt($2, $4);
@@ -995,13 +867,8 @@ block_item_list
                 // Flatten it
                 $$.nodes = $1->data.compound.statements;
                 $$.count = $1->data.compound.stmt_count;
-                // Don't free the statements, just the wrapper
-                $1->data.compound.statements = NULL;
-                $1->data.compound.stmt_count = 0;
-                free_ast($1);
             } else {
-                $$.nodes = malloc(sizeof(ast_node_t*));
-                $$.nodes[0] = $1;
+                $$.nodes = arena_append(&ast_arena, NULL, 0, &$1, 1, sizeof(ast_node_t*));
                 $$.count = 1;
             }
         } else {
@@ -1011,24 +878,16 @@ block_item_list
     }
     | block_item_list statement {
         if ($2) {
+            ast_node_t **items = &$2;
+            int new_items = 1;
             // Check if statement is a compound (multiple declarations)
             if ($2->type == AST_COMPOUND_STMT) {
                 // Flatten it into the list
-                int new_items = $2->data.compound.stmt_count;
-                $$.count = $1.count + new_items;
-                $$.nodes = realloc($1.nodes, $$.count * sizeof(ast_node_t*));
-                for (int i = 0; i < new_items; i++) {
-                    $$.nodes[$1.count + i] = $2->data.compound.statements[i];
-                }
-                // Don't free the statements, just the wrapper
-                $2->data.compound.statements = NULL;
-                $2->data.compound.stmt_count = 0;
-                free_ast($2);
-            } else {
-                $$.count = $1.count + 1;
-                $$.nodes = realloc($1.nodes, $$.count * sizeof(ast_node_t*));
-                $$.nodes[$$.count - 1] = $2;
+                items = $2->data.compound.statements;
+                new_items = $2->data.compound.stmt_count;
             }
+            $$.nodes = arena_append(&ast_arena, $1.nodes, $1.count, items, new_items, sizeof(ast_node_t*));
+            $$.count = $1.count + new_items;
         } else {
             $$ = $1;
         }
@@ -1085,8 +944,7 @@ iteration_statement
 
 jump_statement
     : GOTO IDENTIFIER SEMICOLON {
-        $$ = create_goto_stmt(string_duplicate($2));
-        free($2);
+        $$ = create_goto_stmt($2);
     }
     | CONTINUE SEMICOLON {
         $$ = create_continue_stmt();
@@ -1105,8 +963,7 @@ jump_statement
 /* Expressions */
 primary_expression
     : IDENTIFIER {
-        $$ = create_identifier(string_duplicate($1));
-        free($1);
+        $$ = create_identifier($1);
     }
     | CONSTANT {
         $$ = create_number($1);
@@ -1115,8 +972,7 @@ primary_expression
         $$ = create_character($1);
     }
     | STRING_LITERAL {
-        $$ = create_string_literal(string_duplicate($1));
-        free($1);
+        $$ = create_string_literal($1.text, $1.length);
     }
     | LPAREN expression RPAREN {
         $$ = $2;
@@ -1130,29 +986,25 @@ postfix_expression
     }
     | postfix_expression LPAREN RPAREN {
         if ($1->type == AST_IDENTIFIER) {
-            char *func_name = string_duplicate($1->data.identifier.name);
+            char *func_name = $1->data.identifier.name;
             $$ = create_call(func_name, NULL, 0);
-            free_ast($1);
         } else {
             $$ = create_error_expression();
         }
     }
     | postfix_expression LPAREN argument_expression_list RPAREN {
         if ($1->type == AST_IDENTIFIER) {
-            char *func_name = string_duplicate($1->data.identifier.name);
+            char *func_name = $1->data.identifier.name;
             $$ = create_call(func_name, $3.nodes, $3.count);
-            free_ast($1);
         } else {
             $$ = create_error_expression();
         }
     }
     | postfix_expression DOT IDENTIFIER {
-        $$ = create_member_access($1, string_duplicate($3));
-        free($3);
+        $$ = create_member_access($1, $3);
     }
     | postfix_expression PTR_OP IDENTIFIER {
-        $$ = create_ptr_member_access($1, string_duplicate($3));
-        free($3);
+        $$ = create_ptr_member_access($1, $3);
     }
     | postfix_expression INC_OP {
         $$ = create_unary_op(OP_POSTINC, $1);
@@ -1162,24 +1014,20 @@ postfix_expression
     }
     | LPAREN type_name RPAREN LBRACE initializer_list RBRACE {
         $$ = create_cast($2, $5);
-        cleanup_type_info(&$2);
     }
     | LPAREN type_name RPAREN LBRACE initializer_list COMMA RBRACE {
         $$ = create_cast($2, $5);
-        cleanup_type_info(&$2);
     }
     ;
 
 argument_expression_list
     : assignment_expression {
-        $$.nodes = malloc(sizeof(ast_node_t*));
-        $$.nodes[0] = $1;
+        $$.nodes = arena_append(&ast_arena, NULL, 0, &$1, 1, sizeof(ast_node_t*));
         $$.count = 1;
     }
     | argument_expression_list COMMA assignment_expression {
+        $$.nodes = arena_append(&ast_arena, $1.nodes, $1.count, &$3, 1, sizeof(ast_node_t*));
         $$.count = $1.count + 1;
-        $$.nodes = realloc($1.nodes, $$.count * sizeof(ast_node_t*));
-        $$.nodes[$$.count - 1] = $3;
     }
     ;
 
@@ -1212,12 +1060,11 @@ unary_expression
     }
     | SIZEOF unary_expression {
         $$ = create_sizeof_expr($2);
-        calculate_and_store_sizes($$);
+        calculate_and_store_sizes($$, context->symbols);
     }
     | SIZEOF LPAREN type_name RPAREN {
         $$ = create_sizeof_type($3);
-        calculate_and_store_sizes($$);
-        cleanup_type_info(&$3);
+        $$->data.sizeof_op.size_value = calculate_type_size(&$3, context->symbols);
     }
     ;
 
@@ -1225,7 +1072,6 @@ cast_expression
     : unary_expression { $$ = $1; }
     | LPAREN type_name RPAREN cast_expression {
         $$ = create_cast($2, $4);
-        cleanup_type_info(&$2);
     }
     ;
 
@@ -1335,9 +1181,8 @@ assignment_expression
     | unary_expression assignment_operator assignment_expression {
         if ($2 == OP_ASSIGN) {
             if ($1->type == AST_IDENTIFIER) {
-                char *var_name = string_duplicate($1->data.identifier.name);
+                char *var_name = $1->data.identifier.name;
                 $$ = create_assignment(var_name, $3);
-                free_ast($1);
             } else {
                 $$ = create_assignment_to_lvalue($1, $3);
             }
@@ -1382,28 +1227,22 @@ initializer
 
 initializer_list
     : initializer {
-        ast_node_t **values = malloc(sizeof(ast_node_t*));
-        values[0] = $1;
-        $$ = create_initializer_list(values, 1);
+        $$ = create_initializer_list(arena_append(&ast_arena, NULL, 0, &$1, 1, sizeof(ast_node_t*)), 1);
     }
     | designation initializer {
-        ast_node_t **values = malloc(sizeof(ast_node_t*));
-        values[0] = $2;
-        $$ = create_initializer_list(values, 1);
+        $$ = create_initializer_list(arena_append(&ast_arena, NULL, 0, &$2, 1, sizeof(ast_node_t*)), 1);
     }
     | initializer_list COMMA initializer {
         $$ = $1;
+        $$->data.initializer_list.values = arena_append(&ast_arena, $$->data.initializer_list.values,
+                                                        $$->data.initializer_list.count, &$3, 1, sizeof(ast_node_t*));
         $$->data.initializer_list.count++;
-        $$->data.initializer_list.values = realloc($$->data.initializer_list.values,
-                                                   $$->data.initializer_list.count * sizeof(ast_node_t*));
-        $$->data.initializer_list.values[$$->data.initializer_list.count - 1] = $3;
     }
     | initializer_list COMMA designation initializer {
         $$ = $1;
+        $$->data.initializer_list.values = arena_append(&ast_arena, $$->data.initializer_list.values,
+                                                        $$->data.initializer_list.count, &$4, 1, sizeof(ast_node_t*));
         $$->data.initializer_list.count++;
-        $$->data.initializer_list.values = realloc($$->data.initializer_list.values,
-                                                   $$->data.initializer_list.count * sizeof(ast_node_t*));
-        $$->data.initializer_list.values[$$->data.initializer_list.count - 1] = $4;
     }
     ;
 
@@ -1420,7 +1259,6 @@ designator
     : LBRACKET constant_expression RBRACKET { $$ = NULL; }
     | DOT IDENTIFIER { 
         $$ = NULL; 
-        free($2);
     }
     ;
 
@@ -1436,7 +1274,7 @@ declaration
             ast_node_t **params = $2.declarators[0].params;
             int param_count = $2.declarators[0].param_count;
             
-            $$ = create_function(string_duplicate($2.declarators[0].name), 
+            $$ = create_function($2.declarators[0].name, 
                                complete_type, params, param_count, NULL);
             $$->data.function.is_defined = 0;
             $$->data.function.is_variadic = $2.declarators[0].is_variadic;
@@ -1445,61 +1283,53 @@ declaration
             if ($1.storage_class == STORAGE_EXTERN) {
                 $$->data.function.storage_class = STORAGE_EXTERN;
             }
-            
-            free($2.declarators[0].name);
-            free($2.declarators);
-            free($2.initializers);
-            cleanup_type_info(&$1);
         }
         // Create a declaration for each declarator with proper type
         else if ($2.count == 1) {
             // Single declarator - return it directly
             type_info_t complete_type = make_complete_type($1, $2.declarators[0]);
             $$ = create_declaration(complete_type, 
-                                   string_duplicate($2.declarators[0].name), 
+                                   $2.declarators[0].name, 
                                    $2.initializers[0]);
-            
-            // Clean up
-            free($2.declarators[0].name);
-            free($2.declarators);
-            free($2.initializers);
-            cleanup_type_info(&$1);
         } else {
             // Multiple declarators - create a compound statement containing all declarations
-            ast_node_t **decls = malloc($2.count * sizeof(ast_node_t*));
+            ast_node_t **decls = arena_realloc(&ast_arena, NULL, $2.count * sizeof(ast_node_t*));
             
             for (int i = 0; i < $2.count; i++) {
                 type_info_t complete_type = make_complete_type($1, $2.declarators[i]);
                 decls[i] = create_declaration(complete_type,
-                                             string_duplicate($2.declarators[i].name),
+                                             $2.declarators[i].name,
                                              $2.initializers[i]);
-                free($2.declarators[i].name);
             }
             
             // Create a compound statement to hold all declarations
             // This allows the rest of the parser to treat it as a single statement
             $$ = create_compound_stmt(decls, $2.count);
-            
-            // Clean up
-            free($2.declarators);
-            free($2.initializers);
-            cleanup_type_info(&$1);
         }
     }
     | declaration_specifiers SEMICOLON {
         $$ = NULL;
-        cleanup_type_info(&$1);
     }
     ;
 
 %%
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Error at line %d, column %d: %s\n", line_number, column, s);
-    error_count++;
+void yyerror(yyscan_t scanner, parse_context_t *context, const char *s) {
+    (void)scanner;
+    int line, column;
+    source_position(context->source, context->offset, &line, &column);
+    fprintf(stderr, "Error at line %d, column %d: %s\n", line, column, s);
+    context->error_count++;
 
-    if (error_count >= max_errors) {
+    if (context->error_count >= max_errors) {
         fprintf(stderr, "Too many errors (%d), stopping compilation.\n", max_errors);
         exit(1);
     }
 }
+
+int parse_source(source_t *source, parse_context_t *context) {
+    yyscan_t scanner = open_scanner(source, context);
+    int result = yyparse(scanner, context);
+    close_scanner(scanner);
+    return result;
+}
@@ -0,0 +1,212 @@
+#include "scan.h"
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Same sets as the flex rules: [ \t\v\f\n], [A-Za-z0-9_], and what ends
+// the run of plain characters inside a string literal
+static int is_blank(unsigned char c)
+{
+	return c == ' ' || (unsigned char)(c - '\t') <= '\f' - '\t';
+}
+
+static int is_identifier_char(unsigned char c)
+{
+	return (unsigned char)((c | 0x20) - 'a') <= 'z' - 'a' || (unsigned char)(c - '0') <= 9 || c == '_';
+}
+
+static int is_string_stop(unsigned char c)
+{
+	return c == '"' || c == '\\' || c == '\n';
+}
+
+static const char *whitespace_scalar(const char *p, const char *end)
+{
+	while (p < end && is_blank((unsigned char)*p))
+		p++;
+	return p;
+}
+
+static const char *identifier_scalar(const char *p, const char *end)
+{
+	while (p < end && is_identifier_char((unsigned char)*p))
+		p++;
+	return p;
+}
+
+static const char *string_scalar(const char *p, const char *end)
+{
+	while (p < end && !is_string_stop((unsigned char)*p))
+		p++;
+	return p;
+}
+
+#ifdef SCAN_X86
+// Byte lanes of x within [lo, hi]; SSE2 has no unsigned compare, so this
+// checks min(x - lo, hi - lo) == x - lo
+static __m128i in_range_sse2(__m128i x, char lo, char hi)
+{
+	__m128i d = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+	return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8((char)(hi - lo))), d);
+}
+
+static const char *whitespace_sse2(const char *p, const char *end)
+{
+	for (; end - p >= 16; p += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i *)p);
+		__m128i hit = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), in_range_sse2(x, '\t', '\f'));
+		unsigned miss = ~(unsigned)_mm_movemask_epi8(hit) & 0xffff;
+		if (miss)
+			return p + __builtin_ctz(miss);
+	}
+	return whitespace_scalar(p, end);
+}
+
+static const char *identifier_sse2(const char *p, const char *end)
+{
+	for (; end - p >= 16; p += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i *)p);
+		__m128i hit = _mm_or_si128(in_range_sse2(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z'),
+					   _mm_or_si128(in_range_sse2(x, '0', '9'), _mm_cmpeq_epi8(x, _mm_set1_epi8('_'))));
+		unsigned miss = ~(unsigned)_mm_movemask_epi8(hit) & 0xffff;
+		if (miss)
+			return p + __builtin_ctz(miss);
+	}
+	return identifier_scalar(p, end);
+}
+
+static const char *string_sse2(const char *p, const char *end)
+{
+	for (; end - p >= 16; p += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i *)p);
+		__m128i hit = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('"')),
+					   _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\\')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'))));
+		unsigned stop = (unsigned)_mm_movemask_epi8(hit);
+		if (stop)
+			return p + __builtin_ctz(stop);
+	}
+	return string_scalar(p, end);
+}
+
+// The same three loops over 32 bytes
+__attribute__((target("avx2"))) static __m256i in_range_avx2(__m256i x, char lo, char hi)
+{
+	__m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8((char)(hi - lo))), d);
+}
+
+__attribute__((target("avx2"))) static const char *whitespace_avx2(const char *p, const char *end)
+{
+	for (; end - p >= 32; p += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)p);
+		__m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), in_range_avx2(x, '\t', '\f'));
+		unsigned miss = ~(unsigned)_mm256_movemask_epi8(hit);
+		if (miss)
+			return p + __builtin_ctz(miss);
+	}
+	return whitespace_sse2(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *identifier_avx2(const char *p, const char *end)
+{
+	for (; end - p >= 32; p += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)p);
+		__m256i hit = _mm256_or_si256(in_range_avx2(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z'),
+					      _mm256_or_si256(in_range_avx2(x, '0', '9'), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'))));
+		unsigned miss = ~(unsigned)_mm256_movemask_epi8(hit);
+		if (miss)
+			return p + __builtin_ctz(miss);
+	}
+	return identifier_sse2(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *string_avx2(const char *p, const char *end)
+{
+	for (; end - p >= 32; p += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)p);
+		__m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')),
+					      _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'))));
+		unsigned stop = (unsigned)_mm256_movemask_epi8(hit);
+		if (stop)
+			return p + __builtin_ctz(stop);
+	}
+	return string_sse2(p, end);
+}
+#endif
+
+typedef struct {
+	const char *name;
+	const char *(*whitespace)(const char *p, const char *end);
+	const char *(*identifier)(const char *p, const char *end);
+	const char *(*string)(const char *p, const char *end);
+} scan_kernels_t;
+
+#ifdef SCAN_X86
+static scan_kernels_t kernels = { "sse2", whitespace_sse2, identifier_sse2, string_sse2 };
+
+// Picked before main() runs, so scanners on several threads only ever read it
+__attribute__((constructor)) static void pick_kernels(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		kernels = (scan_kernels_t){ "avx2", whitespace_avx2, identifier_avx2, string_avx2 };
+}
+#else
+static const scan_kernels_t kernels = { "scalar", whitespace_scalar, identifier_scalar, string_scalar };
+#endif
+
+const char *skip_blanks(const char *p, const char *end)
+{
+	for (;;) {
+		p = kernels.whitespace(p, end);
+		if (end - p < 2 || p[0] != '/')
+			return p;
+		if (p[1] == '/') {
+			// Up to the newline, which the next round skips
+			const char *newline = memchr(p + 2, '\n', (size_t)(end - p - 2));
+			p = newline ? newline : end;
+		} else if (p[1] == '*') {
+			// Comment bodies are searched with memchr, which libc already
+			// vectorises for a single byte
+			const char *star = p + 2;
+			p = end;
+			while ((star = memchr(star, '*', (size_t)(end - star))) != NULL) {
+				star++;
+				if (star < end && *star == '/') {
+					p = star + 1;
+					break;
+				}
+			}
+		} else {
+			return p;
+		}
+	}
+}
+
+const char *skip_identifier(const char *p, const char *end)
+{
+	return kernels.identifier(p, end);
+}
+
+const char *find_string_end(const char *p, const char *end)
+{
+	for (;;) {
+		p = kernels.string(p, end);
+		if (p == end || *p == '\n')
+			return NULL;
+		if (*p == '"')
+			return p;
+		// A backslash escapes any character but a newline
+		if (end - p < 2 || p[1] == '\n')
+			return NULL;
+		p += 2;
+	}
+}
+
+const char *scan_kernel_name(void)
+{
+	return kernels.name;
+}
@@ -0,0 +1,24 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+// Character-run scanners behind the lexer's fast path (yylex() in
+// lexer.l). Each looks at [p, end) only and returns where the run stops,
+// or end. On x86-64 they compare 16 or 32 bytes at a time with SSE2 or
+// AVX2, chosen once at startup from what the CPU supports; other targets
+// use the plain loops.
+
+// Skips whitespace, /* */ comments (an unterminated one runs to end) and
+// // comments
+const char *skip_blanks(const char *p, const char *end);
+
+// Skips [A-Za-z0-9_]
+const char *skip_identifier(const char *p, const char *end);
+
+// From just past the opening quote of a string literal: returns its
+// closing quote, or NULL when a newline or end comes first
+const char *find_string_end(const char *p, const char *end);
+
+// Name of the variant in use ("avx2", "sse2" or "scalar")
+const char *scan_kernel_name(void);
+
+#endif
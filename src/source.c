@@ -0,0 +1,156 @@
+#define _POSIX_C_SOURCE 200809L
+#include "source.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Reads everything left in fd into a heap buffer with two NULs after it
+static int read_source(source_t *source, int fd, size_t size_hint)
+{
+	size_t capacity = size_hint + 2 > 4096 ? size_hint + 2 : 4096;
+	size_t size = 0;
+	char *text = malloc(capacity);
+	if (!text) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (;;) {
+		// Room for at least one more byte plus the NULs
+		if (capacity - size < 3) {
+			capacity *= 2;
+			char *grown = realloc(text, capacity);
+			if (!grown) {
+				fprintf(stderr, "Memory allocation failed\n");
+				exit(1);
+			}
+			text = grown;
+		}
+		ssize_t n = read(fd, text + size, capacity - size - 2);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			free(text);
+			return -1;
+		}
+		if (n == 0)
+			break;
+		size += (size_t)n;
+	}
+	text[size] = text[size + 1] = '\0';
+	source->text = text;
+	source->size = size;
+	source->mapped = 0;
+	return 0;
+}
+
+int source_open(source_t *source, const char *path, int map)
+{
+	source->line_starts = NULL;
+	source->line_count = 0;
+	source->line_capacity = 0;
+	source->indexed = 0;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		int saved = errno;
+		close(fd);
+		errno = saved;
+		return -1;
+	}
+
+	// Bytes past the end of the file read as zero up to the end of its last
+	// page, so the two NULs come for free unless the file ends within two
+	// bytes of a page boundary. The mapping is private and writable because
+	// flex briefly writes a NUL after each token it matches.
+	size_t size = S_ISREG(st.st_mode) ? (size_t)st.st_size : 0;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t tail = size % page;
+	if (map && size > 0 && tail != 0 && tail <= page - 2) {
+		void *text = mmap(NULL, size + 2, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (text != MAP_FAILED) {
+			close(fd);
+			source->text = text;
+			source->size = size;
+			source->mapped = size + 2;
+			return 0;
+		}
+	}
+
+	int result = read_source(source, fd, size);
+	int saved = errno;
+	close(fd);
+	errno = saved;
+	return result;
+}
+
+void source_close(source_t *source)
+{
+	if (source->mapped)
+		munmap(source->text, source->mapped);
+	else
+		free(source->text);
+	free(source->line_starts);
+	source->text = NULL;
+	source->size = 0;
+	source->mapped = 0;
+	source->line_starts = NULL;
+	source->line_count = 0;
+	source->line_capacity = 0;
+	source->indexed = 0;
+}
+
+// Record the line starts in text[indexed, end)
+static void index_lines(source_t *source, size_t end)
+{
+	const char *text = source->text;
+	for (const char *p = text + source->indexed; (p = memchr(p, '\n', end - (size_t)(p - text))) != NULL;) {
+		p++;
+		if (source->line_count == source->line_capacity) {
+			source->line_capacity = source->line_capacity ? source->line_capacity * 2 : 256;
+			size_t *grown = realloc(source->line_starts, source->line_capacity * sizeof(size_t));
+			if (!grown) {
+				fprintf(stderr, "Memory allocation failed\n");
+				exit(1);
+			}
+			source->line_starts = grown;
+		}
+		source->line_starts[source->line_count++] = (size_t)(p - text);
+	}
+	source->indexed = end;
+}
+
+void source_position(source_t *source, size_t offset, int *line, int *column)
+{
+	if (offset > source->size)
+		offset = source->size;
+	if (offset > source->indexed)
+		index_lines(source, offset);
+
+	// Lines after the first start after a newline; count those at or
+	// before offset
+	size_t low = 0, high = source->line_count;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (source->line_starts[mid] <= offset)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	*line = (int)low + 1;
+
+	if (column) {
+		int col = 0;
+		for (size_t i = low ? source->line_starts[low - 1] : 0; i < offset; i++)
+			col = source->text[i] == '\t' ? col + 8 - col % 8 : col + 1;
+		*column = col;
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+// A whole source file in memory, scanned in place by the lexer
+// (yy_scan_buffer). Regular files are mapped privately, so nothing is
+// read or copied up front; other inputs, or all of them when map is 0,
+// are read into the heap. Either way text stays valid until
+// source_close(), and tokens may point into it.
+typedef struct {
+	char *text;  // size bytes followed by the two NULs flex needs
+	size_t size;
+	size_t mapped; // Length of the mapping, 0 when text is a heap copy
+	size_t *line_starts; // Offset of each line start found so far
+	size_t line_count;
+	size_t line_capacity;
+	size_t indexed; // Bytes already searched for line starts
+} source_t;
+
+// Returns 0 on success, -1 with errno set on failure
+int source_open(source_t *source, const char *path, int map);
+void source_close(source_t *source);
+
+// Locations are kept as byte offsets and only turned into a 1-based line
+// and a column (tabs expanded to multiples of 8) when a message needs
+// them. The line index grows on demand and never looks past offset,
+// where flex may have parked a NUL in the text. column may be NULL.
+void source_position(source_t *source, size_t offset, int *line, int *column);
+
+#endif
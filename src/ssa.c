@@ -0,0 +1,792 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ssa.h"
+#include "arena.h"
+#include "ir_text.h"
+#include "common.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { LINE_OTHER, LINE_ALLOCA, LINE_LOAD, LINE_STORE };
+
+typedef struct {
+	slice_t text; // Without the newline
+	int kind;
+	int block;
+	int var;       // Candidate allocated, loaded or stored by this line
+	int result;    // Register number of a load result (%tN)
+	slice_t value; // Stored value
+	int deleted;
+} line_t;
+
+typedef struct phi {
+	struct phi *next;
+	int var;
+	int block;
+	int temp;
+	slice_t *incoming; // One value per predecessor edge, NULL ptr for undef
+	int live;
+} phi_t;
+
+typedef struct {
+	slice_t name;   // Label, empty for an unlabeled entry block
+	int has_label;  // First line of the block is its label
+	int first, end; // Lines [first, end)
+	int *succs;
+	int succ_count;
+	int *preds;
+	int pred_count;
+	int idom; // -1 while unreachable
+	int rpo;
+	int *children;
+	int child_count;
+	int *frontier;
+	int frontier_count;
+	phi_t *phis;
+} block_t;
+
+typedef struct {
+	slice_t name;
+	slice_t type;
+	int escaped;
+	slice_t *stack; // Reaching definitions during renaming
+	int depth;
+} var_t;
+
+// Open-addressing map from names to indices
+typedef struct {
+	slice_t *keys;
+	int *values;
+	size_t cap;
+	size_t count;
+} slice_map_t;
+
+static THREAD_LOCAL arena_t ssa_arena;
+static size_t promoted_total;
+static pthread_mutex_t promoted_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static THREAD_LOCAL line_t *lines;
+static THREAD_LOCAL int line_count;
+static THREAD_LOCAL block_t *blocks;
+static THREAD_LOCAL int block_count;
+static THREAD_LOCAL var_t *vars;
+static THREAD_LOCAL int var_count;
+static THREAD_LOCAL slice_map_t var_map;
+static THREAD_LOCAL slice_map_t block_map;
+static THREAD_LOCAL slice_t *repl; // Replacement value per load register %tN, indexed by N - repl_base
+static THREAD_LOCAL int repl_base;
+static THREAD_LOCAL int repl_size;
+static THREAD_LOCAL int *push_log; // Variables pushed while renaming, for popping
+static THREAD_LOCAL int push_log_len;
+static THREAD_LOCAL int push_log_cap;
+
+static const slice_t undef_value = {"undef", 5};
+
+static int slice_eq_str(slice_t a, const char *s)
+{
+	return a.len == strlen(s) && memcmp(a.ptr, s, a.len) == 0;
+}
+
+static void map_init(slice_map_t *map, size_t expected)
+{
+	map->cap = 16;
+	while (map->cap < expected * 2)
+		map->cap *= 2;
+	map->keys = arena_calloc(&ssa_arena, map->cap, sizeof(slice_t));
+	map->values = arena_alloc(&ssa_arena, map->cap * sizeof(int));
+	map->count = 0;
+}
+
+static void map_put(slice_map_t *map, slice_t key, int value)
+{
+	size_t i = hash_slice(key) & (map->cap - 1);
+	while (map->keys[i].ptr && !slice_eq(map->keys[i], key))
+		i = (i + 1) & (map->cap - 1);
+	if (!map->keys[i].ptr)
+		map->count++;
+	map->keys[i] = key;
+	map->values[i] = value;
+}
+
+static int map_get(const slice_map_t *map, slice_t key)
+{
+	size_t i = hash_slice(key) & (map->cap - 1);
+	while (map->keys[i].ptr) {
+		if (slice_eq(map->keys[i], key))
+			return map->values[i];
+		i = (i + 1) & (map->cap - 1);
+	}
+	return -1;
+}
+
+// Register number of a "tN" name, -1 for any other name
+static int temp_number(slice_t name)
+{
+	if (name.len < 2 || name.ptr[0] != 't')
+		return -1;
+	int n = 0;
+	for (size_t i = 1; i < name.len; i++) {
+		if (name.ptr[i] < '0' || name.ptr[i] > '9')
+			return -1;
+		n = n * 10 + (name.ptr[i] - '0');
+	}
+	return n;
+}
+
+// Replacement slot of %tN, NULL for registers defined outside this function
+static slice_t *repl_slot(int n)
+{
+	return n >= repl_base && n - repl_base < repl_size ? &repl[n - repl_base] : NULL;
+}
+
+static void *grow(void *array, int count, size_t size)
+{
+	return arena_realloc(&ssa_arena, array, (size_t)(count + 1) * size);
+}
+
+static void split_lines(const char *body, size_t len)
+{
+	const char *p = body;
+	slice_t text;
+	lines = NULL;
+	line_count = 0;
+	while (next_line(&p, body + len, &text)) {
+		lines = grow(lines, line_count, sizeof(line_t));
+		line_t *line = &lines[line_count++];
+		memset(line, 0, sizeof(*line));
+		line->text = text;
+		line->var = -1;
+		line->result = -1;
+	}
+}
+
+static void split_blocks(void)
+{
+	blocks = NULL;
+	block_count = 0;
+	map_init(&block_map, (size_t)line_count / 4 + 1);
+	for (int i = 0; i < line_count; i++) {
+		int label = is_label_line(lines[i].text);
+		if (i == 0 || label) {
+			if (block_count > 0)
+				blocks[block_count - 1].end = i;
+			blocks = grow(blocks, block_count, sizeof(block_t));
+			block_t *b = &blocks[block_count];
+			memset(b, 0, sizeof(*b));
+			b->first = i;
+			b->idom = -1;
+			b->rpo = -1;
+			if (label) {
+				b->has_label = 1;
+				b->name.ptr = lines[i].text.ptr;
+				b->name.len = lines[i].text.len - 1;
+				map_put(&block_map, b->name, block_count);
+			}
+			block_count++;
+		}
+		lines[i].block = block_count - 1;
+	}
+	if (block_count > 0)
+		blocks[block_count - 1].end = line_count;
+}
+
+// Scalar types that can live in a register
+static int is_promotable_type(slice_t type)
+{
+	if (type.len == 0)
+		return 0;
+	for (size_t i = 0; i < type.len; i++) {
+		char c = type.ptr[i];
+		if (c == ' ' || c == ',' || c == '[' || c == '(' || c == '{' || c == '<')
+			return 0;
+	}
+	if (type.ptr[type.len - 1] == '*')
+		return 1;
+	if (slice_eq_str(type, "float") || slice_eq_str(type, "double"))
+		return 1;
+	return type.ptr[0] == 'i' && type.len > 1 && type.ptr[1] >= '0' && type.ptr[1] <= '9';
+}
+
+static void find_allocas(void)
+{
+	vars = NULL;
+	var_count = 0;
+	map_init(&var_map, (size_t)line_count / 8 + 1);
+	for (int i = 0; i < line_count; i++) {
+		slice_t text = lines[i].text;
+		if (!starts_with(text, "  %"))
+			continue;
+		const char *p = text.ptr + 2;
+		slice_t name;
+		if (!next_local(&p, text.ptr + text.len, &name))
+			continue;
+		static const char marker[] = " = alloca ";
+		size_t rest = (size_t)(text.ptr + text.len - p);
+		if (rest <= sizeof(marker) - 1 || memcmp(p, marker, sizeof(marker) - 1) != 0)
+			continue;
+		slice_t type = {p + sizeof(marker) - 1, rest - (sizeof(marker) - 1)};
+		if (!is_promotable_type(type))
+			continue;
+
+		vars = grow(vars, var_count, sizeof(var_t));
+		var_t *v = &vars[var_count];
+		memset(v, 0, sizeof(*v));
+		v->name = name;
+		v->type = type;
+		map_put(&var_map, name, var_count);
+		lines[i].kind = LINE_ALLOCA;
+		lines[i].var = var_count;
+		var_count++;
+	}
+}
+
+// Any mention of a candidate in [p, end) other than as a load or store
+// address lets its address escape
+static void escape_mentions(const char *p, const char *end)
+{
+	slice_t name;
+	while (next_local(&p, end, &name)) {
+		int v = map_get(&var_map, name);
+		if (v >= 0)
+			vars[v].escaped = 1;
+	}
+}
+
+// Matches "<type>* %<name>" exactly at the end of text; returns its start
+static const char *match_address(slice_t text, const var_t *v)
+{
+	size_t n = v->type.len + 3 + v->name.len;
+	if (text.len < n)
+		return NULL;
+	const char *p = text.ptr + text.len - n;
+	if (memcmp(p, v->type.ptr, v->type.len) != 0 || memcmp(p + v->type.len, "* %", 3) != 0 ||
+	    memcmp(p + v->type.len + 3, v->name.ptr, v->name.len) != 0)
+		return NULL;
+	return p;
+}
+
+static void classify_line(line_t *line)
+{
+	slice_t text = line->text;
+	const char *end = text.ptr + text.len;
+
+	if (line->kind == LINE_ALLOCA || is_label_line(text))
+		return;
+
+	// Address operand: the %name that ends the line
+	const char *q = end;
+	while (q > text.ptr && is_name_char(q[-1]))
+		q--;
+	int v = -1;
+	if (q > text.ptr && q[-1] == '%' && q < end) {
+		slice_t last = {q, (size_t)(end - q)};
+		v = map_get(&var_map, last);
+	}
+	if (v < 0 || vars[v].escaped) {
+		escape_mentions(text.ptr, end);
+		return;
+	}
+
+	var_t *var = &vars[v];
+	const char *address = match_address(text, var);
+
+	if (address && starts_with(text, "  store ")) {
+		// "  store <type> <value>, <type>* %name"
+		const char *value = text.ptr + 8 + var->type.len + 1;
+		if (value < address - 2 && memcmp(text.ptr + 8, var->type.ptr, var->type.len) == 0 &&
+		    text.ptr[8 + var->type.len] == ' ' && memcmp(address - 2, ", ", 2) == 0) {
+			line->kind = LINE_STORE;
+			line->var = v;
+			line->value.ptr = value;
+			line->value.len = (size_t)(address - 2 - value);
+			escape_mentions(value, address - 2);
+			return;
+		}
+	} else if (address && starts_with(text, "  %t")) {
+		// "  %tN = load <type>, <type>* %name"
+		const char *p = text.ptr + 2;
+		slice_t result;
+		next_local(&p, end, &result);
+		int n = temp_number(result);
+		size_t prefix = (size_t)(p - text.ptr);
+		if (repl_slot(n) && address - text.ptr == (long)(prefix + 8 + var->type.len + 2) &&
+		    memcmp(p, " = load ", 8) == 0 && memcmp(p + 8, var->type.ptr, var->type.len) == 0 &&
+		    memcmp(p + 8 + var->type.len, ", ", 2) == 0) {
+			line->kind = LINE_LOAD;
+			line->var = v;
+			line->result = n;
+			return;
+		}
+	}
+	escape_mentions(text.ptr, end);
+}
+
+static void add_edge(int from, slice_t label)
+{
+	int to = map_get(&block_map, label);
+	if (to < 0)
+		return;
+	block_t *a = &blocks[from];
+	block_t *b = &blocks[to];
+	a->succs = grow(a->succs, a->succ_count, sizeof(int));
+	a->succs[a->succ_count++] = to;
+	b->preds = grow(b->preds, b->pred_count, sizeof(int));
+	b->preds[b->pred_count++] = from;
+}
+
+static void build_cfg(void)
+{
+	for (int b = 0; b < block_count; b++) {
+		int in_switch = 0;
+		for (int i = blocks[b].first; i < blocks[b].end; i++) {
+			slice_t text = lines[i].text;
+			int terminator = starts_with(text, "  br ") || starts_with(text, "  indirectbr ");
+			if (starts_with(text, "  switch "))
+				in_switch = terminator = 1;
+			else if (in_switch)
+				terminator = 1;
+			if (in_switch && starts_with(text, "  ]"))
+				in_switch = 0;
+			if (!terminator)
+				continue;
+
+			const char *p = text.ptr;
+			const char *end = text.ptr + text.len;
+			while ((p = memchr(p, 'l', (size_t)(end - p))) != NULL) {
+				if ((size_t)(end - p) > 7 && memcmp(p, "label %", 7) == 0) {
+					const char *start = p + 7;
+					p = start;
+					while (p < end && is_name_char(*p))
+						p++;
+					slice_t label = {start, (size_t)(p - start)};
+					add_edge(b, label);
+				} else {
+					p++;
+				}
+			}
+		}
+	}
+}
+
+static int intersect(int a, int b)
+{
+	while (a != b) {
+		while (blocks[a].rpo > blocks[b].rpo)
+			a = blocks[a].idom;
+		while (blocks[b].rpo > blocks[a].rpo)
+			b = blocks[b].idom;
+	}
+	return a;
+}
+
+// Algorithm: Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+static void compute_dominators(void)
+{
+	int *order = arena_alloc(&ssa_arena, (size_t)block_count * sizeof(int));
+	int *stack = arena_alloc(&ssa_arena, (size_t)block_count * sizeof(int));
+	int *next_succ = arena_calloc(&ssa_arena, (size_t)block_count, sizeof(int));
+	int *visited = arena_calloc(&ssa_arena, (size_t)block_count, sizeof(int));
+	int count = 0;
+	int depth = 0;
+
+	// Iterative DFS for the postorder
+	stack[depth++] = 0;
+	visited[0] = 1;
+	while (depth > 0) {
+		int b = stack[depth - 1];
+		if (next_succ[b] < blocks[b].succ_count) {
+			int s = blocks[b].succs[next_succ[b]++];
+			if (!visited[s]) {
+				visited[s] = 1;
+				stack[depth++] = s;
+			}
+		} else {
+			order[count++] = b;
+			depth--;
+		}
+	}
+	// Reverse it into reverse postorder
+	for (int i = 0; i < count / 2; i++) {
+		int t = order[i];
+		order[i] = order[count - 1 - i];
+		order[count - 1 - i] = t;
+	}
+	for (int i = 0; i < count; i++)
+		blocks[order[i]].rpo = i;
+
+	blocks[0].idom = 0;
+	int changed = 1;
+	while (changed) {
+		changed = 0;
+		for (int i = 1; i < count; i++) {
+			block_t *b = &blocks[order[i]];
+			int new_idom = -1;
+			for (int j = 0; j < b->pred_count; j++) {
+				int p = b->preds[j];
+				if (blocks[p].idom < 0)
+					continue;
+				new_idom = new_idom < 0 ? p : intersect(p, new_idom);
+			}
+			if (new_idom != b->idom) {
+				b->idom = new_idom;
+				changed = 1;
+			}
+		}
+	}
+
+	for (int i = 1; i < count; i++) {
+		int b = order[i];
+		block_t *parent = &blocks[blocks[b].idom];
+		parent->children = grow(parent->children, parent->child_count, sizeof(int));
+		parent->children[parent->child_count++] = b;
+	}
+
+	for (int b = 0; b < block_count; b++) {
+		if (blocks[b].idom < 0 || blocks[b].pred_count < 2)
+			continue;
+		for (int j = 0; j < blocks[b].pred_count; j++) {
+			int runner = blocks[b].preds[j];
+			if (blocks[runner].idom < 0)
+				continue;
+			while (runner != blocks[b].idom) {
+				block_t *r = &blocks[runner];
+				if (r->frontier_count == 0 || r->frontier[r->frontier_count - 1] != b) {
+					r->frontier = grow(r->frontier, r->frontier_count, sizeof(int));
+					r->frontier[r->frontier_count++] = b;
+				}
+				runner = r->idom;
+			}
+		}
+	}
+}
+
+static void place_phis(int *temp_counter)
+{
+	int *has_phi = arena_alloc(&ssa_arena, (size_t)block_count * sizeof(int));
+	int *queued = arena_alloc(&ssa_arena, (size_t)block_count * sizeof(int));
+	int *worklist = arena_alloc(&ssa_arena, (size_t)block_count * sizeof(int));
+	for (int b = 0; b < block_count; b++)
+		has_phi[b] = queued[b] = -1;
+
+	for (int v = 0; v < var_count; v++) {
+		if (vars[v].escaped)
+			continue;
+		int count = 0;
+		for (int i = 0; i < line_count; i++) {
+			if (lines[i].kind != LINE_STORE || lines[i].var != v)
+				continue;
+			int b = lines[i].block;
+			if (blocks[b].idom >= 0 && queued[b] != v) {
+				queued[b] = v;
+				worklist[count++] = b;
+			}
+		}
+		while (count > 0) {
+			block_t *b = &blocks[worklist[--count]];
+			for (int k = 0; k < b->frontier_count; k++) {
+				int f = b->frontier[k];
+				if (has_phi[f] == v)
+					continue;
+				has_phi[f] = v;
+				phi_t *phi = arena_calloc(&ssa_arena, 1, sizeof(phi_t));
+				phi->var = v;
+				phi->block = f;
+				phi->temp = ++*temp_counter;
+				phi->incoming = arena_calloc(&ssa_arena, (size_t)blocks[f].pred_count, sizeof(slice_t));
+				phi->next = blocks[f].phis;
+				blocks[f].phis = phi;
+				if (queued[f] != v) {
+					queued[f] = v;
+					worklist[count++] = f;
+				}
+			}
+		}
+	}
+}
+
+static slice_t temp_slice(int n)
+{
+	char buf[24];
+	int len = snprintf(buf, sizeof(buf), "%%t%d", n);
+	slice_t s = {arena_strndup(&ssa_arena, buf, (size_t)len), (size_t)len};
+	return s;
+}
+
+static void push_value(int v, slice_t value)
+{
+	var_t *var = &vars[v];
+	var->stack = grow(var->stack, var->depth, sizeof(slice_t));
+	var->stack[var->depth++] = value;
+	if (push_log_len == push_log_cap) {
+		push_log_cap = push_log_cap ? push_log_cap * 2 : 64;
+		push_log = arena_realloc(&ssa_arena, push_log, (size_t)push_log_cap * sizeof(int));
+	}
+	push_log[push_log_len++] = v;
+}
+
+static slice_t current_value(int v)
+{
+	return vars[v].depth > 0 ? vars[v].stack[vars[v].depth - 1] : undef_value;
+}
+
+// A stored value may itself be a load that has been replaced
+static slice_t resolve(slice_t value)
+{
+	if (value.len > 2 && value.ptr[0] == '%') {
+		slice_t name = {value.ptr + 1, value.len - 1};
+		int n = temp_number(name);
+		slice_t *slot = repl_slot(n);
+		if (slot && slot->ptr)
+			return *slot;
+	}
+	return value;
+}
+
+static void rename_block(int b)
+{
+	block_t *block = &blocks[b];
+
+	for (phi_t *phi = block->phis; phi; phi = phi->next)
+		push_value(phi->var, temp_slice(phi->temp));
+
+	for (int i = block->first; i < block->end; i++) {
+		line_t *line = &lines[i];
+		if (line->var < 0 || vars[line->var].escaped)
+			continue;
+		if (line->kind == LINE_LOAD) {
+			*repl_slot(line->result) = current_value(line->var);
+		} else if (line->kind == LINE_STORE) {
+			push_value(line->var, resolve(line->value));
+		}
+		line->deleted = 1;
+	}
+
+	for (int k = 0; k < block->succ_count; k++) {
+		block_t *succ = &blocks[block->succs[k]];
+		for (phi_t *phi = succ->phis; phi; phi = phi->next) {
+			for (int j = 0; j < succ->pred_count; j++) {
+				if (succ->preds[j] == b)
+					phi->incoming[j] = current_value(phi->var);
+			}
+		}
+	}
+}
+
+// Iterative preorder walk of the dominator tree: each frame remembers the
+// push_log mark taken before its block, popped back once its children are done
+static void rename_tree(void)
+{
+	typedef struct {
+		int block;
+		int next_child;
+		int mark;
+	} frame_t;
+	frame_t *stack = arena_alloc(&ssa_arena, (size_t)block_count * sizeof(frame_t));
+	int depth = 0;
+
+	stack[depth++] = (frame_t){0, 0, push_log_len};
+	rename_block(0);
+	while (depth > 0) {
+		frame_t *top = &stack[depth - 1];
+		block_t *block = &blocks[top->block];
+		if (top->next_child < block->child_count) {
+			int child = block->children[top->next_child++];
+			stack[depth++] = (frame_t){child, 0, push_log_len};
+			rename_block(child);
+		} else {
+			while (push_log_len > top->mark)
+				vars[push_log[--push_log_len]].depth--;
+			depth--;
+		}
+	}
+}
+
+static THREAD_LOCAL phi_t **phi_by_temp;
+static THREAD_LOCAL int phi_base;
+static THREAD_LOCAL int phi_limit;
+
+static phi_t *phi_of(slice_t value)
+{
+	if (value.len < 3 || value.ptr[0] != '%')
+		return NULL;
+	slice_t name = {value.ptr + 1, value.len - 1};
+	int n = temp_number(name);
+	if (n < phi_base || n >= phi_limit)
+		return NULL;
+	return phi_by_temp[n - phi_base];
+}
+
+// Drops phis whose values are never used
+static void mark_live_phis(void)
+{
+	phi_t **worklist = NULL;
+	int count = 0;
+
+	for (int i = 0; i < line_count; i++) {
+		if (lines[i].deleted)
+			continue;
+		const char *p = lines[i].text.ptr;
+		const char *end = p + lines[i].text.len;
+		slice_t name;
+		while (next_local(&p, end, &name)) {
+			int n = temp_number(name);
+			slice_t value = {name.ptr - 1, name.len + 1};
+			slice_t *slot = repl_slot(n);
+			if (slot && slot->ptr)
+				value = *slot;
+			phi_t *phi = phi_of(value);
+			if (phi && !phi->live) {
+				phi->live = 1;
+				worklist = grow(worklist, count, sizeof(phi_t *));
+				worklist[count++] = phi;
+			}
+		}
+	}
+	while (count > 0) {
+		phi_t *phi = worklist[--count];
+		int b = phi->block;
+		for (int j = 0; j < blocks[b].pred_count; j++) {
+			phi_t *used = phi_of(phi->incoming[j]);
+			if (used && !used->live) {
+				used->live = 1;
+				worklist = grow(worklist, count, sizeof(phi_t *));
+				worklist[count++] = used;
+			}
+		}
+	}
+}
+
+static void write_line(ir_writer_t *out, slice_t text)
+{
+	const char *p = text.ptr;
+	const char *end = text.ptr + text.len;
+	const char *written = p;
+	slice_t name;
+
+	while (next_local(&p, end, &name)) {
+		int n = temp_number(name);
+		slice_t *slot = repl_slot(n);
+		if (!slot || !slot->ptr)
+			continue;
+		ir_putn(out, written, (size_t)(name.ptr - 1 - written));
+		ir_putn(out, slot->ptr, slot->len);
+		written = p;
+	}
+	ir_putn(out, written, (size_t)(end - written));
+	ir_putc(out, '\n');
+}
+
+static void write_body(ir_writer_t *out)
+{
+	// The entry block needs a name once a phi refers to it
+	slice_t entry_name = {"entry", 5};
+	if (map_get(&block_map, entry_name) >= 0)
+		entry_name = (slice_t){"entry.ssa", 9};
+	int entry_used = 0;
+	for (int b = 0; b < block_count && !blocks[0].has_label; b++) {
+		for (phi_t *phi = blocks[b].phis; phi; phi = phi->next) {
+			for (int j = 0; j < blocks[b].pred_count; j++)
+				entry_used |= phi->live && blocks[b].preds[j] == 0;
+		}
+	}
+	if (entry_used) {
+		blocks[0].name = entry_name;
+		ir_putn(out, entry_name.ptr, entry_name.len);
+		ir_putn(out, ":\n", 2);
+	}
+
+	for (int b = 0; b < block_count; b++) {
+		block_t *block = &blocks[b];
+		int i = block->first;
+		if (block->has_label)
+			write_line(out, lines[i++].text);
+
+		for (phi_t *phi = block->phis; phi; phi = phi->next) {
+			if (!phi->live)
+				continue;
+			const var_t *var = &vars[phi->var];
+			ir_puts(out, "  ");
+			ir_temp(out, phi->temp);
+			ir_puts(out, " = phi ");
+			ir_putn(out, var->type.ptr, var->type.len);
+			for (int j = 0; j < block->pred_count; j++) {
+				slice_t value = phi->incoming[j].ptr ? phi->incoming[j] : undef_value;
+				ir_puts(out, j > 0 ? ", [ " : " [ ");
+				ir_putn(out, value.ptr, value.len);
+				ir_puts(out, ", %");
+				ir_putn(out, blocks[block->preds[j]].name.ptr, blocks[block->preds[j]].name.len);
+				ir_puts(out, " ]");
+			}
+			ir_putc(out, '\n');
+		}
+
+		for (; i < block->end; i++) {
+			if (!lines[i].deleted)
+				write_line(out, lines[i].text);
+		}
+	}
+}
+
+void ssa_promote_function(const char *body, size_t len, ir_writer_t *out, int first_temp, int *temp_counter)
+{
+	repl_base = first_temp;
+	repl_size = *temp_counter - first_temp + 1;
+	repl = arena_calloc(&ssa_arena, (size_t)repl_size, sizeof(slice_t));
+	push_log = NULL;
+	push_log_len = push_log_cap = 0;
+
+	split_lines(body, len);
+	find_allocas();
+	if (var_count == 0 || line_count == 0) {
+		ir_putn(out, body, len);
+		arena_release(&ssa_arena);
+		return;
+	}
+	split_blocks();
+	for (int i = 0; i < line_count; i++)
+		classify_line(&lines[i]);
+	build_cfg();
+	compute_dominators();
+
+	phi_base = *temp_counter + 1;
+	place_phis(temp_counter);
+	phi_limit = *temp_counter + 1;
+	phi_by_temp = arena_calloc(&ssa_arena, (size_t)(phi_limit - phi_base) + 1, sizeof(phi_t *));
+	for (int b = 0; b < block_count; b++) {
+		for (phi_t *phi = blocks[b].phis; phi; phi = phi->next)
+			phi_by_temp[phi->temp - phi_base] = phi;
+	}
+
+	rename_tree();
+
+	// Unreachable blocks are kept as they are, minus the promoted memory
+	for (int b = 0; b < block_count; b++) {
+		if (blocks[b].idom >= 0)
+			continue;
+		for (int i = blocks[b].first; i < blocks[b].end; i++) {
+			line_t *line = &lines[i];
+			if (line->var < 0 || vars[line->var].escaped)
+				continue;
+			if (line->kind == LINE_LOAD)
+				*repl_slot(line->result) = undef_value;
+			line->deleted = 1;
+		}
+	}
+
+	size_t promoted = 0;
+	for (int v = 0; v < var_count; v++)
+		promoted += !vars[v].escaped;
+	pthread_mutex_lock(&promoted_lock);
+	promoted_total += promoted;
+	pthread_mutex_unlock(&promoted_lock);
+
+	mark_live_phis();
+	write_body(out);
+	arena_release(&ssa_arena);
+}
+
+size_t ssa_promoted_count(void)
+{
+	return promoted_total;
+}
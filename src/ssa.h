@@ -0,0 +1,17 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "ir_writer.h"
+
+// Promotes the scalar allocas of one function body to SSA registers
+// (mem2reg). body holds the text between the "define" line and the closing
+// brace. Allocas whose address never escapes a plain load or store are
+// removed, their loads are replaced by the reaching value and phis are
+// placed at dominance frontiers. The rewritten body is appended to out.
+// The body's own registers are numbered above first_temp; new ones are
+// numbered from *temp_counter.
+void ssa_promote_function(const char *body, size_t len, ir_writer_t *out, int first_temp, int *temp_counter);
+
+size_t ssa_promoted_count(void);
+
+#endif
@@ -1,5 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
 #include "symbol_table.h"
+#include "intern.h"
+#include "common.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,26 +25,11 @@
 #define BOOL_SIZE 1
 #define BOOL_ALIGN 1
 
-// Utility function for string duplication
-static inline char *string_duplicate(const char *str)
-{
-	if (!str)
-		return NULL;
-	size_t len = strlen(str) + 1;
-	char *copy = malloc(len);
-	if (!copy) {
-		fprintf(stderr, "Memory allocation failed\n");
-		exit(1);
-	}
-	strcpy(copy, str);
-	return copy;
-}
-
-// Deep copy function for type_info_t with proper memory management
+// Copy of a type_info_t; the base type name is immutable and shared
 type_info_t deep_copy_type_info(const type_info_t *src)
 {
 	type_info_t result;
-	result.base_type = src->base_type ? string_duplicate(src->base_type) : NULL;
+	result.base_type = src->base_type;
 	result.pointer_level = src->pointer_level;
 	result.is_array = src->is_array;
 	result.is_vla = src->is_vla;
@@ -53,59 +40,76 @@ type_info_t deep_copy_type_info(const type_info_t *src)
 	result.is_incomplete = src->is_incomplete;
 	result.storage_class = src->storage_class;
 	result.qualifiers = src->qualifiers;
+	result.pointer_qualifiers = src->pointer_qualifiers;
 	result.array_size = src->array_size;
 	result.param_types = NULL;
 	result.param_count = src->param_count;
 	result.is_variadic = src->is_variadic;
+	result.is_inline = src->is_inline;
 	return result;
 }
 
-size_t symbol_table_hash(const char *src)
-{
-	// Algorithm: djb2a hash function
-	size_t hash = 5381; // Magic constant: fewer collisions and better avalanche effect, apparently
-	char c;
-	while ((c = *src++))
-		hash = ((hash << 5) + hash) ^ c; // hash * 33 ^ c
-	return hash;
-}
-
-/*
-    size_t symbol_table_nhash(const char *src, size_t len)
-    {
-        // Algorithm: djb2a hash function
-        size_t hash = 5381;
-        for (size_t i = 0; i < len; i++)
-            hash = ((hash << 5) + hash) ^ src[i]; // hash * 33 ^ src[i]
-        return hash;
-    }
-*/
-
 // Alignment calculation helper
 static inline size_t align_to(size_t size, size_t alignment)
 {
 	return (size + alignment - 1) & ~(alignment - 1);
 }
 
-static inline scope_t *allocate_scope(int level, scope_t *parent)
+static inline scope_t *allocate_scope(symbol_table_t *table, int level, scope_t *parent)
 {
-	scope_t *s = malloc(sizeof(scope_t));
-	if (!s) {
-		fprintf(stderr, "Failed scope alloc\n");
-		exit(1);
-	}
-	s->bucket_count = SCOPE_BUCKETS;
-	s->buckets = calloc(s->bucket_count, sizeof(symbol_t *));
-	if (!s->buckets) {
-		fprintf(stderr, "Failed buckets alloc\n");
-		exit(1);
+	scope_t *s = table->free_scopes;
+	if (s) {
+		table->free_scopes = s->parent;
+	} else {
+		s = malloc(sizeof(scope_t));
+		if (!s) {
+			fprintf(stderr, "Failed scope alloc\n");
+			exit(1);
+		}
 	}
+	s->list = NULL;
+	s->buckets = &s->list;
+	s->bucket_count = 1;
 	s->symbol_count = 0;
 	s->level = level;
 	s->parent = parent;
 	return s;
 }
 
+// Hand an emptied scope back to the table for the next enter_scope()
+static inline void release_scope(symbol_table_t *table, scope_t *scope)
+{
+	if (scope->buckets != &scope->list)
+		free(scope->buckets);
+	scope->parent = table->free_scopes;
+	table->free_scopes = scope;
+}
+
+// Rehash into twice the buckets (SCOPE_BUCKETS for a scope still on its list)
+static void grow_scope(scope_t *scope)
+{
+	size_t bucket_count = scope->bucket_count == 1 ? SCOPE_BUCKETS : scope->bucket_count * 2;
+	symbol_t **buckets = calloc(bucket_count, sizeof(symbol_t *));
+	if (!buckets) {
+		fprintf(stderr, "Failed buckets alloc\n");
+		exit(1);
+	}
+	for (size_t i = 0; i < scope->bucket_count; i++) {
+		symbol_t *sym = scope->buckets[i];
+		while (sym) {
+			symbol_t *next = sym->next;
+			size_t idx = interned_hash(sym->name) & (bucket_count - 1);
+			sym->next = buckets[idx];
+			buckets[idx] = sym;
+			sym = next;
+		}
+	}
+	if (scope->buckets != &scope->list)
+		free(scope->buckets);
+	scope->buckets = buckets;
+	scope->bucket_count = bucket_count;
+}
+
 // Create a new symbol table
 symbol_table_t *create_symbol_table(void)
 {
@@ -115,15 +119,39 @@ symbol_table_t *create_symbol_table(void)
 		exit(1);
 	}
 
+	table->free_scopes = NULL;
+
 	// Create global scope
-	table->global_scope = allocate_scope(0, NULL);
-	table->global_scope->level = 0;
-	table->global_scope->parent = NULL;
+	table->global_scope = allocate_scope(table, 0, NULL);
 
 	table->current_scope = table->global_scope;
 	table->scope_counter = 0;
 	table->temp_counter = 0;
 	table->current_function = NULL;
+	table->retain_symbols = 0;
+	table->retained = NULL;
+
+	return table;
+}
+
+// Symbol table for one function body. Its global scope is borrowed from
+// parent and must not be modified while other function tables share it.
+symbol_table_t *create_function_symbol_table(symbol_table_t *parent)
+{
+	symbol_table_t *table = malloc(sizeof(symbol_table_t));
+	if (!table) {
+		fprintf(stderr, "Failed to allocate symbol table\n");
+		exit(1);
+	}
+
+	table->global_scope = parent->global_scope;
+	table->current_scope = parent->global_scope;
+	table->scope_counter = 0;
+	table->temp_counter = 0;
+	table->current_function = NULL;
+	table->retain_symbols = 0;
+	table->retained = NULL;
+	table->free_scopes = NULL;
 
 	return table;
 }
@@ -134,7 +162,6 @@ void free_symbol(symbol_t *sym)
 	if (!sym)
 		return;
 
-	free(sym->name);
 	free(sym->llvm_name);
 	free_type_info(&sym->type_info);
 
@@ -148,6 +175,7 @@ void free_symbol(symbol_t *sym)
 		free(sym->members);
 	}
 
+	free(sym->param_symbols);
 	free(sym->label_name);
 	free(sym);
 }
@@ -164,20 +192,43 @@ void free_symbol(symbol_t *sym)
     }
 */
 
-static inline void free_scope(scope_t *scope)
+static void free_symbol_list(symbol_t *sym)
+{
+	while (sym) {
+		symbol_t *next = sym->next;
+		free_symbol(sym);
+		sym = next;
+	}
+}
+
+static inline void free_scope_symbols(scope_t *scope)
+{
+	for (size_t i = 0; i < scope->bucket_count; i++)
+		free_symbol_list(scope->buckets[i]);
+}
+
+// Keep the scope's symbols, which AST nodes may still point to, on the
+// table's retained list
+static void retain_scope_symbols(symbol_table_t *table, scope_t *scope)
 {
-	if (!scope)
-		return;
 	for (size_t i = 0; i < scope->bucket_count; i++) {
 		symbol_t *sym = scope->buckets[i];
 		while (sym) {
 			symbol_t *next = sym->next;
-			free_symbol(sym);
+			sym->next = table->retained;
+			table->retained = sym;
 			sym = next;
 		}
 	}
-	free(scope->buckets);
-	free(scope);
+}
+
+static void free_scope_pool(symbol_table_t *table)
+{
+	while (table->free_scopes) {
+		scope_t *next = table->free_scopes->parent;
+		free(table->free_scopes);
+		table->free_scopes = next;
+	}
 }
 
 // Destroy symbol table and free all memory
@@ -192,16 +243,35 @@ void destroy_symbol_table(symbol_table_t *table)
 	}
 
 	// Clean up global scope
-	free_scope(table->global_scope);
+	free_scope_symbols(table->global_scope);
+	release_scope(table, table->global_scope);
+	free_scope_pool(table);
+	free_symbol_list(table->retained);
 
 	free(table->current_function);
 	free(table);
 }
 
+// Like destroy_symbol_table, but leaves the borrowed global scope alone
+void destroy_function_symbol_table(symbol_table_t *table)
+{
+	if (!table)
+		return;
+
+	while (table->current_scope != table->global_scope) {
+		exit_scope(table);
+	}
+
+	free_scope_pool(table);
+	free_symbol_list(table->retained);
+	free(table->current_function);
+	free(table);
+}
+
 // Enter a new scope
 void enter_scope(symbol_table_t *table)
 {
-	scope_t *new_scope = allocate_scope(++table->scope_counter, table->current_scope);
+	scope_t *new_scope = allocate_scope(table, ++table->scope_counter, table->current_scope);
 	table->current_scope = new_scope;
 }
 
@@ -216,8 +286,12 @@ void exit_scope(symbol_table_t *table)
 	table->current_scope = old_scope->parent;
 	table->scope_counter--;
 
-	// Free all symbols in the exiting scope
-	free_scope(old_scope);
+	// Free all symbols in the exiting scope, unless they are retained
+	if (table->retain_symbols)
+		retain_scope_symbols(table, old_scope);
+	else
+		free_scope_symbols(old_scope);
+	release_scope(table, old_scope);
 }
 
 // Calculate size of a basic type
@@ -461,7 +535,7 @@ symbol_t *create_symbol(const char *name, symbol_type_t sym_type, type_info_t ty
 		exit(1);
 	}
 
-	sym->name = string_duplicate(name);
+	sym->name = intern_string(name);
 	sym->llvm_name = NULL; // Will be set when added to table
 	sym->sym_type = sym_type;
 	sym->type_info = deep_copy_type_info(&type_info); // Make a deep copy
@@ -523,20 +597,21 @@ char *generate_unique_name(symbol_table_t *table, const char *base_name)
 // Add symbol to current scope
 symbol_t *add_symbol(symbol_table_t *table, const char *name, symbol_type_t sym_type, type_info_t type_info)
 {
-	size_t h = symbol_table_hash(name);
-	size_t idx = h % table->current_scope->bucket_count;
+	const char *key = intern_string(name);
+	scope_t *scope = table->current_scope;
+	size_t idx = interned_hash(key) & (scope->bucket_count - 1);
 
 	// Check if symbol already exists in current scope
-	symbol_t *cur = table->current_scope->buckets[idx];
+	symbol_t *cur = scope->buckets[idx];
 	while (cur) {
-		if (strcmp(cur->name, name) == 0) {
+		if (cur->name == key) {
 			fprintf(stderr, "Symbol '%s' already defined in scope %d\n", name, table->current_scope->level);
 			return NULL;
 		}
 		cur = cur->next;
 	}
 
-	symbol_t *sym = create_symbol(name, sym_type, type_info);
+	symbol_t *sym = create_symbol(key, sym_type, type_info);
 	sym->scope_level = table->current_scope->level;
 	sym->is_global = (table->current_scope == table->global_scope);
 
@@ -553,21 +628,54 @@ symbol_t *add_symbol(symbol_table_t *table, const char *name, symbol_type_t sym_
 		sym->alignment = calculate_type_alignment(&sym->type_info, table);
 	}
 
-	// Push forward into the bucket list
-	sym->next = table->current_scope->buckets[idx];
-	table->current_scope->buckets[idx] = sym;
-	table->current_scope->symbol_count++;
+	// Push forward into the bucket list, hashing a full list first
+	if (scope->symbol_count >= (scope->bucket_count == 1 ? SCOPE_LIST_LIMIT : scope->bucket_count)) {
+		grow_scope(scope);
+		idx = interned_hash(key) & (scope->bucket_count - 1);
+	}
+	sym->next = scope->buckets[idx];
+	scope->buckets[idx] = sym;
+	scope->symbol_count++;
 
 	return sym;
 }
 
+// Bucket walk for an interned name: pointer compares only
+static inline symbol_t *lookup_in_scope(scope_t *scope, const char *key, size_t hash)
+{
+	symbol_t *sym = scope->buckets[hash & (scope->bucket_count - 1)];
+
+	while (sym) {
+		if (sym->name == key) {
+			return sym;
+		}
+		sym = sym->next;
+	}
+
+	return NULL;
+}
+
 // Find symbol by name (search all scopes from current to global)
 symbol_t *find_symbol(symbol_table_t *table, const char *name)
 {
+	// A name that was never interned cannot have been declared
+	const char *key = intern_lookup(name);
+	if (!key)
+		return NULL;
+	return find_symbol_interned(table, key);
+}
+
+// Same as find_symbol for a name that is already interned (AST identifiers)
+symbol_t *find_symbol_interned(symbol_table_t *table, const char *name)
+{
+	if (!name)
+		return NULL;
+
+	size_t h = interned_hash(name);
 	scope_t *scope = table->current_scope;
 
 	while (scope) {
-		symbol_t *sym = find_symbol_in_scope(scope, name);
+		symbol_t *sym = lookup_in_scope(scope, name, h);
 		if (sym) {
 			return sym;
 		}
@@ -580,18 +688,10 @@ symbol_t *find_symbol(symbol_table_t *table, const char *name)
 // Find symbol in specific scope
 symbol_t *find_symbol_in_scope(scope_t *scope, const char *name)
 {
-	size_t h = symbol_table_hash(name);
-	size_t idx = h % scope->bucket_count;
-	symbol_t *sym = scope->buckets[idx];
-
-	while (sym) {
-		if (strcmp(sym->name, name) == 0) {
-			return sym;
-		}
-		sym = sym->next;
-	}
-
-	return NULL;
+	const char *key = intern_lookup(name);
+	if (!key)
+		return NULL;
+	return lookup_in_scope(scope, key, interned_hash(key));
 }
 
 // Add member to struct/union
@@ -622,8 +722,12 @@ symbol_t *find_struct_member(symbol_t *struct_sym, const char *member_name)
 		return NULL;
 	}
 
+	const char *key = intern_lookup(member_name);
+	if (!key)
+		return NULL;
+
 	for (int i = 0; i < struct_sym->member_count; i++) {
-		if (strcmp(struct_sym->members[i]->name, member_name) == 0) {
+		if (struct_sym->members[i]->name == key) {
 			return struct_sym->members[i];
 		}
 	}
@@ -644,7 +748,7 @@ void calculate_struct_offsets(symbol_t *struct_sym)
 // Add enum constant
 symbol_t *add_enum_constant(symbol_table_t *table, const char *name, int value)
 {
-	type_info_t enum_type = create_type_info(string_duplicate("int"), 0, 0, NULL);
+	type_info_t enum_type = create_type_info("int", 0, 0, NULL);
 	symbol_t *sym = add_symbol(table, name, SYM_ENUM_CONSTANT, enum_type);
 	if (sym) {
 		sym->enum_value = value;
@@ -674,7 +778,7 @@ symbol_t *get_current_function(symbol_table_t *table)
 // Add label
 symbol_t *add_label(symbol_table_t *table, const char *label_name)
 {
-	type_info_t void_type = create_type_info(string_duplicate("void"), 0, 0, NULL);
+	type_info_t void_type = create_type_info("void", 0, 0, NULL);
 	symbol_t *sym = add_symbol(table, label_name, SYM_LABEL, void_type);
 	if (sym) {
 		sym->label_name = string_duplicate(label_name);
@@ -688,13 +792,16 @@ symbol_t *add_label(symbol_table_t *table, const char *label_name)
 symbol_t *find_label(symbol_table_t *table, const char *label_name)
 {
 	// Labels have function scope, so search all scopes in current function
+	const char *key = intern_lookup(label_name);
+	if (!key)
+		return NULL;
 	scope_t *scope = table->current_scope;
 
 	while (scope) {
 		for (size_t i = 0; i < scope->bucket_count; i++) {
 			symbol_t *sym = scope->buckets[i];
 			while (sym) {
-				if (sym->sym_type == SYM_LABEL && strcmp(sym->name, label_name) == 0) {
+				if (sym->sym_type == SYM_LABEL && sym->name == key) {
 					return sym;
 				}
 				sym = sym->next;
@@ -737,35 +844,67 @@ int is_compatible_type(type_info_t *type1, type_info_t *type2)
 	return 1;
 }
 
-// Get expression type (returns a deep copy that must be freed)
-// Get expression type (returns a deep copy that must be freed)
+// Unsigned after the integer promotions: unsigned int or unsigned long,
+// but not the unsigned types narrower than int
+static int promotes_to_unsigned(const type_info_t *type)
+{
+	return type->pointer_level == 0 && !type->is_array && type->base_type &&
+	       strstr(type->base_type, "unsigned") && !strstr(type->base_type, "char") &&
+	       !strstr(type->base_type, "short");
+}
+
+static int is_long_type(const type_info_t *type)
+{
+	return type->pointer_level == 0 && !type->is_array && type->base_type && strstr(type->base_type, "long");
+}
+
+// Whether the usual arithmetic conversions of two operands give an
+// unsigned type. long holds every unsigned int, so it stays signed.
+int is_unsigned_arithmetic(const type_info_t *left, const type_info_t *right)
+{
+	int signed_long = (is_long_type(left) && !promotes_to_unsigned(left)) ||
+			  (is_long_type(right) && !promotes_to_unsigned(right));
+	int unsigned_long = (is_long_type(left) && promotes_to_unsigned(left)) ||
+			    (is_long_type(right) && promotes_to_unsigned(right));
+	return unsigned_long || (!signed_long && (promotes_to_unsigned(left) || promotes_to_unsigned(right)));
+}
+
+// Get expression type. Nodes typed by check_types() answer with a shallow
+// copy of their memoized type; the strings of any result belong to the
+// interner or the AST, so callers do not own it and free_type_info() on it
+// only clears the copy.
 type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 {
 	if (!expr) {
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
+	}
+	if (expr->expr_type) {
+		return *expr->expr_type;
 	}
 
 	switch (expr->type) {
 	case AST_NUMBER:
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 
 	case AST_CHARACTER:
-		return create_type_info(string_duplicate("char"), 0, 0, NULL);
+		return create_type_info("char", 0, 0, NULL);
 
 	case AST_STRING_LITERAL:
-		return create_type_info(string_duplicate("char"), 1, 0, NULL);
+		return create_type_info("char", 1, 0, NULL);
 
 	case AST_IDENTIFIER: {
-		symbol_t *sym = find_symbol(table, expr->data.identifier.name);
+		symbol_t *sym = expr->data.identifier.symbol;
+		if (!sym)
+			sym = find_symbol_interned(table, expr->data.identifier.name);
 		if (sym) {
 			return deep_copy_type_info(&sym->type_info);
 		}
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 
 	case AST_BINARY_OP:
 		if (expr->data.binary_op.op >= OP_EQ && expr->data.binary_op.op <= OP_GE) {
-			return create_type_info(string_duplicate("_Bool"), 0, 0, NULL);
+			return create_type_info("_Bool", 0, 0, NULL);
 		}
 
 		type_info_t left_type = get_expression_type(expr->data.binary_op.left, table);
@@ -810,17 +949,25 @@ type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 			    (right_type.pointer_level > 0 || right_type.is_array)) {
 				free_type_info(&left_type);
 				free_type_info(&right_type);
-				return create_type_info(string_duplicate("long"), 0, 0, NULL);
+				return create_type_info("long", 0, 0, NULL);
 			}
 		}
 
+		// Arithmetic is computed in i32, so a result converted to unsigned
+		// long is typed unsigned int
+		int is_unsigned = 0;
+		binary_op_t op = expr->data.binary_op.op;
+		if (op == OP_LSHIFT || op == OP_RSHIFT)
+			is_unsigned = is_unsigned_arithmetic(&left_type, &left_type);
+		else if (op != OP_LAND && op != OP_LOR)
+			is_unsigned = is_unsigned_arithmetic(&left_type, &right_type);
 		free_type_info(&left_type);
 		free_type_info(&right_type);
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info(is_unsigned ? "unsigned int" : "int", 0, 0, NULL);
 
 	case AST_UNARY_OP:
 		if (expr->data.unary_op.op == OP_NOT) {
-			return create_type_info(string_duplicate("_Bool"), 0, 0, NULL);
+			return create_type_info("_Bool", 0, 0, NULL);
 		} else {
 			return get_expression_type(expr->data.unary_op.operand, table);
 		}
@@ -840,11 +987,13 @@ type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 	}
 
 	case AST_CALL: {
-		symbol_t *func_sym = find_symbol(table, expr->data.call.name);
+		symbol_t *func_sym = expr->data.call.symbol;
+		if (!func_sym)
+			func_sym = find_symbol_interned(table, expr->data.call.name);
 		if (func_sym) {
 			return deep_copy_type_info(&func_sym->type_info);
 		}
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 
 	case AST_ARRAY_ACCESS: {
@@ -864,7 +1013,7 @@ type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 		if (struct_type.pointer_level > 0) {
 			fprintf(stderr, "Error: Use '->' for pointer member access, not '.'\n");
 			free_type_info(&struct_type);
-			return create_type_info(string_duplicate("int"), 0, 0, NULL);
+			return create_type_info("int", 0, 0, NULL);
 		}
 
 		symbol_t *struct_sym = find_symbol(table, struct_type.base_type);
@@ -876,7 +1025,7 @@ type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 			}
 		}
 		free_type_info(&struct_type);
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 
 	case AST_CAST:
@@ -889,7 +1038,7 @@ type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 		if (is_floating_type(&then_type) || is_floating_type(&else_type)) {
 			free_type_info(&then_type);
 			free_type_info(&else_type);
-			return create_type_info(string_duplicate("double"), 0, 0, NULL);
+			return create_type_info("double", 0, 0, NULL);
 		}
 
 		if (is_compatible_type(&then_type, &else_type)) {
@@ -899,11 +1048,11 @@ type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 
 		free_type_info(&then_type);
 		free_type_info(&else_type);
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 
 	case AST_SIZEOF:
-		return create_type_info(string_duplicate("size_t"), 0, 0, NULL);
+		return create_type_info("size_t", 0, 0, NULL);
 
 	case AST_PTR_MEMBER_ACCESS: {
 		type_info_t ptr_type = get_expression_type(expr->data.ptr_member_access.object, table);
@@ -921,17 +1070,17 @@ type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table)
 			}
 		}
 		free_type_info(&ptr_type);
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 
 	case AST_INITIALIZER_LIST:
 		if (expr->data.initializer_list.count > 0) {
 			return get_expression_type(expr->data.initializer_list.values[0], table);
 		}
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 
 	default:
-		return create_type_info(string_duplicate("int"), 0, 0, NULL);
+		return create_type_info("int", 0, 0, NULL);
 	}
 }
 
@@ -3,7 +3,11 @@
 
 #include "ast.h"
 
-#define SCOPE_BUCKETS 256
+// A scope keeps its symbols on one chain until it holds SCOPE_LIST_LIMIT of
+// them, then hashes them into SCOPE_BUCKETS buckets, doubling as it fills.
+// Most block scopes hold a few names and never allocate buckets.
+#define SCOPE_LIST_LIMIT 8
+#define SCOPE_BUCKETS 32
 
 // Symbol types
 typedef enum symbol_type {
@@ -19,7 +23,7 @@ typedef enum symbol_type {
 
 // Symbol table entry with complete information
 typedef struct symbol {
-	char *name;
+	const char *name; // Interned, compare with ==
 	char *llvm_name;
 	symbol_type_t sym_type;
 	type_info_t type_info;
@@ -69,8 +73,9 @@ typedef struct symbol {
 
 // Scope management
 typedef struct scope {
-	symbol_t **buckets;
-	size_t bucket_count; // normally SCOPE_BUCKETS
+	symbol_t **buckets;  // &list while the scope is small
+	size_t bucket_count; // 1 while small, else a power of two >= SCOPE_BUCKETS
+	symbol_t *list;
 	size_t symbol_count;
 	int level;
 	struct scope *parent;
@@ -83,11 +88,16 @@ typedef struct symbol_table {
 	int scope_counter;
 	int temp_counter;
 	char *current_function;
+	int retain_symbols; // exit_scope() keeps the symbols of the scopes it leaves
+	symbol_t *retained; // ...chained here until the table is destroyed
+	scope_t *free_scopes; // Exited scopes, reused by enter_scope()
 } symbol_table_t;
 
 // Main symbol table functions
 symbol_table_t *create_symbol_table(void);
 void destroy_symbol_table(symbol_table_t *table);
+symbol_table_t *create_function_symbol_table(symbol_table_t *parent);
+void destroy_function_symbol_table(symbol_table_t *table);
 
 // Scope management
 void enter_scope(symbol_table_t *table);
@@ -97,6 +107,7 @@ void exit_scope(symbol_table_t *table);
 symbol_t *create_symbol(const char *name, symbol_type_t sym_type, type_info_t type_info);
 symbol_t *add_symbol(symbol_table_t *table, const char *name, symbol_type_t sym_type, type_info_t type_info);
 symbol_t *find_symbol(symbol_table_t *table, const char *name);
+symbol_t *find_symbol_interned(symbol_table_t *table, const char *name);
 symbol_t *find_symbol_in_scope(scope_t *scope, const char *name);
 
 // Type size calculations
@@ -125,9 +136,8 @@ symbol_t *find_label(symbol_table_t *table, const char *label_name);
 char *generate_unique_name(symbol_table_t *table, const char *base_name);
 int is_compatible_type(type_info_t *type1, type_info_t *type2);
 type_info_t get_expression_type(ast_node_t *expr, symbol_table_t *table);
+int is_unsigned_arithmetic(const type_info_t *left, const type_info_t *right);
 type_info_t deep_copy_type_info(const type_info_t *src);
-size_t symbol_table_hash(const char *src);
-// size_t symbol_table_nhash(const char *src, size_t size);
 
 // Memory management helpers
 void free_symbol(symbol_t *sym);
@@ -0,0 +1,298 @@
+#define _POSIX_C_SOURCE 200809L
+#include "type_table.h"
+#include "arena.h"
+#include "intern.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TYPE_TABLE_INITIAL_BUCKETS 256
+
+// Cache entry mapping a C type shape to its canonical LLVM type
+typedef struct type_key {
+	struct type_key *next;
+	const char *base; // Interned
+	int pointer_level;
+	int tag; // 1 struct, 2 union, 0 otherwise
+	const llvm_type_t *type;
+} type_key_t;
+
+static arena_t type_arena;
+
+static llvm_type_t **type_buckets;
+static size_t type_bucket_count;
+static size_t type_count;
+
+static type_key_t **key_buckets;
+static size_t key_bucket_count;
+static size_t key_count;
+
+// Taken only while several threads may use the table (parallel codegen)
+static pthread_rwlock_t type_lock = PTHREAD_RWLOCK_INITIALIZER;
+static int type_shared;
+
+// Algorithm: djb2a hash function
+static size_t hash_bytes(const char *str, size_t len)
+{
+	size_t hash = 5381;
+	for (size_t i = 0; i < len; i++)
+		hash = ((hash << 5) + hash) ^ (unsigned char)str[i];
+	return hash;
+}
+
+static void *alloc_buckets(size_t count)
+{
+	void *buckets = calloc(count, sizeof(void *));
+	if (!buckets) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	return buckets;
+}
+
+static void grow_type_buckets(void)
+{
+	size_t new_count = type_bucket_count ? type_bucket_count * 2 : TYPE_TABLE_INITIAL_BUCKETS;
+	llvm_type_t **new_buckets = alloc_buckets(new_count);
+	for (size_t i = 0; i < type_bucket_count; i++) {
+		llvm_type_t *entry = type_buckets[i];
+		while (entry) {
+			llvm_type_t *next = entry->next;
+			size_t idx = entry->hash & (new_count - 1);
+			entry->next = new_buckets[idx];
+			new_buckets[idx] = entry;
+			entry = next;
+		}
+	}
+	free(type_buckets);
+	type_buckets = new_buckets;
+	type_bucket_count = new_count;
+}
+
+static void classify(llvm_type_t *type)
+{
+	const char *name = type->name;
+
+	if (type->length > 0 && name[type->length - 1] == '*') {
+		type->kind = LLVM_TYPE_POINTER;
+		return;
+	}
+	if (strcmp(name, "void") == 0) {
+		type->kind = LLVM_TYPE_VOID;
+	} else if (strcmp(name, "float") == 0) {
+		type->kind = LLVM_TYPE_FLOAT;
+	} else if (strcmp(name, "double") == 0) {
+		type->kind = LLVM_TYPE_DOUBLE;
+	} else if (name[0] == 'i' && name[1] >= '0' && name[1] <= '9') {
+		type->kind = LLVM_TYPE_INTEGER;
+		type->bits = atoi(name + 1);
+	} else {
+		type->kind = LLVM_TYPE_AGGREGATE;
+	}
+}
+
+// Canonical type for an LLVM spelling
+static llvm_type_t *type_named(const char *name, size_t len)
+{
+	size_t hash = hash_bytes(name, len);
+	if (type_buckets) {
+		llvm_type_t *entry = type_buckets[hash & (type_bucket_count - 1)];
+		for (; entry; entry = entry->next) {
+			if (entry->hash == hash && entry->length == len && memcmp(entry->name, name, len) == 0)
+				return entry;
+		}
+	}
+
+	if (type_count >= type_bucket_count)
+		grow_type_buckets();
+
+	llvm_type_t *type = arena_calloc(&type_arena, 1, sizeof(llvm_type_t) + len + 1);
+	type->hash = hash;
+	type->length = len;
+	memcpy(type->name, name, len);
+	type->name[len] = '\0';
+	classify(type);
+	if (type->kind == LLVM_TYPE_POINTER)
+		type->pointee = type_named(name, len - 1);
+
+	// The pointee lookup may have grown the table
+	size_t idx = hash & (type_bucket_count - 1);
+	type->next = type_buckets[idx];
+	type_buckets[idx] = type;
+	type_count++;
+	return type;
+}
+
+static const llvm_type_t *pointer_to(const llvm_type_t *type)
+{
+	llvm_type_t *mutable_type = (llvm_type_t *)type;
+	if (!mutable_type->pointer_type) {
+		char stack_buf[256];
+		char *buf = type->length + 1 < sizeof(stack_buf) ? stack_buf : malloc(type->length + 2);
+		if (!buf) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		memcpy(buf, type->name, type->length);
+		buf[type->length] = '*';
+		mutable_type->pointer_type = type_named(buf, type->length + 1);
+		if (buf != stack_buf)
+			free(buf);
+	}
+	return mutable_type->pointer_type;
+}
+
+// LLVM spelling of a C base type. Pointee spellings differ slightly from
+// value spellings: void* is i8*, and _Bool has no pointer form of its own.
+static const char *base_spelling(const char *base, int tag, int as_pointee, char *buf, size_t size)
+{
+	if (strcmp(base, "void") == 0)
+		return as_pointee ? "i8" : "void";
+	if (strcmp(base, "char") == 0)
+		return "i8";
+	if (strcmp(base, "short") == 0)
+		return "i16";
+	if (strcmp(base, "int") == 0)
+		return "i32";
+	if (strstr(base, "long"))
+		return "i64";
+	if (strcmp(base, "float") == 0)
+		return "float";
+	if (strcmp(base, "double") == 0)
+		return "double";
+	if (!as_pointee && strcmp(base, "_Bool") == 0)
+		return "i1";
+	if (tag == 1) {
+		snprintf(buf, size, "%%struct.%s", base);
+		return buf;
+	}
+	if (tag == 2) {
+		snprintf(buf, size, "%%union.%s", base);
+		return buf;
+	}
+	return "i32"; // Enums and anything unknown
+}
+
+static size_t key_hash(const char *base, int pointer_level, int tag)
+{
+	return interned_hash(base) * 31 + (size_t)(pointer_level * 4 + tag);
+}
+
+static void grow_key_buckets(void)
+{
+	size_t new_count = key_bucket_count ? key_bucket_count * 2 : TYPE_TABLE_INITIAL_BUCKETS;
+	type_key_t **new_buckets = alloc_buckets(new_count);
+	for (size_t i = 0; i < key_bucket_count; i++) {
+		type_key_t *entry = key_buckets[i];
+		while (entry) {
+			type_key_t *next = entry->next;
+			size_t idx = key_hash(entry->base, entry->pointer_level, entry->tag) & (new_count - 1);
+			entry->next = new_buckets[idx];
+			new_buckets[idx] = entry;
+			entry = next;
+		}
+	}
+	free(key_buckets);
+	key_buckets = new_buckets;
+	key_bucket_count = new_count;
+}
+
+static const llvm_type_t *find_key(const char *base, int pointer_level, int tag, size_t hash)
+{
+	if (!key_buckets)
+		return NULL;
+	type_key_t *entry = key_buckets[hash & (key_bucket_count - 1)];
+	for (; entry; entry = entry->next) {
+		if (entry->base == base && entry->pointer_level == pointer_level && entry->tag == tag)
+			return entry->type;
+	}
+	return NULL;
+}
+
+static const llvm_type_t *add_key(const char *base, int pointer_level, int tag, size_t hash)
+{
+	char buf[256];
+	const char *spelling = base_spelling(base, tag, pointer_level > 0, buf, sizeof(buf));
+	const llvm_type_t *type = type_named(spelling, strlen(spelling));
+	for (int i = 0; i < pointer_level; i++)
+		type = pointer_to(type);
+
+	if (key_count >= key_bucket_count)
+		grow_key_buckets();
+
+	type_key_t *entry = arena_alloc(&type_arena, sizeof(type_key_t));
+	entry->base = base;
+	entry->pointer_level = pointer_level;
+	entry->tag = tag;
+	entry->type = type;
+	size_t idx = hash & (key_bucket_count - 1);
+	entry->next = key_buckets[idx];
+	key_buckets[idx] = entry;
+	key_count++;
+	return type;
+}
+
+const llvm_type_t *llvm_type_of(const type_info_t *type_info)
+{
+	const char *base = intern_string(type_info->base_type ? type_info->base_type : "");
+	int pointer_level = type_info->pointer_level > 0 ? type_info->pointer_level : 0;
+	int tag = type_info->is_struct ? 1 : type_info->is_union ? 2 : 0;
+	size_t hash = key_hash(base, pointer_level, tag);
+
+	if (!type_shared) {
+		const llvm_type_t *type = find_key(base, pointer_level, tag, hash);
+		return type ? type : add_key(base, pointer_level, tag, hash);
+	}
+
+	pthread_rwlock_rdlock(&type_lock);
+	const llvm_type_t *type = find_key(base, pointer_level, tag, hash);
+	pthread_rwlock_unlock(&type_lock);
+	if (type)
+		return type;
+
+	pthread_rwlock_wrlock(&type_lock);
+	type = find_key(base, pointer_level, tag, hash);
+	if (!type)
+		type = add_key(base, pointer_level, tag, hash);
+	pthread_rwlock_unlock(&type_lock);
+	return type;
+}
+
+const llvm_type_t *llvm_pointer_to(const llvm_type_t *type)
+{
+	if (!type_shared)
+		return pointer_to(type);
+
+	pthread_rwlock_rdlock(&type_lock);
+	const llvm_type_t *pointer = type->pointer_type;
+	pthread_rwlock_unlock(&type_lock);
+	if (pointer)
+		return pointer;
+
+	pthread_rwlock_wrlock(&type_lock);
+	pointer = pointer_to(type);
+	pthread_rwlock_unlock(&type_lock);
+	return pointer;
+}
+
+void type_table_set_shared(int shared)
+{
+	type_shared = shared;
+}
+
+size_t type_table_count(void)
+{
+	return type_count;
+}
+
+void type_table_release(void)
+{
+	arena_release(&type_arena);
+	free(type_buckets);
+	free(key_buckets);
+	type_buckets = NULL;
+	key_buckets = NULL;
+	type_bucket_count = key_bucket_count = 0;
+	type_count = key_count = 0;
+}
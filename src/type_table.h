@@ -0,0 +1,49 @@
+#ifndef TYPE_TABLE_H
+#define TYPE_TABLE_H
+
+#include "ast.h"
+
+// Canonical LLVM types. Every distinct spelling ("i32", "%struct.node**",
+// ...) has exactly one llvm_type_t, so handles can be compared with ==.
+// type_info_t values are resolved once per (base, pointer level, tag) and
+// the result is cached; handles live until type_table_release().
+typedef enum {
+	LLVM_TYPE_VOID,
+	LLVM_TYPE_INTEGER,
+	LLVM_TYPE_FLOAT,
+	LLVM_TYPE_DOUBLE,
+	LLVM_TYPE_POINTER,
+	LLVM_TYPE_AGGREGATE // %struct.* / %union.*
+} llvm_type_kind_t;
+
+typedef struct llvm_type {
+	struct llvm_type *next; // Hash chain
+	size_t hash;
+	size_t length;
+	llvm_type_kind_t kind;
+	int bits;                       // Integer width, 0 for other kinds
+	struct llvm_type *pointee;      // Element type of a pointer
+	struct llvm_type *pointer_type; // Cached T*, created on demand
+	char name[];                    // LLVM spelling
+} llvm_type_t;
+
+const llvm_type_t *llvm_type_of(const type_info_t *type_info);
+const llvm_type_t *llvm_pointer_to(const llvm_type_t *type);
+
+static inline int llvm_type_is_integer(const llvm_type_t *type)
+{
+	return type->kind == LLVM_TYPE_INTEGER;
+}
+
+static inline int llvm_type_is_pointer(const llvm_type_t *type)
+{
+	return type->kind == LLVM_TYPE_POINTER;
+}
+
+// While shared, the table may be used from several threads at once
+void type_table_set_shared(int shared);
+
+size_t type_table_count(void);
+void type_table_release(void);
+
+#endif
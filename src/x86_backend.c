@@ -0,0 +1,2187 @@
+#define _POSIX_C_SOURCE 200809L
+#include "x86_backend.h"
+#include "fold.h"
+#include "ir_writer.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Callee-saved registers handed out by the allocator. They survive calls,
+// so nothing has to be spilled around call sites.
+static const char *const alloc_regs[] = {"%rbx", "%r12", "%r13", "%r14", "%r15"};
+#define ALLOC_REG_COUNT 5
+
+static const char *const arg_regs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+#define ARG_REG_COUNT 6
+
+// Expressions are computed in %rax; binary operators take their right
+// operand in %rcx. Values narrower than 8 bytes are kept extended to 32 bits.
+static const char *const reg64[] = {"%rax", "%rcx"};
+static const char *const reg32[] = {"%eax", "%ecx"};
+static const char *const reg16[] = {"%ax", "%cx"};
+static const char *const reg8[] = {"%al", "%cl"};
+static const char *const reg_mem[] = {"(%rax)", "(%rcx)"};
+
+// Room for one memory operand such as "name.3(%rip)"
+#define OPERAND_SIZE 512
+
+enum { CC_E, CC_NE, CC_L, CC_LE, CC_G, CC_GE, CC_B, CC_BE, CC_A, CC_AE };
+static const char *const cc_names[] = {"e", "ne", "l", "le", "g", "ge", "b", "be", "a", "ae"};
+static const int cc_negated[] = {CC_NE, CC_E, CC_GE, CC_G, CC_LE, CC_L, CC_AE, CC_A, CC_BE, CC_B};
+
+// Open-addressing map from pointers (symbols, interned names) to values
+typedef struct {
+	const void **keys;
+	intptr_t *values;
+	size_t cap;
+	size_t count;
+} ptr_map_t;
+
+typedef struct {
+	symbol_t *sym;
+	type_info_t type; // Parameters declared as arrays are pointers here
+	int reg;          // Index into alloc_regs, -1 while in memory
+	int offset;       // %rbp offset of the stack slot
+	int candidate;    // Scalar whose address is never taken
+	int is_vla;       // The slot holds the address of the array
+	int static_id;    // Static locals are data labelled name.<id>
+	int start, end;   // Live interval in scan positions, start < 0 if unused
+} var_t;
+
+typedef struct {
+	int start, end;
+} loop_t;
+
+typedef struct {
+	const ast_node_t *node; // case or default statement
+	int label;
+} switch_case_t;
+
+typedef struct {
+	ir_writer_t text;
+	ir_writer_t data;
+	ir_writer_t rodata;
+	symbol_table_t *table;
+	ptr_map_t definitions; // Interned name -> defining node, for what this file defines
+	int labels;
+	int strings;
+	int statics;
+	const char *unsupported; // First construct this backend cannot compile
+	const ast_node_t *unsupported_at;
+
+	// Function being compiled
+	var_t *vars;
+	int var_count, var_cap;
+	ptr_map_t var_map; // Symbol -> index into vars
+	loop_t *loops;
+	int loop_count, loop_cap;
+	int position; // Scan position, advanced at every use of a variable
+	int has_labels;
+	int function_id;
+	int return_label;
+	type_info_t return_type;
+	int depth; // Bytes pushed since the prologue, for call alignment
+	int break_label, continue_label;
+	switch_case_t *cases; // Case labels of the enclosing switches
+	int case_count, case_cap;
+	int case_base; // First case of the innermost switch
+} x86_ctx_t;
+
+static x86_ctx_t ctx;
+
+#define emit(...) ir_printf(&ctx.text, "\t" __VA_ARGS__)
+
+static type_info_t gen_expr(ast_node_t *node);
+static type_info_t gen_addr(ast_node_t *node);
+static void gen_branch(ast_node_t *node, int label, int when);
+static void gen_stmt(ast_node_t *node);
+
+static void unsupported(const ast_node_t *node, const char *what)
+{
+	if (!ctx.unsupported) {
+		ctx.unsupported = what;
+		ctx.unsupported_at = node;
+	}
+}
+
+static void *grow(void *items, int *cap, size_t size)
+{
+	*cap = *cap ? *cap * 2 : 16;
+	items = realloc(items, (size_t)*cap * size);
+	if (!items) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	return items;
+}
+
+static size_t ptr_hash(const void *key)
+{
+	uint64_t h = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull;
+	return (size_t)(h ^ (h >> 32));
+}
+
+static intptr_t *map_find(ptr_map_t *map, const void *key)
+{
+	if (!map->cap)
+		return NULL;
+	for (size_t i = ptr_hash(key) & (map->cap - 1);; i = (i + 1) & (map->cap - 1)) {
+		if (map->keys[i] == key)
+			return &map->values[i];
+		if (!map->keys[i])
+			return NULL;
+	}
+}
+
+static void map_put(ptr_map_t *map, const void *key, intptr_t value)
+{
+	if ((map->count + 1) * 2 > map->cap) {
+		ptr_map_t bigger = {0};
+		bigger.cap = map->cap ? map->cap * 2 : 64;
+		bigger.keys = calloc(bigger.cap, sizeof(*bigger.keys));
+		bigger.values = malloc(bigger.cap * sizeof(*bigger.values));
+		if (!bigger.keys || !bigger.values) {
+			fprintf(stderr, "Memory allocation failed\n");
+			exit(1);
+		}
+		for (size_t i = 0; i < map->cap; i++) {
+			if (map->keys[i])
+				map_put(&bigger, map->keys[i], map->values[i]);
+		}
+		free(map->keys);
+		free(map->values);
+		*map = bigger;
+	}
+	size_t i = ptr_hash(key) & (map->cap - 1);
+	while (map->keys[i] && map->keys[i] != key)
+		i = (i + 1) & (map->cap - 1);
+	if (!map->keys[i])
+		map->count++;
+	map->keys[i] = key;
+	map->values[i] = value;
+}
+
+static void map_clear(ptr_map_t *map)
+{
+	if (map->count)
+		memset(map->keys, 0, map->cap * sizeof(*map->keys));
+	map->count = 0;
+}
+
+static void map_free(ptr_map_t *map)
+{
+	free(map->keys);
+	free(map->values);
+	memset(map, 0, sizeof(*map));
+}
+
+static int new_label(void)
+{
+	return ctx.labels++;
+}
+
+static void label_def(int label)
+{
+	ir_printf(&ctx.text, ".L%d:\n", label);
+}
+
+static void push_rax(void)
+{
+	emit("pushq %%rax\n");
+	ctx.depth += 8;
+}
+
+static void pop_reg(const char *reg)
+{
+	emit("popq %s\n", reg);
+	ctx.depth -= 8;
+}
+
+// Types
+
+static type_info_t make_type(const char *base, int pointer_level)
+{
+	return create_type_info(base, pointer_level, 0, NULL);
+}
+
+static int is_void(const type_info_t *t)
+{
+	return !t->is_array && t->pointer_level == 0 && t->base_type && strcmp(t->base_type, "void") == 0;
+}
+
+static int is_pointer(const type_info_t *t)
+{
+	return !t->is_array && t->pointer_level > 0;
+}
+
+// Arrays, structs and unions; their value is their address
+static int is_aggregate(const type_info_t *t)
+{
+	return t->is_array || (t->pointer_level == 0 && (t->is_struct || t->is_union));
+}
+
+static int is_float(const type_info_t *t)
+{
+	return !t->is_array && t->pointer_level == 0 && t->base_type &&
+	       (strcmp(t->base_type, "float") == 0 || strcmp(t->base_type, "double") == 0);
+}
+
+static int is_bool(const type_info_t *t)
+{
+	return !t->is_array && t->pointer_level == 0 && t->base_type && strcmp(t->base_type, "_Bool") == 0;
+}
+
+static int is_unsigned(const type_info_t *t)
+{
+	return is_pointer(t) || is_bool(t) || (t->base_type && strstr(t->base_type, "unsigned"));
+}
+
+// Sizes follow calculate_type_size(), so struct layouts agree with the
+// offsets semantic analysis gave the members
+static int scalar_size(const type_info_t *t)
+{
+	if (t->pointer_level > 0 || t->is_array)
+		return 8;
+	if (t->is_enum || !t->base_type)
+		return 4;
+	const char *base = t->base_type;
+	if (strcmp(base, "_Bool") == 0 || strstr(base, "char"))
+		return 1;
+	if (strstr(base, "short"))
+		return 2;
+	if (strstr(base, "int"))
+		return 4;
+	if (strstr(base, "long"))
+		return 8;
+	return 4;
+}
+
+static long object_size(const type_info_t *t)
+{
+	if (t->is_array) {
+		type_info_t element = *t;
+		element.is_array = 0;
+		long count = t->array_size && t->array_size->type == AST_NUMBER ? t->array_size->data.number.value : 0;
+		return object_size(&element) * count;
+	}
+	if (t->pointer_level == 0 && (t->is_struct || t->is_union))
+		return (long)calculate_type_size((type_info_t *)t, ctx.table);
+	return scalar_size(t);
+}
+
+static int object_align(const type_info_t *t)
+{
+	if (t->is_array) {
+		type_info_t element = *t;
+		element.is_array = 0;
+		return object_size(t) >= 16 ? 16 : object_align(&element);
+	}
+	if (t->pointer_level == 0 && (t->is_struct || t->is_union))
+		return (int)calculate_type_alignment((type_info_t *)t, ctx.table);
+	return scalar_size(t);
+}
+
+static type_info_t decay(type_info_t t)
+{
+	if (t.is_array) {
+		t.is_array = 0;
+		t.is_vla = 0;
+		t.array_size = NULL;
+		t.pointer_level++;
+	}
+	return t;
+}
+
+static type_info_t pointee(type_info_t t)
+{
+	if (t.is_array) {
+		t.is_array = 0;
+		t.is_vla = 0;
+		t.array_size = NULL;
+	} else if (t.pointer_level > 0) {
+		t.pointer_level--;
+	}
+	return t;
+}
+
+// Step of pointer arithmetic on t; void * steps by bytes like GNU C
+static long element_size(const type_info_t *t)
+{
+	type_info_t element = pointee(*t);
+	long size = is_void(&element) ? 1 : object_size(&element);
+	return size > 0 ? size : 1;
+}
+
+// Integer type after the usual arithmetic conversions: int, unsigned int,
+// long or unsigned long. _Bool, char and short promote to int.
+static type_info_t arithmetic_type(const type_info_t *a, const type_info_t *b)
+{
+	int size_a = scalar_size(a) == 8 ? 8 : 4;
+	int size_b = scalar_size(b) == 8 ? 8 : 4;
+	int unsigned_a = is_unsigned(a) && scalar_size(a) >= 4;
+	int unsigned_b = is_unsigned(b) && scalar_size(b) >= 4;
+	if (size_a == 8 || size_b == 8) {
+		int u = (size_a == 8 && unsigned_a) || (size_b == 8 && unsigned_b);
+		return make_type(u ? "unsigned long" : "long", 0);
+	}
+	return make_type(unsigned_a || unsigned_b ? "unsigned int" : "int", 0);
+}
+
+static type_info_t promote(const type_info_t *t)
+{
+	return arithmetic_type(t, t);
+}
+
+// Code for values
+
+// Sign or zero extends a char, short or _Bool in register r to 32 bits
+static void normalize(const type_info_t *t, int r)
+{
+	if (is_aggregate(t) || is_void(t))
+		return;
+	int size = scalar_size(t);
+	if (size == 1)
+		emit("mov%cbl %s, %s\n", is_unsigned(t) ? 'z' : 's', reg8[r], reg32[r]);
+	else if (size == 2)
+		emit("mov%cwl %s, %s\n", is_unsigned(t) ? 'z' : 's', reg16[r], reg32[r]);
+}
+
+// Converts the value in register r from one scalar type to another
+static void convert(const type_info_t *from, const type_info_t *to, int r)
+{
+	if (is_aggregate(to) || is_void(to) || is_aggregate(from))
+		return;
+	int from_size = scalar_size(from), to_size = scalar_size(to);
+	if (is_bool(to)) {
+		if (!is_bool(from)) {
+			emit("test%c %s, %s\n", from_size == 8 ? 'q' : 'l', from_size == 8 ? reg64[r] : reg32[r],
+			     from_size == 8 ? reg64[r] : reg32[r]);
+			emit("setne %s\n", reg8[r]);
+			emit("movzbl %s, %s\n", reg8[r], reg32[r]);
+		}
+		return;
+	}
+	if (to_size < 4) {
+		if (from_size != to_size || is_unsigned(from) != is_unsigned(to))
+			normalize(to, r);
+	} else if (to_size == 8 && from_size < 8) {
+		if (is_unsigned(from))
+			emit("movl %s, %s\n", reg32[r], reg32[r]);
+		else
+			emit("movslq %s, %s\n", reg32[r], reg64[r]);
+	}
+}
+
+// Loads a scalar of type t from mem into register r
+static void load(const type_info_t *t, const char *mem, int r)
+{
+	if (is_float(t)) {
+		unsupported(NULL, "floating point");
+		return;
+	}
+	switch (scalar_size(t)) {
+	case 1:
+		emit("mov%cbl %s, %s\n", is_unsigned(t) ? 'z' : 's', mem, reg32[r]);
+		break;
+	case 2:
+		emit("mov%cwl %s, %s\n", is_unsigned(t) ? 'z' : 's', mem, reg32[r]);
+		break;
+	case 4:
+		emit("movl %s, %s\n", mem, reg32[r]);
+		break;
+	default:
+		emit("movq %s, %s\n", mem, reg64[r]);
+		break;
+	}
+}
+
+// Stores %rax to mem. For structs %rax holds the address of the source.
+// Only %rdi, %rsi and %rcx are clobbered.
+static void store(const type_info_t *t, const char *mem)
+{
+	if (is_aggregate(t)) {
+		emit("leaq %s, %%rdi\n", mem);
+		emit("movq %%rax, %%rsi\n");
+		emit("movl $%ld, %%ecx\n", object_size(t));
+		emit("rep movsb\n");
+		return;
+	}
+	switch (scalar_size(t)) {
+	case 1:
+		emit("movb %%al, %s\n", mem);
+		break;
+	case 2:
+		emit("movw %%ax, %s\n", mem);
+		break;
+	case 4:
+		emit("movl %%eax, %s\n", mem);
+		break;
+	default:
+		emit("movq %%rax, %s\n", mem);
+		break;
+	}
+}
+
+// Multiplies register r, a long, by a pointer step
+static void scale(long size, int r)
+{
+	if (size == 1)
+		return;
+	if ((size & (size - 1)) == 0) {
+		int shift = 0;
+		while ((1L << shift) != size)
+			shift++;
+		emit("shlq $%d, %s\n", shift, reg64[r]);
+	} else {
+		emit("imulq $%ld, %s, %s\n", size, reg64[r], reg64[r]);
+	}
+}
+
+// Strings go to .rodata as .LC<n>, escaped for the assembler
+static int emit_string(const ast_node_t *node)
+{
+	int id = ctx.strings++;
+	const unsigned char *s = (const unsigned char *)node->data.string_literal.value;
+	int length = node->data.string_literal.length;
+	ir_printf(&ctx.rodata, ".LC%d:\n\t.string \"", id);
+	for (int i = 0; i < length; i++) {
+		if (s[i] == '"' || s[i] == '\\') {
+			ir_putc(&ctx.rodata, '\\');
+			ir_putc(&ctx.rodata, (char)s[i]);
+		} else if (s[i] >= 32 && s[i] < 127) {
+			ir_putc(&ctx.rodata, (char)s[i]);
+		} else {
+			char escape[5] = {'\\', (char)('0' + (s[i] >> 6)), (char)('0' + ((s[i] >> 3) & 7)),
+					  (char)('0' + (s[i] & 7)), '\0'};
+			ir_puts(&ctx.rodata, escape);
+		}
+	}
+	ir_puts(&ctx.rodata, "\"\n");
+	return id;
+}
+
+// Variables
+
+static var_t *find_var(const symbol_t *sym)
+{
+	intptr_t *index = sym ? map_find(&ctx.var_map, sym) : NULL;
+	return index ? &ctx.vars[*index] : NULL;
+}
+
+static var_t *add_var(symbol_t *sym, type_info_t type)
+{
+	if (ctx.var_count == ctx.var_cap)
+		ctx.vars = grow(ctx.vars, &ctx.var_cap, sizeof(var_t));
+	var_t *var = &ctx.vars[ctx.var_count];
+	memset(var, 0, sizeof(*var));
+	var->sym = sym;
+	var->type = type;
+	var->reg = -1;
+	var->start = var->end = -1;
+	map_put(&ctx.var_map, sym, ctx.var_count++);
+	return var;
+}
+
+static symbol_t *identifier_symbol(ast_node_t *node)
+{
+	symbol_t *sym = node->data.identifier.symbol;
+	return sym ? sym : find_symbol(ctx.table, node->data.identifier.name);
+}
+
+static int is_defined(const char *name)
+{
+	return map_find(&ctx.definitions, name) != NULL;
+}
+
+enum { LOC_REG, LOC_MEM, LOC_GOT };
+
+// Where a variable is read and written: its register, a memory operand
+// written to mem, or a global of another file reached through the GOT
+static int locate(const symbol_t *sym, const var_t *var, char *mem)
+{
+	if (var && var->reg >= 0)
+		return LOC_REG;
+	if (var && var->static_id) {
+		snprintf(mem, OPERAND_SIZE, "%s.%d(%%rip)", sym->name, var->static_id);
+		return LOC_MEM;
+	}
+	if (var) {
+		snprintf(mem, OPERAND_SIZE, "%d(%%rbp)", var->offset);
+		return LOC_MEM;
+	}
+	if (is_defined(sym->name)) {
+		snprintf(mem, OPERAND_SIZE, "%s(%%rip)", sym->name);
+		return LOC_MEM;
+	}
+	return LOC_GOT;
+}
+
+// Address of a variable, array or function into register r
+static void gen_symbol_address(const ast_node_t *node, symbol_t *sym, int r)
+{
+	var_t *var = sym->sym_type == SYM_FUNCTION ? NULL : find_var(sym);
+	char mem[OPERAND_SIZE];
+	switch (locate(sym, var, mem)) {
+	case LOC_REG:
+		unsupported(node, "address of a register variable");
+		break;
+	case LOC_GOT:
+		emit("movq %s@GOTPCREL(%%rip), %s\n", sym->name, reg64[r]);
+		break;
+	default:
+		if (var && var->is_vla)
+			emit("movq %s, %s\n", mem, reg64[r]);
+		else
+			emit("leaq %s, %s\n", mem, reg64[r]);
+		break;
+	}
+}
+
+// Constants and plain variables load into either register without
+// touching the other one, so a binary operator need not push its left side
+static int is_leaf(const ast_node_t *node)
+{
+	return node->type == AST_NUMBER || node->type == AST_CHARACTER || node->type == AST_IDENTIFIER;
+}
+
+static int is_immediate(const ast_node_t *node, long long *value)
+{
+	if (node->type == AST_NUMBER) {
+		*value = node->data.number.value;
+		return 1;
+	}
+	if (node->type == AST_CHARACTER) {
+		*value = (signed char)node->data.character.value;
+		return 1;
+	}
+	return 0;
+}
+
+static type_info_t gen_leaf(ast_node_t *node, int r)
+{
+	long long value;
+	if (is_immediate(node, &value)) {
+		if (value == 0)
+			emit("xorl %s, %s\n", reg32[r], reg32[r]);
+		else
+			emit("movl $%lld, %s\n", value, reg32[r]);
+		return make_type("int", 0);
+	}
+
+	symbol_t *sym = identifier_symbol(node);
+	if (!sym) {
+		unsupported(node, "undeclared identifier");
+		return make_type("int", 0);
+	}
+	if (sym->sym_type == SYM_ENUM_CONSTANT) {
+		emit("movl $%d, %s\n", sym->enum_value, reg32[r]);
+		return make_type("int", 0);
+	}
+	if (sym->sym_type == SYM_FUNCTION) {
+		gen_symbol_address(node, sym, r);
+		return make_type("void", 1);
+	}
+
+	var_t *var = find_var(sym);
+	type_info_t type = var ? var->type : sym->type_info;
+	if (is_float(&type)) {
+		unsupported(node, "floating point");
+		return type;
+	}
+	if (is_aggregate(&type)) {
+		gen_symbol_address(node, sym, r);
+		return type;
+	}
+	char mem[OPERAND_SIZE];
+	switch (locate(sym, var, mem)) {
+	case LOC_REG:
+		emit("movq %s, %s\n", alloc_regs[var->reg], reg64[r]);
+		break;
+	case LOC_MEM:
+		load(&type, mem, r);
+		break;
+	default:
+		emit("movq %s@GOTPCREL(%%rip), %s\n", sym->name, reg64[r]);
+		load(&type, reg_mem[r], r);
+		break;
+	}
+	return type;
+}
+
+// Evaluates left into %rax and right into %rcx
+static void gen_operands(ast_node_t *left, ast_node_t *right, type_info_t *lt, type_info_t *rt)
+{
+	*lt = decay(gen_expr(left));
+	if (is_leaf(right)) {
+		*rt = decay(gen_leaf(right, 1));
+		return;
+	}
+	push_rax();
+	*rt = decay(gen_expr(right));
+	emit("movq %%rax, %%rcx\n");
+	pop_reg("%rax");
+}
+
+// %rax = %rax op %rcx, both already converted to the integer type k
+static void emit_arith(binary_op_t op, const type_info_t *k)
+{
+	int wide = scalar_size(k) == 8;
+	char s = wide ? 'q' : 'l';
+	const char *a = wide ? "%rax" : "%eax";
+	const char *c = wide ? "%rcx" : "%ecx";
+
+	switch (op) {
+	case OP_ADD:
+		emit("add%c %s, %s\n", s, c, a);
+		break;
+	case OP_SUB:
+		emit("sub%c %s, %s\n", s, c, a);
+		break;
+	case OP_MUL:
+		emit("imul%c %s, %s\n", s, c, a);
+		break;
+	case OP_DIV:
+	case OP_MOD:
+		if (is_unsigned(k)) {
+			emit("xorl %%edx, %%edx\n");
+			emit("div%c %s\n", s, c);
+		} else {
+			emit("%s\n", wide ? "cqto" : "cltd");
+			emit("idiv%c %s\n", s, c);
+		}
+		if (op == OP_MOD)
+			emit("mov%c %s, %s\n", s, wide ? "%rdx" : "%edx", a);
+		break;
+	case OP_BAND:
+		emit("and%c %s, %s\n", s, c, a);
+		break;
+	case OP_BOR:
+		emit("or%c %s, %s\n", s, c, a);
+		break;
+	case OP_BXOR:
+		emit("xor%c %s, %s\n", s, c, a);
+		break;
+	case OP_LSHIFT:
+		emit("shl%c %%cl, %s\n", s, a);
+		break;
+	case OP_RSHIFT:
+		emit("%s%c %%cl, %s\n", is_unsigned(k) ? "shr" : "sar", s, a);
+		break;
+	default:
+		break;
+	}
+}
+
+// Same with a constant right operand; returns 0 for division, which takes
+// no immediate
+static int emit_arith_immediate(binary_op_t op, const type_info_t *k, long long value)
+{
+	int wide = scalar_size(k) == 8;
+	char s = wide ? 'q' : 'l';
+	const char *a = wide ? "%rax" : "%eax";
+
+	switch (op) {
+	case OP_ADD:
+		emit("add%c $%lld, %s\n", s, value, a);
+		return 1;
+	case OP_SUB:
+		emit("sub%c $%lld, %s\n", s, value, a);
+		return 1;
+	case OP_MUL:
+		emit("imul%c $%lld, %s, %s\n", s, value, a, a);
+		return 1;
+	case OP_BAND:
+		emit("and%c $%lld, %s\n", s, value, a);
+		return 1;
+	case OP_BOR:
+		emit("or%c $%lld, %s\n", s, value, a);
+		return 1;
+	case OP_BXOR:
+		emit("xor%c $%lld, %s\n", s, value, a);
+		return 1;
+	case OP_LSHIFT:
+		emit("shl%c $%lld, %s\n", s, value & (wide ? 63 : 31), a);
+		return 1;
+	case OP_RSHIFT:
+		emit("%s%c $%lld, %s\n", is_unsigned(k) ? "shr" : "sar", s, value & (wide ? 63 : 31), a);
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// Pointer + integer, integer + pointer, pointer - integer and
+// pointer - pointer, with the operands in %rax and %rcx
+static type_info_t emit_pointer_arith(binary_op_t op, type_info_t lt, type_info_t rt)
+{
+	type_info_t long_type = make_type("long", 0);
+	if (is_pointer(&lt) && is_pointer(&rt)) {
+		emit("subq %%rcx, %%rax\n");
+		long size = element_size(&lt);
+		if (size > 1) {
+			emit("cqto\n");
+			emit("movq $%ld, %%rcx\n", size);
+			emit("idivq %%rcx\n");
+		}
+		return long_type;
+	}
+	if (is_pointer(&lt)) {
+		convert(&rt, &long_type, 1);
+		scale(element_size(&lt), 1);
+		emit("%s %%rcx, %%rax\n", op == OP_ADD ? "addq" : "subq");
+		return lt;
+	}
+	convert(&lt, &long_type, 0);
+	scale(element_size(&rt), 0);
+	emit("addq %%rcx, %%rax\n");
+	return rt;
+}
+
+static int is_comparison(binary_op_t op)
+{
+	return op >= OP_EQ && op <= OP_GE;
+}
+
+// Emits the cmp of a comparison and returns the condition that holds
+// when it is true
+static int gen_compare(ast_node_t *node)
+{
+	ast_node_t *left = node->data.binary_op.left;
+	ast_node_t *right = node->data.binary_op.right;
+	type_info_t lt, rt, k;
+	long long value;
+	int immediate = is_immediate(right, &value);
+
+	if (immediate) {
+		lt = decay(gen_expr(left));
+		rt = make_type("int", 0);
+	} else {
+		gen_operands(left, right, &lt, &rt);
+	}
+	if (is_pointer(&lt) || is_pointer(&rt))
+		k = make_type("unsigned long", 0);
+	else
+		k = arithmetic_type(&lt, &rt);
+	convert(&lt, &k, 0);
+
+	int wide = scalar_size(&k) == 8;
+	if (immediate) {
+		emit("cmp%c $%lld, %s\n", wide ? 'q' : 'l', value, wide ? "%rax" : "%eax");
+	} else {
+		convert(&rt, &k, 1);
+		emit("cmp%c %s, %s\n", wide ? 'q' : 'l', wide ? "%rcx" : "%ecx", wide ? "%rax" : "%eax");
+	}
+
+	int u = is_unsigned(&k);
+	switch (node->data.binary_op.op) {
+	case OP_EQ:
+		return CC_E;
+	case OP_NE:
+		return CC_NE;
+	case OP_LT:
+		return u ? CC_B : CC_L;
+	case OP_LE:
+		return u ? CC_BE : CC_LE;
+	case OP_GT:
+		return u ? CC_A : CC_G;
+	default:
+		return u ? CC_AE : CC_GE;
+	}
+}
+
+// 0 or 1 in %eax for comparisons, &&, || and !
+static type_info_t gen_truth_value(ast_node_t *node)
+{
+	if (node->type == AST_BINARY_OP && is_comparison(node->data.binary_op.op)) {
+		int cc = gen_compare(node);
+		emit("set%s %%al\n", cc_names[cc]);
+		emit("movzbl %%al, %%eax\n");
+	} else {
+		int false_label = new_label(), end_label = new_label();
+		gen_branch(node, false_label, 0);
+		emit("movl $1, %%eax\n");
+		emit("jmp .L%d\n", end_label);
+		label_def(false_label);
+		emit("xorl %%eax, %%eax\n");
+		label_def(end_label);
+	}
+	return make_type("int", 0);
+}
+
+static void emit_test(const type_info_t *t)
+{
+	if (scalar_size(t) == 8)
+		emit("testq %%rax, %%rax\n");
+	else
+		emit("testl %%eax, %%eax\n");
+}
+
+// Jumps to label when the truth value of node is when
+static void gen_branch(ast_node_t *node, int label, int when)
+{
+	long long value;
+	if (is_immediate(node, &value)) {
+		if ((value != 0) == when)
+			emit("jmp .L%d\n", label);
+		return;
+	}
+	if (node->type == AST_UNARY_OP && node->data.unary_op.op == OP_NOT) {
+		gen_branch(node->data.unary_op.operand, label, !when);
+		return;
+	}
+	if (node->type == AST_BINARY_OP) {
+		binary_op_t op = node->data.binary_op.op;
+		if (is_comparison(op)) {
+			int cc = gen_compare(node);
+			emit("j%s .L%d\n", cc_names[when ? cc : cc_negated[cc]], label);
+			return;
+		}
+		if (op == OP_LAND || op == OP_LOR) {
+			// Both operands decide alone only when the result matches
+			// what the operator short-circuits on
+			if ((op == OP_LAND) != when) {
+				gen_branch(node->data.binary_op.left, label, when);
+				gen_branch(node->data.binary_op.right, label, when);
+			} else {
+				int skip = new_label();
+				gen_branch(node->data.binary_op.left, skip, !when);
+				gen_branch(node->data.binary_op.right, label, when);
+				label_def(skip);
+			}
+			return;
+		}
+	}
+	type_info_t t = decay(gen_expr(node));
+	emit_test(&t);
+	emit("j%s .L%d\n", when ? "ne" : "e", label);
+}
+
+static type_info_t gen_binary(ast_node_t *node)
+{
+	binary_op_t op = node->data.binary_op.op;
+	ast_node_t *left = node->data.binary_op.left;
+	ast_node_t *right = node->data.binary_op.right;
+	if (is_comparison(op) || op == OP_LAND || op == OP_LOR)
+		return gen_truth_value(node);
+
+	type_info_t lt, rt;
+	long long value;
+	if (is_immediate(right, &value)) {
+		lt = decay(gen_expr(left));
+		if (is_pointer(&lt) && (op == OP_ADD || op == OP_SUB)) {
+			long long offset = value * element_size(&lt);
+			if (offset >= INT32_MIN && offset <= INT32_MAX) {
+				if (offset)
+					emit("%s $%lld, %%rax\n", op == OP_ADD ? "addq" : "subq", offset);
+				return lt;
+			}
+		} else if (!is_pointer(&lt)) {
+			rt = make_type("int", 0);
+			type_info_t k = op == OP_LSHIFT || op == OP_RSHIFT ? promote(&lt) : arithmetic_type(&lt, &rt);
+			convert(&lt, &k, 0);
+			if (emit_arith_immediate(op, &k, value))
+				return k;
+			emit("movl $%lld, %%ecx\n", value);
+			convert(&rt, &k, 1);
+			emit_arith(op, &k);
+			return k;
+		}
+		rt = decay(gen_leaf(right, 1));
+	} else {
+		gen_operands(left, right, &lt, &rt);
+	}
+
+	if ((op == OP_ADD || op == OP_SUB) && (is_pointer(&lt) || is_pointer(&rt)))
+		return emit_pointer_arith(op, lt, rt);
+
+	if (op == OP_LSHIFT || op == OP_RSHIFT) {
+		type_info_t k = promote(&lt);
+		convert(&lt, &k, 0);
+		emit_arith(op, &k);
+		return k;
+	}
+	type_info_t k = arithmetic_type(&lt, &rt);
+	convert(&lt, &k, 0);
+	convert(&rt, &k, 1);
+	emit_arith(op, &k);
+	return k;
+}
+
+// ++ and --, on a register variable or through an address
+static type_info_t gen_increment(ast_node_t *operand, int delta, int post)
+{
+	if (operand->type == AST_IDENTIFIER) {
+		symbol_t *sym = identifier_symbol(operand);
+		var_t *var = find_var(sym);
+		if (var && var->reg >= 0) {
+			type_info_t t = var->type;
+			long step = is_pointer(&t) ? element_size(&t) : 1;
+			emit("movq %s, %%rax\n", alloc_regs[var->reg]);
+			if (post)
+				emit("movq %%rax, %%rdx\n");
+			emit("addq $%ld, %%rax\n", step * delta);
+			if (is_bool(&t))
+				convert(&t, &t, 0);
+			else
+				normalize(&t, 0);
+			emit("movq %%rax, %s\n", alloc_regs[var->reg]);
+			if (post)
+				emit("movq %%rdx, %%rax\n");
+			return t;
+		}
+	}
+
+	type_info_t t = gen_addr(operand);
+	if (is_float(&t) || is_aggregate(&t)) {
+		unsupported(operand, is_float(&t) ? "floating point" : "increment of an aggregate");
+		return t;
+	}
+	long step = is_pointer(&t) ? element_size(&t) : 1;
+	emit("movq %%rax, %%rdi\n");
+	load(&t, "(%rdi)", 0);
+	if (post)
+		emit("movq %%rax, %%rdx\n");
+	emit("addq $%ld, %%rax\n", step * delta);
+	normalize(&t, 0);
+	store(&t, "(%rdi)");
+	if (post)
+		emit("movq %%rdx, %%rax\n");
+	return t;
+}
+
+static type_info_t gen_unary(ast_node_t *node)
+{
+	ast_node_t *operand = node->data.unary_op.operand;
+	switch (node->data.unary_op.op) {
+	case OP_NOT:
+		return gen_truth_value(node);
+	case OP_NEG:
+	case OP_BNOT: {
+		type_info_t t = decay(gen_expr(operand));
+		type_info_t k = promote(&t);
+		convert(&t, &k, 0);
+		int wide = scalar_size(&k) == 8;
+		emit("%s%c %s\n", node->data.unary_op.op == OP_NEG ? "neg" : "not", wide ? 'q' : 'l',
+		     wide ? "%rax" : "%eax");
+		return k;
+	}
+	case OP_PREINC:
+		return gen_increment(operand, 1, 0);
+	case OP_POSTINC:
+		return gen_increment(operand, 1, 1);
+	case OP_PREDEC:
+		return gen_increment(operand, -1, 0);
+	default:
+		return gen_increment(operand, -1, 1);
+	}
+}
+
+// lhs op= rhs with lhs in %rax and rhs in %rcx; leaves lhs's new value
+static void emit_compound(binary_op_t op, const type_info_t *lt, type_info_t rt)
+{
+	binary_op_t arith = op == OP_ADD_ASSIGN	   ? OP_ADD
+			    : op == OP_SUB_ASSIGN    ? OP_SUB
+			    : op == OP_MUL_ASSIGN    ? OP_MUL
+			    : op == OP_DIV_ASSIGN    ? OP_DIV
+			    : op == OP_MOD_ASSIGN    ? OP_MOD
+			    : op == OP_LSHIFT_ASSIGN ? OP_LSHIFT
+			    : op == OP_RSHIFT_ASSIGN ? OP_RSHIFT
+			    : op == OP_BAND_ASSIGN   ? OP_BAND
+			    : op == OP_BOR_ASSIGN    ? OP_BOR
+						     : OP_BXOR;
+	if (is_pointer(lt) && (arith == OP_ADD || arith == OP_SUB)) {
+		emit_pointer_arith(arith, *lt, rt);
+		return;
+	}
+	type_info_t k = arith == OP_LSHIFT || arith == OP_RSHIFT ? promote(lt) : arithmetic_type(lt, &rt);
+	convert(lt, &k, 0);
+	if (arith != OP_LSHIFT && arith != OP_RSHIFT)
+		convert(&rt, &k, 1);
+	emit_arith(arith, &k);
+	convert(&k, lt, 0);
+}
+
+static type_info_t gen_assignment(ast_node_t *node)
+{
+	ast_node_t *value = node->data.assignment.value;
+	ast_node_t *lvalue = node->data.assignment.lvalue;
+	binary_op_t op = node->data.assignment.op;
+
+	// Plain variables are written in place
+	symbol_t *sym = NULL;
+	if (!lvalue) {
+		sym = node->data.assignment.symbol;
+		if (!sym)
+			sym = find_symbol(ctx.table, node->data.assignment.name);
+		if (!sym) {
+			unsupported(node, "undeclared identifier");
+			return make_type("int", 0);
+		}
+	} else if (lvalue->type == AST_IDENTIFIER) {
+		sym = identifier_symbol(lvalue);
+	}
+	if (sym && sym->sym_type == SYM_VARIABLE) {
+		var_t *var = find_var(sym);
+		type_info_t t = var ? var->type : sym->type_info;
+		char mem[OPERAND_SIZE];
+		int loc = locate(sym, var, mem);
+		if (is_float(&t)) {
+			unsupported(node, "floating point");
+			return t;
+		}
+		if (loc != LOC_GOT && !is_aggregate(&t)) {
+			type_info_t vt = decay(gen_expr(value));
+			if (op == OP_ASSIGN) {
+				convert(&vt, &t, 0);
+			} else {
+				emit("movq %%rax, %%rcx\n");
+				if (loc == LOC_REG)
+					emit("movq %s, %%rax\n", alloc_regs[var->reg]);
+				else
+					load(&t, mem, 0);
+				emit_compound(op, &t, vt);
+			}
+			if (loc == LOC_REG)
+				emit("movq %%rax, %s\n", alloc_regs[var->reg]);
+			else
+				store(&t, mem);
+			return t;
+		}
+	}
+
+	// Anything else through its address, kept in %rdi
+	type_info_t t;
+	if (lvalue) {
+		t = gen_addr(lvalue);
+	} else if (sym->sym_type == SYM_VARIABLE) {
+		gen_symbol_address(node, sym, 0);
+		var_t *var = find_var(sym);
+		t = var ? var->type : sym->type_info;
+	} else {
+		unsupported(node, "assignment target");
+		return make_type("int", 0);
+	}
+	if (is_float(&t)) {
+		unsupported(node, "floating point");
+		return t;
+	}
+	type_info_t vt;
+	if (is_leaf(value)) {
+		emit("movq %%rax, %%rdi\n");
+		vt = decay(gen_leaf(value, 0));
+	} else {
+		push_rax();
+		vt = decay(gen_expr(value));
+		pop_reg("%rdi");
+	}
+	if (op == OP_ASSIGN) {
+		convert(&vt, &t, 0);
+	} else {
+		emit("movq %%rax, %%rcx\n");
+		load(&t, "(%rdi)", 0);
+		emit_compound(op, &t, vt);
+	}
+	store(&t, "(%rdi)");
+	return t;
+}
+
+// Parameter type of a function, from its definition or its prototype
+static int parameter_type(symbol_t *fn, int index, type_info_t *type)
+{
+	intptr_t *definition = map_find(&ctx.definitions, fn->name);
+	ast_node_t *decl = definition ? (ast_node_t *)*definition : NULL;
+	ast_node_t *param = NULL;
+	if (decl && decl->type == AST_FUNCTION && index < decl->data.function.param_count)
+		param = decl->data.function.params[index];
+	else if (fn->param_symbols && index < fn->param_count)
+		param = fn->param_symbols[index];
+	if (!param)
+		return 0;
+	if (param->type == AST_PARAMETER)
+		*type = decay(param->data.parameter.type_info);
+	else if (param->type == AST_DECLARATION)
+		*type = decay(param->data.declaration.type_info);
+	else
+		return 0;
+	return !is_void(type);
+}
+
+static type_info_t gen_call(ast_node_t *node)
+{
+	symbol_t *fn = node->data.call.symbol;
+	if (!fn)
+		fn = find_symbol(ctx.table, node->data.call.name);
+	if (fn && fn->sym_type != SYM_FUNCTION) {
+		unsupported(node, "call through a pointer");
+		return make_type("int", 0);
+	}
+
+	// Arguments are pushed right to left; the first six are then popped
+	// into registers and the rest stay where the callee expects them
+	int argc = node->data.call.arg_count;
+	int stack_args = argc > ARG_REG_COUNT ? argc - ARG_REG_COUNT : 0;
+	int padding = (ctx.depth + 8 * stack_args) % 16 ? 8 : 0;
+	if (padding) {
+		emit("subq $8, %%rsp\n");
+		ctx.depth += 8;
+	}
+	for (int i = argc - 1; i >= 0; i--) {
+		ast_node_t *arg = node->data.call.args[i];
+		type_info_t at = decay(gen_expr(arg));
+		if (is_aggregate(&at) || is_float(&at))
+			unsupported(arg, is_float(&at) ? "floating point" : "struct passed by value");
+		type_info_t pt;
+		if (fn && parameter_type(fn, i, &pt))
+			convert(&at, &pt, 0);
+		push_rax();
+	}
+	for (int i = 0; i < argc && i < ARG_REG_COUNT; i++)
+		pop_reg(arg_regs[i]);
+
+	// %al holds the number of vector registers a variadic callee receives
+	emit("xorl %%eax, %%eax\n");
+	const char *name = fn ? fn->name : node->data.call.name;
+	if (is_defined(name))
+		emit("call %s\n", name);
+	else
+		emit("call %s@PLT\n", name);
+	if (stack_args || padding) {
+		emit("addq $%d, %%rsp\n", 8 * stack_args + padding);
+		ctx.depth -= 8 * stack_args + padding;
+	}
+
+	type_info_t rt = fn ? fn->type_info : make_type("int", 0);
+	rt.storage_class = STORAGE_NONE;
+	if (is_float(&rt) || is_aggregate(&rt))
+		unsupported(node, is_float(&rt) ? "floating point" : "struct returned by value");
+	normalize(&rt, 0);
+	return rt;
+}
+
+static type_info_t gen_conditional(ast_node_t *node)
+{
+	type_info_t result = decay(node->expr_type ? *node->expr_type : get_expression_type(node, ctx.table));
+	int false_label = new_label(), end_label = new_label();
+	gen_branch(node->data.conditional.condition, false_label, 0);
+	type_info_t t = decay(gen_expr(node->data.conditional.true_expr));
+	convert(&t, &result, 0);
+	emit("jmp .L%d\n", end_label);
+	label_def(false_label);
+	t = decay(gen_expr(node->data.conditional.false_expr));
+	convert(&t, &result, 0);
+	label_def(end_label);
+	return result;
+}
+
+// a[i]: the address of the element into %rax
+static type_info_t gen_element_address(ast_node_t *node)
+{
+	ast_node_t *array = node->data.array_access.array;
+	ast_node_t *index = node->data.array_access.index;
+	type_info_t long_type = make_type("long", 0);
+	type_info_t at, it;
+	long long value;
+
+	if (is_immediate(index, &value)) {
+		at = decay(gen_expr(array));
+		long long offset = value * element_size(&at);
+		if (offset >= INT32_MIN && offset <= INT32_MAX) {
+			if (offset)
+				emit("addq $%lld, %%rax\n", offset);
+			return pointee(at);
+		}
+		push_rax();
+		it = decay(gen_leaf(index, 0));
+	} else if (is_leaf(array)) {
+		// The index first, then the base straight into %rcx
+		it = decay(gen_expr(index));
+		convert(&it, &long_type, 0);
+		at = decay(gen_leaf(array, 1));
+		long size = element_size(&at);
+		if (size == 1 || size == 2 || size == 4 || size == 8) {
+			emit("leaq (%%rcx,%%rax,%ld), %%rax\n", size);
+		} else {
+			scale(size, 0);
+			emit("addq %%rcx, %%rax\n");
+		}
+		return pointee(at);
+	} else {
+		at = decay(gen_expr(array));
+		push_rax();
+		it = decay(gen_expr(index));
+	}
+	if (!is_pointer(&at)) {
+		unsupported(node, "subscript of a non-pointer");
+		return at;
+	}
+	convert(&it, &long_type, 0);
+	scale(element_size(&at), 0);
+	pop_reg("%rcx");
+	emit("addq %%rcx, %%rax\n");
+	return pointee(at);
+}
+
+static type_info_t gen_addr(ast_node_t *node)
+{
+	switch (node->type) {
+	case AST_IDENTIFIER: {
+		symbol_t *sym = identifier_symbol(node);
+		if (!sym) {
+			unsupported(node, "undeclared identifier");
+			return make_type("int", 0);
+		}
+		gen_symbol_address(node, sym, 0);
+		var_t *var = find_var(sym);
+		return var ? var->type : sym->type_info;
+	}
+	case AST_DEREFERENCE:
+		return pointee(decay(gen_expr(node->data.dereference.operand)));
+	case AST_ARRAY_ACCESS:
+		return gen_element_address(node);
+	case AST_MEMBER_ACCESS: {
+		type_info_t t = gen_addr(node->data.member_access.object);
+		if (!is_aggregate(&t))
+			unsupported(node, "member of a non-struct");
+		if (node->data.member_access.member_offset)
+			emit("addq $%zu, %%rax\n", node->data.member_access.member_offset);
+		return node->data.member_access.member_type;
+	}
+	case AST_PTR_MEMBER_ACCESS:
+		gen_expr(node->data.ptr_member_access.object);
+		if (node->data.ptr_member_access.member_offset)
+			emit("addq $%zu, %%rax\n", node->data.ptr_member_access.member_offset);
+		return node->data.ptr_member_access.member_type;
+	case AST_STRING_LITERAL:
+		emit("leaq .LC%d(%%rip), %%rax\n", emit_string(node));
+		return make_type("char", 0);
+	default:
+		unsupported(node, "expression used as an lvalue");
+		return make_type("int", 0);
+	}
+}
+
+static type_info_t gen_expr(ast_node_t *node)
+{
+	switch (node->type) {
+	case AST_NUMBER:
+	case AST_CHARACTER:
+	case AST_IDENTIFIER:
+		return gen_leaf(node, 0);
+	case AST_STRING_LITERAL:
+		emit("leaq .LC%d(%%rip), %%rax\n", emit_string(node));
+		return make_type("char", 1);
+	case AST_BINARY_OP:
+		return gen_binary(node);
+	case AST_UNARY_OP:
+		return gen_unary(node);
+	case AST_ASSIGNMENT:
+		return gen_assignment(node);
+	case AST_CALL:
+		return gen_call(node);
+	case AST_CONDITIONAL:
+		return gen_conditional(node);
+	case AST_ADDRESS_OF: {
+		ast_node_t *operand = node->data.address_of.operand;
+		if (operand->type == AST_DEREFERENCE)
+			return decay(gen_expr(operand->data.dereference.operand));
+		type_info_t t = decay(gen_addr(operand));
+		t.pointer_level++;
+		return t;
+	}
+	case AST_DEREFERENCE:
+	case AST_ARRAY_ACCESS:
+	case AST_MEMBER_ACCESS:
+	case AST_PTR_MEMBER_ACCESS: {
+		type_info_t t = gen_addr(node);
+		if (!is_aggregate(&t))
+			load(&t, "(%rax)", 0);
+		return t;
+	}
+	case AST_CAST: {
+		type_info_t target = node->data.cast.target_type;
+		type_info_t t = decay(gen_expr(node->data.cast.expression));
+		if (is_float(&target))
+			unsupported(node, "floating point");
+		convert(&t, &target, 0);
+		return target;
+	}
+	case AST_SIZEOF:
+		emit("movl $%zu, %%eax\n", node->data.sizeof_op.size_value);
+		return make_type("unsigned long", 0);
+	default:
+		unsupported(node, "expression");
+		return make_type("int", 0);
+	}
+}
+
+// Statements
+
+// Case labels of one switch, without descending into nested switches
+static void collect_cases(ast_node_t *node)
+{
+	if (!node)
+		return;
+	switch (node->type) {
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < node->data.compound.stmt_count; i++)
+			collect_cases(node->data.compound.statements[i]);
+		return;
+	case AST_IF_STMT:
+		collect_cases(node->data.if_stmt.then_stmt);
+		collect_cases(node->data.if_stmt.else_stmt);
+		return;
+	case AST_WHILE_STMT:
+		collect_cases(node->data.while_stmt.body);
+		return;
+	case AST_DO_WHILE_STMT:
+		collect_cases(node->data.do_while_stmt.body);
+		return;
+	case AST_FOR_STMT:
+		collect_cases(node->data.for_stmt.body);
+		return;
+	case AST_LABEL_STMT:
+		collect_cases(node->data.label_stmt.statement);
+		return;
+	case AST_CASE_STMT:
+	case AST_DEFAULT_STMT:
+		if (ctx.case_count == ctx.case_cap)
+			ctx.cases = grow(ctx.cases, &ctx.case_cap, sizeof(switch_case_t));
+		ctx.cases[ctx.case_count].node = node;
+		ctx.cases[ctx.case_count++].label = new_label();
+		collect_cases(node->type == AST_CASE_STMT ? node->data.case_stmt.statement
+							  : node->data.default_stmt.statement);
+		return;
+	default:
+		return;
+	}
+}
+
+static int case_label(const ast_node_t *node)
+{
+	for (int i = ctx.case_base; i < ctx.case_count; i++) {
+		if (ctx.cases[i].node == node)
+			return ctx.cases[i].label;
+	}
+	unsupported(node, "case outside a switch");
+	return 0;
+}
+
+// A chain of compares; the cases go in source order
+static void gen_switch(ast_node_t *node)
+{
+	type_info_t t = decay(gen_expr(node->data.switch_stmt.expression));
+	type_info_t k = promote(&t);
+	convert(&t, &k, 0);
+	int wide = scalar_size(&k) == 8;
+
+	int saved_base = ctx.case_base, saved_count = ctx.case_count;
+	int saved_break = ctx.break_label;
+	ctx.case_base = ctx.case_count;
+	collect_cases(node->data.switch_stmt.body);
+
+	int end_label = new_label();
+	int default_label = end_label;
+	for (int i = ctx.case_base; i < ctx.case_count; i++) {
+		const ast_node_t *c = ctx.cases[i].node;
+		long long value;
+		if (c->type == AST_DEFAULT_STMT) {
+			default_label = ctx.cases[i].label;
+			continue;
+		}
+		if (!evaluate_constant(c->data.case_stmt.value, ctx.table, &value)) {
+			unsupported(c, "case value that is not constant");
+			continue;
+		}
+		if (!wide)
+			value = (int)value;
+		emit("cmp%c $%lld, %s\n", wide ? 'q' : 'l', value, wide ? "%rax" : "%eax");
+		emit("je .L%d\n", ctx.cases[i].label);
+	}
+	emit("jmp .L%d\n", default_label);
+
+	ctx.break_label = end_label;
+	gen_stmt(node->data.switch_stmt.body);
+	label_def(end_label);
+	ctx.break_label = saved_break;
+	ctx.case_base = saved_base;
+	ctx.case_count = saved_count;
+}
+
+// Zero-fills a local struct and stores the initializers member by member
+static void gen_struct_initializer(var_t *var, ast_node_t *list, const char *mem)
+{
+	symbol_t *struct_sym = find_symbol(ctx.table, var->type.base_type);
+	if (!struct_sym || (struct_sym->sym_type != SYM_STRUCT && struct_sym->sym_type != SYM_UNION)) {
+		unsupported(list, "initializer of an unknown struct");
+		return;
+	}
+	emit("leaq %s, %%rdi\n", mem);
+	emit("xorl %%eax, %%eax\n");
+	emit("movl $%ld, %%ecx\n", object_size(&var->type));
+	emit("rep stosb\n");
+	for (int i = 0; i < list->data.initializer_list.count && i < struct_sym->member_count; i++) {
+		symbol_t *member = struct_sym->members[i];
+		ast_node_t *value = list->data.initializer_list.values[i];
+		if (value->type == AST_INITIALIZER_LIST || is_aggregate(&member->type_info)) {
+			unsupported(value, "nested initializer");
+			return;
+		}
+		type_info_t vt = decay(gen_expr(value));
+		convert(&vt, &member->type_info, 0);
+		char member_mem[OPERAND_SIZE];
+		snprintf(member_mem, sizeof(member_mem), "%ld(%%rbp)", var->offset + (long)member->offset);
+		store(&member->type_info, member_mem);
+	}
+}
+
+static void gen_declaration(ast_node_t *node)
+{
+	symbol_t *sym = node->data.declaration.symbol;
+	var_t *var = find_var(sym);
+	ast_node_t *init = node->data.declaration.init;
+	if (!var || var->static_id || !init)
+		return;
+
+	char mem[OPERAND_SIZE];
+	int loc = locate(sym, var, mem);
+	if (init->type == AST_INITIALIZER_LIST) {
+		if (is_aggregate(&var->type)) {
+			gen_struct_initializer(var, init, mem);
+			return;
+		}
+		if (init->data.initializer_list.count == 0) {
+			emit("xorl %%eax, %%eax\n");
+		} else {
+			type_info_t vt = decay(gen_expr(init->data.initializer_list.values[0]));
+			convert(&vt, &var->type, 0);
+		}
+	} else {
+		type_info_t vt = decay(gen_expr(init));
+		convert(&vt, &var->type, 0);
+	}
+	if (loc == LOC_REG)
+		emit("movq %%rax, %s\n", alloc_regs[var->reg]);
+	else
+		store(&var->type, mem);
+}
+
+// Only VLAs do anything at run time: the stack grows by the array,
+// rounded to keep %rsp 16-byte aligned
+static void gen_array_declaration(ast_node_t *node)
+{
+	var_t *var = find_var(node->data.array_decl.symbol);
+	if (!var || !var->is_vla)
+		return;
+	type_info_t long_type = make_type("long", 0);
+	type_info_t t = decay(gen_expr(node->data.array_decl.size));
+	convert(&t, &long_type, 0);
+	scale(element_size(&var->type), 0);
+	emit("addq $15, %%rax\n");
+	emit("andq $-16, %%rax\n");
+	emit("subq %%rax, %%rsp\n");
+	emit("movq %%rsp, %d(%%rbp)\n", var->offset);
+}
+
+static void gen_loop_body(ast_node_t *body, int break_label, int continue_label)
+{
+	int saved_break = ctx.break_label, saved_continue = ctx.continue_label;
+	ctx.break_label = break_label;
+	ctx.continue_label = continue_label;
+	gen_stmt(body);
+	ctx.break_label = saved_break;
+	ctx.continue_label = saved_continue;
+}
+
+static void gen_stmt(ast_node_t *node)
+{
+	if (!node)
+		return;
+
+	switch (node->type) {
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < node->data.compound.stmt_count; i++)
+			gen_stmt(node->data.compound.statements[i]);
+		break;
+	case AST_DECLARATION:
+		gen_declaration(node);
+		break;
+	case AST_ARRAY_DECL:
+		gen_array_declaration(node);
+		break;
+	case AST_EXPR_STMT:
+		if (node->data.expr_stmt.expr)
+			gen_expr(node->data.expr_stmt.expr);
+		break;
+	case AST_IF_STMT: {
+		int else_label = new_label();
+		gen_branch(node->data.if_stmt.condition, else_label, 0);
+		gen_stmt(node->data.if_stmt.then_stmt);
+		if (node->data.if_stmt.else_stmt) {
+			int end_label = new_label();
+			emit("jmp .L%d\n", end_label);
+			label_def(else_label);
+			gen_stmt(node->data.if_stmt.else_stmt);
+			label_def(end_label);
+		} else {
+			label_def(else_label);
+		}
+		break;
+	}
+	case AST_WHILE_STMT: {
+		// The condition sits below the body, so each iteration takes one jump
+		int body_label = new_label(), cond_label = new_label(), end_label = new_label();
+		emit("jmp .L%d\n", cond_label);
+		label_def(body_label);
+		gen_loop_body(node->data.while_stmt.body, end_label, cond_label);
+		label_def(cond_label);
+		gen_branch(node->data.while_stmt.condition, body_label, 1);
+		label_def(end_label);
+		break;
+	}
+	case AST_DO_WHILE_STMT: {
+		int body_label = new_label(), cond_label = new_label(), end_label = new_label();
+		label_def(body_label);
+		gen_loop_body(node->data.do_while_stmt.body, end_label, cond_label);
+		label_def(cond_label);
+		gen_branch(node->data.do_while_stmt.condition, body_label, 1);
+		label_def(end_label);
+		break;
+	}
+	case AST_FOR_STMT: {
+		int body_label = new_label(), update_label = new_label();
+		int cond_label = new_label(), end_label = new_label();
+		gen_stmt(node->data.for_stmt.init);
+		emit("jmp .L%d\n", cond_label);
+		label_def(body_label);
+		gen_loop_body(node->data.for_stmt.body, end_label, update_label);
+		label_def(update_label);
+		if (node->data.for_stmt.update)
+			gen_expr(node->data.for_stmt.update);
+		label_def(cond_label);
+		if (node->data.for_stmt.condition)
+			gen_branch(node->data.for_stmt.condition, body_label, 1);
+		else
+			emit("jmp .L%d\n", body_label);
+		label_def(end_label);
+		break;
+	}
+	case AST_SWITCH_STMT:
+		gen_switch(node);
+		break;
+	case AST_CASE_STMT:
+		label_def(case_label(node));
+		gen_stmt(node->data.case_stmt.statement);
+		break;
+	case AST_DEFAULT_STMT:
+		label_def(case_label(node));
+		gen_stmt(node->data.default_stmt.statement);
+		break;
+	case AST_BREAK_STMT:
+	case AST_CONTINUE_STMT: {
+		int label = node->type == AST_BREAK_STMT ? ctx.break_label : ctx.continue_label;
+		if (label < 0)
+			unsupported(node, "break or continue outside a loop");
+		emit("jmp .L%d\n", label);
+		break;
+	}
+	case AST_GOTO_STMT:
+		emit("jmp .Lg%d.%s\n", ctx.function_id, node->data.goto_stmt.label);
+		break;
+	case AST_LABEL_STMT:
+		ir_printf(&ctx.text, ".Lg%d.%s:\n", ctx.function_id, node->data.label_stmt.label);
+		gen_stmt(node->data.label_stmt.statement);
+		break;
+	case AST_RETURN_STMT:
+		if (node->data.return_stmt.value) {
+			type_info_t t = decay(gen_expr(node->data.return_stmt.value));
+			convert(&t, &ctx.return_type, 0);
+		}
+		emit("jmp .L%d\n", ctx.return_label);
+		break;
+	case AST_EMPTY_STMT:
+	case AST_STRUCT_DECL:
+	case AST_UNION_DECL:
+	case AST_ENUM_DECL:
+	case AST_TYPEDEF:
+		break;
+	default:
+		gen_expr(node);
+		break;
+	}
+}
+
+// Data
+
+// A global or static local: .data with a constant initializer, .bss without
+static void emit_data_object(const char *label, int is_global, const type_info_t *t, ast_node_t *init)
+{
+	long size = object_size(t);
+	if (is_float(t) || size <= 0) {
+		unsupported(init, is_float(t) ? "floating point" : "object of unknown size");
+		return;
+	}
+	if (is_global)
+		ir_printf(&ctx.data, "\t.globl %s\n", label);
+
+	long long value = 0;
+	int string = -1;
+	if (init) {
+		if (init->type == AST_STRING_LITERAL && is_pointer(t)) {
+			string = emit_string(init);
+		} else if (is_aggregate(t) || !evaluate_constant(init, ctx.table, &value)) {
+			unsupported(init, "global initializer that is not a constant");
+			return;
+		}
+	}
+	ir_printf(&ctx.data, "\t%s\n\t.align %d\n\t.type %s, @object\n\t.size %s, %ld\n%s:\n", init ? ".data" : ".bss",
+		  object_align(t), label, label, size, label);
+	if (!init) {
+		ir_printf(&ctx.data, "\t.zero %ld\n", size);
+	} else if (string >= 0) {
+		ir_printf(&ctx.data, "\t.quad .LC%d\n", string);
+	} else {
+		static const char *const directives[] = {"", "byte", "short", "", "long", "", "", "", "quad"};
+		if (is_bool(t))
+			value = value != 0;
+		ir_printf(&ctx.data, "\t.%s %lld\n", directives[scalar_size(t)], value);
+	}
+}
+
+// Functions
+
+static void touch(symbol_t *sym)
+{
+	var_t *var = find_var(sym);
+	if (!var)
+		return;
+	if (var->start < 0)
+		var->start = ctx.position;
+	var->end = ctx.position++;
+}
+
+static void declare_local(ast_node_t *node)
+{
+	symbol_t *sym = node->data.declaration.symbol;
+	type_info_t t = node->data.declaration.type_info;
+	if (!sym || t.is_function || t.storage_class == STORAGE_EXTERN || t.storage_class == STORAGE_TYPEDEF)
+		return;
+	if (is_float(&t)) {
+		unsupported(node, "floating point");
+		return;
+	}
+	var_t *var = add_var(sym, t);
+	if (t.storage_class == STORAGE_STATIC) {
+		var->static_id = ++ctx.statics;
+		char label[OPERAND_SIZE];
+		snprintf(label, sizeof(label), "%s.%d", sym->name, var->static_id);
+		emit_data_object(label, 0, &t, node->data.declaration.init);
+		return;
+	}
+	var->candidate = !is_aggregate(&t) && !(t.qualifiers & QUAL_VOLATILE);
+}
+
+static void declare_array(ast_node_t *node)
+{
+	symbol_t *sym = node->data.array_decl.symbol;
+	if (!sym)
+		return;
+	type_info_t t = node->data.array_decl.type_info;
+	t.is_array = 1;
+	t.array_size = node->data.array_decl.size;
+	if (is_float(&t)) {
+		unsupported(node, "floating point");
+		return;
+	}
+	var_t *var = add_var(sym, t);
+	var->is_vla = node->data.array_decl.is_vla;
+	if (t.storage_class == STORAGE_STATIC && !var->is_vla) {
+		var->static_id = ++ctx.statics;
+		char label[OPERAND_SIZE];
+		snprintf(label, sizeof(label), "%s.%d", sym->name, var->static_id);
+		emit_data_object(label, 0, &t, NULL);
+	}
+}
+
+static void loop_begin(int *start)
+{
+	*start = ctx.position;
+}
+
+static void loop_end(int start)
+{
+	if (ctx.loop_count == ctx.loop_cap)
+		ctx.loops = grow(ctx.loops, &ctx.loop_cap, sizeof(loop_t));
+	ctx.loops[ctx.loop_count].start = start;
+	ctx.loops[ctx.loop_count++].end = ctx.position;
+}
+
+// Declares the locals of a function body and numbers every use of them in
+// the order code is generated; an interval from first to last use is what
+// the allocator sees
+static void scan(ast_node_t *node)
+{
+	if (!node)
+		return;
+
+	int start;
+	switch (node->type) {
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < node->data.compound.stmt_count; i++)
+			scan(node->data.compound.statements[i]);
+		break;
+	case AST_DECLARATION:
+		declare_local(node);
+		scan(node->data.declaration.init);
+		touch(node->data.declaration.symbol);
+		break;
+	case AST_ARRAY_DECL:
+		scan(node->data.array_decl.size);
+		declare_array(node);
+		break;
+	case AST_ASSIGNMENT:
+		scan(node->data.assignment.value);
+		if (node->data.assignment.lvalue)
+			scan(node->data.assignment.lvalue);
+		else
+			touch(node->data.assignment.symbol);
+		break;
+	case AST_IF_STMT:
+		scan(node->data.if_stmt.condition);
+		scan(node->data.if_stmt.then_stmt);
+		scan(node->data.if_stmt.else_stmt);
+		break;
+	case AST_WHILE_STMT:
+		loop_begin(&start);
+		scan(node->data.while_stmt.body);
+		scan(node->data.while_stmt.condition);
+		loop_end(start);
+		break;
+	case AST_DO_WHILE_STMT:
+		loop_begin(&start);
+		scan(node->data.do_while_stmt.body);
+		scan(node->data.do_while_stmt.condition);
+		loop_end(start);
+		break;
+	case AST_FOR_STMT:
+		scan(node->data.for_stmt.init);
+		loop_begin(&start);
+		scan(node->data.for_stmt.body);
+		scan(node->data.for_stmt.update);
+		scan(node->data.for_stmt.condition);
+		loop_end(start);
+		break;
+	case AST_SWITCH_STMT:
+		scan(node->data.switch_stmt.expression);
+		scan(node->data.switch_stmt.body);
+		break;
+	case AST_CASE_STMT:
+		scan(node->data.case_stmt.statement);
+		break;
+	case AST_DEFAULT_STMT:
+		scan(node->data.default_stmt.statement);
+		break;
+	case AST_LABEL_STMT:
+		ctx.has_labels = 1;
+		scan(node->data.label_stmt.statement);
+		break;
+	case AST_RETURN_STMT:
+		scan(node->data.return_stmt.value);
+		break;
+	case AST_EXPR_STMT:
+		scan(node->data.expr_stmt.expr);
+		break;
+	case AST_CALL:
+		for (int i = node->data.call.arg_count - 1; i >= 0; i--)
+			scan(node->data.call.args[i]);
+		break;
+	case AST_BINARY_OP:
+		scan(node->data.binary_op.left);
+		scan(node->data.binary_op.right);
+		break;
+	case AST_UNARY_OP:
+		scan(node->data.unary_op.operand);
+		break;
+	case AST_IDENTIFIER:
+		touch(identifier_symbol(node));
+		break;
+	case AST_ADDRESS_OF: {
+		ast_node_t *operand = node->data.address_of.operand;
+		var_t *var = operand->type == AST_IDENTIFIER ? find_var(identifier_symbol(operand)) : NULL;
+		if (var)
+			var->candidate = 0;
+		scan(operand);
+		break;
+	}
+	case AST_DEREFERENCE:
+		scan(node->data.dereference.operand);
+		break;
+	case AST_ARRAY_ACCESS:
+		scan(node->data.array_access.array);
+		scan(node->data.array_access.index);
+		break;
+	case AST_MEMBER_ACCESS:
+		scan(node->data.member_access.object);
+		break;
+	case AST_PTR_MEMBER_ACCESS:
+		scan(node->data.ptr_member_access.object);
+		break;
+	case AST_CAST:
+		scan(node->data.cast.expression);
+		break;
+	case AST_CONDITIONAL:
+		scan(node->data.conditional.condition);
+		scan(node->data.conditional.true_expr);
+		scan(node->data.conditional.false_expr);
+		break;
+	case AST_INITIALIZER_LIST:
+		for (int i = 0; i < node->data.initializer_list.count; i++)
+			scan(node->data.initializer_list.values[i]);
+		break;
+	default:
+		break;
+	}
+}
+
+static int compare_interval_start(const void *a, const void *b)
+{
+	const var_t *x = &ctx.vars[*(const int *)a];
+	const var_t *y = &ctx.vars[*(const int *)b];
+	return (x->start > y->start) - (x->start < y->start);
+}
+
+// Linear scan (Poletto and Sarkar) over the intervals of the candidates.
+// A variable live before a loop and used inside it stays live to the end
+// of the loop, and with labels in the function every interval runs to its
+// end, since a goto may jump backwards. Returns the registers used as a
+// bit mask.
+static unsigned allocate_registers(void)
+{
+	for (int l = 0; l < ctx.loop_count; l++) {
+		for (int i = 0; i < ctx.var_count; i++) {
+			var_t *var = &ctx.vars[i];
+			if (var->start >= 0 && var->start < ctx.loops[l].start && var->end >= ctx.loops[l].start &&
+			    var->end < ctx.loops[l].end)
+				var->end = ctx.loops[l].end;
+		}
+	}
+
+	int *order = malloc(sizeof(int) * (size_t)(ctx.var_count ? ctx.var_count : 1));
+	if (!order) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	int count = 0;
+	for (int i = 0; i < ctx.var_count; i++) {
+		var_t *var = &ctx.vars[i];
+		if (var->candidate && var->start >= 0) {
+			if (ctx.has_labels)
+				var->end = ctx.position;
+			order[count++] = i;
+		}
+	}
+	qsort(order, (size_t)count, sizeof(int), compare_interval_start);
+
+	int active[ALLOC_REG_COUNT];
+	int active_count = 0;
+	unsigned used = 0;
+	for (int n = 0; n < count; n++) {
+		var_t *var = &ctx.vars[order[n]];
+
+		// Expire intervals that ended before this one starts
+		for (int a = 0; a < active_count;) {
+			if (ctx.vars[active[a]].end < var->start)
+				active[a] = active[--active_count];
+			else
+				a++;
+		}
+
+		if (active_count < ALLOC_REG_COUNT) {
+			unsigned taken = 0;
+			for (int a = 0; a < active_count; a++)
+				taken |= 1u << ctx.vars[active[a]].reg;
+			int reg = 0;
+			while (taken & (1u << reg))
+				reg++;
+			var->reg = reg;
+			active[active_count++] = order[n];
+			used |= 1u << reg;
+			continue;
+		}
+
+		// Spill whichever interval ends last
+		int furthest = 0;
+		for (int a = 1; a < active_count; a++) {
+			if (ctx.vars[active[a]].end > ctx.vars[active[furthest]].end)
+				furthest = a;
+		}
+		var_t *victim = &ctx.vars[active[furthest]];
+		if (victim->end > var->end) {
+			var->reg = victim->reg;
+			victim->reg = -1;
+			active[furthest] = order[n];
+		}
+	}
+	free(order);
+	return used;
+}
+
+static void gen_function(ast_node_t *node)
+{
+	const char *name = node->data.function.name;
+	ctx.var_count = 0;
+	map_clear(&ctx.var_map);
+	ctx.loop_count = 0;
+	ctx.position = 0;
+	ctx.has_labels = 0;
+	ctx.depth = 0;
+	ctx.break_label = ctx.continue_label = -1;
+	ctx.function_id++;
+	ctx.return_label = new_label();
+	ctx.return_type = node->data.function.return_type;
+	ctx.return_type.storage_class = STORAGE_NONE;
+
+	if (node->data.function.is_variadic)
+		unsupported(node, "variadic function definition");
+	if (is_float(&ctx.return_type) || is_aggregate(&ctx.return_type))
+		unsupported(node, is_float(&ctx.return_type) ? "floating point" : "struct returned by value");
+
+	// Parameters, then everything the body declares
+	int param_count = node->data.function.param_count;
+	int *param_vars = malloc(sizeof(int) * (size_t)(param_count ? param_count : 1));
+	if (!param_vars) {
+		fprintf(stderr, "Memory allocation failed\n");
+		exit(1);
+	}
+	for (int i = 0; i < param_count; i++) {
+		ast_node_t *param = node->data.function.params[i];
+		param_vars[i] = -1;
+		if (!param || param->type != AST_PARAMETER || !param->data.parameter.symbol)
+			continue;
+		type_info_t t = decay(param->data.parameter.type_info);
+		if (is_void(&t))
+			continue;
+		if (is_float(&t) || is_aggregate(&t)) {
+			unsupported(param, is_float(&t) ? "floating point" : "struct passed by value");
+			continue;
+		}
+		var_t *var = add_var(param->data.parameter.symbol, t);
+		var->candidate = !(t.qualifiers & QUAL_VOLATILE);
+		var->start = var->end = ctx.position++;
+		param_vars[i] = ctx.var_count - 1;
+	}
+	scan(node->data.function.body);
+	unsigned used = allocate_registers();
+
+	// Frame: saved registers first, then a slot for every local in memory.
+	// Parameters past the sixth stay where the caller put them.
+	int saved = 0;
+	int frame = 0;
+	for (int r = 0; r < ALLOC_REG_COUNT; r++) {
+		if (used & (1u << r))
+			frame += 8;
+	}
+	for (int i = 0; i < ctx.var_count; i++) {
+		var_t *var = &ctx.vars[i];
+		if (var->reg >= 0 || var->static_id)
+			continue;
+		int param_index = -1;
+		for (int p = 0; p < param_count; p++) {
+			if (param_vars[p] == i)
+				param_index = p;
+		}
+		if (param_index >= ARG_REG_COUNT) {
+			var->offset = 16 + 8 * (param_index - ARG_REG_COUNT);
+			continue;
+		}
+		long size = var->is_vla ? 8 : object_size(&var->type);
+		int align = var->is_vla ? 8 : object_align(&var->type);
+		if (size <= 0) {
+			unsupported(node, "local of unknown size");
+			size = 8;
+		}
+		frame = (int)((frame + size + align - 1) / align * align);
+		var->offset = -frame;
+	}
+	frame = (frame + 15) / 16 * 16;
+
+	int is_static = node->data.function.storage_class == STORAGE_STATIC ||
+			node->data.function.return_type.storage_class == STORAGE_STATIC;
+	if (!is_static)
+		ir_printf(&ctx.text, "\t.globl %s\n", name);
+	ir_printf(&ctx.text, "\t.type %s, @function\n%s:\n", name, name);
+	emit("pushq %%rbp\n");
+	emit("movq %%rsp, %%rbp\n");
+	if (frame)
+		emit("subq $%d, %%rsp\n", frame);
+	for (int r = 0; r < ALLOC_REG_COUNT; r++) {
+		if (used & (1u << r))
+			emit("movq %s, %d(%%rbp)\n", alloc_regs[r], -8 * ++saved);
+	}
+
+	// Arguments move to their homes, sign or zero extended as callers may
+	// leave narrow values unextended
+	for (int i = 0; i < param_count; i++) {
+		if (param_vars[i] < 0)
+			continue;
+		var_t *var = &ctx.vars[param_vars[i]];
+		char mem[OPERAND_SIZE];
+		int loc = locate(var->sym, var, mem);
+		if (i >= ARG_REG_COUNT) {
+			if (loc == LOC_REG) {
+				load(&var->type, mem[0] ? mem : "", 0);
+				emit("movq %%rax, %s\n", alloc_regs[var->reg]);
+			}
+			continue;
+		}
+		emit("movq %s, %%rax\n", arg_regs[i]);
+		normalize(&var->type, 0);
+		if (loc == LOC_REG)
+			emit("movq %%rax, %s\n", alloc_regs[var->reg]);
+		else
+			store(&var->type, mem);
+	}
+	free(param_vars);
+
+	gen_stmt(node->data.function.body);
+
+	// Falling off the end returns 0, as the LLVM backend does
+	if (!is_void(&ctx.return_type))
+		emit("xorl %%eax, %%eax\n");
+	label_def(ctx.return_label);
+	saved = 0;
+	for (int r = 0; r < ALLOC_REG_COUNT; r++) {
+		if (used & (1u << r))
+			emit("movq %d(%%rbp), %s\n", -8 * ++saved, alloc_regs[r]);
+	}
+	emit("leave\n");
+	emit("ret\n");
+	ir_printf(&ctx.text, "\t.size %s, .-%s\n", name, name);
+}
+
+// Program
+
+// Names this file defines, so references to them skip the PLT and GOT
+static void collect_definitions(ast_node_t *node)
+{
+	if (!node)
+		return;
+	switch (node->type) {
+	case AST_PROGRAM:
+		for (int i = 0; i < node->data.program.decl_count; i++)
+			collect_definitions(node->data.program.declarations[i]);
+		break;
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < node->data.compound.stmt_count; i++)
+			collect_definitions(node->data.compound.statements[i]);
+		break;
+	case AST_FUNCTION:
+		if (node->data.function.body)
+			map_put(&ctx.definitions, node->data.function.name, (intptr_t)node);
+		break;
+	case AST_DECLARATION: {
+		type_info_t *t = &node->data.declaration.type_info;
+		if (t->is_function || t->storage_class == STORAGE_EXTERN || t->storage_class == STORAGE_TYPEDEF)
+			break;
+		// A tentative definition gives way to one with an initializer
+		intptr_t *previous = map_find(&ctx.definitions, node->data.declaration.name);
+		if (!previous || node->data.declaration.init)
+			map_put(&ctx.definitions, node->data.declaration.name, (intptr_t)node);
+		break;
+	}
+	case AST_ARRAY_DECL:
+		if (node->data.array_decl.type_info.storage_class != STORAGE_EXTERN &&
+		    !map_find(&ctx.definitions, node->data.array_decl.name))
+			map_put(&ctx.definitions, node->data.array_decl.name, (intptr_t)node);
+		break;
+	default:
+		break;
+	}
+}
+
+static void gen_top_level(ast_node_t *node)
+{
+	if (!node)
+		return;
+	switch (node->type) {
+	case AST_COMPOUND_STMT:
+		for (int i = 0; i < node->data.compound.stmt_count; i++)
+			gen_top_level(node->data.compound.statements[i]);
+		break;
+	case AST_FUNCTION:
+		if (node->data.function.body)
+			gen_function(node);
+		break;
+	case AST_DECLARATION: {
+		intptr_t *definition = map_find(&ctx.definitions, node->data.declaration.name);
+		if (definition && *definition == (intptr_t)node) {
+			type_info_t *t = &node->data.declaration.type_info;
+			emit_data_object(node->data.declaration.name, t->storage_class != STORAGE_STATIC, t,
+					 node->data.declaration.init);
+		}
+		break;
+	}
+	case AST_ARRAY_DECL: {
+		intptr_t *definition = map_find(&ctx.definitions, node->data.array_decl.name);
+		if (definition && *definition == (intptr_t)node) {
+			type_info_t t = node->data.array_decl.type_info;
+			t.is_array = 1;
+			t.array_size = node->data.array_decl.size;
+			emit_data_object(node->data.array_decl.name, t.storage_class != STORAGE_STATIC, &t, NULL);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+char *x86_generate_assembly(ast_node_t *ast, symbol_table_t *table, size_t *length)
+{
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.table = table;
+	ir_writer_init(&ctx.text, NULL);
+	ir_writer_init(&ctx.data, NULL);
+	ir_writer_init(&ctx.rodata, NULL);
+
+	if (ast && ast->type == AST_PROGRAM) {
+		ir_puts(&ctx.text, "\t.text\n");
+		collect_definitions(ast);
+		for (int i = 0; i < ast->data.program.decl_count; i++)
+			gen_top_level(ast->data.program.declarations[i]);
+	} else {
+		unsupported(ast, "program");
+	}
+
+	char *text = NULL;
+	if (ctx.unsupported) {
+		int line = ctx.unsupported_at ? node_line(ctx.unsupported_at) : 0;
+		if (line > 0)
+			fprintf(stderr, "Native backend: %s (line %d) not supported, using LLVM\n", ctx.unsupported, line);
+		else
+			fprintf(stderr, "Native backend: %s not supported, using LLVM\n", ctx.unsupported);
+	} else {
+		if (ctx.data.len)
+			ir_putn(&ctx.text, ctx.data.buf, ctx.data.len);
+		if (ctx.rodata.len) {
+			ir_puts(&ctx.text, "\t.section .rodata\n");
+			ir_putn(&ctx.text, ctx.rodata.buf, ctx.rodata.len);
+		}
+		ir_puts(&ctx.text, "\t.section .note.GNU-stack,\"\",@progbits\n");
+		*length = ctx.text.len;
+		ir_putc(&ctx.text, '\0');
+		text = ctx.text.buf;
+		ctx.text.buf = NULL;
+	}
+
+	ir_writer_finish(&ctx.text);
+	ir_writer_finish(&ctx.data);
+	ir_writer_finish(&ctx.rodata);
+	map_free(&ctx.definitions);
+	map_free(&ctx.var_map);
+	free(ctx.vars);
+	free(ctx.loops);
+	free(ctx.cases);
+	memset(&ctx, 0, sizeof(ctx));
+	return text;
+}
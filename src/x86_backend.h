@@ -0,0 +1,24 @@
+#ifndef X86_BACKEND_H
+#define X86_BACKEND_H
+
+#include <stddef.h>
+#include "ast.h"
+#include "symbol_table.h"
+
+// Native x86-64 code generator for fast debug builds, picked with
+// --backend=native. It walks the same checked (and folded) AST as
+// generate_llvm_ir() and produces GNU assembler text for the System V ABI,
+// which cc assembles and links. No object file is written directly, so
+// cc stays on the path and the whole build is only about 1.5x faster than
+// LLVM at -O0. Scalar locals that never have their address taken get
+// callee-saved registers by linear scan; everything else lives in stack
+// slots, and there is no other optimization.
+//
+// Returns the assembly as a malloc'd, NUL-terminated buffer of *length
+// bytes. Returns NULL, after naming the first construct it cannot compile
+// on stderr (floating point, structs passed by value, variadic
+// definitions, calls through pointers, ...), so the caller can fall back to
+// the LLVM backend.
+char *x86_generate_assembly(ast_node_t *ast, symbol_table_t *table, size_t *length);
+
+#endif
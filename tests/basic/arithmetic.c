@@ -0,0 +1,6 @@
+int main() {
+    int x = 10;
+    int y = 20;
+    int result = x + y * 2;
+    return result;
+}
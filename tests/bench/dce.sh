@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark da ELIMINAÇÃO DE DEFINIÇÕES static NÃO USADAS.
+# Um arquivo com muitas funções e globais static, das quais só uma parte
+# é alcançável a partir de main; compara linhas de IR, tempo de compilação
+# do IR (llc -O0, ou clang) e tamanho do executável com e sem --no-dce.
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/dce.sh   # usar binário customizado
+#   FUNCS=5000 USED=10 RUNS=5 ./tests/bench/dce.sh
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+FUNCS="${FUNCS:-2000}"
+USED="${USED:-20}"
+RUNS="${RUNS:-3}"
+
+TMP="$(mktemp -d -t dcebench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada sintética ----------
+# h_i chama h_(i-1), então main alcança exatamente h1..h$USED
+SRC="$TMP/statics.c"
+{
+    echo "static int h0(int a) { return a; }"
+    for i in $(seq 1 "$FUNCS"); do
+        cat <<C
+static int g$i = $i;
+static int h$i(int a) {
+    int s = a + g$i;
+    int i;
+    for (i = 0; i < 4; i++) { s = s * 3 + i; s = s ^ (s >> 2); }
+    return h$((i - 1))(s & 1023);
+}
+C
+    done
+    echo "int main() { return h$USED(1) & 0; }"
+} >"$SRC"
+
+# ---------- Helpers ----------
+now_ms () {
+    echo $(($(date +%s%N) / 1000000))
+}
+
+build () {
+    if command -v clang >/dev/null; then
+        clang -O0 -o "$TMP/prog" "$TMP/out.ll"
+    else
+        llc -O0 -relocation-model=pic -filetype=obj "$TMP/out.ll" -o "$TMP/prog.o"
+        cc -o "$TMP/prog" "$TMP/prog.o"
+    fi
+}
+
+# Linhas de IR, melhor tempo de build do IR entre RUNS execuções e
+# tamanho do executável
+measure () {
+    "$BIN" -S "$@" "$SRC" -o "$TMP/out.ll" >/dev/null
+    local best=""
+    for _ in $(seq 1 "$RUNS"); do
+        local start end
+        start=$(now_ms)
+        build
+        end=$(now_ms)
+        if [ -z "$best" ] || [ $((end - start)) -lt "$best" ]; then
+            best=$((end - start))
+        fi
+    done
+    echo "$(wc -l <"$TMP/out.ll") linhas de IR, build $best ms, executável $(wc -c <"$TMP/prog") bytes"
+}
+
+# ---------- Execução ----------
+echo "== Benchmark de DCE ($FUNCS funções static, $USED usadas, melhor de $RUNS) =="
+echo "  com DCE:  $(measure)"
+echo "  --no-dce: $(measure --no-dce)"
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark do DOBRAMENTO DE CONSTANTES.
+# Funções cheias de aritmética entre constantes de enum, sizeof, máscaras
+# e blocos "if (DEBUG)"; compara linhas de IR e tempo de geração de código
+# (ms, reportado por --stats) com e sem --no-fold.
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/fold.sh   # usar binário customizado
+#   FUNCS=5000 RUNS=5 ./tests/bench/fold.sh
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+FUNCS="${FUNCS:-2000}"
+RUNS="${RUNS:-3}"
+
+TMP="$(mktemp -d -t foldbench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada sintética ----------
+SRC="$TMP/consts.c"
+{
+    echo "enum { DEBUG = 0, SHIFT = 4, MASK = (1 << SHIFT) - 1, WORDS = 64 / sizeof(int) };"
+    echo "struct rec { int key; int value; char tag; };"
+    for i in $(seq 1 "$FUNCS"); do
+        cat <<C
+int h$i(int a, int b) {
+    int buf[WORDS * 2];
+    int s = (a & MASK) * 1 + 0;
+    buf[WORDS - 1] = s * (SHIFT * SHIFT - 15) + b * 0;
+    if (DEBUG) { s = s + buf[0] * 3; buf[1] = s; }
+    while (DEBUG && s) { s = s - 1; }
+    s = s + (sizeof(struct rec) * 8 - 3 * 4) / 2 + (DEBUG ? a : b);
+    if (WORDS > 8) { s = s | (1 << SHIFT); } else { s = s ^ MASK; }
+    return s + buf[WORDS - 1] + (MASK & ~0) - -$i;
+}
+C
+    done
+    echo "int main() { return h1(3, 4) & 0; }"
+} >"$SRC"
+
+# ---------- Helpers ----------
+# Melhor tempo de geração de código entre RUNS execuções, e linhas de IR
+best_ms () {
+    local best=""
+    for _ in $(seq 1 "$RUNS"); do
+        local gen
+        gen=$("$BIN" -S --stats "$@" "$SRC" -o "$TMP/out.ll" 2>&1 >/dev/null | awk '/Code generation:/ { print $3 }')
+        if [ -z "$best" ] || awk -v a="$gen" -v b="$best" 'BEGIN { exit !(a < b) }'; then
+            best=$gen
+        fi
+    done
+    echo "geração $best ms, $(wc -l <"$TMP/out.ll") linhas de IR"
+}
+
+# ---------- Execução ----------
+echo "== Benchmark de dobramento ($FUNCS funções, melhor de $RUNS) =="
+echo "  com dobramento: $(best_ms)"
+echo "  --no-fold:      $(best_ms --no-fold)"
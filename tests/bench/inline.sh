@@ -0,0 +1,101 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark do INLINING.
+# Funções pequenas (folhas e declaradas inline) chamadas dentro de laços;
+# compara chamadas que sobram no IR e tempo de execução do binário (-O0,
+# onde o clang não faz inlining) com e sem --no-inline.
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/inline.sh   # usar binário customizado
+#   N=50000000 RUNS=5 ./tests/bench/inline.sh
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+N="${N:-20000000}"
+RUNS="${RUNS:-3}"
+
+TMP="$(mktemp -d -t inlinebench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada sintética ----------
+SRC="$TMP/calls.c"
+cat >"$SRC" <<C
+int absi(int v) { return v < 0 ? -v : v; }
+int clampi(int v, int lo, int hi) { if (v < lo) return lo; if (v > hi) return hi; return v; }
+static inline int mix(int a, int b) { return clampi(a * 31 + absi(b), -1000, 1000); }
+int step(int s, int i) { return (s + mix(i, s)) & 65535; }
+int main() {
+    int i;
+    int s = 0;
+    for (i = 0; i < $N; i++) {
+        s = step(s, i - 7) + absi(i & 3);
+    }
+    return s & 127;
+}
+C
+
+MANY="$TMP/many.c"
+{
+    for i in $(seq 0 1999); do
+        echo "int f$i(int a, int b) { int s = a; if (b > $i) s = s + b * $((i % 7)); return s - $i; }"
+    done
+    echo 'int main() {'
+    echo '    int s = 0;'
+    for i in $(seq 0 50 1999); do
+        echo "    s = s + f$i(s, $i);"
+    done
+    echo '    return s & 127;'
+    echo '}'
+} >"$MANY"
+
+# ---------- Helpers ----------
+now_ms () {
+    echo $(($(date +%s%N) / 1000000))
+}
+
+# Chamadas no IR e melhor tempo (ms) entre RUNS execuções do binário
+measure () {
+    "$BIN" -S "$@" "$SRC" -o "$TMP/out.ll" >/dev/null
+    if command -v clang >/dev/null; then
+        clang -O0 -o "$TMP/prog" "$TMP/out.ll"
+    else
+        llc -O0 -filetype=obj "$TMP/out.ll" -o "$TMP/prog.o"
+        cc -o "$TMP/prog" "$TMP/prog.o"
+    fi
+    local calls best=""
+    calls=$(grep -c ' call ' "$TMP/out.ll" || true)
+    for _ in $(seq 1 "$RUNS"); do
+        local start end
+        start=$(now_ms)
+        "$TMP/prog" >/dev/null 2>&1 || true
+        end=$(now_ms)
+        if [ -z "$best" ] || [ $((end - start)) -lt "$best" ]; then
+            best=$((end - start))
+        fi
+    done
+    echo "$calls chamadas no IR, execução $best ms"
+}
+
+# Melhor tempo de geração de código (--stats) entre RUNS compilações de MANY
+codegen_ms () {
+    local best=""
+    for _ in $(seq 1 "$RUNS"); do
+        local ms
+        ms=$("$BIN" --stats -S "$@" "$MANY" -o "$TMP/many.ll" 2>&1 >/dev/null |
+             awk '/Code generation:/ { print int($3) }')
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+            best=$ms
+        fi
+    done
+    echo "$best ms"
+}
+
+# ---------- Execução ----------
+echo "== Benchmark de inlining ($N iterações, -O0, melhor de $RUNS) =="
+echo "  com inlining: $(measure)"
+echo "  --no-inline:  $(measure --no-inline)"
+echo
+echo "== Geração de código de 2000 funções folha, 40 chamadas (melhor de $RUNS) =="
+echo "  com inlining: $(codegen_ms)"
+echo "  --no-inline:  $(codegen_ms --no-inline)"
@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark da EMISSÃO de IR.
+# Compara o writer bufferizado (padrão) com o caminho antigo de uma
+# chamada stdio por fragmento (--no-ir-buffer) num arquivo sintético grande.
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/ir_emit.sh   # usar binário customizado
+#   FUNCS=5000 RUNS=5 ./tests/bench/ir_emit.sh
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+FUNCS="${FUNCS:-2000}"
+RUNS="${RUNS:-3}"
+
+TMP="$(mktemp -d -t irbench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada sintética ----------
+SRC="$TMP/big.c"
+{
+    for i in $(seq 1 "$FUNCS"); do
+        cat <<C
+int f$i(int a, int b) {
+    int s = 0;
+    int i;
+    for (i = 0; i < a; i++) {
+        if (i % 3 == 0 && b > 0) {
+            s = s + i * b - (a ^ i);
+        } else {
+            s = s - (i << 2) + (b | 1);
+        }
+    }
+    while (s > 1000) {
+        s = s / 2;
+    }
+    return s;
+}
+C
+    done
+    echo "int main() { return f1(3, 4) & 0; }"
+} >"$SRC"
+
+# ---------- Helpers ----------
+# Melhor tempo de geração de código (ms, reportado por --stats) entre RUNS
+# execuções; o tempo do front-end fica de fora da comparação
+best_ms () {
+    local best=""
+    for _ in $(seq 1 "$RUNS"); do
+        local ms
+        ms=$("$BIN" -S --stats "$@" "$SRC" -o "$TMP/out.ll" 2>&1 >/dev/null |
+             awk '/Code generation:/ { print $3 }')
+        if [ -z "$best" ] || awk -v a="$ms" -v b="$best" 'BEGIN { exit !(a < b) }'; then
+            best=$ms
+        fi
+    done
+    echo "$best"
+}
+
+# ---------- Execução ----------
+echo "== Benchmark de emissão de IR ($FUNCS funções, melhor de $RUNS) =="
+buffered=$(best_ms)
+cp "$TMP/out.ll" "$TMP/buffered.ll"
+unbuffered=$(best_ms --no-ir-buffer)
+
+# As duas saídas devem ser idênticas byte a byte
+if ! cmp -s "$TMP/buffered.ll" "$TMP/out.ll"; then
+    echo "FAIL: saída difere entre os modos"
+    exit 1
+fi
+
+echo "  IR gerado:        $(wc -l <"$TMP/out.ll") linhas"
+echo "  --no-ir-buffer:   ${unbuffered} ms"
+echo "  buffer (padrão):  ${buffered} ms"
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark do LÉXICO.
+# Mede a vazão de --lex-only (bytes/s reportados por -v) em
+# examples/text_editor.c e num arquivo sintético grande.
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/lex.sh   # usar binário customizado
+#   FUNCS=20000 RUNS=5 ./tests/bench/lex.sh
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+FUNCS="${FUNCS:-5000}"
+RUNS="${RUNS:-3}"
+
+TMP="$(mktemp -d -t lexbench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada sintética ----------
+# Mistura identificadores longos, comentários, strings e indentação
+SRC="$TMP/big.c"
+{
+    for i in $(seq 1 "$FUNCS"); do
+        cat <<C
+/*
+ * Função $i: soma os elementos de um vetor e registra o resultado.
+ */
+int accumulate_values_$i(int *values, int value_count) {
+        int running_total = 0;      // acumulador
+        int index;
+        for (index = 0; index < value_count; index++) {
+                running_total = running_total + values[index] * $i;
+        }
+        printf("accumulate_values_$i: %d\n", running_total);
+        return running_total;
+}
+C
+    done
+} >"$SRC"
+
+# ---------- Helpers ----------
+# Melhor vazão (MB/s) entre RUNS execuções
+best_rate () {
+    local best="" line=""
+    for _ in $(seq 1 "$RUNS"); do
+        line=$("$BIN" --lex-only -v "$1" | grep '^Scanned')
+        local rate
+        rate=$(echo "$line" | sed 's/.*(\([0-9.]*\) MB\/s.*/\1/')
+        if [ -z "$best" ] || awk -v a="$rate" -v b="$best" 'BEGIN { exit !(a > b) }'; then
+            best=$rate
+        fi
+    done
+    echo "$best MB/s  ($(echo "$line" | sed 's/^Scanned \([0-9]*\) bytes.*, \([a-z0-9]*\) fast path)$/\1 bytes, \2/'))"
+}
+
+# ---------- Execução ----------
+echo "== Benchmark do léxico (melhor de $RUNS) =="
+echo "  text_editor.c:      $(best_rate examples/text_editor.c)"
+echo "  sintético ($FUNCS): $(best_rate "$SRC")"
@@ -0,0 +1,119 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark do BACKEND NATIVO.
+# Tempo de ponta a ponta de "-c" (fonte até executável) com
+# --backend=native, comparado ao caminho LLVM: o IR gerado com -S e
+# compilado por clang -O0 (ou llc -O0 + cc quando não há clang).
+# Também confere que o executável nativo roda e devolve o esperado.
+# Cada caminho é quebrado em geração (-S) e no que vem depois: o cc que
+# monta e liga o assembly, ou o clang que compila o IR. O minicc não
+# escreve o objeto direto, então o montador e o ligador externos são um
+# piso do tempo nativo e limitam o ganho (perto de 1,5x).
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/native.sh   # usar binário customizado
+#   FUNCS=2000 RUNS=5 ./tests/bench/native.sh
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+FUNCS="${FUNCS:-500}"
+RUNS="${RUNS:-3}"
+
+TMP="$(mktemp -d -t nativebench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada sintética ----------
+# Laços, vetores, switch, globais e chamadas: o que um build de depuração compila
+SRC="$TMP/prog.c"
+{
+    echo "int count;"
+    echo "long total;"
+    for i in $(seq 1 "$FUNCS"); do
+        cat <<C
+int f$i(int n) {
+    int v[16];
+    int i, s = 0;
+    for (i = 0; i < 16; i++) v[i] = (i * $i + n) % 31;
+    i = 0;
+    while (i < 16) { if (v[i] & 1) s += v[i]; else s -= i; i++; }
+    switch (s & 3) { case 0: s += 2; break; case 1: s *= 3; break; default: s--; }
+    count++;
+    total += s;
+    return s;
+}
+C
+    done
+    echo "int main() {"
+    for i in $(seq 1 "$FUNCS"); do
+        echo "    f$i($i);"
+    done
+    echo "    return count == $FUNCS ? 0 : 1;"
+    echo "}"
+} >"$SRC"
+
+# ---------- Helpers ----------
+now_ms () {
+    echo $(($(date +%s%N) / 1000000))
+}
+
+# Melhor tempo (ms) entre RUNS execuções do comando; 0 se falhar
+best_ms () {
+    local best=""
+    for _ in $(seq 1 "$RUNS"); do
+        local start end
+        start=$(now_ms)
+        "$@" >/dev/null 2>&1 || { echo 0; return; }
+        end=$(now_ms)
+        if [ -z "$best" ] || [ $((end - start)) -lt "$best" ]; then
+            best=$((end - start))
+        fi
+    done
+    echo "$best"
+}
+
+# "N ms", ou "falhou"
+show_ms () {
+    if [ "$1" = 0 ]; then echo "falhou"; else echo "$1 ms"; fi
+}
+
+llvm_link () {
+    if command -v clang >/dev/null; then
+        clang -O0 -o "$TMP/prog.llvm" "$TMP/prog.ll"
+    else
+        llc -O0 -filetype=obj "$TMP/prog.ll" -o "$TMP/prog.o"
+        cc -o "$TMP/prog.llvm" "$TMP/prog.o"
+    fi
+}
+
+llvm_build () {
+    "$BIN" -S "$SRC" -o "$TMP/prog.ll"
+    llvm_link
+}
+
+# ---------- Execução ----------
+echo "== Benchmark do backend nativo ($FUNCS funções, melhor de $RUNS) =="
+native=$(best_ms "$BIN" --backend=native -c "$SRC" -o "$TMP/prog.native")
+echo "  --backend=native: $(show_ms "$native")"
+if "$TMP/prog.native"; then
+    echo "  executável nativo: ok"
+else
+    echo "  executável nativo: código de saída inesperado"
+fi
+echo "    geração (-S):   $(show_ms "$(best_ms "$BIN" --backend=native -S "$SRC" -o "$TMP/prog.s")")"
+assemble=$(best_ms cc -o "$TMP/prog.s.native" "$TMP/prog.s")
+echo "    cc (montar e ligar): $(show_ms "$assemble")"
+if command -v clang >/dev/null || command -v llc >/dev/null; then
+    llvm=$(best_ms llvm_build)
+    echo "  LLVM -O0:         $(show_ms "$llvm")"
+    echo "    geração (-S):   $(show_ms "$(best_ms "$BIN" -S "$SRC" -o "$TMP/prog.ll")")"
+    echo "    back-end -O0:   $(show_ms "$(best_ms llvm_link)")"
+    if [ "$native" != 0 ] && [ "$llvm" != 0 ]; then
+        # O objeto não é escrito pelo minicc: o cc externo é um piso do tempo nativo
+        awk -v n="$native" -v l="$llvm" -v a="$assemble" 'BEGIN {
+            printf "  ganho sobre LLVM -O0: %.2fx (o cc externo leva %d%% do tempo nativo)\n", l / n, 100 * a / n
+        }'
+    fi
+else
+    echo "  LLVM -O0:         sem clang nem llc, ignorado"
+fi
@@ -0,0 +1,77 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark dos ESCOPOS.
+# Muitos blocos pequenos (corpo de cada if/for/while) abrem e fecham um
+# escopo cada; mede a análise semântica e a geração de código (ms,
+# reportados por --stats) num arquivo sintético com esse perfil.
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/scopes.sh   # usar binário customizado
+#   BASE=/tmp/minicc-antigo ./tests/bench/scopes.sh   # comparar com outro
+#   FUNCS=5000 RUNS=5 ./tests/bench/scopes.sh
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+BASE="${BASE:-}"
+FUNCS="${FUNCS:-2000}"
+RUNS="${RUNS:-3}"
+
+TMP="$(mktemp -d -t scopebench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada sintética ----------
+# Cada função tem ~20 blocos com uma ou duas declarações cada
+SRC="$TMP/blocks.c"
+{
+    for i in $(seq 1 "$FUNCS"); do
+        cat <<C
+int g$i(int a, int b) {
+    int s = 0;
+    for (int i = 0; i < a; i++) {
+        if (i & 1) { int t = i * b; s = s + t; } else { int t = i - b; s = s - t; }
+        if (i % 3 == 0) { int u = s >> 1; s = u; }
+        while (s > 1000) { int h = s / 2; s = h; }
+        { int v = a + i; { int w = v * 2; s = s + w; } }
+        do { int d = b; s = s ^ d; } while (0);
+    }
+    if (a > b) { int m = a; { int n = m - b; s = s + n; } } else { int m = b; s = s - m; }
+    { int x = s; { int y = x + 1; { int z = y + 1; s = z; } } }
+    return s;
+}
+C
+    done
+    echo "int main() { return g1(3, 4) & 0; }"
+} >"$SRC"
+
+# ---------- Helpers ----------
+# Melhores tempos (semântica e geração de código) entre RUNS execuções
+best_ms () {
+    local bin=$1 best_sem="" best_gen=""
+    for _ in $(seq 1 "$RUNS"); do
+        local out sem gen
+        out=$("$bin" -S --stats "$SRC" -o "$TMP/out.ll" 2>&1 >/dev/null)
+        sem=$(echo "$out" | awk '/Semantic analysis:/ { print $3 }')
+        gen=$(echo "$out" | awk '/Code generation:/ { print $3 }')
+        if [ -z "$best_sem" ] || awk -v a="$sem" -v b="$best_sem" 'BEGIN { exit !(a < b) }'; then
+            best_sem=$sem
+        fi
+        if [ -z "$best_gen" ] || awk -v a="$gen" -v b="$best_gen" 'BEGIN { exit !(a < b) }'; then
+            best_gen=$gen
+        fi
+    done
+    echo "semântica ${best_sem:-?} ms, geração ${best_gen} ms"
+}
+
+# ---------- Execução ----------
+echo "== Benchmark de escopos ($FUNCS funções, melhor de $RUNS) =="
+echo "  $BIN: $(best_ms "$BIN")"
+if [ -n "$BASE" ]; then
+    cp "$TMP/out.ll" "$TMP/bin.ll"
+    echo "  $BASE: $(best_ms "$BASE")"
+    # O escopo não muda o código gerado
+    if ! cmp -s "$TMP/bin.ll" "$TMP/out.ll"; then
+        echo "FAIL: saída difere entre os binários"
+        exit 1
+    fi
+fi
@@ -0,0 +1,90 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Benchmark da VETORIZAÇÃO do IR gerado.
+# Laços simples sobre vetores (soma, produto escalar, saxpy, preenchimento)
+# são compilados com -S e otimizados em -O3 por opt (ou clang); conta
+# quantas funções saíram com instruções vetoriais (<N x i32>). Depende do
+# target datalayout/triple no módulo, de GEPs inbounds e de nsw nas
+# operações com sinal. Com opt, conta também as extensões de sinal (sext)
+# que sobram dentro dos laços em -O2 sem vetorização: os índices i64 e o
+# nsw deixam o indvars alargar o contador, e o esperado é zero.
+# O saxpy aparece também com restrict: os parâmetros saem noalias e o
+# vetorizador dispensa a checagem de sobreposição em tempo de execução
+# (vector.memcheck) que a versão sem restrict precisa.
+#
+# Dicas:
+#   BIN=./minicc ./tests/bench/vectorize.sh   # usar binário customizado
+#   KEEP=1 ./tests/bench/vectorize.sh         # mostrar o IR otimizado
+
+# ---------- Config ----------
+BIN="${BIN:-./minicc}"
+KEEP="${KEEP:-0}"
+
+TMP="$(mktemp -d -t vecbench.XXXX)"
+trap 'rm -rf "$TMP"' EXIT
+
+# ---------- Entrada ----------
+SRC="$TMP/loops.c"
+cat >"$SRC" <<'C'
+int sum(int *a, int n) {
+    int s = 0;
+    int i;
+    for (i = 0; i < n; i++) { s = s + a[i]; }
+    return s;
+}
+int dot(int *a, int *b, int n) {
+    int s = 0;
+    int i;
+    for (i = 0; i < n; i++) { s = s + a[i] * b[i]; }
+    return s;
+}
+void saxpy(int *y, int *x, int n, int k) {
+    int i;
+    for (i = 0; i < n; i++) { y[i] = y[i] + x[i] * k; }
+}
+void saxpy_r(int *restrict y, const int *restrict x, int n, int k) {
+    int i;
+    for (i = 0; i < n; i++) { y[i] = y[i] + x[i] * k; }
+}
+void fill(int *a, int n, int v) {
+    int i;
+    for (i = 0; i < n; i++) { a[i] = v + i; }
+}
+C
+
+# ---------- Helpers ----------
+optimize () {
+    if command -v opt >/dev/null; then
+        opt -O3 -S "$1" -o "$2"
+    else
+        clang -O3 -S -emit-llvm "$1" -o "$2"
+    fi
+}
+
+# ---------- Execução ----------
+echo "== Benchmark de vetorização (-O3) =="
+if ! command -v opt >/dev/null && ! command -v clang >/dev/null; then
+    echo "  sem opt nem clang, ignorado"
+    exit 0
+fi
+"$BIN" -S "$SRC" -o "$TMP/loops.ll" >/dev/null
+if ! optimize "$TMP/loops.ll" "$TMP/loops.opt.ll"; then
+    echo "  o IR gerado não passou pelo otimizador"
+    exit 1
+fi
+total=$(grep -c '^define' "$TMP/loops.opt.ll")
+vectorized=$(awk '/^define/ { f = $0 } /x i32>/ && f != "" { seen[f] = 1 } END { print length(seen) }' "$TMP/loops.opt.ll")
+echo "  funções vetorizadas: $vectorized de $total"
+memchecks () {
+    awk -v fn="$1" '/^define/ { f = ($0 ~ "@" fn "\\(") } f && /^vector\.memcheck/ { n++ } END { print n + 0 }' "$TMP/loops.opt.ll"
+}
+echo "  checagens de sobreposição: saxpy $(memchecks saxpy), saxpy com restrict $(memchecks saxpy_r)"
+if command -v opt >/dev/null; then
+    opt -O2 -vectorize-loops=false -S "$TMP/loops.ll" -o "$TMP/loops.o2.ll"
+    sext=$(awk '/^[a-z_.0-9]+:/ { body = ($1 ~ /^(for|while|do)_body/) } body && / sext / { n++ } END { print n + 0 }' "$TMP/loops.o2.ll")
+    echo "  sext dentro dos laços (-O2): $sext"
+fi
+if [ "$KEEP" = 1 ]; then
+    cat "$TMP/loops.opt.ll"
+fi
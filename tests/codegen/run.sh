@@ -0,0 +1,690 @@
+# tests/codegen/run.sh
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Runner de testes da GERAÇÃO DE CÓDIGO.
+# Verifica:
+#   (1) Casos OK: o IR passa no opt -verify em cada modo do minicc (padrão,
+#       --no-mem2reg, --no-inline, --no-dce, --codegen-threads=4 e os
+#       extras do caso) e o
+#       programa, executado com lli, sai com o código esperado e a mesma
+#       saída em todos os modos e também depois de opt -O2
+#   (2) Casos BAD: a compilação falha e o diagnóstico aparece uma vez
+#   (3) Padrões que o IR do modo padrão deve (ou não deve) conter
+#
+# Dicas:
+#   BIN=./minicc ./tests/codegen/run.sh
+#   KEEP_TMP=1 ./tests/codegen/run.sh
+#   bash -x ./tests/codegen/run.sh
+
+BIN="${BIN:-./minicc}"
+MODES=("" "--no-mem2reg" "--no-inline" "--no-dce" "--codegen-threads=4")
+
+if ! command -v opt >/dev/null || ! command -v lli >/dev/null; then
+    echo "== Casos de GERAÇÃO DE CÓDIGO: sem opt ou lli, ignorado =="
+    exit 0
+fi
+
+TMP="$(mktemp -d -t gencases.XXXX)"
+if [ "${KEEP_TMP:-0}" = "1" ]; then
+    echo "# KEEP_TMP=1 — casos em: $TMP"
+else
+    trap 'rm -rf "$TMP"' EXIT
+fi
+
+ok_total=0 ok_pass=0
+bad_total=0 bad_pass=0
+ir_total=0 ir_pass=0
+
+# Executa um .ll com lli; imprime a saída e, na última linha, o código
+run_ll () {
+    local rc=0
+    timeout 10 lli "$1" </dev/null || rc=$?
+    echo "exit=$rc"
+}
+
+# run_ok NOME CÓDIGO [MODOS EXTRAS SEPARADOS POR VÍRGULA]: fonte na entrada padrão
+run_ok () {
+    local name="$1" code="$2"
+    local f="$TMP/${name}.c"
+    cat >"$f"
+    local reference="" problem=""
+    local i=0
+    local modes=("${MODES[@]}")
+    [ -n "${3:-}" ] && IFS=',' read -r -a extra <<<"$3" && modes+=("${extra[@]}")
+    for mode in "${modes[@]}"; do
+        local ll="$TMP/${name}.$i.ll"
+        i=$((i+1))
+        if ! "$BIN" $mode -S "$f" -o "$ll" >/dev/null 2>"$ll.err"; then
+            problem="não compila com '$mode'"
+            break
+        fi
+        if ! opt -verify "$ll" -o /dev/null 2>"$ll.err"; then
+            problem="IR inválido com '$mode': $(head -1 "$ll.err")"
+            break
+        fi
+        local out
+        out="$(run_ll "$ll")"
+        if [ -z "$reference" ]; then
+            reference="$out"
+            opt -O2 -S "$ll" -o "$ll.O2.ll"
+            if [ "$(run_ll "$ll.O2.ll")" != "$reference" ]; then
+                problem="saída muda depois de opt -O2"
+                break
+            fi
+        elif [ "$out" != "$reference" ]; then
+            problem="saída muda com '$mode'"
+            break
+        fi
+    done
+    if [ -z "$problem" ] && [ "${reference##*exit=}" != "$code" ]; then
+        problem="código ${reference##*exit=}, esperado $code"
+    fi
+    if [ -z "$problem" ]; then
+        echo "PASS (ok):  $name"
+        ok_pass=$((ok_pass+1))
+    else
+        echo "FAIL (ok):  $name  ($problem)"
+    fi
+    ok_total=$((ok_total+1))
+}
+
+# run_bad NOME MENSAGEM: a compilação falha e MENSAGEM sai uma única vez
+run_bad () {
+    local name="$1" message="$2"
+    local f="$TMP/${name}.c"
+    cat >"$f"
+    if "$BIN" -S "$f" -o "$TMP/${name}.ll" >/dev/null 2>"$TMP/${name}.err"; then
+        echo "FAIL (bad): $name  (esperado: exit != 0)"
+    elif [ "$(grep -cF -- "$message" "$TMP/${name}.err")" != 1 ]; then
+        echo "FAIL (bad): $name  (esperado: '$message' uma vez)"
+    else
+        echo "PASS (bad): $name"
+        bad_pass=$((bad_pass+1))
+    fi
+    bad_total=$((bad_total+1))
+}
+
+# ir_has / ir_lacks NOME PADRÃO: grep -E no IR do modo padrão de NOME
+ir_check () {
+    local expect="$1" name="$2" pattern="$3"
+    local found=0
+    grep -Eq -- "$pattern" "$TMP/${name}.0.ll" 2>/dev/null && found=1
+    if [ "$found" = "$expect" ]; then
+        ir_pass=$((ir_pass+1))
+    else
+        echo "FAIL (ir):  $name  ($([ "$expect" = 1 ] && echo "falta" || echo "sobra") '$pattern')"
+    fi
+    ir_total=$((ir_total+1))
+}
+ir_has () { ir_check 1 "$@"; }
+ir_lacks () { ir_check 0 "$@"; }
+
+echo "== Gerando e rodando casos de GERAÇÃO DE CÓDIGO =="
+
+# --------- ARITMÉTICA ---------
+
+# Sem signo: nada de nsw nem comparação com sinal, mesmo aninhado
+run_ok unsigned_wrap 1 <<'C'
+int f(unsigned a, unsigned b) {
+    unsigned t = a * b + 1;
+    if (t > a * b) return 1;
+    return 0;
+}
+long g(unsigned long a) { return a * 3 + 1; }
+int main() {
+    unsigned long v = 1;
+    if (f(65535, 65537)) return 2;
+    if (g(v) != 4) return 3;
+    return f(2, 3);
+}
+C
+ir_lacks unsigned_wrap 'nsw'
+ir_has unsigned_wrap 'icmp ugt'
+
+# Divisão, resto e deslocamento sem signo
+run_ok unsigned_div 7 <<'C'
+int main() {
+    unsigned x = 0;
+    x = x - 2;
+    unsigned q = x / 2;
+    unsigned r = x % 10;
+    unsigned s = x >> 28;
+    return (q == 2147483647) + (r == 4) * 2 + (s == 15) * 4;
+}
+C
+
+# int com sinal mantém o nsw
+run_ok signed_nsw 42 <<'C'
+int f(int a, int b) { return a * b + 2; }
+int main() { return f(5, 8); }
+C
+ir_has signed_nsw 'mul nsw'
+
+# --------- PONTEIROS ---------
+
+# Diferença de ponteiros é um long: argumento int, cast, long e condição
+run_ok ptrdiff_contexts 45 <<'C'
+int seen;
+void pn(int n) { seen = seen + n; }
+long span(int *p, int *q) { return q - p; }
+int take(long n) { return (int)(n * 2); }
+int main() {
+    int a[10];
+    int *p = a;
+    int *q = a + 7;
+    pn(q - p);
+    int x = (int)(q - p);
+    long d = q - p;
+    pn((int)d);
+    int r = seen + x;
+    if (q - p) r = r + 1;
+    if (!(q - q)) r = r + 1;
+    if ((q - p) && d) r = r + 1;
+    r = r + take(q - p) + (int)span(p, q);
+    return r;
+}
+C
+ir_lacks ptrdiff_contexts 'bitcast i64'
+
+# Argumentos convertidos para o tipo do parâmetro: sinal, largura e void *.
+# A aritmética de long é feita em i32, então wide() olha a palavra alta
+run_ok call_conversions 15 <<'C'
+int wide(long n) {
+    long v = n;
+    int *words = (int *)&v;
+    return words[1] < 0;
+}
+int narrow(char c) { return c; }
+int is_null(void *p) { return p == 0; }
+int main() {
+    int m = -1;
+    unsigned u = 4294967295;
+    int a[2];
+    return wide(m) + (wide(u) == 0) * 2 + (narrow(260) == 4) * 4 + is_null(0) * 8 + is_null(a);
+}
+C
+
+# --------- SWITCH ---------
+
+# Declarações antes do primeiro case (e puladas por goto) ainda têm slot
+run_ok switch_skipped_decl 59 <<'C'
+int f(int x) {
+    switch (x) {
+        int y;
+        int arr[3];
+    case 1:
+        y = 5;
+        arr[0] = y;
+        return arr[0] + y;
+    case 2:
+        y = 7;
+        return y;
+    default:
+        return 0;
+    }
+}
+int g(int x) {
+    if (x) goto later;
+    return 1;
+    int z;
+later:
+    z = 40;
+    return z + x;
+}
+int main() { return f(1) + f(2) + f(3) + g(2); }
+C
+
+# Fallthrough, default, cases agrupados, negativos e switch aninhado, em
+# todas as formas de baixar o switch
+run_ok switch_lowering 112 "--switch=table,--switch=tree,--switch=llvm,--no-fold" <<'C'
+int classify(int x) {
+    int r = 0;
+    switch (x) {
+    case 0:
+        r = r + 1;
+    case 1:
+        r = r + 2;
+        break;
+    case 5:
+    case 6:
+        r = 10;
+        break;
+    case -2:
+        r = 7;
+        break;
+    default:
+        r = 20;
+    }
+    return r;
+}
+int sparse(int x) {
+    switch (x) {
+    case 1: return 1;
+    case 100: return 2;
+    case 1000: return 3;
+    case 10000: return 4;
+    case 100000: return 5;
+    case -100000: return 6;
+    }
+    return 0;
+}
+int nested(int a, int b) {
+    switch (a) {
+    case 1:
+        switch (b) {
+        case 1: return 11;
+        case 2: break;
+        }
+        return 10;
+    case 2:
+        return 20;
+    }
+    return -1;
+}
+int letter(char c) {
+    switch (c) {
+    case 'a': return 1;
+    case 'b': return 2;
+    case 'z': return 3;
+    }
+    return 0;
+}
+int main() {
+    int s = classify(0) + classify(1) + classify(5) + classify(6) + classify(9) + classify(-2);
+    s = s + nested(1, 1) + nested(1, 2) + nested(2, 0) + nested(3, 3);
+    s = s + sparse(100000) + sparse(-100000) + sparse(10000) + sparse(7);
+    s = s + letter('z') + letter('b') + letter('q');
+    return s;
+}
+C
+ir_has switch_lowering 'indirectbr'
+ir_has switch_lowering 'switch i32'
+
+# Case dentro de if e de laço depois de um break: o comando é gerado
+# inteiro, num bloco a que só o switch chega
+run_ok switch_nested_case 239 "--switch=table,--switch=tree,--no-fold" <<'C'
+int f(int x) {
+    int r = 0;
+    switch (x) {
+    case 0:
+        r = 1;
+        break;
+        if (r) {
+        case 1:
+            r = r + 2;
+        }
+        r = r + 10;
+        while (r < 100) {
+        case 2:
+            r = r * 3 + 1;
+        }
+        break;
+    default:
+        r = 5;
+    }
+    return r;
+}
+int main() { return f(0) + f(1) + f(2) + f(7); }
+C
+
+# Case repetido e case não constante são erros, relatados uma vez só
+run_bad switch_duplicate_case "Duplicate case value 2" <<'C'
+int f(int x) {
+    switch (x) {
+    case 1: return 1;
+    case 1 + 1: return 2;
+    case 2: return 3;
+    }
+    return 0;
+}
+int main() { return f(2); }
+C
+
+run_bad switch_non_constant_case "does not reduce to an integer constant" <<'C'
+int f(int x, int k) {
+    switch (x) {
+    case 1: return 1;
+    case k: return 2;
+    }
+    return 0;
+}
+int main() { return f(2, 2); }
+C
+
+# --------- MEM2REG ---------
+
+# Laços, ifs, break e continue viram phis; locais com endereço tomado e
+# volatile continuam na memória
+run_ok mem2reg_promotion 33 <<'C'
+void bump(int *p) { *p = *p + 1; }
+int loop(int n) {
+    int sum = 0;
+    int i;
+    for (i = 0; i < n; i = i + 1) {
+        if (i % 2) sum = sum + i;
+        else sum = sum - 1;
+    }
+    return sum;
+}
+int search(int n) {
+    int i = 0;
+    int hits = 0;
+    do {
+        i = i + 1;
+        if (i % 3 == 0) continue;
+        if (i > n) break;
+        hits = hits + 1;
+    } while (i < 100);
+    return hits;
+}
+int taken(int n) {
+    int k = n;
+    bump(&k);
+    bump(&k);
+    return k;
+}
+int vol(int n) {
+    volatile int v = n;
+    v = v + 1;
+    return v;
+}
+int main() {
+    int a = loop(10);
+    int b;
+    if (a > 0) b = a; else b = 0;
+    return b + search(9) + taken(3) + vol(1);
+}
+C
+ir_has mem2reg_promotion 'phi i32'
+ir_lacks mem2reg_promotion '%loop\.(sum|i)[.0-9]* = alloca'
+ir_has mem2reg_promotion '%taken\.k[.0-9]* = alloca'
+ir_has mem2reg_promotion 'store volatile i32'
+
+# Uma função com 20000 ifs em sequência tem uma árvore de dominadores com
+# 20000 níveis; com pilha de 1 MB a renomeação não pode ser recursiva
+run_deep () {
+    local name="mem2reg_deep" f="$TMP/mem2reg_deep.c"
+    {
+        echo 'int f(int x) {'
+        echo '    int y = 0;'
+        awk 'BEGIN { for (k = 0; k < 20000; k++) printf "    if (x > %d) y = y + %d;\n", k, k }'
+        echo '    return y;'
+        echo '}'
+        echo 'int main() { return f(3); }'
+    } >"$f"
+    local problem="" out
+    for mode in "" "--codegen-threads=2"; do
+        if ! (ulimit -s 1024 && "$BIN" $mode -S "$f" -o "$TMP/$name.ll" >/dev/null 2>&1); then
+            problem="não compila com '$mode' e pilha de 1 MB"
+            break
+        fi
+    done
+    if [ -z "$problem" ] && ! opt -verify "$TMP/$name.ll" -o /dev/null 2>/dev/null; then
+        problem="IR inválido"
+    elif [ -z "$problem" ] && out="$(run_ll "$TMP/$name.ll")" && [ "$out" != "exit=3" ]; then
+        problem="saída '$out', esperado exit=3"
+    fi
+    if [ -z "$problem" ]; then
+        echo "PASS (ok):  $name"
+        ok_pass=$((ok_pass+1))
+    else
+        echo "FAIL (ok):  $name  ($problem)"
+    fi
+    ok_total=$((ok_total+1))
+}
+run_deep
+
+# --------- DOBRA DE CONSTANTES ---------
+
+# enum, sizeof, identidades, ramos constantes e divisão por zero (que fica
+# para o tempo de execução); com --no-fold o resultado tem de ser o mesmo
+run_ok fold_constants 52 "--no-fold,--no-fold --no-inline" <<'C'
+enum { A = 3, B = A * 4 + 1 };
+int zero;
+int ident(int x) { return (x * 1 + 0) - (x & 0); }
+int branch(int x) {
+    if (2 > 3) return 100;
+    while (0) x = x + 1;
+    return 1 ? x : 50;
+}
+int divide(int x) {
+    if (zero) return x / 0;
+    return x / 2;
+}
+int main() {
+    int size = sizeof(int) * 2;
+    unsigned half = (unsigned)-1 / 2;
+    int r = B + size + ident(7) + branch(4) + divide(10) + (-7 / 2) + (-7 % 2) + (1 << 4);
+    return r + (half == 2147483647) + ((unsigned)-1 > 5) * 2;
+}
+C
+ir_lacks fold_constants 'mul nsw i32 (%x, 1|4, 2)'
+ir_lacks fold_constants 'i32 100'
+ir_has fold_constants 'sdiv i32 %x, 0'
+
+# Cast numa constante trunca para o tipo: (char)200 é -56, não 200
+run_ok fold_casts 15 "--no-fold" <<'C'
+int pick(int x) {
+    switch (x) {
+    case (char)200: return 1;
+    case 200: return 2;
+    case (short)70000: return 4;
+    case (_Bool)7: return 8;
+    }
+    return 0;
+}
+int main() {
+    int c = (char)200;
+    return pick(c) + pick(200) + pick(4464) + pick(1) - 2 * (c != -56);
+}
+C
+
+# Leitura de volatile não some com v * 0 nem v & 0
+run_ok fold_volatile 10 "--no-fold" <<'C'
+int g(volatile int *p) { return *p * 0 + (p[0] & 0); }
+int main() {
+    volatile int v = 3;
+    int a = v * 0;
+    int b = v & 0;
+    return a + b + g(&v) + 10;
+}
+C
+ir_has fold_volatile 'load volatile i32, i32\* %main\.v'
+ir_has fold_volatile 'load volatile i32, i32\* %p'
+
+# --------- INLINING ---------
+
+# Funções folha e inline são copiadas (com efeitos na ordem certa);
+# recursão nunca
+run_ok inline_calls 71 "--inline-threshold=1,--inline-threshold=100" <<'C'
+int sq(int x) { return x * x; }
+inline int sum_sq(int a, int b) { return sq(a) + sq(b); }
+int fact(int n) {
+    if (n <= 1) return 1;
+    return n * fact(n - 1);
+}
+int clamp(int v, int lo, int hi) {
+    if (v < lo) return lo;
+    if (v > hi) return hi;
+    return v;
+}
+int counter;
+int tick() { counter = counter + 1; return counter; }
+int main() {
+    int r = sum_sq(3, 4);
+    r = r + clamp(-5, 0, 10) + clamp(50, 0, 10) + clamp(7, 0, 10);
+    r = r + fact(4);
+    int t = tick() + tick() * 10;
+    return r + t - 18 + counter;
+}
+C
+ir_lacks inline_calls 'call i32 @(clamp|tick|sum_sq)'
+ir_has inline_calls 'call i32 @fact\(i32 4\)'
+
+# --------- LIGAÇÃO INTERNA E DCE ---------
+
+# static vira internal e o que não é alcançável a partir do que é
+# exportado some, inclusive a string que só um global morto usava
+run_ok dce_internal 128 <<'C'
+static int used_counter;
+static int unused_counter;
+static const int limit = 9;
+static char *greeting = "hello";
+static char *farewell = "goodbye";
+static int helper(int x) { return x + used_counter; }
+static int dead(int x) { return x * 3 + unused_counter; }
+static int dead_chain(int x) { return dead(x) + 1; }
+static int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+int exported(int x) { return helper(x) * 2; }
+int main() {
+    used_counter = 1;
+    return exported(4) + limit + greeting[1] + fib(6);
+}
+C
+ir_has dce_internal '^define internal i32 @fib'
+ir_has dce_internal '^define i32 @exported'
+ir_has dce_internal 'internal constant i32 9'
+ir_lacks dce_internal '@(dead|dead_chain|helper)\b'
+ir_lacks dce_internal 'unused_counter|farewell|goodbye'
+
+# Só é constant o global const cujo inicializador sai no IR: o do vetor
+# ainda não é gerado (ele começa zerado), e um constant com zeros deixaria
+# o opt -O2 dobrar a leitura de ctab[1] para esses zeros
+run_ok const_globals 5 <<'C'
+static const int ctab[3] = {1, 2, 3};
+static const int zeros[2];
+const int k = 7;
+static const int neg = -4;
+int main() {
+    int e = ctab[1];
+    return (e == 0 || e == 2) * 2 + zeros[1] + k + neg;
+}
+C
+ir_has const_globals '@global\.ctab[.0-9]* = internal global \[3 x i32\]'
+ir_has const_globals '@global\.zeros[.0-9]* = internal constant \[2 x i32\] zeroinitializer'
+ir_has const_globals 'internal constant i32 -4'
+ir_lacks const_globals 'constant \[3 x i32\]'
+
+# --------- ATRIBUTOS ---------
+
+# readnone/readonly inferidos do corpo; const só vira readonly se nada é
+# escrito através do ponteiro nem ele escapa; restrict vira noalias e
+# volatile fica na memória
+run_ok attributes 48 <<'C'
+int total;
+int pure(int a, int b) { return a * b + 1; }
+int sum(const int *p, int n) {
+    int s = 0;
+    int i;
+    for (i = 0; i < n; i = i + 1) s = s + p[i];
+    return s;
+}
+void cast_away(const int *p) {
+    int *q = (int *)p;
+    q[0] = 9;
+}
+int escapes(const int *p) {
+    cast_away(p);
+    return p[0] + 2;
+}
+void scale(int *restrict dst, const int *restrict src, int n) {
+    int i;
+    for (i = 0; i < n; i = i + 1) dst[i] = src[i] * 2;
+}
+int reads_global() { return total; }
+void writes_global(int v) { total = v; }
+int main() {
+    int a[3];
+    int b[3];
+    a[0] = 1; a[1] = 2; a[2] = 3;
+    scale(b, a, 3);
+    cast_away(a);
+    writes_global(4);
+    volatile int v = 5;
+    return pure(2, 3) + sum(b, 3) + a[0] + escapes(b) + reads_global() + v;
+}
+C
+ir_has attributes '^define i32 @pure\(.*\) nounwind readnone'
+ir_has attributes '^define i32 @sum\(i32\* readonly %p, i32 %n\) nounwind readonly'
+ir_has attributes '^define void @cast_away\(i32\* %p\) nounwind \{'
+ir_has attributes '^define i32 @escapes\(i32\* %p\) nounwind \{'
+ir_has attributes '^define void @scale\(i32\* noalias %dst, i32\* noalias readonly %src'
+ir_has attributes '^define i32 @reads_global\(\) nounwind readonly'
+ir_has attributes '^define void @writes_global\(i32 %v\) nounwind \{'
+ir_has attributes 'store volatile i32 5'
+ir_has attributes 'load volatile i32'
+
+# --------- LOTE ---------
+
+# Vários arquivos com -j: o ruim falha, os bons geram .ll e todo
+# diagnóstico começa com o caminho do arquivo que o causou
+run_batch () {
+    local dir="$TMP/batch"
+    mkdir -p "$dir"
+    echo 'int main() { return 0; }' >"$dir/good1.c"
+    echo 'int main() { return undeclared; }' >"$dir/bad.c"
+    printf 'int f() { return 1; }\nint main() { return f(); }\n' >"$dir/good2.c"
+    local bin
+    bin="$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")"
+    local problem=""
+    if (cd "$dir" && "$bin" -S -j 3 good1.c bad.c good2.c >/dev/null 2>batch.err); then
+        problem="esperado: exit != 0"
+    elif [ ! -s "$dir/good1.ll" ] || [ ! -s "$dir/good2.ll" ]; then
+        problem="faltam good1.ll ou good2.ll"
+    elif ! grep -q "^bad.c: Semantic Error: .*'undeclared'" "$dir/batch.err"; then
+        problem="erro sem o nome do arquivo"
+    elif grep -v '^bad.c: ' "$dir/batch.err" | grep -q .; then
+        problem="diagnóstico sem o prefixo bad.c: $(grep -v '^bad.c: ' "$dir/batch.err" | head -1)"
+    fi
+    if [ -z "$problem" ]; then
+        echo "PASS (bad): batch_diagnostics"
+        bad_pass=$((bad_pass+1))
+    else
+        echo "FAIL (bad): batch_diagnostics  ($problem)"
+    fi
+    bad_total=$((bad_total+1))
+}
+run_batch
+
+# Entradas com o mesmo nome em diretórios diferentes iriam para o mesmo
+# x.ll: falha antes de compilar qualquer uma, sem escrever saída
+run_batch_clash () {
+    local dir="$TMP/batch_clash"
+    mkdir -p "$dir/a" "$dir/b"
+    echo 'int main() { return 1; }' >"$dir/a/x.c"
+    echo 'int main() { return 2; }' >"$dir/b/x.c"
+    echo 'int main() { return 0; }' >"$dir/y.c"
+    local bin
+    bin="$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")"
+    local problem=""
+    if (cd "$dir" && "$bin" -S -j 2 a/x.c y.c b/x.c >/dev/null 2>batch.err); then
+        problem="esperado: exit != 0"
+    elif [ -e "$dir/x.ll" ] || [ -e "$dir/y.ll" ]; then
+        problem="escreveu saída mesmo assim"
+    elif [ "$(grep -cF 'a/x.c and b/x.c would both be written to x.ll' "$dir/batch.err")" != 1 ]; then
+        problem="sem o diagnóstico da colisão"
+    fi
+    if [ -z "$problem" ]; then
+        echo "PASS (bad): batch_output_clash"
+        bad_pass=$((bad_pass+1))
+    else
+        echo "FAIL (bad): batch_output_clash  ($problem)"
+    fi
+    bad_total=$((bad_total+1))
+}
+run_batch_clash
+
+echo
+echo "Resumo:"
+echo "  OK : $ok_pass / $ok_total"
+echo "  BAD: $bad_pass / $bad_total"
+echo "  IR : $ir_pass / $ir_total"
+
+# Falha geral se algo não bateu
+if [ $ok_pass -ne $ok_total ] || [ $bad_pass -ne $bad_total ] || [ $ir_pass -ne $ir_total ]; then
+    exit 1
+fi